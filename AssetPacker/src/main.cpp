@@ -0,0 +1,124 @@
+#include "core/container/vector.h"
+#include "core/container/string_view.h"
+#include "core/memory/allocator.h"
+#include "core/memory/linear_allocator.h"
+#include "core/job_system/job.h"
+#include "core/context.h"
+#include "engine/pack.h"
+#include "graphics/assets/assets.h"
+#include "graphics/assets/model.h"
+#include <stdio.h>
+
+//Sources load_Model imports with assimp. The _lod1 and higher files of an fbx are imported together with its lod 0
+bool is_model_source(string_view path) {
+	if (path.ends_with(".obj")) return true;
+	if (!path.ends_with(".fbx")) return false;
+
+	string_view name = path.sub(0, path.length - 4);
+	if (name.length < 5) return true;
+
+	string_view suffix = name.sub(name.length - 5, name.length);
+	return !suffix.starts_with("_lod") || suffix.ends_with("0");
+}
+
+struct CookModelsJob {
+	slice<const char*> directories;
+	uint cooked;
+	uint failed;
+};
+
+//Paths are relative to the directory they were found in, which serves as both the level and engine asset folder
+void cook_models(CookModelsJob& job) {
+	for (const char* directory : job.directories) {
+		string_buffer root = string_view(directory);
+		if (!root.ends_with("/") && !root.ends_with("\\")) root += "/";
+		set_asset_path(root, root);
+
+		vector<PackSource> sources;
+		collect_pack_sources(root, sources);
+
+		for (PackSource& source : sources) {
+			if (!is_model_source(source.path)) continue;
+
+			//the imported meshes are only needed until they are written out
+			LinearRegion permanent_region(get_permanent_allocator());
+			LinearRegion temporary_region(get_temporary_allocator());
+
+			bool cooked = false;
+			try {
+				cooked = cook_model(source.path, glm::mat4(1.0));
+			}
+			catch (string_buffer& err) {
+				fprintf(stderr, "%s\n", err.c_str());
+			}
+
+			if (cooked) job.cooked++;
+			else {
+				fprintf(stderr, "Could not cook %s\n", source.full_path.c_str());
+				job.failed++;
+			}
+		}
+	}
+}
+
+//AssetPacker [-c] [-m] -o <output.pack> <directory>...
+//Packs every file below the directories, the engine asset directory and the level asset directory go into the same pack.
+//-c compresses the entries that shrink with LZ4
+//-m cooks every model first, so the cooked models are packed and the first load of a level never imports a source
+int main(int argc, const char** c_args) {
+	LinearAllocator& permanent_allocator = get_thread_local_permanent_allocator();
+	LinearAllocator& temporary_allocator = get_thread_local_temporary_allocator();
+
+	permanent_allocator = LinearAllocator(mb(100));
+	temporary_allocator = LinearAllocator(mb(100));
+
+	Context context;
+	context.temporary_allocator = &get_thread_local_temporary_allocator();
+	context.allocator = &default_allocator;
+
+	ScopedContext scoped_context(context);
+
+	const char* output = nullptr;
+	bool compress = false;
+	bool cook = false;
+	vector<const char*> directories;
+
+	for (int i = 1; i < argc; i++) {
+		string_view arg = c_args[i];
+
+		if (arg == "-o" && i + 1 < argc) output = c_args[++i];
+		else if (arg == "-c") compress = true;
+		else if (arg == "-m") cook = true;
+		else directories.append(c_args[i]);
+	}
+
+	if (!output || directories.length == 0) {
+		fprintf(stderr, "Usage: AssetPacker [-c] [-m] -o <output.pack> <directory>...\n");
+		return 1;
+	}
+
+	if (cook) {
+		//lod generation and mesh optimization schedule jobs, a single worker runs them on this thread
+		make_job_system(20, 1);
+
+		CookModelsJob job = { directories };
+		JobDesc desc(cook_models, &job);
+		wait_for_jobs_on_thread(PRIORITY_HIGH, desc);
+
+		destroy_job_system();
+
+		printf("Cooked %u models\n", job.cooked);
+		if (job.failed > 0) return 1;
+	}
+
+	vector<PackSource> sources;
+	for (const char* directory : directories) collect_pack_sources(directory, sources);
+
+	if (!write_Pack(output, sources, compress)) {
+		fprintf(stderr, "Could not write %s\n", output);
+		return 1;
+	}
+
+	printf("Packed %u files into %s\n", sources.length, output);
+	return 0;
+}
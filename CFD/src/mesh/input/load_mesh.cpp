@@ -1,6 +1,7 @@
 #include "mesh/input_mesh.h"
 #include "graphics/assets/assets.h"
 #include "graphics/assets/model.h"
+#include "graphics/assets/vertex_compression.h"
 #include "core/container/hash_map.h"
 
 //found on https://cs.stackexchange.com/questions/37952/hash-function-floating-point-inputs-for-genetic-algorithm
@@ -34,7 +35,6 @@ SurfaceTriMesh surface_from_mesh(const glm::mat4& mat, Mesh& mesh) {
 	uint lod = 0;
 	
 	slice<uint> mesh_indices = mesh.indices[lod];
-	slice<Vertex> mesh_vertices = mesh.vertices[lod];
 
 	uint hash_map_size = mesh_indices.length * 3;
 
@@ -61,9 +61,8 @@ SurfaceTriMesh surface_from_mesh(const glm::mat4& mat, Mesh& mesh) {
 		vec3 vertex_positions[3] = {};
 
 		for (uint j = 0; j < 3; j++) {
-			Vertex vertex = mesh.vertices[lod][indices[j]];
-
-			vec3 position = vertex.position;
+			//cooked meshes only keep compact vertices, so go through the accessor
+			vec3 position = mesh_vertex_position(mesh, lod, indices[j]);
 			uint& id = vertex_hash_map[position]; //deduplicate vertices
 			if (id == 0) { id = vertex_id++; } //assign the vertex an ID
 
@@ -117,7 +116,7 @@ input_model_handle InputMeshRegistry::load_model(string_view path, const glm::ma
 	u64 vertices = 0;
 	u64 indices = 0;
 	for (Mesh mesh : model->meshes) {
-		vertices += mesh.vertices[0].length;
+		vertices += mesh_vertex_count(mesh, 0);
 		indices += mesh.indices[0].length;
 	}
 
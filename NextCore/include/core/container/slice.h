@@ -24,9 +24,12 @@ struct slice {
 	T* data;	
 	uint length;
 
-	slice() : data(nullptr), length(0) {}
-	slice(T& value) :  data(&value), length(1) {}
-	slice(T* data, uint length) : data(data), length(length) {}
+	constexpr slice() : data(nullptr), length(0) {}
+	constexpr slice(T& value) :  data(&value), length(1) {}
+	constexpr slice(T* data, uint length) : data(data), length(length) {}
+
+	template<uint N>
+	constexpr slice(T (&array)[N]) : data(array), length(N) {}
 
 	ARRAY_INDEXING
 };
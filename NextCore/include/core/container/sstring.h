@@ -7,7 +7,7 @@ struct sstring {
 
 	char data[N];
 	
-	inline void length(int l) {
+	constexpr void length(int l) {
 		data[N - 1] = N - l;
 	}
 
@@ -19,7 +19,8 @@ struct sstring {
         return data;
     }
 
-	inline sstring(const char* str) {
+	//Clears the whole array first, which lets static sstrings be initialized at compile time
+	constexpr sstring(const char* str) : data{} {
 		int i = 0;
 		while (*str) {
 			assert(i < N);
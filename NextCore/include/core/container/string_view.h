@@ -15,7 +15,7 @@ struct string_view {
 	unsigned int length = 0;
 
 	inline string_view() {}
-	inline string_view(const char* data, unsigned int length) : data(data), length(length) {}
+	constexpr string_view(const char* data, unsigned int length) : data(data), length(length) {}
 
 	inline string_view(const char* data) {
 		if (data == NULL) data = "";
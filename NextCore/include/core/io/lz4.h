@@ -0,0 +1,10 @@
+#pragma once
+
+#include "core/core.h"
+
+//LZ4 block format, used for asset packs and compressed serializer streams
+CORE_API u64 lz4_compress_bound(u64 size);
+//Output must hold lz4_compress_bound(size) bytes, returns the compressed size
+CORE_API u64 lz4_compress(const char* input, u64 size, char* output);
+//Fails on corrupt input or when it does not decompress to exactly output_size bytes
+CORE_API bool lz4_decompress(const char* input, u64 size, char* output, u64 output_size);
@@ -0,0 +1,240 @@
+#pragma once
+
+#include "core/core.h"
+#include "core/container/string_view.h"
+#include <string.h>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#include <emmintrin.h>
+#define LEXING_SSE
+#endif
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#define LEXING_AVX2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//Shared by the lexers of Notec and the reflection tool. The scans classify 16 bytes at a time with SSE2,
+//or 32 with AVX2 when the compiler targets it, and fall back to a byte at a time for the tail
+
+inline uint first_set_bit(uint mask) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+inline uint count_set_bits(uint mask) {
+#ifdef _MSC_VER
+	return __popcnt(mask);
+#else
+	return __builtin_popcount(mask);
+#endif
+}
+
+inline bool is_blank_char(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool is_identifier_char(char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+#ifdef LEXING_SSE
+//Bytes are compared as signed, so everything from 0x80 up is below the ranges
+inline __m128i in_range(__m128i chars, char low, char high) {
+	return _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(low - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8(high + 1)));
+}
+
+inline uint blank_mask(__m128i chars) {
+	__m128i blank = _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')), _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(chars, _mm_set1_epi8('\r'))));
+	return _mm_movemask_epi8(blank);
+}
+
+inline uint identifier_mask(__m128i chars) {
+	__m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20)); //folds A-Z onto a-z
+	__m128i ident = _mm_or_si128(in_range(lower, 'a', 'z'), _mm_or_si128(in_range(chars, '0', '9'), _mm_cmpeq_epi8(chars, _mm_set1_epi8('_'))));
+	return _mm_movemask_epi8(ident);
+}
+#endif
+
+#ifdef LEXING_AVX2
+inline __m256i in_range(__m256i chars, char low, char high) {
+	return _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8(low - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), chars));
+}
+
+inline uint blank_mask(__m256i chars) {
+	__m256i blank = _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' ')), _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\t')), _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\r'))));
+	return _mm256_movemask_epi8(blank);
+}
+
+inline uint identifier_mask(__m256i chars) {
+	__m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+	__m256i ident = _mm256_or_si256(in_range(lower, 'a', 'z'), _mm256_or_si256(in_range(chars, '0', '9'), _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('_'))));
+	return _mm256_movemask_epi8(ident);
+}
+#endif
+
+//Past spaces, tabs and carriage returns, newlines are left to the lexer so it can count lines.
+//Most runs are a single space, so one byte is checked before any wide load
+inline const char* skip_blanks(const char* c, const char* end) {
+	if (c == end || !is_blank_char(*c)) return c;
+#if defined(LEXING_AVX2)
+	for (; c + 32 <= end; c += 32) {
+		uint other = ~blank_mask(_mm256_loadu_si256((const __m256i*)c));
+		if (other) return c + first_set_bit(other);
+	}
+#elif defined(LEXING_SSE)
+	for (; c + 16 <= end; c += 16) {
+		uint other = ~blank_mask(_mm_loadu_si128((const __m128i*)c)) & 0xffff;
+		if (other) return c + first_set_bit(other);
+	}
+#endif
+	while (c < end && is_blank_char(*c)) c++;
+	return c;
+}
+
+//Past letters, digits and underscores
+inline const char* skip_identifier(const char* c, const char* end) {
+#if defined(LEXING_AVX2)
+	for (; c + 32 <= end; c += 32) {
+		uint other = ~identifier_mask(_mm256_loadu_si256((const __m256i*)c));
+		if (other) return c + first_set_bit(other);
+	}
+#elif defined(LEXING_SSE)
+	for (; c + 16 <= end; c += 16) {
+		uint other = ~identifier_mask(_mm_loadu_si128((const __m128i*)c)) & 0xffff;
+		if (other) return c + first_set_bit(other);
+	}
+#endif
+	while (c < end && is_identifier_char(*c)) c++;
+	return c;
+}
+
+//First occurence of the character, or end
+inline const char* find_char(const char* c, const char* end, char target) {
+#if defined(LEXING_AVX2)
+	__m256i wide_target = _mm256_set1_epi8(target);
+	for (; c + 32 <= end; c += 32) {
+		uint found = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)c), wide_target));
+		if (found) return c + first_set_bit(found);
+	}
+#elif defined(LEXING_SSE)
+	__m128i wide_target = _mm_set1_epi8(target);
+	for (; c + 16 <= end; c += 16) {
+		uint found = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)c), wide_target));
+		if (found) return c + first_set_bit(found);
+	}
+#endif
+	while (c < end && *c != target) c++;
+	return c;
+}
+
+inline uint count_char(const char* c, const char* end, char target) {
+	uint count = 0;
+#ifdef LEXING_SSE
+	__m128i wide_target = _mm_set1_epi8(target);
+	for (; c + 16 <= end; c += 16) {
+		count += count_set_bits(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)c), wide_target)));
+	}
+#endif
+	for (; c < end; c++) count += *c == target;
+	return count;
+}
+
+//Start of the closing */ of a block comment, or end
+inline const char* find_comment_end(const char* c, const char* end) {
+	while ((c = find_char(c, end, '*')) + 1 < end) {
+		if (c[1] == '/') return c;
+		c++;
+	}
+	return end;
+}
+
+//Keyword lookup through a perfect hash that is searched for at compile time, a lookup hashes the string once
+//and compares it against the one keyword in its slot
+template<typename T>
+struct KeywordDesc {
+	const char* name;
+	T type;
+};
+
+constexpr uint keyword_length(const char* name) {
+	uint length = 0;
+	while (name[length]) length++;
+	return length;
+}
+
+constexpr uint keyword_hash(const char* str, uint length, uint seed) {
+	uint hash = seed;
+	for (uint i = 0; i < length; i++) hash = (hash ^ (u8)str[i]) * 16777619u;
+	return hash ^ (hash >> 15);
+}
+
+//Four times as many slots as keywords, which makes a seed without collisions quick to find
+constexpr uint keyword_slots(uint count) {
+	uint slots = 1;
+	while (slots < count * 4) slots *= 2;
+	return slots;
+}
+
+template<typename T, uint N>
+struct KeywordTable {
+	static constexpr uint SLOTS = keyword_slots(N);
+
+	const char* names[SLOTS] = {};
+	T types[SLOTS] = {};
+	u8 lengths[SLOTS] = {};
+	uint seed = 0;
+	uint longest = 0;
+
+	constexpr KeywordTable(const KeywordDesc<T> (&keywords)[N]) {
+		for (uint i = 0; i < N; i++) {
+			uint length = keyword_length(keywords[i].name);
+			if (length > longest) longest = length;
+		}
+
+		for (seed = 2166136261u; ; seed++) {
+			bool used[SLOTS] = {};
+			bool collision = false;
+
+			for (uint i = 0; i < N && !collision; i++) {
+				uint slot = keyword_hash(keywords[i].name, keyword_length(keywords[i].name), seed) & (SLOTS - 1);
+				collision = used[slot];
+				used[slot] = true;
+			}
+
+			if (!collision) break;
+		}
+
+		for (uint i = 0; i < N; i++) {
+			uint length = keyword_length(keywords[i].name);
+			uint slot = keyword_hash(keywords[i].name, length, seed) & (SLOTS - 1);
+			names[slot] = keywords[i].name;
+			types[slot] = keywords[i].type;
+			lengths[slot] = length;
+		}
+	}
+
+	bool lookup(string_view str, T* type) const {
+		if (str.length == 0 || str.length > longest) return false;
+
+		uint slot = keyword_hash(str.data, str.length, seed) & (SLOTS - 1);
+		if (lengths[slot] != str.length || memcmp(names[slot], str.data, str.length) != 0) return false;
+
+		*type = types[slot];
+		return true;
+	}
+};
+
+template<typename T, uint N>
+constexpr KeywordTable<T, N> make_keyword_table(const KeywordDesc<T> (&keywords)[N]) {
+	return KeywordTable<T, N>(keywords);
+}
@@ -4,10 +4,13 @@
 #include "core/container/vector.h"
 #include "core/container/tvector.h"
 #include "core/container/array.h"
+#include "core/container/slice.h"
+#include "core/container/sstring.h"
 #include "core/io/logger.h"
 #include <glm/glm.hpp>
 
-//todo all allocations for reflection objects should use one clearable allocator per dll
+//Types are tables the reflection tool generates, the fields and values point into static arrays,
+//so the types are built at compile time and never allocate. Each type exists once, the same pointer is the same type
 namespace refl {
 	const uint REFLECT_TAG = 1 << 0;
 	const uint SERIALIZE_TAG = 1 << 1;
@@ -32,6 +35,7 @@ namespace refl {
 		uint offset;
 		Type* type;
 		uint flags;
+		u64 id; //stable across builds, identifies the field in data written by an older layout
 	};
 
 	struct Ptr : Type {
@@ -45,7 +49,7 @@ namespace refl {
 		Type* element;
 		int num;
 
-		inline Array(ArrayType arr_type, uint size, const char* name, Type* element, uint num = 0)
+		constexpr Array(ArrayType arr_type, uint size, const char* name, Type* element, uint num = 0)
 			: Type{ Type::Array, size, name }, element(element), arr_type(arr_type), num(num) {}
 	};
 
@@ -55,24 +59,24 @@ namespace refl {
 			int value;
 		};
 
-		vector<Value> values;
+		slice<Value> values;
 
-		inline Enum(string_view name, uint size) : Type{ Type::Enum, size, name } {}
+		constexpr Enum(const char* name, uint size, slice<Value> values = {}) : Type{ Type::Enum, size, name }, values(values) {}
 	};
 
 	/* technically a tagged union, since regular unions cannot be serialized!*/
 	struct Union : Type {
-		vector<Field> fields;
-		vector<Type> types;
+		slice<Field> fields;
+		slice<Type> types;
 		
 		int type_offset;
 	};
 
 	struct Struct : Type {
-		vector<Field> fields;
-		vector<Type*> template_args;
+		slice<Field> fields;
+		slice<Type*> template_args;
 
-		inline Struct(string_view name, uint size) : Type{Type::Struct, size, name} {}
+		constexpr Struct(const char* name, uint size, slice<Field> fields = {}) : Type{Type::Struct, size, name}, fields(fields) {}
 	};
 
 	struct Namespace {
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "core/core.h"
+#include "core/reflection.h"
+#include "core/container/vector.h"
+#include "core/container/sstring.h"
+
+struct SerializerBuffer;
+struct DeserializerBuffer;
+
+//A reflected type flattened to the fields that hold data. It is stored once per file next to data written
+//with the layout, so the data can be read by a build in which the type changed.
+//Fields of nested structs are listed on their own, with an id made from the field ids along their path
+//Arrays are a single field, their id also hashes the layout of the elements
+namespace refl {
+	//What a field owns, so it can be freed after the type that declared it was unloaded.
+	//Only the storage of an array is freed, not what its elements own
+	enum class DestroyKind : u8 { None, Array, StringBuffer };
+
+	struct SchemaField {
+		u64 id;
+		uint offset;
+		uint size;
+		Type::RefType kind;
+		DestroyKind destroy;
+	};
+
+	struct Schema {
+		sstring name;
+		uint size = 0;
+		u64 hash = 0; //equal hashes and sizes mean the layouts are the same
+		vector<SchemaField> fields;
+	};
+
+	struct MigrationCopy {
+		uint src_offset;
+		uint dst_offset;
+		uint size;
+	};
+
+	//Compiled once per pair of layouts and applied to whole columns of components.
+	//Fields that are new or changed kind or size keep the value the constructor gave them
+	struct MigrationPlan {
+		uint src_size = 0;
+		uint dst_size = 0;
+		bool identity = false;
+		vector<SchemaField> dropped; //fields of the source that own something and are not copied
+		vector<MigrationCopy> copies;
+	};
+
+	//The id emitted by the reflection tool, or the hash of the name for types that were reflected by hand
+	CORE_API u64 field_id(const Field& field);
+
+	CORE_API void make_Schema(Schema& schema, Type* type);
+	//Adjacent fields that moved together are merged into one copy
+	CORE_API void make_MigrationPlan(MigrationPlan& plan, const Schema& from, const Schema& to);
+	//Moves the fields migrate_column overwrites out of constructed components, into zeroed storage of the same
+	//layout. Destroying it frees what the constructor allocated for them, zeroed containers own nothing
+	CORE_API void take_migrated_fields(const MigrationPlan& plan, u8* taken, const u8* dst, uint count);
+	//Dst must already be constructed, count components of plan.src_size are read from src
+	CORE_API void migrate_column(const MigrationPlan& plan, u8* dst, const u8* src, uint count);
+	//Frees what the dropped fields of count components of plan.src_size own, the copied fields were moved by migrate_column
+	CORE_API void destroy_dropped_fields(const MigrationPlan& plan, u8* src, uint count);
+
+	CORE_API void write_Schema_to_buffer(SerializerBuffer& buffer, const Schema& schema);
+	CORE_API void read_Schema_from_buffer(DeserializerBuffer& buffer, Schema& schema);
+}
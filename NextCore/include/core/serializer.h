@@ -5,32 +5,100 @@
 #include "core/container/string_buffer.h"
 #include "core/container/sstring.h"
 #include "core/container/array.h"
+#include "core/memory/allocator.h"
+#include <stdio.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
+//Buffers either hold everything in memory, or stream through a chunk that is flushed to or refilled from a file.
+//Streamed files start with a SerializerStreamHeader, LZ4 compressed ones store every chunk as a SerializerBlock
+const uint SERIALIZER_CHUNK_SIZE = kb(256);
+const uint SERIALIZER_STREAM_MAGIC = 'N' | 'E' << 8 | 'S' << 16 | 'R' << 24;
+
+struct SerializerStreamHeader {
+	uint magic;
+	uint compressed;
+};
+
+struct SerializerBlock {
+	uint size;
+	uint stored_size; //equal to size when the chunk did not compress
+};
+
+struct SerializerSink {
+	FILE* file = nullptr;
+	bool compress = false;
+	bool failed = false;
+	char* compressed = nullptr;
+};
+
+struct DeserializerSource {
+	FILE* file = nullptr;
+	bool compressed = false;
+	char* stored = nullptr;
+};
+
 struct SerializerBuffer {
-	char* data;
+	char* data = nullptr;
 	uint index = 0;
-	uint capacity;
+	uint capacity = 0;
+	Allocator* allocator = nullptr; //when set the data grows instead of overflowing, it must have been allocated by it
+	SerializerSink* sink = nullptr; //full chunks are written out, index is relative to the current chunk
+	bool overflow = false; //a write did not fit in a fixed buffer and was dropped
 };
 
 struct DeserializerBuffer {
-	char* data;
-	uint index;
-	uint length;
+	char* data = nullptr;
+	uint index = 0;
+	uint length = 0;
+	DeserializerSource* source = nullptr; //refills data once it was read
+	bool overflow = false; //a read went past the end, the missing bytes were zeroed
 };
- 
-inline void write_n_to_buffer(SerializerBuffer& buffer, void* ptr, u64 size) {
-	assert(buffer.index + size <= buffer.capacity);
+
+//Called once the data does not fit in the chunk, flushes the chunk or grows it
+CORE_API void write_n_to_buffer_slow(SerializerBuffer& buffer, const void* ptr, u64 size);
+CORE_API void read_n_from_buffer_slow(DeserializerBuffer& buffer, void* ptr, u64 size);
+
+inline void write_n_to_buffer(SerializerBuffer& buffer, const void* ptr, u64 size) {
+	if (buffer.index + size > buffer.capacity) {
+		write_n_to_buffer_slow(buffer, ptr, size);
+		return;
+	}
+
 	memcpy(buffer.data + buffer.index, ptr, size);
 	buffer.index += size;
 }
 
 inline void read_n_from_buffer(DeserializerBuffer& buffer, void* ptr, u64 size) {
+	if (buffer.index + size > buffer.length) {
+		read_n_from_buffer_slow(buffer, ptr, size);
+		return;
+	}
+
 	memcpy(ptr, buffer.data + buffer.index, size);
 	buffer.index += size;
 }
 
+//Points into the buffer instead of copying, for trivially copyable data written with a matching layout hash.
+//Returns nullptr when the data is not contiguous in the current chunk of a stream, the caller then reads a copy
+inline void* view_n_from_buffer(DeserializerBuffer& buffer, u64 size) {
+	if (buffer.index + size > buffer.length) return nullptr;
+
+	void* ptr = buffer.data + buffer.index;
+	buffer.index += size;
+	return ptr;
+}
+
+//The buffer streams everything that is written to it into the file, memory use stays at a chunk.
+//Without compression every write but the last is exactly one chunk at a chunk aligned offset
+CORE_API bool open_file_sink(SerializerBuffer& buffer, SerializerSink& sink, const char* path, bool compress);
+//Flushes the last chunk, fails when any write to the file failed
+CORE_API bool close_file_sink(SerializerBuffer& buffer);
+
+//Reads files written through a sink, and plain files without a stream header as they are
+CORE_API bool open_file_source(DeserializerBuffer& buffer, DeserializerSource& source, const char* path);
+CORE_API void close_file_source(DeserializerBuffer& buffer);
+
 inline void write_char_to_buffer(SerializerBuffer& buffer, char value) {
 	write_n_to_buffer(buffer, &value, sizeof(char));
 }
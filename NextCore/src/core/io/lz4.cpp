@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include "core/io/lz4.h"
+#include "core/memory/allocator.h"
+#include <string.h>
+
+//LZ4 block format, greedy matching against a single hash table of the previous occurence of every 4 bytes
+const uint LZ4_MIN_MATCH = 4;
+const uint LZ4_LAST_LITERALS = 5;
+const uint LZ4_MATCH_LIMIT = 12;
+const uint LZ4_MAX_OFFSET = 65535;
+const uint LZ4_HASH_LOG = 16;
+
+uint read_u32(const char* ptr) {
+	uint value;
+	memcpy(&value, ptr, sizeof(uint));
+	return value;
+}
+
+char* write_length(char* output, u64 length) {
+	for (; length >= 255; length -= 255) *output++ = (char)255;
+	*output++ = (char)length;
+	return output;
+}
+
+char* write_sequence(char* output, const char* literals, u64 literal_length, uint offset, u64 match_length) {
+	char* token = output++;
+	*token = (char)((literal_length < 15 ? literal_length : 15) << 4);
+	if (literal_length >= 15) output = write_length(output, literal_length - 15);
+
+	memcpy(output, literals, literal_length);
+	output += literal_length;
+
+	if (match_length == 0) return output; //the last sequence only has literals
+
+	*output++ = (char)(offset & 0xff);
+	*output++ = (char)(offset >> 8);
+
+	match_length -= LZ4_MIN_MATCH;
+	*token |= (char)(match_length < 15 ? match_length : 15);
+	if (match_length >= 15) output = write_length(output, match_length - 15);
+
+	return output;
+}
+
+u64 lz4_compress_bound(u64 size) {
+	return size + size / 255 + 16;
+}
+
+u64 lz4_compress(const char* input, u64 size, char* output) {
+	char* op = output;
+	u64 anchor = 0;
+
+	if (size >= LZ4_MATCH_LIMIT) {
+		Allocator& allocator = get_allocator();
+		uint* table = (uint*)allocator.allocate(sizeof(uint) << LZ4_HASH_LOG);
+		memset(table, 0, sizeof(uint) << LZ4_HASH_LOG); //0 is empty, positions are stored plus one
+
+		u64 limit = size - LZ4_MATCH_LIMIT;
+
+		for (u64 i = 0; i <= limit;) {
+			uint sequence = read_u32(input + i);
+			uint hash = (sequence * 2654435761u) >> (32 - LZ4_HASH_LOG);
+
+			u64 ref = table[hash];
+			table[hash] = (uint)i + 1;
+
+			if (ref == 0 || i - (ref - 1) > LZ4_MAX_OFFSET || read_u32(input + ref - 1) != sequence) {
+				i++;
+				continue;
+			}
+
+			ref--;
+
+			u64 length = LZ4_MIN_MATCH;
+			u64 max_length = size - LZ4_LAST_LITERALS - i;
+			while (length < max_length && input[ref + length] == input[i + length]) length++;
+
+			op = write_sequence(op, input + anchor, i - anchor, (uint)(i - ref), length);
+
+			i += length;
+			anchor = i;
+		}
+
+		allocator.deallocate(table);
+	}
+
+	op = write_sequence(op, input + anchor, size - anchor, 0, 0);
+	return op - output;
+}
+
+bool read_length(const char*& ip, const char* end, u64& length) {
+	u8 byte;
+	do {
+		if (ip >= end) return false;
+		byte = (u8)*ip++;
+		length += byte;
+	} while (byte == 255);
+	return true;
+}
+
+bool lz4_decompress(const char* input, u64 size, char* output, u64 output_size) {
+	const char* ip = input;
+	const char* end = input + size;
+	char* op = output;
+	char* output_end = output + output_size;
+
+	while (ip < end) {
+		u8 token = (u8)*ip++;
+
+		u64 literal_length = token >> 4;
+		if (literal_length == 15 && !read_length(ip, end, literal_length)) return false;
+		if (literal_length > (u64)(end - ip) || literal_length > (u64)(output_end - op)) return false;
+
+		memcpy(op, ip, literal_length);
+		ip += literal_length;
+		op += literal_length;
+
+		if (ip == end) break;
+		if (end - ip < 2) return false;
+
+		uint offset = (u8)ip[0] | (u8)ip[1] << 8;
+		ip += 2;
+		if (offset == 0 || offset > (u64)(op - output)) return false;
+
+		u64 match_length = token & 15;
+		if (match_length == 15 && !read_length(ip, end, match_length)) return false;
+		match_length += LZ4_MIN_MATCH;
+		if (match_length > (u64)(output_end - op)) return false;
+
+		//the match may overlap the bytes it produces
+		const char* match = op - offset;
+		for (u64 i = 0; i < match_length; i++) op[i] = match[i];
+		op += match_length;
+	}
+
+	return op == output_end;
+}
@@ -6,104 +6,79 @@
 #include "core/container/array.h"
 #include "core/container/sstring.h"
 #include "core/container/string_buffer.h"
-#include "core/container/hash_map.h"
 #include <glm/gtc/quaternion.hpp>
 
 using namespace refl;
 
-LinearAllocator reflection_allocator(mb(10));
+#define RESOLVE_PRIMITIVE_TYPE(typ, enum_name) static Type typ##_type{ Type::enum_name, sizeof(typ), "" }; \
+Type* get_##typ##_type() { return &typ##_type; }
 
-#define RESOLVE_PRIMITIVE_TYPE(typ, enum_name) Type* get_##typ##_type() { \
-	static Type type{Type::enum_name, sizeof(typ) };\
-	return &type;\
-} 
-
-#define RESOLVE_TYPE(typ, name) Type* get_##name##_type() { \
-	static auto type = init_##name(); \
-	return &type; \
-} \
-
-RESOLVE_PRIMITIVE_TYPE(uint, UInt)
-	RESOLVE_PRIMITIVE_TYPE(float, Float)
-	RESOLVE_PRIMITIVE_TYPE(int, Int)
-	RESOLVE_PRIMITIVE_TYPE(u64, UInt)
-	RESOLVE_PRIMITIVE_TYPE(bool, Bool)
-	RESOLVE_PRIMITIVE_TYPE(string_view, StringView)
-
-	Struct init_vec2() {
-	Struct type("glm::vec2", sizeof(glm::vec2));
-	type.fields.append({ "x", offsetof(glm::vec2, x), get_float_type() });
-	type.fields.append({ "y", offsetof(glm::vec2, y), get_float_type() });
-
-	return type;
-}
-
-RESOLVE_TYPE(glm::vec2, vec2)
-
-	Struct init_vec3() {
-	Struct type("glm::vec3", sizeof(glm::vec3));
-	type.fields.append({ "x", offsetof(glm::vec3, x), get_float_type() });
-	type.fields.append({ "y", offsetof(glm::vec3, y), get_float_type() });
-	type.fields.append({ "z", offsetof(glm::vec3, z), get_float_type() });
-
-	return type;
-}
-
-RESOLVE_TYPE(glm::vec3, vec3)
-
-	Struct init_vec4() {
-	Struct type("glm::vec4", sizeof(glm::vec4));
-	type.fields.append({ "x", offsetof(glm::vec4, x), get_float_type() });
-	type.fields.append({ "y", offsetof(glm::vec4, y), get_float_type() });
-	type.fields.append({ "z", offsetof(glm::vec4, z), get_float_type() });
-	type.fields.append({ "w", offsetof(glm::vec4, w), get_float_type() });
-
-	return type;
-}
-
-RESOLVE_TYPE(glm::vec4, vec4)
-
-Struct init_quat() {
-	Struct type("glm::quat", sizeof(glm::quat));
-	type.fields.append({ "x", offsetof(glm::quat, x), get_float_type() });
-	type.fields.append({ "y", offsetof(glm::quat, y), get_float_type() });
-	type.fields.append({ "z", offsetof(glm::quat, z), get_float_type() });
-	type.fields.append({ "w", offsetof(glm::quat, w), get_float_type() });
-
-	return type;
-}
-
-RESOLVE_TYPE(glm::quat, quat)
-
-Struct init_ivec2() {
-	Struct type("glm::ivec2", sizeof(glm::ivec2));
-	type.fields.append({ "x", offsetof(glm::ivec2, x), get_int_type() });
-	type.fields.append({ "y", offsetof(glm::ivec2, y), get_int_type() });
-
-	return type;
-}
-
-RESOLVE_TYPE(glm::ivec2, ivec2)
-
-Struct init_mat4() {
-	Struct type("glm::mat4", sizeof(glm::mat4));
-	return type;
-}
-
-RESOLVE_TYPE(glm::mat4, mat4)
-
-Type init_sstring() {
-	return Type{Type::SString, sizeof(sstring)};
-}
-
-RESOLVE_TYPE(sstring, sstring)
-
-Type init_string_buffer() {
-	return Type{ Type::StringBuffer, sizeof(string_buffer) };
+#define RESOLVE_TYPE(name) Type* get_##name##_type() { \
+	return &name##_type; \
 }
 
-RESOLVE_TYPE(string_buffer, string_buffer)
-
+RESOLVE_PRIMITIVE_TYPE(uint, UInt)
+RESOLVE_PRIMITIVE_TYPE(float, Float)
+RESOLVE_PRIMITIVE_TYPE(int, Int)
+RESOLVE_PRIMITIVE_TYPE(u64, UInt)
+RESOLVE_PRIMITIVE_TYPE(bool, Bool)
+RESOLVE_PRIMITIVE_TYPE(string_view, StringView)
+
+static Field vec2_fields[] = {
+	{ "x", offsetof(glm::vec2, x), &float_type },
+	{ "y", offsetof(glm::vec2, y), &float_type },
+};
+
+static Struct vec2_type("glm::vec2", sizeof(glm::vec2), vec2_fields);
+RESOLVE_TYPE(vec2)
+
+static Field vec3_fields[] = {
+	{ "x", offsetof(glm::vec3, x), &float_type },
+	{ "y", offsetof(glm::vec3, y), &float_type },
+	{ "z", offsetof(glm::vec3, z), &float_type },
+};
+
+static Struct vec3_type("glm::vec3", sizeof(glm::vec3), vec3_fields);
+RESOLVE_TYPE(vec3)
+
+static Field vec4_fields[] = {
+	{ "x", offsetof(glm::vec4, x), &float_type },
+	{ "y", offsetof(glm::vec4, y), &float_type },
+	{ "z", offsetof(glm::vec4, z), &float_type },
+	{ "w", offsetof(glm::vec4, w), &float_type },
+};
+
+static Struct vec4_type("glm::vec4", sizeof(glm::vec4), vec4_fields);
+RESOLVE_TYPE(vec4)
+
+static Field quat_fields[] = {
+	{ "x", offsetof(glm::quat, x), &float_type },
+	{ "y", offsetof(glm::quat, y), &float_type },
+	{ "z", offsetof(glm::quat, z), &float_type },
+	{ "w", offsetof(glm::quat, w), &float_type },
+};
+
+static Struct quat_type("glm::quat", sizeof(glm::quat), quat_fields);
+RESOLVE_TYPE(quat)
+
+static Field ivec2_fields[] = {
+	{ "x", offsetof(glm::ivec2, x), &int_type },
+	{ "y", offsetof(glm::ivec2, y), &int_type },
+};
+
+static Struct ivec2_type("glm::ivec2", sizeof(glm::ivec2), ivec2_fields);
+RESOLVE_TYPE(ivec2)
+
+static Struct mat4_type("glm::mat4", sizeof(glm::mat4));
+RESOLVE_TYPE(mat4)
+
+static Type sstring_type{ Type::SString, sizeof(sstring), "" };
+RESOLVE_TYPE(sstring)
+
+static Type string_buffer_type{ Type::StringBuffer, sizeof(string_buffer), "" };
+RESOLVE_TYPE(string_buffer)
+
+//Only for types built at runtime, the reflection tool emits a static Array for every array field
 Array* make_vector_type(Type* type) {
 	char* name = PERMANENT_ARRAY(char, 100);
 	snprintf(name, 100, "vector<%s>", type->name.c_str());
@@ -148,8 +123,7 @@ DiffField diff_field(Field& a, Field& b) {
     field.previous_type = a.type;
     field.current_type = b.type;
     
-    if (field.previous_type->name == field.current_type->name
-    ) {
+    if (field.previous_type == field.current_type || field.previous_type->name == field.current_type->name) {
         field.type = UNCHANGED_DIFF;
     } else {
         field.type = EDITED_DIFF;
@@ -193,13 +167,13 @@ DiffOfType diff_type(Type* a, Type* b) {
     diff.previous_size = a->size;
     diff.current_size = b->size;
     
+    //every type is one static table, the same pointer cannot have changed
+    if (a == b) return diff;
+    
     if (a->type == Type::Struct && b->type == Type::Struct) {
         Struct* a_struct = (Struct*)a;
         Struct* b_struct = (Struct*)b;
         
-        hash_map<sstring, Field*, 103> a_fields;
-        hash_map<sstring, Field*, 103> b_fields;
-        
         diff.fields.reserve(a_struct->fields.length);
         
         bool edited = false;
@@ -0,0 +1,206 @@
+#include "stdafx.h"
+#include "core/schema.h"
+#include "core/serializer.h"
+#include "core/container/string_buffer.h"
+#include <string.h>
+
+namespace refl {
+
+const u64 FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+//FNV-1a, the reflection tool emits field ids with the same hash
+u64 hash_bytes(u64 hash, const void* data, u64 size) {
+	const u8* bytes = (const u8*)data;
+	for (u64 i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+u64 field_id(const Field& field) {
+	if (field.id) return field.id;
+
+	string_view name = field.name;
+	return hash_bytes(FNV_OFFSET_BASIS, name.data, name.length);
+}
+
+//Elements of a type can contain arrays of that type, past this depth only their name is hashed
+const uint MAX_ELEMENT_NESTING = 4;
+
+void flatten_type(Schema& schema, Type* type, uint offset, u64 id, uint nesting);
+
+u64 hash_fields(const Schema& schema) {
+	u64 hash = hash_bytes(FNV_OFFSET_BASIS, &schema.size, sizeof(uint));
+	for (const SchemaField& field : schema.fields) {
+		hash = hash_bytes(hash, &field.id, sizeof(u64));
+		hash = hash_bytes(hash, &field.offset, sizeof(uint));
+		hash = hash_bytes(hash, &field.size, sizeof(uint));
+		hash = hash_bytes(hash, &field.kind, sizeof(Type::RefType));
+	}
+	return hash;
+}
+
+u64 element_hash(Type* element, uint nesting) {
+	if (nesting >= MAX_ELEMENT_NESTING) return hash_bytes(FNV_OFFSET_BASIS, element->name.data, strlen(element->name.data));
+
+	Schema schema;
+	schema.size = element->size;
+	flatten_type(schema, element, 0, FNV_OFFSET_BASIS, nesting + 1);
+	return hash_fields(schema);
+}
+
+void flatten_type(Schema& schema, Type* type, uint offset, u64 id, uint nesting) {
+	if (type->type == Type::Alias) {
+		flatten_type(schema, ((Alias*)type)->aliasing, offset, id, nesting);
+		return;
+	}
+
+	if (type->type == Type::Struct && ((Struct*)type)->fields.length > 0) {
+		for (Field& field : ((Struct*)type)->fields) {
+			u64 child_id = field_id(field);
+			flatten_type(schema, field.type, offset + field.offset, hash_bytes(id, &child_id, sizeof(u64)), nesting);
+		}
+		return;
+	}
+
+	if (type->size == 0) return; //inline unions are reflected without a size
+
+	//the elements are not part of the field, an array whose elements changed gets a new id and is not copied
+	if (type->type == Type::Array) {
+		u64 element = element_hash(((Array*)type)->element, nesting);
+		id = hash_bytes(id, &element, sizeof(u64));
+	}
+
+	SchemaField field = {};
+	field.id = id;
+	field.offset = offset;
+	field.size = type->size;
+	field.kind = type->type;
+	if (type->type == Type::Array && ((Array*)type)->arr_type == Array::Vector) field.destroy = DestroyKind::Array;
+	if (type->type == Type::StringBuffer) field.destroy = DestroyKind::StringBuffer;
+	schema.fields.append(field);
+}
+
+void make_Schema(Schema& schema, Type* type) {
+	schema.name = type->name;
+	schema.size = type->size;
+	schema.fields.clear();
+
+	flatten_type(schema, type, 0, FNV_OFFSET_BASIS, 0);
+
+	schema.hash = hash_fields(schema);
+}
+
+const SchemaField* find_schema_field(const Schema& schema, u64 id) {
+	for (const SchemaField& field : schema.fields) {
+		if (field.id == id) return &field;
+	}
+	return nullptr;
+}
+
+void make_MigrationPlan(MigrationPlan& plan, const Schema& from, const Schema& to) {
+	plan.src_size = from.size;
+	plan.dst_size = to.size;
+	plan.identity = from.hash == to.hash && from.size == to.size;
+	plan.dropped.clear();
+	plan.copies.clear();
+
+	if (plan.identity) return;
+
+	for (const SchemaField& src : from.fields) {
+		const SchemaField* dst = find_schema_field(to, src.id);
+		if (!dst || dst->kind != src.kind || dst->size != src.size) {
+			if (src.destroy != DestroyKind::None) plan.dropped.append(src);
+			continue;
+		}
+
+		if (plan.copies.length > 0) {
+			MigrationCopy& last = plan.copies.last();
+			if (last.src_offset + last.size == src.offset && last.dst_offset + last.size == dst->offset) {
+				last.size += src.size;
+				continue;
+			}
+		}
+
+		plan.copies.append({ src.offset, dst->offset, src.size });
+	}
+}
+
+//A constant size lets the compiler turn the copies into plain loads and stores
+template<uint N>
+void copy_strided(u8* dst, uint dst_stride, const u8* src, uint src_stride, uint count) {
+	for (uint i = 0; i < count; i++) memcpy(dst + i * dst_stride, src + i * src_stride, N);
+}
+
+void migrate_column(const MigrationPlan& plan, u8* dst, const u8* src, uint count) {
+	if (plan.identity) {
+		memcpy(dst, src, (u64)plan.src_size * count);
+		return;
+	}
+
+	uint src_stride = plan.src_size;
+	uint dst_stride = plan.dst_size;
+
+	for (const MigrationCopy& copy : plan.copies) {
+		u8* dst_field = dst + copy.dst_offset;
+		const u8* src_field = src + copy.src_offset;
+
+		switch (copy.size) {
+		case 4: copy_strided<4>(dst_field, dst_stride, src_field, src_stride, count); break;
+		case 8: copy_strided<8>(dst_field, dst_stride, src_field, src_stride, count); break;
+		case 12: copy_strided<12>(dst_field, dst_stride, src_field, src_stride, count); break;
+		case 16: copy_strided<16>(dst_field, dst_stride, src_field, src_stride, count); break;
+		default:
+			for (uint i = 0; i < count; i++) memcpy(dst_field + i * dst_stride, src_field + i * src_stride, copy.size);
+		}
+	}
+}
+
+void destroy_dropped_fields(const MigrationPlan& plan, u8* src, uint count) {
+	for (const SchemaField& field : plan.dropped) {
+		for (uint i = 0; i < count; i++) {
+			u8* ptr = src + (u64)i * plan.src_size + field.offset;
+
+			//the element type is unknown, but the storage is laid out the same for any of them
+			if (field.destroy == DestroyKind::Array) ((vector<u8>*)ptr)->~vector();
+			if (field.destroy == DestroyKind::StringBuffer) ((string_buffer*)ptr)->~string_buffer();
+		}
+	}
+}
+
+void take_migrated_fields(const MigrationPlan& plan, u8* taken, const u8* dst, uint count) {
+	uint stride = plan.dst_size;
+	memset(taken, 0, (u64)stride * count);
+
+	for (const MigrationCopy& copy : plan.copies) {
+		for (uint i = 0; i < count; i++) {
+			uint offset = i * stride + copy.dst_offset;
+			memcpy(taken + offset, dst + offset, copy.size);
+		}
+	}
+}
+
+void write_Schema_to_buffer(SerializerBuffer& buffer, const Schema& schema) {
+	write_n_to_buffer(buffer, &schema.name, sizeof(sstring));
+	write_uint_to_buffer(buffer, schema.size);
+	write_u64_to_buffer(buffer, schema.hash);
+	write_uint_to_buffer(buffer, schema.fields.length);
+	write_n_to_buffer(buffer, schema.fields.data, sizeof(SchemaField) * schema.fields.length);
+}
+
+void read_Schema_from_buffer(DeserializerBuffer& buffer, Schema& schema) {
+	uint count = 0;
+
+	read_n_from_buffer(buffer, &schema.name, sizeof(sstring));
+	read_uint_from_buffer(buffer, schema.size);
+	read_u64_from_buffer(buffer, schema.hash);
+	read_uint_from_buffer(buffer, count);
+
+	if (buffer.overflow) count = 0;
+
+	schema.fields.resize(count);
+	read_n_from_buffer(buffer, schema.fields.data, sizeof(SchemaField) * count);
+}
+
+}
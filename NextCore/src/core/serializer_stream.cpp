@@ -0,0 +1,209 @@
+#include "stdafx.h"
+#include "core/serializer.h"
+#include "core/io/lz4.h"
+#include <limits.h>
+
+void write_to_sink(SerializerSink& sink, const void* data, u64 size) {
+	if (fwrite(data, sizeof(char), size, sink.file) != size) sink.failed = true;
+}
+
+void flush_chunk(SerializerBuffer& buffer) {
+	SerializerSink& sink = *buffer.sink;
+	if (buffer.index == 0) return;
+
+	if (sink.compress) {
+		SerializerBlock block;
+		block.size = buffer.index;
+		block.stored_size = lz4_compress(buffer.data, buffer.index, sink.compressed);
+
+		const char* stored = sink.compressed;
+		if (block.stored_size >= block.size) {
+			block.stored_size = block.size;
+			stored = buffer.data;
+		}
+
+		write_to_sink(sink, &block, sizeof(SerializerBlock));
+		write_to_sink(sink, stored, block.stored_size);
+	}
+	else {
+		write_to_sink(sink, buffer.data, buffer.index);
+	}
+
+	buffer.index = 0;
+}
+
+void grow_buffer(SerializerBuffer& buffer, u64 size) {
+	u64 capacity = buffer.capacity > 0 ? buffer.capacity : SERIALIZER_CHUNK_SIZE;
+	while (capacity < buffer.index + size) capacity *= 2;
+	assert(capacity <= UINT_MAX); //beyond 4gb the buffer has to stream to a sink
+
+	char* data = (char*)buffer.allocator->allocate(capacity);
+	if (buffer.data) {
+		memcpy(data, buffer.data, buffer.index);
+		buffer.allocator->deallocate(buffer.data);
+	}
+
+	buffer.data = data;
+	buffer.capacity = capacity;
+}
+
+void write_n_to_buffer_slow(SerializerBuffer& buffer, const void* ptr, u64 size) {
+	if (buffer.sink) {
+		const char* input = (const char*)ptr;
+
+		while (size > 0) {
+			if (buffer.index == buffer.capacity) flush_chunk(buffer);
+
+			u64 copy = buffer.capacity - buffer.index;
+			if (copy > size) copy = size;
+
+			memcpy(buffer.data + buffer.index, input, copy);
+			buffer.index += copy;
+			input += copy;
+			size -= copy;
+		}
+		return;
+	}
+
+	if (buffer.allocator) {
+		grow_buffer(buffer, size);
+		memcpy(buffer.data + buffer.index, ptr, size);
+		buffer.index += size;
+		return;
+	}
+
+	//fixed capacity, the caller checks overflow once it is done writing
+	buffer.overflow = true;
+}
+
+//Returns false at the end of the file, or when a block is corrupt
+bool refill_buffer(DeserializerBuffer& buffer) {
+	DeserializerSource& source = *buffer.source;
+	buffer.index = 0;
+	buffer.length = 0;
+
+	if (!source.compressed) {
+		buffer.length = fread(buffer.data, sizeof(char), SERIALIZER_CHUNK_SIZE, source.file);
+		return buffer.length > 0;
+	}
+
+	SerializerBlock block;
+	if (fread(&block, sizeof(SerializerBlock), 1, source.file) != 1) return false;
+	if (block.size > SERIALIZER_CHUNK_SIZE || block.stored_size > block.size) return false;
+
+	if (block.stored_size == block.size) {
+		if (fread(buffer.data, sizeof(char), block.size, source.file) != block.size) return false;
+	}
+	else {
+		if (fread(source.stored, sizeof(char), block.stored_size, source.file) != block.stored_size) return false;
+		if (!lz4_decompress(source.stored, block.stored_size, buffer.data, block.size)) return false;
+	}
+
+	buffer.length = block.size;
+	return true;
+}
+
+void read_n_from_buffer_slow(DeserializerBuffer& buffer, void* ptr, u64 size) {
+	char* output = (char*)ptr;
+
+	while (size > 0) {
+		bool empty = buffer.index >= buffer.length;
+		if (empty && !(buffer.source && refill_buffer(buffer))) {
+			memset(output, 0, size);
+			buffer.overflow = true;
+			return;
+		}
+
+		u64 copy = buffer.length - buffer.index;
+		if (copy > size) copy = size;
+
+		memcpy(output, buffer.data + buffer.index, copy);
+		buffer.index += copy;
+		output += copy;
+		size -= copy;
+	}
+}
+
+bool open_file_sink(SerializerBuffer& buffer, SerializerSink& sink, const char* path, bool compress) {
+	FILE* file = fopen(path, "wb");
+	if (!file) return false;
+
+	setvbuf(file, nullptr, _IONBF, 0); //the chunk already buffers
+
+	sink = {};
+	sink.file = file;
+	sink.compress = compress;
+	if (compress) sink.compressed = (char*)default_allocator.allocate(lz4_compress_bound(SERIALIZER_CHUNK_SIZE));
+
+	buffer = {};
+	buffer.data = (char*)default_allocator.allocate(SERIALIZER_CHUNK_SIZE);
+	buffer.capacity = SERIALIZER_CHUNK_SIZE;
+	buffer.sink = &sink;
+
+	SerializerStreamHeader header = { SERIALIZER_STREAM_MAGIC, compress };
+	if (compress) write_to_sink(sink, &header, sizeof(SerializerStreamHeader));
+	else write_n_to_buffer(buffer, &header, sizeof(SerializerStreamHeader)); //part of the first chunk, so later writes stay aligned
+
+	return true;
+}
+
+bool close_file_sink(SerializerBuffer& buffer) {
+	SerializerSink& sink = *buffer.sink;
+
+	flush_chunk(buffer);
+	if (fclose(sink.file) != 0) sink.failed = true;
+
+	default_allocator.deallocate(buffer.data);
+	if (sink.compressed) default_allocator.deallocate(sink.compressed);
+
+	bool written = !sink.failed;
+	sink = {};
+	buffer = {};
+
+	return written;
+}
+
+bool open_file_source(DeserializerBuffer& buffer, DeserializerSource& source, const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (!file) return false;
+
+	setvbuf(file, nullptr, _IONBF, 0);
+
+	source = {};
+	source.file = file;
+
+	buffer = {};
+	buffer.data = (char*)default_allocator.allocate(SERIALIZER_CHUNK_SIZE);
+	buffer.source = &source;
+	buffer.length = fread(buffer.data, sizeof(char), SERIALIZER_CHUNK_SIZE, file);
+
+	SerializerStreamHeader header = {};
+	if (buffer.length >= sizeof(SerializerStreamHeader)) memcpy(&header, buffer.data, sizeof(SerializerStreamHeader));
+
+	if (header.magic != SERIALIZER_STREAM_MAGIC) return true; //written before streams, read as it is
+
+	if (!header.compressed) {
+		buffer.index = sizeof(SerializerStreamHeader);
+		return true;
+	}
+
+	source.compressed = true;
+	source.stored = (char*)default_allocator.allocate(lz4_compress_bound(SERIALIZER_CHUNK_SIZE));
+
+	fseek(file, sizeof(SerializerStreamHeader), SEEK_SET);
+	buffer.length = 0;
+
+	return true;
+}
+
+void close_file_source(DeserializerBuffer& buffer) {
+	DeserializerSource& source = *buffer.source;
+
+	fclose(source.file);
+
+	default_allocator.deallocate(buffer.data);
+	if (source.stored) default_allocator.deallocate(source.stored);
+
+	source = {};
+	buffer = {};
+}
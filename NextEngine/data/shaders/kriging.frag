@@ -1,14 +1,14 @@
 layout (location = 0) out vec4 FragColor;
 
-#define MAX_MATRIX_N 12
+#define MAX_POINTS 512
 
 layout (std140, set = 0, binding = 0) uniform KrigingUBO {
     float a; // (sill - nugget)
     float b; // (-3.0f / range)
     int N;
+    float mean;
 
-    vec4 positions[MAX_MATRIX_N];
-    vec4 c1[MAX_MATRIX_N * MAX_MATRIX_N / 4];
+    vec4 positions[MAX_POINTS]; // xy position, z height, w weight
 };
 
 float cov(float h) {
@@ -16,29 +16,13 @@ float cov(float h) {
 }
 
 void main() {
-    int N_POINTS = N - 1;
     vec2 pos = vec2(gl_FragCoord);
 
-    float c0[MAX_MATRIX_N];
-    c0[N - 1] = 1;
+    float height = mean;
 
-    for (int i = 0; i < N_POINTS; i++) {
-        c0[i] = cov(length(positions[i].xy - pos));
-    }
-
-    float height = 0.0f;
-
-    for (int i = 0; i < N_POINTS; i++) {
-        float weight = 0.0f;
-
-        for (int j = 0; j < N; j++) {
-            int index = i*N + j;
-            weight += c1[index / 4][index % 4] * c0[j];
-        }
-
-        height += weight * positions[i].z;
+    for (int i = 0; i < N; i++) {
+        height += positions[i].w * cov(length(positions[i].xy - pos));
     }
     
     FragColor = vec4(height, 0, 0, 1);
 }
-
@@ -71,9 +71,9 @@ void main()
     vec2 tex_coords = parallax_uv(TexCoords, transpose(TBN) * viewDir);
 
     // properties
-    vec3 norm = texture(normal, tex_coords).rgb;
-	norm = norm * 2.0 - 1.0;
-    norm = normalize(norm);
+    vec3 norm;
+	norm.xy = texture(normal, tex_coords).rg * 2.0 - 1.0;
+	norm.z = sqrt(max(1.0 - dot(norm.xy, norm.xy), 0.0));
 	norm = normalize(TBN * norm);
 
 	FragColor = pbr_frag(
@@ -171,8 +171,8 @@ vec3 calc_point_light(int index, vec3 N, vec3 WorldPos, vec3 V)
 }
 
 vec3 calc_normals_from_tangent(vec3 norm) {
-	norm = norm * 2.0 - 1.0;
-	norm = normalize(norm);
+	norm.xy = norm.xy * 2.0 - 1.0;
+	norm.z = sqrt(max(1.0 - dot(norm.xy, norm.xy), 0.0));
 	norm = normalize(TBN * norm);
 
 	return norm;
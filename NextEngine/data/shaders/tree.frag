@@ -41,8 +41,9 @@ void main()
 	albedo = pow(albedo, vec3(2.2));
 
     // properties
-    vec3 norm = texture(normal, TexCoords).rgb;
-	norm = normalize(norm * 2.0 - 1.0);
+    vec3 norm;
+	norm.xy = texture(normal, TexCoords).rg * 2.0 - 1.0;
+	norm.z = sqrt(max(1.0 - dot(norm.xy, norm.xy), 0.0));
 
 	if (!gl_FrontFacing) norm.y = -norm.y; 
 	norm = normalize(TBN * norm);
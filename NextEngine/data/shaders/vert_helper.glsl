@@ -46,9 +46,10 @@ mat3 make_TBN(mat4 model, vec3 n, vec3 t, vec3 b) {
 }
 #endif
 
+//Normal maps are cooked to BC5 which only stores xy, z is reconstructed
 vec3 normal_from_texture(mat3 TBN, vec3 norm) {
-    norm = norm * 2.0 - 1.0;
-    norm = normalize(norm);
+    norm.xy = norm.xy * 2.0 - 1.0;
+    norm.z = sqrt(max(1.0 - dot(norm.xy, norm.xy), 0.0));
     //norm.y = -norm.y;
     return normalize(TBN * norm);
 }
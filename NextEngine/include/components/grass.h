@@ -3,6 +3,17 @@
 #include "engine/handle.h"
 #include "transform.h"
 #include "core/container/vector.h"
+#include "core/math/aabb.h"
+
+const float GRASS_CELL_SIZE = 16.0f;
+
+//Range of instances which lie in the same GRASS_CELL_SIZE x GRASS_CELL_SIZE column,
+//aabb is in world space and already includes the extent of the placement model
+struct GrassCell {
+	AABB aabb;
+	uint offset;
+	uint count;
+};
 
 COMP
 struct Grass {
@@ -18,7 +29,33 @@ struct Grass {
 	float random_scale = 1.0f;
 	bool align_to_terrain_normal = false;
 
+	//Instances are stored compressed and sorted by cell,
+	//the model matrix is only expanded for visible instances
+	vector<float> position_x;
+	vector<float> position_y;
+	vector<float> position_z;
+	vector<float> rotation;
+	vector<float> scale;
+
+	REFL_FALSE vector<GrassCell> cells;
+	REFL_FALSE model_handle cells_built_for = { INVALID_HANDLE };
+};
+
+inline glm::mat4 grass_model_matrix(const Grass& grass, uint i) {
+	float s = grass.scale[i];
+	float c = cosf(grass.rotation[i]) * s;
+	float n = sinf(grass.rotation[i]) * s;
+
+	//rotation around the y axis followed by uniform scale
+	glm::mat4 model_m;
+	model_m[0] = glm::vec4(c, 0, -n, 0);
+	model_m[1] = glm::vec4(0, s, 0, 0);
+	model_m[2] = glm::vec4(n, 0, c, 0);
+	model_m[3] = glm::vec4(grass.position_x[i], grass.position_y[i], grass.position_z[i], 1);
+	return model_m;
+}
 
-	vector<glm::vec3 > positions;
-	vector<glm::mat4> model_m;
-};
\ No newline at end of file
+ENGINE_API void clear_grass_instances(Grass& grass);
+ENGINE_API void add_grass_instance(Grass& grass, glm::vec3 position, float rotation, float scale);
+//Sorts the instances into cells and computes the world space bounds of each cell
+ENGINE_API void build_grass_cells(Grass& grass, const AABB& model_aabb);
@@ -4,6 +4,7 @@
 #include "engine/handle.h"
 #include "core/container/sstring.h"
 #include "core/container/vector.h"
+#include "core/math/aabb.h"
 #include <glm/glm.hpp>
 
 COMP
@@ -43,6 +44,16 @@ inline uint pack_float_rgb(float r, float g, float b, float a) {
 
 const uint TERRAIN_RESOLUTION = 32;
 
+//Node of the chunk quadtree, aabb is relative to the terrain position
+//and bounds the displacement of every chunk below it
+struct TerrainQuadNode {
+	AABB aabb;
+	u16 x;
+	u16 y;
+	u16 size;
+	uint children[4];
+};
+
 COMP
 struct Terrain {
 	uint width = 12;
@@ -55,6 +66,9 @@ struct Terrain {
 	REFL_FALSE vector<uint> blend_idx_map;
 	REFL_FALSE vector<uint> blend_values_map;
 
+	REFL_FALSE vector<TerrainQuadNode> quadtree;
+	REFL_FALSE vector<glm::vec2> chunk_heights;
+
 	float max_height = 50.0f;
 
 	vector<TerrainMaterial> materials;
@@ -9,6 +9,7 @@
 #include "core/container/tvector.h"
 #include "core/container/array.h"
 #include "core/container/slice.h"
+#include "core/schema.h"
 
 COMP
 struct Entity {
@@ -129,6 +130,7 @@ struct World {
 	hash_map<Archetype, ArchetypeStore, ARCHETYPE_HASH> arches;
 
 	refl::Struct* component_type[MAX_COMPONENTS] = {};
+	refl::Schema component_schema[MAX_COMPONENTS]; //kept when the library with the type is reloaded, to migrate its components
 	u64 component_size[MAX_COMPONENTS] = {};
 	ComponentLifetimeFunc component_lifetime_funcs[MAX_COMPONENTS] = {};
 	ComponentKind component_kind[MAX_COMPONENTS] = {};
@@ -150,9 +152,14 @@ struct World {
     
     ENGINE_API void register_components(slice<struct RegisterComponent> components);
     ENGINE_API ID clone(ID id);
+	//Appends count entities whose components are stored in columns at src + src_offsets[component_id],
+	//every column is migrated to the current layout with plans[component_id]
+	ENGINE_API void append_migrated(ArchetypeStore& store, Archetype arch, u8* src, const uint* src_offsets, const refl::MigrationPlan* plans, uint count);
 
 	void clear() {
 		world_memory_offset = 0;
+		block_free_list = NULL;
+		arches.clear();
 	}
 
 	refl::Struct* get_type_for(ComponentPtr ptr) {
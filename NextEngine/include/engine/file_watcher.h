@@ -0,0 +1,28 @@
+#pragma once
+
+#include "engine/core.h"
+#include "core/container/string_buffer.h"
+#include "core/container/string_view.h"
+#include "core/container/vector.h"
+
+//Editors often save through a temporary file or write a file several times,
+//a change is only reported once the file has been quiet for this many seconds
+const double FILE_WATCH_DEBOUNCE = 0.15;
+
+struct FileChange {
+	string_buffer path;
+	double time;
+};
+
+//Recursively watches a directory, with inotify on Linux and ReadDirectoryChangesW on Windows.
+//On other platforms make_FileWatcher fails and callers have to keep polling modification times
+struct FileWatcher {
+	string_buffer directory;
+	vector<FileChange> pending;
+	void* backend = nullptr;
+};
+
+ENGINE_API bool make_FileWatcher(FileWatcher& watcher, string_view directory);
+ENGINE_API void destroy_FileWatcher(FileWatcher& watcher);
+//Never blocks, nothing is read when no file changed. Paths are relative to the directory and use forward slashes
+ENGINE_API void poll_FileWatcher(FileWatcher& watcher, vector<string_buffer>& modified);
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "engine/core.h"
+#include "engine/vfs.h"
+#include "core/container/string_buffer.h"
+#include "core/container/string_view.h"
+#include "core/container/vector.h"
+#include "core/io/lz4.h"
+
+//Every asset of a shipped game in a single file, so startup maps one file instead of opening and stat-ing each asset.
+//Layout: PackHeader, the entry data (16 byte aligned), the PackEntry index sorted by path hash and the path strings.
+//Paths are relative to the asset root they were packed from, as passed to io_readf
+const uint PACK_MAGIC = 'N' | 'E' << 8 | 'P' << 16 | 'K' << 24;
+const uint PACK_VERSION = 1;
+const u64 PACK_ALIGNMENT = 16;
+//Mounted from the level asset directory when it exists
+const char* const ASSET_PACK_FILENAME = "data.pack";
+
+enum class PackCompression : uint { None, LZ4 };
+
+struct PackHeader {
+	uint magic;
+	uint version;
+	uint entry_count;
+	uint strings_size;
+	u64 index_offset;
+	u64 strings_offset;
+};
+
+struct PackEntry {
+	u64 hash;
+	u64 offset;
+	u64 size;
+	u64 stored_size;
+	i64 time_modified;
+	uint path_offset;
+	uint path_length;
+	PackCompression compression;
+	uint padding;
+};
+
+struct Pack {
+	MappedFile file;
+	const PackHeader* header = nullptr;
+	const PackEntry* entries = nullptr;
+	const char* strings = nullptr;
+};
+
+struct PackSource {
+	string_buffer path;
+	string_buffer full_path;
+};
+
+u64 pack_path_hash(string_view path);
+
+ENGINE_API bool open_Pack(Pack& pack, string_view full_path);
+ENGINE_API void close_Pack(Pack& pack);
+//Binary search on the hash, paths with the same hash are compared
+ENGINE_API const PackEntry* pack_find(const Pack& pack, string_view path);
+//Contents of an entry stored without compression, points into the mapping
+ENGINE_API string_view pack_view(const Pack& pack, const PackEntry& entry);
+//Output must hold entry.size bytes
+ENGINE_API bool pack_read(const Pack& pack, const PackEntry& entry, char* output);
+
+//Appends every file below the directory, except packs, with paths relative to it
+ENGINE_API void collect_pack_sources(string_view directory, vector<PackSource>& sources);
+//Entries are compressed with LZ4 when that saves at least an eighth of their size
+ENGINE_API bool write_Pack(string_view full_path, slice<PackSource> sources, bool compress);
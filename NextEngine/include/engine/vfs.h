@@ -21,6 +21,31 @@ ENGINE_API bool io_readf(string_view path, string_buffer* output);
 ENGINE_API bool io_readfb(string_view path, string_buffer* output);
 ENGINE_API bool io_writef(string_view path, string_view contents);
 ENGINE_API bool io_copyf(string_view src, string_view dst, bool fail_if_exists);
+//Atomically replaces dst with src, existing mappings of dst keep reading the old contents on posix
+ENGINE_API bool io_replacef(string_view src, string_view dst);
+
+enum class MappedFileSource : u8 { Mapping, Pack, Allocation };
+
+//Read only view of a whole file, stays valid until io_unmapf
+struct MappedFile {
+	void* data = nullptr;
+	u64 length = 0;
+	void* handle = nullptr;
+	MappedFileSource source = MappedFileSource::Mapping;
+};
+
+//Files stored uncompressed in the mounted pack point into its mapping, compressed ones are decompressed into memory
+ENGINE_API bool io_mapf(string_view path, MappedFile* output);
+ENGINE_API bool io_mapf_full(string_view full_path, MappedFile* output);
+ENGINE_API void io_unmapf(MappedFile& file);
+
+//While a pack is mounted every read looks in it first and only falls back to the loose file when the pack does not contain it.
+//Development builds simply have no pack, writes always go to loose files
+ENGINE_API bool io_mount_pack(string_view full_path);
+ENGINE_API void io_unmount_pack();
+ENGINE_API bool io_pack_mounted();
+//Zero copy view of a file stored uncompressed in the mounted pack, fails for anything else
+ENGINE_API bool io_viewf(string_view path, string_view* output);
 
 ENGINE_API bool path_absolute(string_view path, string_buffer* output);
 
@@ -41,6 +41,7 @@ ENGINE_API extern DefaultMaterials default_materials;
 void make_AssetManager(string_view path, string_view engine_path);
 void destroy_AssetManager();
 
+//Uploads streamed textures that finished loading, see graphics/assets/texture_streaming.h
 ENGINE_API void load_assets_in_queue();
 
 ENGINE_API model_handle load_Model(string_view filename, bool serialized = false, const glm::mat4& matrix = glm::mat4(1.0));
@@ -56,6 +57,10 @@ ENGINE_API bool load_Shader(Shader&, string_buffer&);
 ENGINE_API Shader* get_Shader(shader_handle);
 ENGINE_API bool reload_Shader(shader_handle);
 ENGINE_API bool reload_modified_shaders();
+//Reloads the shaders, textures and models changed on disk, falls back to reload_modified_shaders without a file watcher
+ENGINE_API void reload_modified();
+//Uploads the textures reloaded in the background, called between frames as it waits for the frames in flight
+ENGINE_API void upload_reloaded_textures();
 
 ENGINE_API texture_handle load_Texture(string_view filename, bool serialized = false);
 ENGINE_API void load_Texture(texture_handle handle, string_view filename);
@@ -65,6 +70,8 @@ ENGINE_API Texture* get_Texture(texture_handle handle);
 ENGINE_API Cubemap* get_Cubemap(cubemap_handle handle);
 void ENGINE_API load_TextureBatch(slice<TextureLoadJob> batch);
 
+//Only sets the folders assets are looked up in, for tools that cook assets without a renderer
+ENGINE_API void set_asset_path(string_view path, string_view engine_path);
 ENGINE_API string_buffer tasset_path(string_view filename);
 ENGINE_API string_view current_asset_path_folder();
 bool ENGINE_API asset_path_rel(string_view filename, string_buffer*);
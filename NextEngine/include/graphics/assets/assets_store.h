@@ -7,6 +7,11 @@
 #include "graphics/assets/shader.h"
 #include "graphics/assets/model.h"
 #include "graphics/assets/texture.h"
+#include "graphics/assets/shader_cache.h"
+#include "graphics/assets/texture_streaming.h"
+#include "engine/file_watcher.h"
+#include "core/job_system/job.h"
+#include <glm/mat4x4.hpp>
 #include "graphics/renderer/lighting_system.h"
 
 #ifdef RENDER_API_VULKAN
@@ -27,6 +32,37 @@ struct EquirectangularToCubemapJob {
 	texture_handle env_map;
 };
 
+enum class WatchedAssetType { Texture, Model };
+
+//Loaded from a source file, so it is reloaded when the file changes
+struct WatchedAsset {
+	WatchedAssetType type;
+	string_buffer path;
+	uint handle;
+	glm::mat4 transform;
+};
+
+void watch_asset(WatchedAssetType type, string_view path, uint handle, const glm::mat4& transform = glm::mat4(1.0f));
+
+struct TextureReloadJob {
+	texture_handle handle;
+	string_buffer path;
+	CookedTexture texture;
+	bool loaded;
+};
+
+struct AssetReloader {
+	//the level and the engine assets
+	FileWatcher watchers[2];
+	uint watcher_count = 0;
+	vector<WatchedAsset> watched;
+
+	//a new batch of textures is only started once the last one was uploaded
+	vector<TextureReloadJob> queued_textures;
+	vector<TextureReloadJob> reloading_textures;
+	atomic_counter texture_counter;
+};
+
 struct Assets {
 	//struct ShaderCompiler* shader_compiler;
 	//struct VertexStreaming* buffer_allocator;
@@ -47,6 +83,9 @@ struct Assets {
 	queue<EquirectangularToCubemapJob, 5> equirectangular_to_cubemap_jobs;
 
 	CubemapPassResources* cubemap_pass_resources;
+	ShaderCache shader_cache;
+	AssetReloader reloader;
+	TextureStreamer streamer;
 };
 
 extern Assets assets;
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "graphics/assets/texture.h"
+
+//Encoders for the BC formats, blocks are 4x4 texels and are read from RGBA8 input.
+//Texels past the edge of the image are clamped to the last row and column
+
+//Opaque, color endpoints along the principal axis refined with a least squares fit
+ENGINE_API void encode_bc1_block(const u8 rgba[64], u8 output[8]);
+//Single channel, values are read with a stride so one channel of RGBA can be encoded
+ENGINE_API void encode_bc4_block(const u8* values, uint stride, u8 output[8]);
+//BC4 alpha followed by BC1 color
+ENGINE_API void encode_bc3_block(const u8 rgba[64], u8 output[16]);
+//BC4 of the red channel followed by BC4 of the green channel
+ENGINE_API void encode_bc5_block(const u8 rgba[64], u8 output[16]);
+
+//Encodes a whole level in parallel, output is image_level_size of the level
+ENGINE_API void compress_image_level(const u8* rgba, uint width, uint height, TextureFormat format, u8* output);
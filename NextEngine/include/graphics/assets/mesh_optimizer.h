@@ -0,0 +1,61 @@
+#pragma once
+
+#include "graphics/assets/model.h"
+#include "core/container/vector.h"
+#include "core/container/tvector.h"
+
+//Import time index and vertex optimization, run on every mesh after assimp has loaded it.
+//The post transform cache is modelled as a FIFO, which matches most hardware closely enough
+const uint VERTEX_CACHE_SIZE = 16;
+//Clusters whose ACMR is below this fraction of the mesh ACMR can be split off for overdraw sorting
+const float OVERDRAW_ACMR_THRESHOLD = 1.05f;
+
+const uint MESHLET_MAX_VERTICES = 64;
+const uint MESHLET_MAX_TRIANGLES = 124;
+
+//The meshlet can be backface culled when
+//dot(center - camera, cone_axis) >= cone_cutoff * length(center - camera) + radius
+//cone_cutoff is 1 when the triangles face too many directions for the test to ever pass
+struct Meshlet {
+	uint vertex_offset;
+	uint triangle_offset;
+	uint vertex_count;
+	uint triangle_count;
+	glm::vec3 center;
+	float radius;
+	glm::vec3 cone_axis;
+	float cone_cutoff;
+};
+
+//vertices indexes the mesh vertices, triangles holds three u8 indices into the meshlet vertices
+struct MeshletBuffers {
+	vector<Meshlet> meshlets;
+	vector<uint> vertices;
+	vector<u8> triangles;
+};
+
+struct MeshOptimizeStats {
+	uint vertices_before;
+	uint vertices_after;
+	uint triangles;
+	float acmr_before;
+	float acmr_after;
+};
+
+//Merges bitwise identical vertices, returns the new vertex count
+ENGINE_API uint weld_vertices(Vertex* vertices, uint vertex_count, uint* indices, uint index_count);
+//Tipsify, the cluster boundaries it had to introduce are appended to clusters as triangle offsets
+ENGINE_API void optimize_vertex_cache(uint* indices, uint index_count, uint vertex_count, uint cache_size, tvector<uint>* clusters = nullptr);
+//Sorts the clusters so outward facing geometry is drawn first, keeping the cache order within each cluster
+ENGINE_API void optimize_overdraw(uint* indices, uint index_count, const Vertex* vertices, uint vertex_count, slice<uint> clusters, uint cache_size, float threshold);
+//Orders the vertices by first use so the vertex fetch is mostly linear, returns the new vertex count
+ENGINE_API uint optimize_vertex_fetch(Vertex* vertices, uint vertex_count, uint* indices, uint index_count);
+//Average cache miss ratio, the number of vertex shader invocations per triangle
+ENGINE_API float compute_acmr(const uint* indices, uint index_count, uint vertex_count, uint cache_size);
+
+ENGINE_API void build_meshlets(MeshletBuffers& output, const Vertex* vertices, uint vertex_count, const uint* indices, uint index_count);
+
+//Runs every pass on a single lod, vertices and indices are rewritten in place
+ENGINE_API MeshOptimizeStats optimize_mesh(Mesh& mesh, uint lod);
+//Optimizes every mesh and lod of the model in parallel and logs the ACMR before and after
+ENGINE_API void optimize_model_meshes(Model* model);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "graphics/assets/model.h"
+
+//Models without hand authored _lodN files get a generated chain when they are imported
+const uint GENERATED_LOD_COUNT = 4;
+//Triangle count of each lod relative to the one before it
+const float GENERATED_LOD_RATIO = 0.5f;
+//A lod that keeps more of the triangles of the one before it than this ends the chain
+const float GENERATED_LOD_MIN_SHRINK = 0.9f;
+//Largest deviation a collapse may introduce, relative to the size of the mesh
+const float GENERATED_LOD_MAX_ERROR = 0.02f;
+
+//Quadric error metric simplification by edge collapse. Vertices are collapsed onto one of their
+//neighbours rather than moved, so the output indexes the same vertices as the input.
+//Vertices on a UV seam or on the border of the mesh, which is where meshes of different materials meet, are never removed.
+//Returns the new index count, the error reached relative to the mesh size is written to result_error
+ENGINE_API uint simplify_mesh(uint* output, const uint* indices, uint index_count, const Vertex* vertices, uint vertex_count, uint target_index_count, float target_error, float* result_error = nullptr);
+
+//Fills up to lods 1 to lod_count - 1 of every mesh by simplifying lod 0, each mesh in its own job.
+//A mesh stops at the first lod the simplifier can not shrink, returns the most lods any mesh got
+ENGINE_API uint generate_model_lods(Model* model, uint lod_count, float ratio, float max_error);
@@ -7,6 +7,7 @@
 #include "engine/handle.h"
 #include "graphics/rhi/buffer.h"
 #include "core/math/aabb.h"
+#include "engine/vfs.h"
 #include <glm/vec3.hpp>
 #include <glm/vec2.hpp>
 
@@ -20,6 +21,15 @@ struct Vertex {
 	glm::vec3 bitangent;
 };
 
+//Compact encoding of Vertex, 20 instead of 56 bytes, see vertex_compression.h
+struct CompactVertex {
+	u16 position[3]; //unorm, relative to the quantization bounds of the mesh
+	int16_t bitangent_sign; //bitangent = cross(normal, tangent) * sign
+	int16_t normal[2]; //octahedral, snorm
+	int16_t tangent[2]; //octahedral, snorm
+	u16 tex_coord[2]; //half float
+};
+
 using MeshFlags = uint;
 const MeshFlags MESH_WITH_NO_UVS = 1 << 0;
 
@@ -28,6 +38,9 @@ struct Mesh {
 	VertexBuffer buffer[MAX_MESH_LOD];
 	slice<Vertex> vertices[MAX_MESH_LOD];
 	slice<uint> indices[MAX_MESH_LOD];
+	//meshes loaded from compact cooked models keep only these, vertices is empty
+	slice<CompactVertex> compact_vertices[MAX_MESH_LOD];
+	AABB quantization_aabb;
 	AABB aabb;
 	uint material_id;
 	MeshFlags flags;
@@ -38,6 +51,7 @@ struct Model {
 	array<MAX_MESH_LOD, float> lod_distance;
 	slice<sstring> materials;
 	AABB aabb;
+	MappedFile file; //the cooked model the mesh slices point into, unmapped when the model is replaced
 };
 
 COMP
@@ -51,4 +65,22 @@ struct VertexStreaming;
 struct Assets;
 
 VertexBuffer get_vertex_buffer(model_handle model, uint index, uint lod = 0);
-void load_assimp(Model* model, string_view real_path, const glm::mat4& apply_transform);
\ No newline at end of file
+void load_assimp(Model* model, string_view real_path, const glm::mat4& apply_transform);
+void upload_model_buffers(Model* model);
+void assign_lod_distances(Model* model, uint lod_count);
+
+//Cooked models are the processed vertices, indices and lod tables in a page aligned blob,
+//loading maps the file and points the mesh slices straight into it.
+//Paths are relative to the asset folder, the cooked model is stale once the source is modified.
+//AssetPacker -m cooks every model ahead of time, otherwise load_Model writes the cooked model the first time it imports the source
+const uint COOKED_MODEL_VERSION = 5;
+
+enum CookedVertexFormat {
+	COOKED_VERTEX_FULL,
+	COOKED_VERTEX_COMPACT,
+};
+
+ENGINE_API bool save_cooked_model(const Model& model, string_view cooked_path, i64 source_time_modified, const glm::mat4& apply_transform, CookedVertexFormat format = COOKED_VERTEX_COMPACT);
+ENGINE_API bool load_cooked_model(Model* model, string_view cooked_path, i64 source_time_modified, const glm::mat4& apply_transform);
+//Imports the model from the source file and writes the cooked model next to it
+ENGINE_API bool cook_model(string_view path, const glm::mat4& apply_transform);
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "engine/core.h"
+#include "core/container/vector.h"
+#include "core/container/string_view.h"
+#include "graphics/assets/shader.h"
+#include "graphics/rhi/shader_access.h"
+
+//SPIR-V of every compiled permutation, packed into the single archive shaders/cache/spirv.cache.
+//The key hashes the preprocessed source, which has every #include inlined and the flags expanded,
+//together with the stage, the SPIR-V version and the Vulkan SDK shaderc was linked from, so a change to any of them misses.
+//Bump the version when shaderc is updated without updating the SDK
+const uint SHADER_CACHE_VERSION = 2;
+
+struct ShaderCacheEntry {
+	u64 key;
+	uint offset;
+	uint length;
+};
+
+struct ShaderCache {
+	vector<ShaderCacheEntry> entries;
+	vector<char> spirv;
+	bool loaded = false;
+	bool dirty = false;
+};
+
+u64 shader_cache_key(string_view preprocessed, Stage stage, shader_flags flags);
+//Reads the archive the first time it is called
+void load_ShaderCache(ShaderCache& cache);
+//Only writes the archive when entries were added since it was last written
+bool save_ShaderCache(ShaderCache& cache);
+//Safe to call from several jobs at once, the view is invalidated by the next insert
+bool shader_cache_lookup(const ShaderCache& cache, u64 key, string_view* spirv);
+void shader_cache_insert(ShaderCache& cache, u64 key, string_view spirv);
@@ -5,6 +5,7 @@
 #include "core/container/string_buffer.h"
 #include "core/container/handle_manager.h"
 #include "core/reflection.h"
+#include "engine/vfs.h"
 
 struct Level;
 
@@ -14,7 +15,8 @@ using TextureID = uint;
 //todo these need to be revised
 
 
-enum class TextureFormat { UNORM, SRGB, HDR, U8 };
+//HALF is a 16 bit float per channel, the BC formats are 4x4 blocks and ignore num_channels
+enum class TextureFormat { UNORM, SRGB, HDR, U8, HALF, BC1, BC3, BC5 };
 enum class Filter { Nearest, Linear };
 enum class Wrap { ClampToBorder, Repeat };
 enum class TextureLayout { Undefined, ColorAttachmentOptimal, TransferSrcOptimal, TransferDstOptimal, ShaderReadOptimal };
@@ -41,10 +43,13 @@ struct TextureDesc {
 	uint num_mips = 1;
 };
 
+//Mips are stored after the base level in the same allocation, every level tightly packed
 struct Image : TextureDesc {
 	void* data;
 };
 
+enum class MipFilter { Box, Kaiser };
+
 struct SamplerDesc {
 	Filter min_filter = Filter::Nearest;
 	Filter mag_filter = Filter::Nearest;
@@ -83,8 +88,45 @@ struct ImageOffset {
 ENGINE_API void blit_image(struct CommandBuffer& cmd_buffer, Filter filter, texture_handle src, ImageOffset src_region[2], texture_handle dst, ImageOffset dst_region[2]);
 ENGINE_API void transition_layout(struct CommandBuffer& cmd_buffer, texture_handle, TextureLayout from, TextureLayout to);
 
-ENGINE_API Image load_Image(string_view, bool reverse=false);
+ENGINE_API Image load_Image(string_view, bool reverse=false, uint num_channels=4);
+//Does not throw and does not touch the global flip setting of stb, so it can be called from jobs
+ENGINE_API bool decode_Image(string_view filename, Image* image, uint num_channels=4);
 ENGINE_API void free_Image(Image& image);
+
+ENGINE_API uint texel_size(TextureFormat format);
+ENGINE_API bool is_block_compressed(TextureFormat format);
+//Bytes per 4x4 block
+ENGINE_API uint block_size(TextureFormat format);
+ENGINE_API u64 image_level_size(const TextureDesc& desc, uint mip);
+ENGINE_API uint max_mip_count(uint width, uint height);
+ENGINE_API u64 image_level_offset(const TextureDesc& desc, uint mip);
+ENGINE_API u64 image_data_size(const TextureDesc& desc);
+//Grows the allocation to hold the full mip chain and fills it in
+ENGINE_API void generate_mips(Image& image, MipFilter filter);
+//Cooked textures hold the final GPU format with every mip, so loading is a single mapped read.
+//Albedo is BC3 when it has alpha and BC1 otherwise, masks are BC1, normals keep xy in BC5 and HDR is RGBA16F.
+//Paths are relative to the asset folder, the cooked texture is written next to the source as <path>.cooked
+const uint COOKED_TEXTURE_VERSION = 1;
+
+enum class TextureCookUsage { Albedo, Normal, Mask, HDR };
+
+//image.data points into the mapped file
+struct CookedTexture {
+	Image image;
+	TextureCookUsage usage;
+	MappedFile file;
+};
+
+//Guesses the usage from the file name, e.g. wood_normal.png or metal_roughness.jpg
+ENGINE_API TextureCookUsage texture_usage_from_path(string_view path);
+//Decodes the source, generates the mips and writes the compressed levels. Does not throw, so it can be called from jobs
+ENGINE_API bool cook_texture(string_view path, TextureCookUsage usage);
+//Fails when the cooked texture is missing or the source changed since, a source that is not shipped is not checked
+ENGINE_API bool load_cooked_texture(string_view path, CookedTexture* output);
+//Cooks the texture first when there is no valid cooked texture
+ENGINE_API bool load_texture_cached(string_view path, TextureCookUsage usage, CookedTexture* output);
+ENGINE_API void free_cooked_texture(CookedTexture& texture);
+
 ENGINE_API texture_handle upload_Texture(const Image& image, bool serialized=false);
 ENGINE_API u64 underlying_texture(texture_handle handle);
 ENGINE_API TextureDesc* texture_desc(texture_handle handle);
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "engine/core.h"
+#include "engine/handle.h"
+#include "core/container/vector.h"
+#include "core/container/sstring.h"
+#include "core/container/string_view.h"
+#include "core/job_system/job.h"
+#include "graphics/assets/texture.h"
+
+#ifdef RENDER_API_VULKAN
+#include "graphics/rhi/vulkan/texture.h"
+#endif
+
+//Textures requested with stream_Texture are bound to a placeholder at once and cooked and loaded in background jobs.
+//The most urgent requests are loaded first and the uploads are spread over frames, materials using a texture are
+//rebuilt once it becomes resident. To stay within the budget the textures that were not requested for the longest
+//time are queued to lose their highest mip, until that frees the memory a texture that does not fit is uploaded at a lower resolution
+const u64 DEFAULT_TEXTURE_STREAMING_BUDGET = mb(512);
+const u64 TEXTURE_STREAMING_UPLOAD_PER_FRAME = mb(16);
+const uint TEXTURE_STREAMING_BATCH = 8;
+//A texture is only evicted when it was not requested for this many frames
+const uint TEXTURE_STREAMING_EVICT_AFTER = 120;
+
+enum class StreamState : u8 { Queued, Loading, Resident, Failed };
+
+struct StreamedTexture {
+	texture_handle handle;
+	sstring path;
+	StreamState state;
+	bool placeholder; //the handle still points at a default texture
+	float priority; //the distance to the camera, lower is loaded first
+	uint last_requested_frame;
+	uint requested_mip; //the first mip of the cooked chain to upload, 0 is full resolution
+	uint resident_mip;
+	u64 resident_size;
+	u64 full_size;
+	bool evicting; //queued again to drop its highest mip
+	double request_time;
+};
+
+struct TextureStreamJob {
+	uint index;
+	sstring path;
+	CookedTexture texture;
+	bool loaded;
+	bool uploaded;
+};
+
+struct RetiredTexture {
+	Texture texture;
+	uint frame;
+};
+
+struct TextureStreamingStats {
+	uint requested;
+	uint completed;
+	uint failed;
+	uint evicted;
+	uint queued;
+	u64 resident_size;
+	u64 budget;
+	double average_latency; //seconds from the request until the texture was resident
+	double max_latency;
+};
+
+struct TextureStreamer {
+	vector<StreamedTexture> textures;
+	vector<uint> index_of_handle; //by texture handle id, ~0u when not streamed
+	vector<RetiredTexture> retired;
+	vector<texture_handle> changed; //materials using them are rebuilt at the end of the frame
+
+	TextureStreamJob jobs[TEXTURE_STREAMING_BATCH];
+	uint job_count = 0;
+	atomic_counter counter;
+
+	u64 budget = DEFAULT_TEXTURE_STREAMING_BUDGET;
+	u64 resident_size = 0;
+	uint frame = 0;
+
+	double total_latency = 0;
+	TextureStreamingStats stats = {};
+};
+
+ENGINE_API texture_handle stream_Texture(string_view path, float priority = 0.0f);
+ENGINE_API void stream_Texture(texture_handle handle, string_view path, float priority = 0.0f);
+//Marks the texture as used this frame, a lower priority makes it load sooner
+ENGINE_API void request_Texture(texture_handle handle, float priority);
+ENGINE_API void request_material_textures(material_handle handle, float priority);
+//False while a texture of the material is still bound to its placeholder, textures that failed to load count as done
+ENGINE_API bool material_textures_resident(material_handle handle);
+//Loads a streamed texture again after its source changed, returns false when the texture is not streamed
+bool restream_Texture(texture_handle handle);
+ENGINE_API void set_texture_streaming_budget(u64 budget);
+ENGINE_API TextureStreamingStats texture_streaming_stats();
+
+//Uploads the textures that finished loading and starts the next batch, called once a frame after the frame fence was waited on
+void update_TextureStreamer(TextureStreamer& streamer);
+void destroy_TextureStreamer(TextureStreamer& streamer);
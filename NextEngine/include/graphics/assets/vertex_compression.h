@@ -0,0 +1,99 @@
+#pragma once
+
+#include "graphics/assets/model.h"
+#include <glm/glm.hpp>
+#include <string.h>
+
+//Positions are quantized to 16 bits relative to the mesh bounds,
+//normals and tangents are octahedral encoded, and the bitangent is reconstructed from its sign
+
+inline u16 float_to_half(float value) {
+	uint bits;
+	memcpy(&bits, &value, sizeof(float));
+
+	uint sign = (bits >> 16) & 0x8000;
+	int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+	uint mantissa = bits & 0x7fffff;
+
+	if (exponent >= 31) return sign | 0x7c00; //overflow to infinity
+	if (exponent <= 0) {
+		if (exponent < -10) return sign; //underflow to zero
+		mantissa = (mantissa | 0x800000) >> (1 - exponent);
+		return sign | ((mantissa + 0x1000) >> 13);
+	}
+
+	//rounding can carry into the exponent, which is still the correct result
+	return sign | (((uint)exponent << 10) + ((mantissa + 0x1000) >> 13));
+}
+
+inline float half_to_float(u16 value) {
+	uint sign = (uint)(value & 0x8000) << 16;
+	uint exponent = (value >> 10) & 0x1f;
+	uint mantissa = value & 0x3ff;
+	uint bits;
+
+	if (exponent == 0) {
+		if (mantissa == 0) bits = sign;
+		else {
+			//denormal, normalize it
+			exponent = 1;
+			while (!(mantissa & 0x400)) {
+				mantissa <<= 1;
+				exponent--;
+			}
+			mantissa &= 0x3ff;
+			bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+		}
+	}
+	else if (exponent == 31) bits = sign | 0x7f800000 | (mantissa << 13);
+	else bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+
+	float result;
+	memcpy(&result, &bits, sizeof(float));
+	return result;
+}
+
+inline int16_t float_to_snorm16(float value) {
+	return (int16_t)roundf(glm::clamp(value, -1.0f, 1.0f) * 32767.0f);
+}
+
+inline float snorm16_to_float(int16_t value) {
+	return glm::max(value / 32767.0f, -1.0f);
+}
+
+inline glm::vec2 sign_not_zero(glm::vec2 v) {
+	return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+//Projects the unit vector onto the octahedron and folds the lower half over the upper
+inline glm::vec2 octahedral_encode(glm::vec3 n) {
+	float sum = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+	if (sum == 0.0f) return glm::vec2(0.0f);
+
+	glm::vec2 p = glm::vec2(n.x, n.y) / sum;
+	if (n.z < 0.0f) p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * sign_not_zero(p);
+	return p;
+}
+
+inline glm::vec3 octahedral_decode(glm::vec2 p) {
+	glm::vec3 n(p.x, p.y, 1.0f - fabsf(p.x) - fabsf(p.y));
+	if (n.z < 0.0f) {
+		glm::vec2 folded = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * sign_not_zero(glm::vec2(n.x, n.y));
+		n.x = folded.x;
+		n.y = folded.y;
+	}
+	return glm::normalize(n);
+}
+
+inline glm::vec3 decode_compact_position(const CompactVertex& vertex, const AABB& bounds) {
+	glm::vec3 q(vertex.position[0], vertex.position[1], vertex.position[2]);
+	return bounds.min + q / 65535.0f * (bounds.max - bounds.min);
+}
+
+ENGINE_API CompactVertex encode_vertex(const Vertex& vertex, const AABB& bounds);
+ENGINE_API Vertex decode_vertex(const CompactVertex& vertex, const AABB& bounds);
+ENGINE_API void decode_vertices(slice<CompactVertex> vertices, const AABB& bounds, Vertex* output);
+
+//Works for either vertex format, intended for CPU consumers such as physics and picking
+ENGINE_API uint mesh_vertex_count(const Mesh& mesh, uint lod);
+ENGINE_API glm::vec3 mesh_vertex_position(const Mesh& mesh, uint lod, uint index);
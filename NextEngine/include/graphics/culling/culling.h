@@ -4,12 +4,15 @@
 #include "scene_partition.h"
 #include "graphics/renderer/model_rendering.h"
 #include "core/math/aabb.h"
+#include "core/container/vector.h"
 #include "graphics/pass/pass.h"
 
 enum CullResult { INTERSECT, INSIDE, OUTSIDE };
 
 void ENGINE_API extract_planes(Viewport&);
 CullResult ENGINE_API frustum_test(const glm::vec4 planes[6], const AABB& aabb);
+//margin is how far the planes can move before the result can change
+CullResult ENGINE_API frustum_test(const glm::vec4 planes[6], const AABB& aabb, float& margin);
 
 struct World;
 struct ModelRendererSystem;
@@ -22,4 +25,35 @@ void render_debug_bvh(ScenePartition& scene_partition, RenderPass&);
 
 using MeshBuckets = hash_set<MeshBucket, MAX_MESH_BUCKETS>;
 
-void cull_meshes(const ScenePartition& scene_partition, World& world, MeshBuckets& buckets, uint viewport_count, CulledMeshBucket** culled_mesh_bucket, Viewport viewports[], EntityQuery query);
+//Visibility of the static scene partition for one view, persisted across frames.
+//Margins are relative to reference_planes, a node or instance is only retested
+//once the planes have drifted further than its margin.
+struct ViewCullingCache {
+	uint partition_version = 0;
+	bool initialized = false;
+	bool rebase_reference = false;
+	glm::vec4 reference_planes[6];
+	glm::vec4 last_planes[6];
+
+	u8 node_state[MAX_NODES];
+	float node_margin[MAX_NODES];
+	float instance_margin[MAX_MESH_INSTANCES];
+	bool instance_visible[MAX_MESH_INSTANCES];
+	uint instance_slot[MAX_MESH_INSTANCES]; //INVALID_INSTANCE_SLOT when not in its bucket
+
+	//visible instances of each bucket and their model matrices in the same order,
+	//patched from the deltas instead of being gathered again every frame
+	vector<uint> bucket_instances[MAX_MESH_BUCKETS];
+	vector<glm::mat4> bucket_model_m[MAX_MESH_BUCKETS];
+
+	//deltas of the last update
+	tvector<uint> became_visible;
+	tvector<uint> became_hidden;
+};
+
+const uint INVALID_INSTANCE_SLOT = ~0u;
+
+void update_culling_cache(ViewCullingCache& cache, const ScenePartition& partition, const glm::vec4 planes[6]);
+//Moves the instances in the deltas of the last update in or out of the lists of their bucket
+void apply_culling_deltas(ViewCullingCache& cache, const ScenePartition& partition);
+void cull_meshes(const ScenePartition& scene_partition, World& world, MeshBuckets& buckets, uint viewport_count, CulledMeshBucket** culled_mesh_bucket, ViewCullingCache* culling_cache, Viewport viewports[], EntityQuery query);
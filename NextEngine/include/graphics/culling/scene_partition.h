@@ -18,6 +18,7 @@ struct Node {
 struct Partition {
 	std::atomic<int> count = 0;
 	std::atomic<int> node_count = 0;
+	uint version = 0; //incremented on every rebuild, invalidates cached visibility
 	Node nodes[MAX_NODES];
 };
 
@@ -36,13 +36,18 @@ struct MeshBucket {
 };
 
 struct CulledMeshBucket {
-	tvector<glm::mat4> model_m;
+	tvector<glm::mat4> model_m; //dynamic instances
+	slice<glm::mat4> static_model_m; //visible instances of the static ScenePartition, kept by the culling cache
 };
 
 constexpr int MAX_MESH_BUCKETS = 103;
 
+struct ScenePartition;
+
 using MeshBucketCache = hash_set<MeshBucket, MAX_MESH_BUCKETS>;
-void render_meshes(const MeshBucketCache& mesh_buckets, CulledMeshBucket* buckets, RenderPass& ctx);
+void render_meshes(const MeshBucketCache& mesh_buckets, const ScenePartition& partition, CulledMeshBucket* buckets, RenderPass& ctx);
+//Requests the streamed textures of every visible bucket, prioritized by the distance to its closest instance
+void request_visible_textures(const MeshBucketCache& mesh_buckets, const ScenePartition& partition, CulledMeshBucket* buckets, glm::vec3 cam_pos);
 
 inline u64 hash_func(MeshBucket& bucket) {
 	return bucket.mat.id << 20 | bucket.model.id << 8 | bucket.mesh_id << 0;
@@ -14,6 +14,7 @@
 #include "graphics/pass/shadow.h"
 #include "graphics/pass/composite.h"
 #include "graphics/culling/scene_partition.h"
+#include "graphics/culling/culling.h"
 #include <glm/mat4x4.hpp>
 #include <glm/glm.hpp>
 #include "frame.h"
@@ -71,6 +72,7 @@ struct ENGINE_API Renderer {
 
 	ScenePartition scene_partition;
 	MeshBucketCache mesh_buckets;
+	ViewCullingCache culling_cache[RenderPass::ScenePassCount];
 
 	LightingSystem lighting_system;
 	TerrainRenderResources terrain_render_resources;
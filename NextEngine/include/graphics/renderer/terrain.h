@@ -66,6 +66,7 @@ void init_terrain_render_resources(TerrainRenderResources&);
 ENGINE_API void default_terrain(Terrain& terrain);
 ENGINE_API void default_terrain_material(Terrain& terrain);
 ENGINE_API void update_terrain_material(TerrainRenderResources& resources, Terrain& terrain);
+ENGINE_API void build_terrain_quadtree(Terrain& terrain);
 void extract_render_data_terrain(TerrainRenderData& render_data, World& world, const Viewport [RenderPass::ScenePassCount], EntityQuery layermask);
 void render_terrain(TerrainRenderResources& resources, const TerrainRenderData& data, RenderPass render_passes[RenderPass::ScenePassCount]);
 
@@ -131,6 +131,8 @@ ENGINE_API void dealloc_cpu_visible_buffer(CPUVisibleBuffer&);
 ENGINE_API VertexLayout register_vertex_layout(VertexLayoutDesc&);
 
 ENGINE_API VertexBuffer alloc_vertex_buffer(VertexLayout layout, int vertices_length, void* vertices, int indices_length, uint* indices);
+//The range may still be read by frames in flight, so release it through queue_for_destruction
+ENGINE_API void dealloc_vertex_buffer(VertexBuffer&);
 ENGINE_API InstanceBuffer frame_alloc_instance_buffer(InstanceLayout layout, uint length, void** data);
 //UBOBuffer frame_alloc_ubo_buffer(int size);
 ENGINE_API UBOBuffer alloc_ubo_buffer(uint size, UBOUpdateFlags);
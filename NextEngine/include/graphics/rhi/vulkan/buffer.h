@@ -2,6 +2,7 @@
 
 #include "core.h"
 #include "core/container/array.h"
+#include "core/container/vector.h"
 #include "graphics/rhi/buffer.h"
 
 struct VertexStreaming;
@@ -40,6 +41,11 @@ void transfer_queue_dependencies(StagingQueue&, QueueSubmitInfo&, uint transfer_
 using ArrayVertexInputs = array<20, VkVertexInputAttributeDescription>;
 using ArrayVertexBindings = array<2, VkVertexInputBindingDescription>;
 
+struct VertexArenaRange {
+	u64 offset;
+	u64 size;
+};
+
 //todo tommorow optimization performing merging
 //todo VkBuffer can be merged for different Layouts
 struct VertexArena {
@@ -51,6 +57,9 @@ struct VertexArena {
 	u64 index_offset;
 	u64 vertex_offset_start_of_frame;
 	u64 index_offset_start_of_frame;
+	//released by dealloc_vertex_buffer, reused first fit before the arena grows
+	vector<VertexArenaRange> free_vertices;
+	vector<VertexArenaRange> free_indices;
 };
 
 struct LayoutVertexInputs {
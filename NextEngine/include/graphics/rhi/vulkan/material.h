@@ -9,6 +9,7 @@ struct Assets;
 
 struct Material {
 	MaterialPipelineInfo info;
+	MaterialDesc desc; //kept to rebuild the descriptors when a streamed texture changes
 	UBOBuffer ubos[MAX_FRAMES_IN_FLIGHT] = {};
 	descriptor_set_handle sets[MAX_FRAMES_IN_FLIGHT] = {};
 	uint index = 0;
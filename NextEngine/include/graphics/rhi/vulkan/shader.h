@@ -61,10 +61,12 @@ struct ShaderModules {
 	vector<VkDescriptorSetLayout> set_layouts;
 };
 
+const uint MAX_SHADER_CONFIGS = 10;
+
 struct Shader {
 	ShaderInfo info;
-	array<10, shader_flags> config_flags;
-	array<10, ShaderModules> configs;
+	array<MAX_SHADER_CONFIGS, shader_flags> config_flags;
+	array<MAX_SHADER_CONFIGS, ShaderModules> configs;
 	
 	//std::mutex mutex;
 	//Shader() = default;
@@ -77,6 +79,9 @@ struct Assets;
 VkShaderModule make_ShaderModule(string_view code);
 
 //ShaderModules make_ShaderModules(ShaderCompiler&, string_view vert, string_view frag);
-string_buffer compile_glsl_to_spirv(shaderc_compiler_t shader_compiler, Stage stage, string_view source, string_view input_file_name, shader_flags flags, string_buffer* err);
+//Expands the #includes, the material struct and the defines for the stage and flags
+string_buffer preprocess_source(string_view source, Stage stage, shader_flags flags);
+//Expects preprocessed source, a compiler may only be used by one thread at a time
+string_buffer compile_glsl_to_spirv(shaderc_compiler_t shader_compiler, Stage stage, string_view source, string_view input_file_name, string_buffer* err);
 void reflect_module(ShaderModuleInfo& info, string_view vert_spirv, string_view frag_spirv);
 void gen_descriptor_layouts(ShaderModules& shader_modules);
\ No newline at end of file
@@ -31,6 +31,7 @@ struct Cubemap {
 
 struct TextureAllocInfo {
 	uint width, height;
+	uint mips;
 	VkFormat format;
 	VkImage image;
 	TextureAllocInfo* next;
@@ -100,7 +101,13 @@ const VkImageLayout to_vk_layout[5] = { VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYO
 void make_TextureAllocator(TextureAllocator&);
 Texture alloc_TextureImage(TextureAllocator&, const TextureDesc&);
 Texture make_TextureImage(TextureAllocator&, const Image&);
+//Uploads new contents into an existing texture, so descriptors that reference it stay valid.
+//Fails when the size, format or mip count differ
+bool update_TextureImage(TextureAllocator&, Texture&, const Image&);
 void transfer_image_ownership(TextureAllocator&, VkCommandBuffer);
+//The image is returned to the free list and reused by the next texture with the same size, format and mips.
+//It must no longer be in use by frames in flight
+void destroy_TextureImage(TextureAllocator&, Texture&);
 void destroy_TextureAllocator(TextureAllocator&);
 
 void blit_image(VkCommandBuffer cmd_buffer, Filter filter, struct Texture& src, ImageOffset src_region[2], Texture& dst, ImageOffset dst_region[2]);
@@ -112,7 +119,7 @@ using Sampler = VkSampler;
 VkSampler get_Sampler(sampler_handle);
 
 VkSampler make_TextureSampler(const SamplerDesc& sampler_desc);
-VkImageView make_ImageView(VkDevice device, VkImage image, VkFormat imageFormat, VkImageAspectFlags aspectFlags);
-void make_Image(VkDevice device, VkPhysicalDevice physical_device, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage* image);
+VkImageView make_ImageView(VkDevice device, VkImage image, VkFormat imageFormat, VkImageAspectFlags aspectFlags, uint mips = 1);
+void make_Image(VkDevice device, VkPhysicalDevice physical_device, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage* image, uint mips = 1);
 void make_alloc_Image(VkDevice device, VkPhysicalDevice physical_device, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage* image, VkDeviceMemory* imageMemory);
 //void make_TextureImage(VkImage* result, VkDeviceMemory* result_memory, StagingQueue& staging_queue, Image& image);
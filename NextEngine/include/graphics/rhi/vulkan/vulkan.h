@@ -10,6 +10,7 @@
 #include "command_buffer.h"
 #include "shader_access.h"
 #include "material.h"
+#include "core/job_system/thread.h"
 
 struct RenderThreadResources {
 	CommandPool command_pool;
@@ -28,7 +29,8 @@ struct RHI {
 	Swapchain swapchain;
 	Window* window;
 	
-	shaderc_compiler_t shader_compiler;
+	//One per worker, created the first time the worker compiles a shader
+	shaderc_compiler_t shader_compilers[MAX_THREADS];
 	VertexLayouts vertex_layouts;
 	VertexStreaming vertex_streaming;
 	TextureAllocator texture_allocator;
@@ -54,6 +56,8 @@ extern RHI rhi;
 
 ENGINE_API void begin_gpu_upload();
 ENGINE_API void end_gpu_upload();
+//Only valid between frames, the fence of the frame being recorded is reset but not yet submitted
+ENGINE_API void wait_for_frames_in_flight();
 
 struct Window;
 struct RHI;
@@ -1,2 +1,93 @@
 #include "components/grass.h"
+#include "core/container/tvector.h"
+#include "core/memory/linear_allocator.h"
 
+void clear_grass_instances(Grass& grass) {
+	grass.position_x.clear();
+	grass.position_y.clear();
+	grass.position_z.clear();
+	grass.rotation.clear();
+	grass.scale.clear();
+	grass.cells.clear();
+	grass.cells_built_for = { INVALID_HANDLE };
+}
+
+void add_grass_instance(Grass& grass, glm::vec3 position, float rotation, float scale) {
+	grass.position_x.append(position.x);
+	grass.position_y.append(position.y);
+	grass.position_z.append(position.z);
+	grass.rotation.append(rotation);
+	grass.scale.append(scale);
+}
+
+void build_grass_cells(Grass& grass, const AABB& model_aabb) {
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
+	uint count = grass.position_x.length;
+	grass.cells.clear();
+	if (count == 0) return;
+
+	glm::vec2 min(FLT_MAX);
+	glm::vec2 max(-FLT_MAX);
+	for (uint i = 0; i < count; i++) {
+		min = glm::min(min, glm::vec2(grass.position_x[i], grass.position_z[i]));
+		max = glm::max(max, glm::vec2(grass.position_x[i], grass.position_z[i]));
+	}
+
+	uint cells_x = (uint)((max.x - min.x) / GRASS_CELL_SIZE) + 1;
+	uint cells_z = (uint)((max.y - min.y) / GRASS_CELL_SIZE) + 1;
+	uint cell_count = cells_x * cells_z;
+
+	uint* cell_of = alloc_t<uint>(temporary, count);
+	uint* offsets = alloc_t<uint>(temporary, cell_count + 1);
+	memset(offsets, 0, sizeof(uint) * (cell_count + 1));
+
+	for (uint i = 0; i < count; i++) {
+		uint x = (uint)((grass.position_x[i] - min.x) / GRASS_CELL_SIZE);
+		uint z = (uint)((grass.position_z[i] - min.y) / GRASS_CELL_SIZE);
+		cell_of[i] = glm::min(x, cells_x - 1) + glm::min(z, cells_z - 1) * cells_x;
+		offsets[cell_of[i] + 1]++;
+	}
+
+	for (uint i = 0; i < cell_count; i++) offsets[i + 1] += offsets[i];
+
+	//Counting sort, stable so resorting already sorted instances is a no-op
+	uint* order = alloc_t<uint>(temporary, count);
+	uint* cursor = alloc_t<uint>(temporary, cell_count);
+	memcpy(cursor, offsets, sizeof(uint) * cell_count);
+	for (uint i = 0; i < count; i++) order[cursor[cell_of[i]]++] = i;
+
+	vector<float>* streams[5] = { &grass.position_x, &grass.position_y, &grass.position_z, &grass.rotation, &grass.scale };
+	float* sorted = alloc_t<float>(temporary, count);
+
+	for (vector<float>* stream : streams) {
+		for (uint i = 0; i < count; i++) sorted[i] = (*stream)[order[i]];
+		memcpy(stream->data, sorted, sizeof(float) * count);
+	}
+
+	//Rotation is around the y axis, so the horizontal extent is bounded by the radius of the model
+	float radius = glm::max(glm::length(glm::vec2(model_aabb.min.x, model_aabb.min.z)), glm::length(glm::vec2(model_aabb.max.x, model_aabb.max.z)));
+	radius = glm::max(radius, glm::max(glm::length(glm::vec2(model_aabb.min.x, model_aabb.max.z)), glm::length(glm::vec2(model_aabb.max.x, model_aabb.min.z))));
+
+	for (uint cell = 0; cell < cell_count; cell++) {
+		uint offset = offsets[cell];
+		uint length = offsets[cell + 1] - offset;
+		if (length == 0) continue;
+
+		GrassCell result = {};
+		result.offset = offset;
+		result.count = length;
+
+		for (uint i = offset; i < offset + length; i++) {
+			float s = grass.scale[i];
+			glm::vec3 position(grass.position_x[i], grass.position_y[i], grass.position_z[i]);
+			glm::vec3 extent(radius * s, 0, radius * s);
+
+			result.aabb.update(position - extent + glm::vec3(0, glm::min(model_aabb.min.y * s, 0.0f), 0));
+			result.aabb.update(position + extent + glm::vec3(0, glm::max(model_aabb.max.y * s, 0.0f), 0));
+		}
+
+		grass.cells.append(result);
+	}
+}
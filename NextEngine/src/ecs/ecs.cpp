@@ -8,193 +8,117 @@
 #include "ecs/ecs.h"
 #include "core/reflection.h"
 
-struct ComponentDiff {
-    uint component_id;
-    uint mask;
-    refl::DiffOfType diff;
-};
-
-void copy_diff(u8* dst, u8* src, refl::DiffOfType& diff) {
-    printf("Copied diff %p %p\n", dst, src);
-    for (refl::DiffField& field : diff.fields) {
-        if (field.type == refl::UNCHANGED_DIFF) {
-            memcpy(dst + field.current_offset, src + field.previous_offset, field.current_type->size);
-        }
-        else if (field.type == refl::REMOVED_DIFF || field.type == refl::ADDED_DIFF) {
-            //TODO CALL DESTRUCTOR!
-        }
-        else {
-            copy_diff(dst + field.current_offset, src + field.previous_offset, field.diff);
-        }
-    }
-}
-
-refl::Type* deep_copy(refl::Type* type, hash_map<refl::Type*, refl::Type*, 103>& copied) {
-    if (type->type != refl::Type::Struct && type->type != refl::Type::Enum && type->type != refl::Type::Union) {
-        return type;
-    }
-    
-    if (refl::Type** type_copy = copied.get(type); type_copy) return *type_copy;
-    
-    refl::Type* type_copy;
-    switch (type->type) {
-        case refl::Type::Struct: {
-            refl::Struct* copy = new refl::Struct(*(refl::Struct*)type);
-            //copy->name = ;
-            for (refl::Field& field : copy->fields) {
-                field.type = deep_copy(field.type, copied);
+void World::append_migrated(ArchetypeStore& store, Archetype arch, u8* src, const uint* src_offsets, const refl::MigrationPlan* plans, uint count) {
+    uint first = 0;
+
+    while (first < count) {
+        if (!store.blocks || store.entity_count_last_block == store.max_per_block) add_block(store);
+
+        uint offset = store.entity_count_last_block;
+        uint n = min(count - first, store.max_per_block - offset);
+        u8* data = last_block_data(store);
+
+        for (uint comp = 0; comp < MAX_COMPONENTS; comp++) {
+            if (!has_component(arch, comp)) continue;
+
+            const refl::MigrationPlan& plan = plans[comp];
+            u8* dst = data + store.offsets[comp] + offset * component_size[comp];
+
+            //fields the plan does not copy keep their default value
+            auto constructor = component_lifetime_funcs[comp].constructor;
+            auto destructor = component_lifetime_funcs[comp].destructor;
+            if (!plan.identity && constructor) {
+                constructor(dst, n);
+
+                //the defaults of the copied fields are destroyed, or what they allocated would leak
+                if (destructor && plan.copies.length > 0) {
+                    LinearRegion region(get_temporary_allocator());
+                    u8* taken = TEMPORARY_ARRAY(u8, (u64)n * plan.dst_size);
+                    refl::take_migrated_fields(plan, taken, dst, n);
+                    destructor(taken, n);
+                }
             }
-            type_copy = copy;
-            break;
-        }
-        case refl::Type::Enum: {
-            refl::Enum* copy = new refl::Enum(*(refl::Enum*)type);
-            type_copy = copy;
-            break;
+
+            u8* src_column = src + src_offsets[comp] + first * plan.src_size;
+            refl::migrate_column(plan, dst, src_column, n);
+            refl::destroy_dropped_fields(plan, src_column, n);
         }
-            
-        case refl::Type::Union: {
-            refl::Union* copy = new refl::Union(*(refl::Union*)type);
 
-            for (refl::Field& field : copy->fields) {
-                field.type = deep_copy(field.type, copied);
+        for (uint i = offset; i < offset + n; i++) {
+            ID id = ((Entity*)(data + store.offsets[0]))[i].id;
+            id_to_arch[id] = arch;
+
+            for (uint comp = 0; comp < MAX_COMPONENTS; comp++) {
+                if (has_component(arch, comp)) id_to_ptr[comp][id] = data + store.offsets[comp] + i * component_size[comp];
             }
-            type_copy = copy;
-            break;
         }
+
+        store.entity_count_last_block += n;
+        first += n;
     }
-    
-    copied[type] = type_copy;
-    return type_copy;
 }
 
-
 void World::register_components(slice<struct RegisterComponent> components) {
-    refl::DiffOfType diffs[MAX_COMPONENTS];
-    Archetype diff_mask = 0;
-    
-    //todo massive leak copied types are cleaned up!
-    hash_map<refl::Type*, refl::Type*, 103> copied_type;
-    
+    refl::MigrationPlan plans[MAX_COMPONENTS];
+    Archetype changed_mask = 0;
+
     for (struct RegisterComponent& component : components) {
         ID component_id = component.component_id;
-        
-        refl::Struct* previous = component_type[component_id];
-        if (previous) {
-            assert(component.type->type == refl::Type::Struct);
-            
-            refl::DiffOfType diff = refl::diff_type(previous, component.type);
-            if (diff.type != refl::UNCHANGED_DIFF) {
-                diff_mask |= 1ul << component_id;
-                diffs[component_id] = diff;
-            }
+        assert(component.type->type == refl::Type::Struct);
+
+        refl::Schema schema;
+        refl::make_Schema(schema, component.type);
+
+        //the previous type can belong to a library that was unloaded, only its schema is used
+        if (component_type[component_id]) {
+            refl::MigrationPlan& plan = plans[component_id];
+            refl::make_MigrationPlan(plan, component_schema[component_id], schema);
+
+            if (!plan.identity) changed_mask |= 1ull << component_id;
         }
-        
+
         component_lifetime_funcs[component_id] = component.funcs;
         component_size[component_id] = component.type->size;
-        component_type[component_id] = (refl::Struct*)deep_copy(component.type, copied_type);
+        component_type[component_id] = (refl::Struct*)component.type;
+        component_schema[component_id] = schema;
         component_kind[component_id] = component.kind;
     }
-    
-    if (diff_mask == 0) return;
-    
-    //todo implement deep diff
+
+    if (changed_mask == 0) return;
+
+    for (uint i = 0; i < MAX_COMPONENTS; i++) {
+        if (changed_mask & (1ull << i)) continue;
+
+        plans[i].identity = true;
+        plans[i].src_size = component_size[i];
+        plans[i].dst_size = component_size[i];
+    }
+
     for (uint i = 0; i < ARCHETYPE_HASH; i++) {
         if (!arches.is_full(i)) continue;
-        
+
         Archetype archetype = arches.keys[i];
-        
-        if (!(archetype & diff_mask)) continue;
-        if (!arches.values[i].blocks) continue;
-        
-        ArchetypeStore store = arches.values[i];
-        
-        printf("Archetype was modified %llu, last block count %i\n", archetype, store.entity_count_last_block);
-        
-        bool changed_size = false;
-        for (uint i = 0; i < MAX_COMPONENTS; i++) {
-            Archetype mask = 1ul << i;
-            if (mask & diff_mask && mask & archetype && diffs[i].current_size != diffs[i].previous_size) {
-                changed_size = true;
-                break;
-            }
-        }
-        
-        BlockHeader* block = store.blocks;
-        ArchetypeStore* new_store;
-        if (changed_size) {
-            new_store = &make_archetype(archetype);
-        }
-        
-        BlockHeader* copy_to = changed_size ? new_store->blocks : nullptr;
-        uint entity_count = store.entity_count_last_block;
-        uint entity_offset = 0;
-        uint dst_entity_offset = 0;
-        
-        while (true) {
-            u8* data = (u8*)(block + 1);
-            
-            if (changed_size) {
-                u8* dst_data = (u8*)(copy_to + 1);
-                uint count = min(entity_count - entity_offset, new_store->max_per_block - dst_entity_offset);
-                
-                for (uint comp = 0; comp < MAX_COMPONENTS; comp++) {
-                    Archetype mask = 1ul << comp;
-                    u8* component_data = data + store.offsets[comp];
-                    u8* dst_component_data = dst_data + new_store->offsets[comp];
-                    u64 size = component_size[comp];
-                    
-                    if ((mask & diff_mask) == 0) {
-                        memcpy(dst_component_data + dst_entity_offset * size, component_data + entity_offset * size, count * component_size[comp]);
-                    } else {
-                        refl::DiffOfType& diff = diffs[comp];
-                        
-                        printf("Calling constructor count %i\n", count);
-                        component_lifetime_funcs[comp].constructor(dst_component_data + dst_entity_offset*diff.current_size, count);
-                        
-                        for (uint i = 0; i < count; i++) {
-                            copy_diff(dst_component_data + (i+dst_entity_offset) * diff.current_size, component_data + (i+entity_offset) * diff.previous_size, diff);
-                        }
-                    }
-                    
-                    for (uint i = 0; i < count; i++) {
-                        id_to_ptr[comp][i] = dst_component_data + i * size;
-                    }
-                }
-                
-                entity_offset += count;
-                dst_entity_offset += count;
-                
-                if (entity_offset == entity_count) {
-                    entity_count = store.max_per_block;
-                    entity_offset = 0;
-                    
-                    BlockHeader* last_block = block;
-                    block = block->next;
-                    
-                    release_block(last_block); //Done copying from the block
-                    
-                    if (!block) break;
-                }
-                
-                if (dst_entity_offset == entity_count) {
-                    dst_entity_offset = 0;
-                    
-                    BlockHeader* new_block = get_block();
-                    new_block->next = copy_to;
-                    copy_to = new_block;
-                }
-            } else {
-                
-                if (!block) break;
-            }
-        }
-        
-        if (changed_size) {
-            new_store->entity_count_last_block = dst_entity_offset;
-            new_store->blocks = copy_to;
-            
-            printf("Last block count %i\n", new_store->entity_count_last_block);
+        if (!(archetype & changed_mask)) continue;
+
+        ArchetypeStore previous = arches.values[i];
+        if (!previous.blocks) continue;
+
+        printf("Migrating archetype %llu\n", archetype);
+
+        //the layout of the blocks depends on the size of the components
+        ArchetypeStore& store = make_archetype(archetype);
+
+        uint entity_count = previous.entity_count_last_block;
+        BlockHeader* block = previous.blocks;
+
+        while (block) {
+            BlockHeader* next = block->next;
+
+            append_migrated(store, archetype, (u8*)(block + 1), previous.offsets, plans, entity_count);
+            release_block(block); //Done copying from the block
+
+            block = next;
+            entity_count = previous.max_per_block;
         }
     }
 }
@@ -202,6 +126,7 @@ void World::register_components(slice<struct RegisterComponent> components) {
 World& World::operator=(const World& from) {
     memcpy(id_to_arch, from.id_to_arch, sizeof(id_to_arch));
     memcpy(component_type, from.component_type, sizeof(component_type));
+    for (uint i = 0; i < MAX_COMPONENTS; i++) component_schema[i] = from.component_schema[i];
     memcpy(component_size, from.component_size, sizeof(component_size));
     memcpy(component_lifetime_funcs, from.component_lifetime_funcs, sizeof(component_lifetime_funcs));
     memcpy(&arches, &from.arches, sizeof(arches));
@@ -0,0 +1,233 @@
+#include "engine/file_watcher.h"
+#include "core/time.h"
+#include "core/io/logger.h"
+#include <string.h>
+
+void mark_changed(FileWatcher& watcher, string_view path) {
+	double now = Time::now();
+
+	for (FileChange& change : watcher.pending) {
+		if (change.path == path) {
+			change.time = now;
+			return;
+		}
+	}
+
+	FileChange change;
+	change.path = path;
+	change.time = now;
+	watcher.pending.append(std::move(change));
+}
+
+void report_settled(FileWatcher& watcher, vector<string_buffer>& modified) {
+	double now = Time::now();
+
+	for (uint i = 0; i < watcher.pending.length;) {
+		FileChange& change = watcher.pending[i];
+
+		if (now - change.time < FILE_WATCH_DEBOUNCE) {
+			i++;
+			continue;
+		}
+
+		modified.append(std::move(change.path));
+
+		//order does not matter, swap in the last change
+		if (i + 1 < watcher.pending.length) watcher.pending[i] = std::move(watcher.pending.last());
+		watcher.pending.pop();
+	}
+}
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <errno.h>
+
+struct WatchedDirectory {
+	int wd;
+	string_buffer path; //relative, empty or ending in /
+};
+
+struct InotifyWatcher {
+	int fd;
+	vector<WatchedDirectory> directories;
+};
+
+const uint INOTIFY_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+void watch_directory(FileWatcher& watcher, InotifyWatcher& inotify, string_view relative) {
+	string_buffer full_path = tformat(watcher.directory, relative);
+
+	int wd = inotify_add_watch(inotify.fd, full_path.c_str(), INOTIFY_MASK | IN_ONLYDIR);
+	if (wd == -1) {
+		log("Could not watch directory ", full_path, "\n");
+		return;
+	}
+
+	WatchedDirectory directory;
+	directory.wd = wd;
+	directory.path = relative;
+	inotify.directories.append(std::move(directory));
+
+	DIR* dir = opendir(full_path.c_str());
+	if (!dir) return;
+
+	while (struct dirent* entry = readdir(dir)) {
+		if (entry->d_type != DT_DIR) continue;
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+
+		watch_directory(watcher, inotify, tformat(relative, entry->d_name, "/"));
+	}
+
+	closedir(dir);
+}
+
+bool make_FileWatcher(FileWatcher& watcher, string_view directory) {
+	int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd == -1) return false;
+
+	InotifyWatcher* inotify = new InotifyWatcher();
+	inotify->fd = fd;
+
+	watcher.directory = directory;
+	watcher.backend = inotify;
+
+	watch_directory(watcher, *inotify, "");
+	return true;
+}
+
+void destroy_FileWatcher(FileWatcher& watcher) {
+	InotifyWatcher* inotify = (InotifyWatcher*)watcher.backend;
+	if (!inotify) return;
+
+	close(inotify->fd);
+	delete inotify;
+	watcher.backend = nullptr;
+}
+
+void poll_FileWatcher(FileWatcher& watcher, vector<string_buffer>& modified) {
+	InotifyWatcher* inotify = (InotifyWatcher*)watcher.backend;
+	if (!inotify) return;
+
+	alignas(struct inotify_event) char buffer[4096];
+
+	while (true) {
+		ssize_t length = read(inotify->fd, buffer, sizeof(buffer));
+		if (length <= 0) break; //EAGAIN once every event was read
+
+		for (char* ptr = buffer; ptr < buffer + length;) {
+			struct inotify_event* event = (struct inotify_event*)ptr;
+			ptr += sizeof(struct inotify_event) + event->len;
+
+			if (event->len == 0) continue;
+
+			WatchedDirectory* directory = nullptr;
+			for (WatchedDirectory& watched : inotify->directories) {
+				if (watched.wd == event->wd) directory = &watched;
+			}
+			if (!directory) continue;
+
+			string_buffer path = tformat(directory->path, event->name);
+
+			if (event->mask & IN_ISDIR) {
+				if (event->mask & (IN_CREATE | IN_MOVED_TO)) watch_directory(watcher, *inotify, tformat(path, "/"));
+			}
+			else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+				mark_changed(watcher, path);
+			}
+		}
+	}
+
+	report_settled(watcher, modified);
+}
+
+#elif defined(NE_PLATFORM_WINDOWS)
+#include <Windows.h>
+
+struct DirectoryChangesWatcher {
+	HANDLE directory;
+	OVERLAPPED overlapped;
+	alignas(DWORD) char buffer[16 * 1024];
+};
+
+const DWORD DIRECTORY_CHANGES_FILTER = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME;
+
+bool read_directory_changes(DirectoryChangesWatcher& windows) {
+	return ReadDirectoryChangesW(windows.directory, windows.buffer, sizeof(windows.buffer), TRUE, DIRECTORY_CHANGES_FILTER, NULL, &windows.overlapped, NULL);
+}
+
+bool make_FileWatcher(FileWatcher& watcher, string_view directory) {
+	HANDLE handle = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+	if (handle == INVALID_HANDLE_VALUE) return false;
+
+	DirectoryChangesWatcher* windows = new DirectoryChangesWatcher();
+	windows->directory = handle;
+	windows->overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+	if (!read_directory_changes(*windows)) {
+		CloseHandle(windows->overlapped.hEvent);
+		CloseHandle(handle);
+		delete windows;
+		return false;
+	}
+
+	watcher.directory = directory;
+	watcher.backend = windows;
+	return true;
+}
+
+void destroy_FileWatcher(FileWatcher& watcher) {
+	DirectoryChangesWatcher* windows = (DirectoryChangesWatcher*)watcher.backend;
+	if (!windows) return;
+
+	CancelIo(windows->directory);
+	CloseHandle(windows->overlapped.hEvent);
+	CloseHandle(windows->directory);
+	delete windows;
+	watcher.backend = nullptr;
+}
+
+void poll_FileWatcher(FileWatcher& watcher, vector<string_buffer>& modified) {
+	DirectoryChangesWatcher* windows = (DirectoryChangesWatcher*)watcher.backend;
+	if (!windows) return;
+
+	DWORD length = 0;
+	if (GetOverlappedResult(windows->directory, &windows->overlapped, &length, FALSE)) {
+		//A length of 0 means the buffer overflowed and the changes were lost
+		for (char* ptr = windows->buffer; length > 0;) {
+			FILE_NOTIFY_INFORMATION* info = (FILE_NOTIFY_INFORMATION*)ptr;
+
+			if (info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+				char name[MAX_PATH];
+				int name_length = WideCharToMultiByte(CP_UTF8, 0, info->FileName, info->FileNameLength / sizeof(WCHAR), name, MAX_PATH - 1, NULL, NULL);
+
+				for (int i = 0; i < name_length; i++) {
+					if (name[i] == '\\') name[i] = '/';
+				}
+
+				mark_changed(watcher, string_view(name, name_length));
+			}
+
+			if (info->NextEntryOffset == 0) break;
+			ptr += info->NextEntryOffset;
+		}
+
+		ResetEvent(windows->overlapped.hEvent);
+		read_directory_changes(*windows);
+	}
+
+	report_settled(watcher, modified);
+}
+
+#else
+
+bool make_FileWatcher(FileWatcher& watcher, string_view directory) {
+	return false;
+}
+
+void destroy_FileWatcher(FileWatcher& watcher) {}
+
+void poll_FileWatcher(FileWatcher& watcher, vector<string_buffer>& modified) {}
+
+#endif
@@ -0,0 +1,278 @@
+#include "engine/pack.h"
+#include "core/io/logger.h"
+#include <algorithm>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef NE_PLATFORM_WINDOWS
+#define stat _stat
+#endif
+
+//FNV-1a
+u64 pack_path_hash(string_view path) {
+	u64 hash = 14695981039346656037ull;
+	for (uint i = 0; i < path.length; i++) {
+		char c = path.data[i] == '\\' ? '/' : path.data[i];
+		hash ^= (u8)c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+//Every entry is checked once here, so pack_view and pack_read can trust the index
+bool pack_entries_valid(const PackHeader& header, const PackEntry* entries, u64 file_length) {
+	for (uint i = 0; i < header.entry_count; i++) {
+		const PackEntry& entry = entries[i];
+
+		if (entry.offset > file_length || entry.stored_size > file_length - entry.offset) return false;
+		if ((u64)entry.path_offset + entry.path_length > header.strings_size) return false;
+		if (entry.compression != PackCompression::None && entry.compression != PackCompression::LZ4) return false;
+		if (entry.compression == PackCompression::None && entry.size != entry.stored_size) return false;
+		if (i > 0 && entries[i - 1].hash > entry.hash) return false; //pack_find binary searches by hash
+	}
+
+	return true;
+}
+
+bool open_Pack(Pack& pack, string_view full_path) {
+	MappedFile file;
+	if (!io_mapf_full(full_path, &file)) return false;
+
+	const PackHeader* header = (const PackHeader*)file.data;
+	const char* blob = (const char*)file.data;
+
+	bool valid = file.length >= sizeof(PackHeader)
+		&& header->magic == PACK_MAGIC
+		&& header->version == PACK_VERSION
+		&& header->index_offset + sizeof(PackEntry) * (u64)header->entry_count <= file.length
+		&& header->strings_offset + header->strings_size <= file.length;
+
+	valid = valid && pack_entries_valid(*header, (const PackEntry*)(blob + header->index_offset), file.length);
+
+	if (!valid) {
+		log("Pack ", full_path, " is invalid or was written by another version\n");
+		io_unmapf(file);
+		return false;
+	}
+
+	pack.file = file;
+	pack.header = header;
+	pack.entries = (const PackEntry*)(blob + header->index_offset);
+	pack.strings = blob + header->strings_offset;
+	return true;
+}
+
+void close_Pack(Pack& pack) {
+	io_unmapf(pack.file);
+	pack = {};
+}
+
+const PackEntry* pack_find(const Pack& pack, string_view path) {
+	if (!pack.header) return nullptr;
+
+	u64 hash = pack_path_hash(path);
+
+	const PackEntry* begin = pack.entries;
+	const PackEntry* end = pack.entries + pack.header->entry_count;
+	const PackEntry* it = std::lower_bound(begin, end, hash, [](const PackEntry& entry, u64 hash) { return entry.hash < hash; });
+
+	for (; it != end && it->hash == hash; it++) {
+		if (it->path_length != path.length) continue;
+
+		const char* entry_path = pack.strings + it->path_offset;
+		bool equal = true;
+		for (uint i = 0; i < path.length && equal; i++) {
+			char c = path.data[i] == '\\' ? '/' : path.data[i];
+			equal = entry_path[i] == c;
+		}
+
+		if (equal) return it;
+	}
+
+	return nullptr;
+}
+
+string_view pack_view(const Pack& pack, const PackEntry& entry) {
+	if (entry.compression != PackCompression::None) return {};
+	return { (const char*)pack.file.data + entry.offset, (uint)entry.size };
+}
+
+bool pack_read(const Pack& pack, const PackEntry& entry, char* output) {
+	const char* stored = (const char*)pack.file.data + entry.offset;
+
+	if (entry.compression == PackCompression::LZ4) return lz4_decompress(stored, entry.stored_size, output, entry.size);
+
+	memcpy(output, stored, entry.size);
+	return true;
+}
+
+bool read_source(string_view full_path, string_buffer* contents, i64* time_modified) {
+	FILE* f = fopen(full_path.c_str(), "rb");
+	if (!f) return false;
+
+	struct stat info;
+	if (stat(full_path.c_str(), &info) != 0) {
+		fclose(f);
+		return false;
+	}
+
+	contents->reserve(info.st_size);
+	contents->length = fread(contents->data, sizeof(char), info.st_size, f);
+	*time_modified = info.st_mtime;
+
+	fclose(f);
+	return true;
+}
+
+void write_padding(FILE* f, u64& offset) {
+	char zeros[PACK_ALIGNMENT] = {};
+	u64 aligned = (offset + PACK_ALIGNMENT - 1) & ~(PACK_ALIGNMENT - 1);
+
+	fwrite(zeros, sizeof(char), aligned - offset, f);
+	offset = aligned;
+}
+
+bool write_Pack(string_view full_path, slice<PackSource> sources, bool compress) {
+	FILE* f = fopen(full_path.c_str(), "wb");
+	if (!f) return false;
+
+	PackHeader header = {};
+	header.magic = PACK_MAGIC;
+	header.version = PACK_VERSION;
+
+	//rewritten once the index is known
+	fwrite(&header, sizeof(PackHeader), 1, f);
+	u64 offset = sizeof(PackHeader);
+
+	vector<PackEntry> entries;
+	vector<char> strings;
+	vector<char> compressed;
+
+	for (PackSource& source : sources) {
+		string_buffer contents;
+
+		PackEntry entry = {};
+		if (!read_source(source.full_path, &contents, &entry.time_modified)) {
+			log("Could not read ", source.full_path, "\n");
+			continue;
+		}
+
+		entry.hash = pack_path_hash(source.path);
+		entry.size = contents.length;
+		entry.stored_size = contents.length;
+		entry.compression = PackCompression::None;
+		entry.path_offset = strings.length;
+		entry.path_length = source.path.length;
+
+		const char* stored = contents.data;
+
+		if (compress && contents.length > 0) {
+			compressed.resize(lz4_compress_bound(contents.length));
+			u64 compressed_size = lz4_compress(contents.data, contents.length, compressed.data);
+
+			if (compressed_size < contents.length - contents.length / 8) {
+				entry.compression = PackCompression::LZ4;
+				entry.stored_size = compressed_size;
+				stored = compressed.data;
+			}
+		}
+
+		write_padding(f, offset);
+		entry.offset = offset;
+
+		fwrite(stored, sizeof(char), entry.stored_size, f);
+		offset += entry.stored_size;
+
+		for (uint i = 0; i < source.path.length; i++) strings.append(source.path.data[i] == '\\' ? '/' : source.path.data[i]);
+		entries.append(entry);
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const PackEntry& a, const PackEntry& b) { return a.hash < b.hash; });
+
+	write_padding(f, offset);
+	header.entry_count = entries.length;
+	header.index_offset = offset;
+	fwrite(entries.data, sizeof(PackEntry), entries.length, f);
+	offset += sizeof(PackEntry) * (u64)entries.length;
+
+	header.strings_offset = offset;
+	header.strings_size = strings.length;
+	fwrite(strings.data, sizeof(char), strings.length, f);
+
+	fseek(f, 0, SEEK_SET);
+	fwrite(&header, sizeof(PackHeader), 1, f);
+
+	bool written = ferror(f) == 0;
+	fclose(f);
+
+	return written;
+}
+
+bool is_pack(string_view name) {
+	return name.ends_with(".pack");
+}
+
+#ifdef NE_PLATFORM_WINDOWS
+#include <Windows.h>
+
+void collect_files(string_view root, string_view relative, vector<PackSource>& sources) {
+	string_buffer pattern = tformat(root, relative, "*");
+
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA(pattern.c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE) return;
+
+	do {
+		string_view name = data.cFileName;
+		if (name.starts_with(".")) continue;
+
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			collect_files(root, tformat(relative, name, "/"), sources);
+		}
+		else if (!is_pack(name)) {
+			PackSource source;
+			source.path = tformat(relative, name);
+			source.full_path = tformat(root, relative, name);
+			sources.append(std::move(source));
+		}
+	} while (FindNextFileA(find, &data));
+
+	FindClose(find);
+}
+
+#else
+#include <dirent.h>
+
+void collect_files(string_view root, string_view relative, vector<PackSource>& sources) {
+	string_buffer directory = tformat(root, relative);
+
+	DIR* dir = opendir(directory.c_str());
+	if (!dir) return;
+
+	while (struct dirent* entry = readdir(dir)) {
+		string_view name = entry->d_name;
+		if (name.starts_with(".")) continue;
+
+		if (entry->d_type == DT_DIR) {
+			collect_files(root, tformat(relative, name, "/"), sources);
+		}
+		else if (!is_pack(name)) {
+			PackSource source;
+			source.path = tformat(relative, name);
+			source.full_path = tformat(root, relative, name);
+			sources.append(std::move(source));
+		}
+	}
+
+	closedir(dir);
+}
+
+#endif
+
+void collect_pack_sources(string_view directory, vector<PackSource>& sources) {
+	string_buffer root = directory;
+	if (!root.ends_with("/") && !root.ends_with("\\")) root += "/";
+
+	collect_files(root, "", sources);
+}
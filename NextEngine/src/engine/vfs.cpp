@@ -1,13 +1,38 @@
 #include "engine/vfs.h"
+#include "engine/pack.h"
 #include "graphics/assets/assets.h"
+#include "core/memory/allocator.h"
 #include <time.h>
 #include <sys/stat.h>
 #include <stdio.h>
 
-#ifdef __APPLE__
+#ifndef NE_PLATFORM_WINDOWS
 #define _stat stat
 #endif
 
+Pack mounted_pack;
+
+bool io_mount_pack(string_view full_path) {
+	io_unmount_pack();
+	return open_Pack(mounted_pack, full_path);
+}
+
+void io_unmount_pack() {
+	if (mounted_pack.header) close_Pack(mounted_pack);
+}
+
+bool io_pack_mounted() {
+	return mounted_pack.header != nullptr;
+}
+
+bool io_viewf(string_view filepath, string_view* output) {
+	const PackEntry* entry = pack_find(mounted_pack, filepath);
+	if (!entry || entry->compression != PackCompression::None) return false;
+
+	*output = pack_view(mounted_pack, *entry);
+	return true;
+}
+
 FILE* open(string_view full_filepath, const char* mode) {
 	return fopen(full_filepath.c_str(), mode);
 }
@@ -17,6 +42,15 @@ FILE* open_rel(string_view filepath, const char* mode) {
 }
 
 bool read_file(string_view filepath, string_buffer* buffer, int null_terminated) {
+	if (const PackEntry* entry = pack_find(mounted_pack, filepath)) {
+		buffer->reserve(entry->size + null_terminated);
+		if (!pack_read(mounted_pack, *entry, buffer->data)) return false;
+
+		if (null_terminated) buffer->data[entry->size] = '\0';
+		buffer->length = entry->size;
+		return true;
+	}
+
 	string_buffer full_filepath = tasset_path(filepath);
 	FILE* f = open(full_filepath, "rb");
 	if (!f) return false;
@@ -56,6 +90,8 @@ bool io_writef(string_view filename, string_view content) {
 }
 
 i64 io_time_modified(string_view filename) {
+	if (const PackEntry* entry = pack_find(mounted_pack, filename)) return entry->time_modified;
+
 	auto f = tasset_path(filename);
 	
 	struct _stat buffer;
@@ -66,7 +102,7 @@ i64 io_time_modified(string_view filename) {
 
 #ifdef NE_PLATFORM_WINDOWS
 const char* SEPERATOR = "\\";
-#elif NE_PLATFORM_MACOSX
+#else
 const char* SEPERATOR = "/";
 #endif
 
@@ -119,6 +155,167 @@ bool io_get_current_dir(string_buffer* output) {
     return true;
 }
 
+#else
+#include <sys/sendfile.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+bool io_copyf(string_view src, string_view dst, bool fail_if_exists) {
+	int src_fd = ::open(src.c_str(), O_RDONLY);
+	if (src_fd == -1) return false;
+
+	struct stat info;
+	if (fstat(src_fd, &info) != 0) {
+		close(src_fd);
+		return false;
+	}
+
+	int flags = O_WRONLY | O_CREAT | O_TRUNC | (fail_if_exists ? O_EXCL : 0);
+	int dst_fd = ::open(dst.c_str(), flags, info.st_mode & 0777);
+	if (dst_fd == -1) {
+		close(src_fd);
+		return false;
+	}
+
+	//copied in the kernel, sendfile may write less than asked
+	off_t offset = 0;
+	bool result = true;
+	while (result && offset < info.st_size) {
+		result = sendfile(dst_fd, src_fd, &offset, info.st_size - offset) > 0;
+	}
+
+	close(src_fd);
+	close(dst_fd);
+	return result;
+}
+
+bool io_get_current_dir(string_buffer* output) {
+	char buffer[PATH_MAX] = {0};
+	if (!getcwd(buffer, PATH_MAX)) return false;
+	*output = buffer;
+	return true;
+}
+
+#endif
+
+bool io_replacef(string_view src, string_view dst) {
+	string_buffer src_path = tasset_path(src);
+	string_buffer dst_path = tasset_path(dst);
+
+#ifdef NE_PLATFORM_WINDOWS
+	//fails while dst is mapped, rather than changing the file under the mapping
+	return MoveFileExA(src_path.c_str(), dst_path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+	return rename(src_path.c_str(), dst_path.c_str()) == 0;
+#endif
+}
+
+bool io_mapf(string_view filepath, MappedFile* output) {
+	if (const PackEntry* entry = pack_find(mounted_pack, filepath)) {
+		if (entry->size == 0) return false;
+
+		if (entry->compression == PackCompression::None) {
+			output->data = (void*)pack_view(mounted_pack, *entry).data;
+			output->length = entry->size;
+			output->handle = nullptr;
+			output->source = MappedFileSource::Pack;
+			return true;
+		}
+
+		Allocator& allocator = get_allocator();
+		char* data = (char*)allocator.allocate(entry->size);
+
+		if (!pack_read(mounted_pack, *entry, data)) {
+			allocator.deallocate(data);
+			return false;
+		}
+
+		output->data = data;
+		output->length = entry->size;
+		output->handle = nullptr;
+		output->source = MappedFileSource::Allocation;
+		return true;
+	}
+
+	return io_mapf_full(tasset_path(filepath), output);
+}
+
+void unmap_file(MappedFile& file);
+
+void io_unmapf(MappedFile& file) {
+	if (file.source == MappedFileSource::Mapping) unmap_file(file);
+	if (file.source == MappedFileSource::Allocation) get_allocator().deallocate(file.data);
+	file = {};
+}
+
+#ifdef NE_PLATFORM_WINDOWS
+#include <Windows.h>
+
+bool io_mapf_full(string_view full_filepath, MappedFile* output) {
+	HANDLE file = CreateFileA(full_filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	//the mapping keeps the file open
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!mapping) return false;
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		CloseHandle(mapping);
+		return false;
+	}
+
+	output->data = data;
+	output->length = size.QuadPart;
+	output->handle = mapping;
+	output->source = MappedFileSource::Mapping;
+	return true;
+}
+
+void unmap_file(MappedFile& file) {
+	if (file.data) UnmapViewOfFile(file.data);
+	if (file.handle) CloseHandle(file.handle);
+}
+
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+bool io_mapf_full(string_view full_filepath, MappedFile* output) {
+	int fd = ::open(full_filepath.c_str(), O_RDONLY);
+	if (fd == -1) return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	//the mapping keeps the file open
+	void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) return false;
+
+	output->data = data;
+	output->length = info.st_size;
+	output->handle = nullptr;
+	output->source = MappedFileSource::Mapping;
+	return true;
+}
+
+void unmap_file(MappedFile& file) {
+	if (file.data) munmap(file.data, file.length);
+}
+
 #endif
 
 wchar_t* to_wide_char(const char* orig);
@@ -424,8 +424,11 @@ refl::Struct init_Grass() {
 	type.fields.append({"random_rotation", offsetof(Grass, random_rotation), get_float_type()});
 	type.fields.append({"random_scale", offsetof(Grass, random_scale), get_float_type()});
 	type.fields.append({"align_to_terrain_normal", offsetof(Grass, align_to_terrain_normal), get_bool_type()});
-	type.fields.append({"positions", offsetof(Grass, positions), make_vector_type(get_vec3_type())});
-	type.fields.append({"model_m", offsetof(Grass, model_m), make_vector_type(get_mat4_type())});
+	type.fields.append({"position_x", offsetof(Grass, position_x), make_vector_type(get_float_type())});
+	type.fields.append({"position_y", offsetof(Grass, position_y), make_vector_type(get_float_type())});
+	type.fields.append({"position_z", offsetof(Grass, position_z), make_vector_type(get_float_type())});
+	type.fields.append({"rotation", offsetof(Grass, rotation), make_vector_type(get_float_type())});
+	type.fields.append({"scale", offsetof(Grass, scale), make_vector_type(get_float_type())});
 	return type;
 }
 
@@ -439,13 +442,25 @@ void write_Grass_to_buffer(SerializerBuffer& buffer, Grass& data) {
     write_n_to_buffer(buffer, &data.random_rotation, sizeof(float));
     write_n_to_buffer(buffer, &data.random_scale, sizeof(float));
     write_n_to_buffer(buffer, &data.align_to_terrain_normal, sizeof(bool));
-    write_uint_to_buffer(buffer, data.positions.length);
-	for (uint i = 0; i < data.positions.length; i++) {
-         write_vec3_to_buffer(buffer, data.positions[i]);
+    write_uint_to_buffer(buffer, data.position_x.length);
+	for (uint i = 0; i < data.position_x.length; i++) {
+         write_n_to_buffer(buffer, &data.position_x[i], sizeof(float));
     }
-    write_uint_to_buffer(buffer, data.model_m.length);
-	for (uint i = 0; i < data.model_m.length; i++) {
-         write_mat4_to_buffer(buffer, data.model_m[i]);
+    write_uint_to_buffer(buffer, data.position_y.length);
+	for (uint i = 0; i < data.position_y.length; i++) {
+         write_n_to_buffer(buffer, &data.position_y[i], sizeof(float));
+    }
+    write_uint_to_buffer(buffer, data.position_z.length);
+	for (uint i = 0; i < data.position_z.length; i++) {
+         write_n_to_buffer(buffer, &data.position_z[i], sizeof(float));
+    }
+    write_uint_to_buffer(buffer, data.rotation.length);
+	for (uint i = 0; i < data.rotation.length; i++) {
+         write_n_to_buffer(buffer, &data.rotation[i], sizeof(float));
+    }
+    write_uint_to_buffer(buffer, data.scale.length);
+	for (uint i = 0; i < data.scale.length; i++) {
+         write_n_to_buffer(buffer, &data.scale[i], sizeof(float));
     }
 }
 
@@ -459,13 +474,25 @@ void read_Grass_from_buffer(DeserializerBuffer& buffer, Grass& data) {
     read_n_from_buffer(buffer, &data.random_rotation, sizeof(float));
     read_n_from_buffer(buffer, &data.random_scale, sizeof(float));
     read_n_from_buffer(buffer, &data.align_to_terrain_normal, sizeof(bool));
-    data.positions.resize(read_uint_from_buffer(buffer));
-	for (uint i = 0; i < data.positions.length; i++) {
-         read_vec3_from_buffer(buffer, data.positions[i]);
+    data.position_x.resize(read_uint_from_buffer(buffer));
+	for (uint i = 0; i < data.position_x.length; i++) {
+         read_n_from_buffer(buffer, &data.position_x[i], sizeof(float));
+    }
+    data.position_y.resize(read_uint_from_buffer(buffer));
+	for (uint i = 0; i < data.position_y.length; i++) {
+         read_n_from_buffer(buffer, &data.position_y[i], sizeof(float));
+    }
+    data.position_z.resize(read_uint_from_buffer(buffer));
+	for (uint i = 0; i < data.position_z.length; i++) {
+         read_n_from_buffer(buffer, &data.position_z[i], sizeof(float));
+    }
+    data.rotation.resize(read_uint_from_buffer(buffer));
+	for (uint i = 0; i < data.rotation.length; i++) {
+         read_n_from_buffer(buffer, &data.rotation[i], sizeof(float));
     }
-    data.model_m.resize(read_uint_from_buffer(buffer));
-	for (uint i = 0; i < data.model_m.length; i++) {
-         read_mat4_from_buffer(buffer, data.model_m[i]);
+    data.scale.resize(read_uint_from_buffer(buffer));
+	for (uint i = 0; i < data.scale.length; i++) {
+         read_n_from_buffer(buffer, &data.scale[i], sizeof(float));
     }
 }
 
@@ -43,6 +43,7 @@ Stage from_vk_stage(VkShaderStageFlags flags) {
 
 void MaterialAllocator::make(MaterialDesc& desc, Material* material) {	
 	material->info = { desc.shader, desc.draw_state };
+	if (&material->desc != &desc) material->desc = desc;
 
 	shader_flags permutations[] = { SHADER_INSTANCED };
 
@@ -255,14 +255,10 @@ string_buffer preprocess_source(string_view source, Stage stage, shader_flags fl
 }
 
 
-string_buffer compile_glsl_to_spirv(shaderc_compiler_t compiler, Stage stage, string_view source, string_view input_file_name, shader_flags flags, string_buffer* err) {
-	string_buffer source_assembly = preprocess_source(source, stage, flags);
-
-	printf("Source: %s", source_assembly.data);
-
+string_buffer compile_glsl_to_spirv(shaderc_compiler_t compiler, Stage stage, string_view source, string_view input_file_name, string_buffer* err) {
 	shaderc_shader_kind glsl_shader_kind = stage == VERTEX_STAGE ? shaderc_glsl_vertex_shader : shaderc_glsl_fragment_shader;
 
-	shaderc_compilation_result_t result = shaderc_compile_into_spv(compiler, source_assembly.data, source_assembly.length, glsl_shader_kind, input_file_name.c_str(), "main", NULL);
+	shaderc_compilation_result_t result = shaderc_compile_into_spv(compiler, source.data, source.length, glsl_shader_kind, input_file_name.c_str(), "main", NULL);
 
 	if (shaderc_result_get_num_errors(result) > 0) {
 		*err = shaderc_result_get_error_message(result);
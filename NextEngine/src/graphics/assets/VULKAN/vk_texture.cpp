@@ -138,14 +138,14 @@ void transition_ImageLayout(VkCommandBuffer cmd_buffer, VkImage image, VkFormat
 	//endSingleTimeCommands(queue, cmd_buffer);
 }
 
-void copy_buffer_to_image(VkCommandBuffer cmd_buffer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t offset = 0) {
+void copy_buffer_to_image(VkCommandBuffer cmd_buffer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t offset = 0, uint32_t mip = 0) {
 	VkBufferImageCopy region = {};
 	region.bufferOffset = offset;
 	region.bufferRowLength = 0;
 	region.bufferImageHeight = 0;
 
 	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.mipLevel = mip;
 	region.imageSubresource.baseArrayLayer = 0;
 	region.imageSubresource.layerCount = 1;
 
@@ -177,7 +177,7 @@ void make_alloc_Image(VkDevice device, VkPhysicalDevice physical_device, uint32_
 }
 
 
-VkImageView make_ImageView(VkDevice device, VkImage image, VkFormat imageFormat, VkImageAspectFlags aspectFlags) {
+VkImageView make_ImageView(VkDevice device, VkImage image, VkFormat imageFormat, VkImageAspectFlags aspectFlags, uint mips) {
 	VkImageViewCreateInfo makeInfo = {}; //todo abstract image view creation
 	makeInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 	makeInfo.image = image;
@@ -185,7 +185,7 @@ VkImageView make_ImageView(VkDevice device, VkImage image, VkFormat imageFormat,
 	makeInfo.format = imageFormat;
 	makeInfo.subresourceRange.aspectMask = aspectFlags;
 	makeInfo.subresourceRange.baseMipLevel = 0;
-	makeInfo.subresourceRange.levelCount = 1;
+	makeInfo.subresourceRange.levelCount = mips;
 	makeInfo.subresourceRange.baseArrayLayer = 0;
 	makeInfo.subresourceRange.layerCount = 1;
 
@@ -200,14 +200,14 @@ VkImageView make_ImageView(VkDevice device, VkImage image, VkFormat imageFormat,
 }
 
 //reminder: image memory must be bound afterwards!
-void make_Image(VkDevice device, VkPhysicalDevice physical_device, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage* image) {
+void make_Image(VkDevice device, VkPhysicalDevice physical_device, uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage* image, uint mips) {
 	VkImageCreateInfo imageInfo = {};
 	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 	imageInfo.imageType = VK_IMAGE_TYPE_2D;
 	imageInfo.extent.width = width;
 	imageInfo.extent.height = height;
 	imageInfo.extent.depth = 1;
-	imageInfo.mipLevels = 1;
+	imageInfo.mipLevels = mips;
 	imageInfo.arrayLayers = 1;
 	imageInfo.format = format;
 	imageInfo.tiling = tiling;
@@ -326,14 +326,20 @@ VkImageUsageFlags to_vk_usage_flags(TextureUsage usage) {
 }
 
 VkFormat to_vk_image_format(TextureFormat format, uint num_channels) {
-	VkFormat formats_by_channel_count[4][4] = {
+	VkFormat formats_by_channel_count[5][4] = {
 		{ VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_R8G8B8A8_UNORM },
 		{VK_FORMAT_R8_SRGB, VK_FORMAT_R8G8_SRGB, VK_FORMAT_R8G8B8_SRGB, VK_FORMAT_R8G8B8A8_SRGB},
 		{VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT},
-		{VK_FORMAT_R8_UINT, VK_FORMAT_R8G8_UINT, VK_FORMAT_R8G8B8_UINT, VK_FORMAT_R8G8B8A8_UINT}
+		{VK_FORMAT_R8_UINT, VK_FORMAT_R8G8_UINT, VK_FORMAT_R8G8B8_UINT, VK_FORMAT_R8G8B8A8_UINT},
+		{VK_FORMAT_R16_SFLOAT, VK_FORMAT_R16G16_SFLOAT, VK_FORMAT_R16G16B16_SFLOAT, VK_FORMAT_R16G16B16A16_SFLOAT}
 	};
 
-	return formats_by_channel_count[(uint)format][num_channels - 1];
+	switch (format) {
+	case TextureFormat::BC1: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+	case TextureFormat::BC3: return VK_FORMAT_BC3_UNORM_BLOCK;
+	case TextureFormat::BC5: return VK_FORMAT_BC5_UNORM_BLOCK;
+	default: return formats_by_channel_count[(uint)format][num_channels - 1];
+	}
 }
 
 VkFormat to_vk_image_format(const TextureDesc& desc) {
@@ -351,9 +357,8 @@ Texture alloc_TextureImage(TextureAllocator& allocator, const TextureDesc& desc)
 
 	VkFormat image_format = to_vk_image_format(desc);
 
-	u64 texel_sizes[3] = { 1, 1, 4 };
-	u64 texel_alignment = texel_sizes[(uint)desc.format] * desc.num_channels;
-	VkDeviceSize image_size = desc.width * desc.height * desc.num_channels * texel_sizes[(uint)desc.format];
+	u64 texel_alignment = texel_size(desc.format) * desc.num_channels;
+	VkDeviceSize image_size = image_data_size(desc);
 
 	/*
 	int32_t offset = allocator.staging_buffer_offset;
@@ -392,6 +397,7 @@ Texture alloc_TextureImage(TextureAllocator& allocator, const TextureDesc& desc)
 		info = &allocator.memory_alloc_info[allocator.texture_allocated_count++];
 		info->width = width;
 		info->height = height;
+		info->mips = 1;
 		info->format = image_format;
 		info->image = vk_image;
 	}
@@ -450,6 +456,38 @@ void alloc_and_bind_memory(TextureAllocator& allocator, VkImage image) {
 	vkBindImageMemory(device, image, allocator.image_memory, offset);
 }
 
+//Copies the whole mip chain into the staging buffer and records the copy into the image
+void record_texture_upload(TextureAllocator& allocator, TextureAllocInfo* info, const Image& image) {
+	StagingQueue& staging_queue = allocator.staging_queue;
+	VkImage vk_image = info->image;
+	VkFormat image_format = info->format;
+
+	u64 texel_alignment = is_block_compressed(image.format) ? block_size(image.format) : texel_size(image.format) * image.num_channels;
+	VkDeviceSize image_size = image_data_size(image);
+
+	int32_t offset = aligned_incr(&allocator.staging_buffer_offset, image_size, texel_alignment);
+	memcpy((char*)allocator.staging.mapped + offset, image.data, image_size);
+
+	assert(allocator.staging_buffer_offset < MAX_IMAGE_UPLOAD);
+	assert(offset % texel_alignment == 0);
+
+	//THIS WAY WE CAN EXECUTE ALL THE RESOURCE TRANSFERS IN THE GRAPHICS QUEUE
+	TextureAllocInfo* next_info = allocator.uploaded_this_frame;
+	allocator.uploaded_this_frame = info;
+	info->next = next_info;
+
+	VkCommandBuffer cmd_buffer = staging_queue.cmd_buffers[staging_queue.frame_index]; 
+
+	printf("COPYING DATA TO IMAGE : 0x%p %ix%i\n", vk_image, info->width, info->height);
+
+	transition_ImageLayout(cmd_buffer, vk_image, image_format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, image.num_mips);
+	for (uint mip = 0; mip < image.num_mips; mip++) {
+		uint mip_offset = offset + image_level_offset(image, mip);
+		copy_buffer_to_image(cmd_buffer, allocator.staging.buffer, vk_image, max(image.width >> mip, 1), max(image.height >> mip, 1), mip_offset, mip);
+	}
+	transition_ImageLayout(cmd_buffer, vk_image, image_format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, image.num_mips, staging_queue.queue_family, staging_queue.dst_queue_family);
+}
+
 Texture make_TextureImage(TextureAllocator& allocator, const Image& image) {
 	VkDevice device = allocator.device;
 	VkPhysicalDevice physical_device = allocator.physical_device;
@@ -466,74 +504,70 @@ Texture make_TextureImage(TextureAllocator& allocator, const Image& image) {
 
 	VkFormat image_format = to_vk_image_format(image);
 
-	void* pixels = image.data;
-
-	u64 texel_sizes[4] = { 1, 1, 4, 1 };
-	u64 texel_alignment = texel_sizes[(uint)image.format] * image.num_channels;
-	VkDeviceSize image_size = image.width * image.height * image.num_channels * texel_sizes[(uint)image.format];
-
-	if (!pixels) throw "Failed to load texture image!";
-
-
-	int32_t offset = aligned_incr(&allocator.staging_buffer_offset, image_size, texel_alignment);
-	memcpy((char*)allocator.staging.mapped + offset, pixels, image_size);
-
-	assert(allocator.staging_buffer_offset < MAX_IMAGE_UPLOAD);
-	assert(offset % texel_alignment == 0);
+	if (!image.data) throw "Failed to load texture image!";
 
 	int mip = select_mip(image.width, image.height);
 	assert(mip < MAX_MIP);
-	TextureAllocInfo* info = allocator.aligned_free_list[(int)mip];
+
+	//Image memory is never returned, freed images are reused when the layout matches exactly
+	TextureAllocInfo** link = &allocator.aligned_free_list[(int)mip];
+	TextureAllocInfo* info = *link;
 
 	while (info != NULL) {
-		if (info->width <= image.width && info->height <= image.height && info->format == image_format) {
+		if (info->width == image.width && info->height == image.height && info->mips == image.num_mips && info->format == image_format) {
+			*link = info->next;
 			break;
 		}
+		link = &info->next;
 		info = info->next;
 	}
 
 	VkImage vk_image;
 
 	if (info == NULL) {
-		make_Image(device, physical_device, image.width, image.height, image_format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &vk_image);
+		make_Image(device, physical_device, image.width, image.height, image_format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &vk_image, image.num_mips);
 
 		alloc_and_bind_memory(allocator, vk_image);
 
 		info = &allocator.memory_alloc_info[allocator.texture_allocated_count++];
 		info->width = image.width;
 		info->height = image.height;
+		info->mips = image.num_mips;
 		info->format = image_format;
 		info->image = vk_image;
 	}
 	else {
 		vk_image = info->image;
-		assert(false);
 	}
 
-	//THIS WAY WE CAN EXECUTE ALL THE RESOURCE TRANSFERS IN THE GRAPHICS QUEUE
-	TextureAllocInfo* next_info = allocator.uploaded_this_frame;
-	allocator.uploaded_this_frame = info;
-	info->next = next_info;
-
-	VkCommandBuffer cmd_buffer = staging_queue.cmd_buffers[staging_queue.frame_index]; 
-
-	printf("COPYING DATA TO IMAGE : 0x%p %ix%i\n", vk_image, info->width, info->height);
-
-	transition_ImageLayout(cmd_buffer, vk_image, image_format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1);
-	copy_buffer_to_image(cmd_buffer, allocator.staging.buffer, vk_image, image.width, image.height, offset);
-	transition_ImageLayout(cmd_buffer, vk_image, image_format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, staging_queue.queue_family, staging_queue.dst_queue_family);
+	record_texture_upload(allocator, info, image);
 	
 	Texture result;
 	result.desc = image;
 	result.alloc_info = info;
 	result.image = vk_image;
-	result.view = make_ImageView(device, vk_image, image_format, VK_IMAGE_ASPECT_COLOR_BIT);
+	result.view = make_ImageView(device, vk_image, image_format, VK_IMAGE_ASPECT_COLOR_BIT, image.num_mips);
 
 	assert(info->image != NULL);
 
 	return result;
 }
 
+bool update_TextureImage(TextureAllocator& allocator, Texture& texture, const Image& image) {
+	assert(allocator.staging_queue.recording);
+
+	const TextureDesc& desc = texture.desc;
+	bool same_layout = desc.width == image.width
+		&& desc.height == image.height
+		&& desc.num_mips == image.num_mips
+		&& to_vk_image_format(desc) == to_vk_image_format(image);
+
+	if (!same_layout || !image.data) return false;
+
+	record_texture_upload(allocator, texture.alloc_info, image);
+	return true;
+}
+
 void transfer_image_ownership(TextureAllocator& allocator, VkCommandBuffer cmd_buffer) {
 	StagingQueue& queue = allocator.staging_queue;
 	TextureAllocInfo* transfer_ownership = allocator.uploaded_this_frame;
@@ -570,6 +604,9 @@ void transition_layout(CommandBuffer& cmd_buffer, texture_handle handle, Texture
 void destroy_TextureImage(TextureAllocator& allocator, Texture& texture) {
 	TextureAllocInfo* info = texture.alloc_info;
 
+	vkDestroyImageView(allocator.device, texture.view, nullptr);
+	texture.view = VK_NULL_HANDLE;
+
 	int mip = select_mip(info->width, info->height);
 	
 	TextureAllocInfo* next = allocator.aligned_free_list[mip];
@@ -11,8 +11,7 @@
 #include <stdio.h>
 #include <shaderc/shaderc.h>
 #include "engine/vfs.h"
-#include <thread>
-#include <mutex>
+#include "engine/pack.h"
 
 #include "graphics/assets/assets_store.h"
 #include <stb_image.h>
@@ -20,15 +19,27 @@
 
 #include "core/io/logger.h"
 #include "core/profiler.h"
+#include "core/job_system/job.h"
 
 Assets assets;
 ENGINE_API DefaultTextures default_textures;
 ENGINE_API DefaultMaterials default_materials;
 ENGINE_API DefaultShaders default_shaders; 
 
-void make_AssetManager(string_view path, string_view engine_path) {
+void set_asset_path(string_view path, string_view engine_path) {
 	path_absolute(path, &assets.asset_path);
-    path_absolute(engine_path, &assets.engine_asset_path);
+	path_absolute(engine_path, &assets.engine_asset_path);
+}
+
+void make_AssetManager(string_view path, string_view engine_path) {
+	set_asset_path(path, engine_path);
+
+	//Packed assets never change on disk, so there is nothing to watch
+	AssetReloader& reloader = assets.reloader;
+	if (!io_mount_pack(tformat(assets.asset_path, ASSET_PACK_FILENAME))) {
+		if (make_FileWatcher(reloader.watchers[0], assets.asset_path)) reloader.watcher_count++;
+		if (make_FileWatcher(reloader.watchers[reloader.watcher_count], assets.engine_asset_path)) reloader.watcher_count++;
+	}
 
 	init_primitives();
 	assets.cubemap_pass_resources = make_cubemap_pass_resources();
@@ -67,7 +78,33 @@ void make_AssetManager(string_view path, string_view engine_path) {
 	}
 }
 
-void destroy_AssetManager() {}
+void destroy_AssetManager() {
+	AssetReloader& reloader = assets.reloader;
+	wait_for_counter(&reloader.texture_counter, 0);
+	destroy_TextureStreamer(assets.streamer);
+
+	for (uint i = 0; i < reloader.watcher_count; i++) destroy_FileWatcher(reloader.watchers[i]);
+	reloader.watcher_count = 0;
+
+	io_unmount_pack();
+}
+
+void watch_asset(WatchedAssetType type, string_view path, uint handle, const glm::mat4& transform) {
+	for (WatchedAsset& watched : assets.reloader.watched) {
+		if (watched.type == type && watched.path == path) {
+			watched.handle = handle;
+			watched.transform = transform;
+			return;
+		}
+	}
+
+	WatchedAsset watched;
+	watched.type = type;
+	watched.path = path;
+	watched.handle = handle;
+	watched.transform = transform;
+	assets.reloader.watched.append(std::move(watched));
+}
 
 string_buffer tasset_path(string_view filename) {
     string_view asset_path = assets.asset_path;
@@ -154,17 +191,42 @@ Shader* get_Shader(shader_handle handle) {
 	return assets.shaders.get(handle);
 }
 
-string_buffer tcache_filename(string_view filename, shader_flags flags) {
-	string_view base = "shaders/cache/";
-	filename = filename.sub(strlen("shaders/"), filename.length);
-	string_buffer result = tformat(base, filename, flags, ".spirv");
-	for (uint i = base.length; i < result.length; i++) {
-		if (result[i] == '\\') result.data[i] = '_';
-		if (result[i] == '/') result.data[i] = '_';
+struct ShaderCompileJob {
+	Stage stage;
+	shader_flags flags;
+	string_view source;
+	string_view filename;
+	const ShaderCache* cache;
+	u64 key;
+	string_view cached_spirv;
+	string_buffer spirv;
+	string_buffer err;
+	bool cached;
+};
+
+//The cache is only read while the jobs run, compiled permutations are added once all of them finished
+void compile_shader_job(ShaderCompileJob& job) {
+	string_buffer source;
+
+	try {
+		source = preprocess_source(job.source, job.stage, job.flags);
 	}
-	return result;
+	catch (const char* message) {
+		job.err = message;
+		return;
+	}
+
+	job.key = shader_cache_key(source, job.stage, job.flags);
+	job.cached = shader_cache_lookup(*job.cache, job.key, &job.cached_spirv);
+	if (job.cached) return;
+
+	shaderc_compiler_t& compiler = rhi.shader_compilers[get_worker_id()];
+	if (!compiler) compiler = shaderc_compiler_initialize();
+
+	job.spirv = compile_glsl_to_spirv(compiler, job.stage, source, job.filename, &job.err);
 }
 
+//Every stage of every permutation is preprocessed, looked up in the cache and compiled in its own job
 bool load_Shader(Shader& shader, string_buffer& err) {
 	//std::scoped_lock scoped_lock(shader.mutex);
 	
@@ -191,53 +253,49 @@ bool load_Shader(Shader& shader, string_buffer& err) {
 
 	log("Loading shader ", vfilename, "with ", shader.config_flags.length, "permutations\n");
 
-	for (uint i = 0; i < shader.config_flags.length; i++) {
-		shader_flags flags = shader.config_flags[i];
+	ShaderCache& cache = assets.shader_cache;
+	load_ShaderCache(cache);
 
-		//todo use just the end of the filename
-		string_buffer vert_cache_file = tcache_filename(vfilename, flags);
-		string_buffer frag_cache_file = tcache_filename(ffilename, flags);
+	//A vertex and fragment job for each permutation
+	uint job_count = 2 * shader.config_flags.length;
 
-		i64 vert_time_cached = io_time_modified(vert_cache_file);
-		i64 frag_time_cached = io_time_modified(frag_cache_file);
+	ShaderCompileJob jobs[2 * MAX_SHADER_CONFIGS];
+	JobDesc desc[2 * MAX_SHADER_CONFIGS];
 
-		string_buffer spirv_vert, spirv_frag;
+	for (uint i = 0; i < job_count; i++) {
+		ShaderCompileJob& job = jobs[i];
+		bool vertex = i % 2 == 0;
 
-		if (vert_time_cached != -1 && vert_time_cached > shader.info.v_time_modified) {
-			if (!io_readf(vert_cache_file, &spirv_vert)) {
-				err = "Failed to read cache file";
-				return false;
-			}
-		}
-		else {
-			log("Recompiling vertex shader\n");
-			
-			spirv_vert = compile_glsl_to_spirv(rhi.shader_compiler, VERTEX_STAGE, vert_source, vfilename, flags, &err);
-			if (spirv_vert.length > 0) io_writef(vert_cache_file, spirv_vert);
-		}
+		job.stage = vertex ? VERTEX_STAGE : FRAGMENT_STAGE;
+		job.flags = shader.config_flags[i / 2];
+		job.source = vertex ? vert_source : frag_source;
+		job.filename = vertex ? vfilename : ffilename;
+		job.cache = &cache;
+		job.key = 0;
+		job.cached = false;
 
-		if (err.length > 0) {
-			fprintf(stderr, "Failed to compile shader %s", err.data);
-			return false;
-		}
+		desc[i] = JobDesc(compile_shader_job, &job);
+	}
 
-		if (frag_time_cached != -1 && frag_time_cached > shader.info.f_time_modified) {
-			if (!io_readf(frag_cache_file, &spirv_frag)) {
-				err = "Failed to read cache file";
-				return false;
-			}
-		}
-		else {
-			log("Recompiling fragment shader\n");
+	wait_for_jobs(PRIORITY_HIGH, { desc, job_count });
 
-			spirv_frag = compile_glsl_to_spirv(rhi.shader_compiler, FRAGMENT_STAGE, frag_source, ffilename, flags, &err);
-			if (spirv_frag.length > 0) io_writef(frag_cache_file, spirv_frag);
-		}
+	for (uint i = 0; i < job_count; i++) {
+		if (jobs[i].err.length == 0) continue;
 
-		if (err.length > 0) {
-			fprintf(stderr, "Failed to compile shader %s", err.data);
-			return false;
-		}
+		err = jobs[i].err;
+		fprintf(stderr, "Failed to compile shader %s", err.data);
+		return false;
+	}
+
+	for (uint i = 0; i < shader.config_flags.length; i++) {
+		ShaderCompileJob& vert = jobs[i * 2];
+		ShaderCompileJob& frag = jobs[i * 2 + 1];
+
+		string_view spirv_vert = vert.cached ? vert.cached_spirv : (string_view)vert.spirv;
+		string_view spirv_frag = frag.cached ? frag.cached_spirv : (string_view)frag.spirv;
+
+		if (!vert.cached) log("Recompiled vertex shader\n");
+		if (!frag.cached) log("Recompiled fragment shader\n");
 
 		ShaderModules modules = {};
 		modules.vert = make_ShaderModule(spirv_vert);
@@ -251,9 +309,15 @@ bool load_Shader(Shader& shader, string_buffer& err) {
 		
 		shader.configs[i] = modules; 
 
-		log("Compiled config %i\n", flags);
+		log("Compiled config %i\n", shader.config_flags[i]);
+	}
+
+	for (uint i = 0; i < job_count; i++) {
+		if (!jobs[i].cached) shader_cache_insert(cache, jobs[i].key, jobs[i].spirv);
 	}
 
+	if (!save_ShaderCache(cache)) log("Could not write the shader cache\n");
+
 	log("Loaded all configs for shader : ", vfilename, " ", ffilename, "\n");
 	return true;
 }
@@ -365,14 +429,28 @@ bool reload_modified_shaders() {
 }
 
 
+//Prefers the cooked model, only falling back to assimp and recooking when it is missing or stale
+void load_model_cached(Model* model, string_view path, const glm::mat4& matrix) {
+	string_buffer cooked_path = tformat(path, ".cooked");
+	i64 time_modified = io_time_modified(path);
+
+	if (load_cooked_model(model, cooked_path, time_modified, matrix)) return;
+
+	load_assimp(model, tasset_path(path), matrix);
+	upload_model_buffers(model);
+
+	if (!save_cooked_model(*model, cooked_path, time_modified, matrix)) {
+		log("Could not write cooked model ", cooked_path, "\n");
+	}
+}
+
 void load_Model(model_handle handle, string_view path, const glm::mat4& matrix, slice<float> lod_distance) {
 	Model model;
 	model.lod_distance = lod_distance;
 
-	string_buffer full_path = tasset_path(path);
-
-	load_assimp(&model, full_path, matrix);
+	load_model_cached(&model, path, matrix);
 	assets.models.assign_handle(handle, std::move(model));
+	watch_asset(WatchedAssetType::Model, path, handle.id, matrix);
 }
 
 VertexBuffer get_vertex_buffer(model_handle model_handle, uint mesh_index, uint lod) {
@@ -386,12 +464,11 @@ model_handle load_Model(string_view path, bool serialized, const glm::mat4& tran
 	if (index != -1) return { assets.path_to_handle.values[index] };
 
 	Model model;
-	string_buffer full_path = tasset_path(path);
-
-	load_assimp(&model, full_path, trans);
+	load_model_cached(&model, path, trans);
 
 	model_handle model_handle = assets.models.assign_handle(std::move(model), serialized);
 	assets.path_to_handle.set(path, model_handle.id);
+	watch_asset(WatchedAssetType::Model, path, model_handle.id, trans);
 	return model_handle;
 }
 
@@ -410,22 +487,11 @@ texture_handle upload_Texture(const Image& image, bool serialized) {
 	return assets.textures.assign_handle(std::move(tex), serialized);
 }
 
-Image load_Image(string_view filename, bool reverse) {
-	string_buffer real_filename = tasset_path(filename); 
-
+Image load_Image(string_view filename, bool reverse, uint num_channels) {
 	stbi_set_flip_vertically_on_load(reverse);
 
-    int width, height, num_channels;
-
-    Image image;
-	image.data = stbi_load(real_filename.c_str(), &width, &height, &num_channels, STBI_rgb_alpha); //todo might waste space
-    image.width = width;
-    image.height = height;
-    image.num_channels = 4;
-	image.format = TextureFormat::UNORM;
-	//image.usage = TextureUsage::Sampled | TextureUsage::TransferDst;
-
-	if (!image.data) throw "Could not load texture";
+	Image image;
+	if (!decode_Image(filename, &image, num_channels)) throw "Could not load texture";
 
 	return image;
 }
@@ -435,10 +501,15 @@ void free_Image(Image& image) {
 }
 
 void load_Texture(texture_handle handle, string_view path) {
-	Image image = load_Image(path);
-	assets.textures.assign_handle(handle, make_TextureImage(rhi.texture_allocator, image));
+	stbi_set_flip_vertically_on_load(false);
+
+	CookedTexture texture;
+	if (!load_texture_cached(path, texture_usage_from_path(path), &texture)) throw "Could not load texture";
+
+	assets.textures.assign_handle(handle, make_TextureImage(rhi.texture_allocator, texture.image));
 	assets.path_to_handle.set(path, handle.id);
-	free_Image(image);
+	watch_asset(WatchedAssetType::Texture, path, handle.id);
+	free_cooked_texture(texture);
 }
 
 texture_handle load_Texture(string_view path, bool serialized) {
@@ -446,11 +517,16 @@ texture_handle load_Texture(string_view path, bool serialized) {
 
 	printf("LOADING TEXTURE %s\n", path.c_str());
 	
-	Image image = load_Image(path);
-	texture_handle handle = upload_Texture(image, serialized);
-	free_Image(image);
+	stbi_set_flip_vertically_on_load(false);
+
+	CookedTexture texture;
+	if (!load_texture_cached(path, texture_usage_from_path(path), &texture)) throw "Could not load texture";
+
+	texture_handle handle = upload_Texture(texture.image, serialized);
+	free_cooked_texture(texture);
 
 	assets.path_to_handle.set(path, handle.id);
+	watch_asset(WatchedAssetType::Texture, path, handle.id);
 
 	return handle;
 }
@@ -488,84 +564,70 @@ u64 hash_func(SamplerDesc& sampler_desc) {
 		| ((uint)sampler_desc.max_anisotropy << 10);
 }
 
-void load_TextureBatch(slice<TextureLoadJob> batch) {
-	for (TextureLoadJob job : batch) {
-		load_Texture(job.handle, job.path);
-	}
+//Number of textures decoded while the previous group is being uploaded
+const uint TEXTURE_DECODE_GROUP = 8;
 
-	/*
-	string_buffer buffer;
-	buffer.allocator = &get_temporary_allocator();
-	DeserializerBuffer serializer;
-	constexpr int num_threads = 9;
-
-	std::mutex tasks_lock;
-	vector<Texture*> tasks;
+struct TextureDecodeJob {
+	sstring path;
+	CookedTexture texture;
+	bool decoded;
+};
 
-	std::mutex result_lock;
-	vector<Image> loaded_image;
-	vector<Texture*> loaded_image_tex;
+void decode_texture_job(TextureDecodeJob& job) {
+	job.decoded = load_texture_cached(job.path, texture_usage_from_path(job.path), &job.texture);
+}
 
-	int num_tasks_left = batch.length;
+//Loading and cooking textures that are out of date run on the job system, the upload stays on the calling thread.
+//The groups are double buffered, waiting on a group lets this thread pick up decode jobs as well
+void load_TextureBatch(slice<TextureLoadJob> batch) {
+	Profile profile("Load texture batch");
 
-	for (int i = 0; i < batch.length; i++) {
-		texture_handle handle = batch[i].handle;
-		
-		Texture tex;
-		tex.filename = batch[i].path;
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
 
-		//todo assign handle should return pointer
-		assets.textures.assign_handle(handle, std::move(tex));
-		tasks.append(assets.textures.get(handle));
-	}
+	stbi_set_flip_vertically_on_load(false);
 
-	std::thread threads[num_threads];
+	TextureDecodeJob* jobs = TEMPORARY_ZEROED_ARRAY(TextureDecodeJob, batch.length);
+	JobDesc* desc = TEMPORARY_ARRAY(JobDesc, batch.length);
+	atomic_counter counters[2] = {};
 
-	for (int i = 0; i < num_threads; i++) {
-		threads[i] = std::thread([&, i]() {
-			while (true) {
-				tasks_lock.lock();
-				if (tasks.length == 0) {
-					tasks_lock.unlock();
-					break;
-				}
+	for (uint i = 0; i < batch.length; i++) {
+		jobs[i].path = batch[i].path;
+		desc[i] = JobDesc(decode_texture_job, jobs + i);
+	}
 
-				Texture* tex = tasks.pop();
-				tasks_lock.unlock();
+	uint group_count = (batch.length + TEXTURE_DECODE_GROUP - 1) / TEXTURE_DECODE_GROUP;
 
-				Image image; //load_Image(asset_manager, tex->filename); // assets.textures.load_Image(tex->filename);
+	auto group_jobs = [&](uint group) -> slice<JobDesc> {
+		uint begin = group * TEXTURE_DECODE_GROUP;
+		return { desc + begin, min(TEXTURE_DECODE_GROUP, batch.length - begin) };
+	};
 
-				result_lock.lock();
-				loaded_image.append(std::move(image));
-				loaded_image_tex.append(tex);
-				num_tasks_left--;
-				result_lock.unlock();
-			}
-		});
-	}
+	if (group_count > 0) add_jobs(PRIORITY_HIGH, group_jobs(0), counters);
 
+	for (uint group = 0; group < group_count; group++) {
+		if (group + 1 < group_count) add_jobs(PRIORITY_HIGH, group_jobs(group + 1), counters + (group + 1) % 2);
 
-	while (true) {
-		result_lock.lock();
-		if (loaded_image_tex.length == 0) {
-			result_lock.unlock();
-			continue;
-		}
+		wait_for_counter(counters + group % 2, 0);
 
-		Texture* tex = loaded_image_tex.pop();
-		Image image = loaded_image.pop();
-		result_lock.unlock();
+		uint begin = group * TEXTURE_DECODE_GROUP;
+		uint end = min(begin + TEXTURE_DECODE_GROUP, batch.length);
 
-		//tex->texture_id = gl_submit(image);
+		for (uint i = begin; i < end; i++) {
+			TextureDecodeJob& job = jobs[i];
+			if (!job.decoded) {
+				log("Could not load texture ", job.path, "\n");
+				continue;
+			}
 
-		if (num_tasks_left == 0 && loaded_image_tex.length == 0) {
-			break;
+			assets.textures.assign_handle(batch[i].handle, make_TextureImage(rhi.texture_allocator, job.texture.image));
+			assets.path_to_handle.set(batch[i].path, batch[i].handle.id);
+			watch_asset(WatchedAssetType::Texture, batch[i].path, batch[i].handle.id);
+			free_cooked_texture(job.texture);
 		}
 	}
 
-	for (int i = 0; i < num_threads; i++) {
-		threads[i].join();
-	}*/
+	profile.end();
 }
 
 void load() {
@@ -636,15 +698,156 @@ pipeline_handle query_pipeline(material_handle material, RenderPass::ID render_p
 	return query_Pipeline(desc);
 }
 
+//Top level shader files reload the shaders using them. Any other file under shaders/ is an #include,
+//so every shader is reloaded, which only recompiles the permutations whose preprocessed source changed
+void reload_shaders_using(string_view path) {
+	auto& shaders = assets.shaders;
+	bool is_include = true;
+
+	for (uint i = 0; i < shaders.slots.length; i++) {
+		ShaderInfo& info = shaders.slots[i].info;
+		if (info.vfilename == path || info.ffilename == path) {
+			reload_Shader(shaders.index_to_handle(i));
+			is_include = false;
+		}
+	}
+
+	if (!is_include) return;
+
+	for (uint i = 0; i < shaders.slots.length; i++) {
+		ShaderInfo& info = shaders.slots[i].info;
+		if (info.vfilename.length() > 0) reload_Shader(shaders.index_to_handle(i));
+	}
+}
+
+void reload_texture_job(TextureReloadJob& job) {
+	job.loaded = cook_texture(job.path, texture_usage_from_path(job.path)) && load_cooked_texture(job.path, &job.texture);
+}
+
+void start_texture_reloads(AssetReloader& reloader) {
+	if (reloader.reloading_textures.length > 0 || reloader.queued_textures.length == 0) return;
+
+	reloader.reloading_textures = std::move(reloader.queued_textures);
+
+	LinearRegion region(get_temporary_allocator());
+	tvector<JobDesc> desc;
+
+	for (TextureReloadJob& job : reloader.reloading_textures) desc.append(JobDesc(reload_texture_job, &job));
+
+	add_jobs(PRIORITY_LOW, desc, &reloader.texture_counter);
+}
+
+//The textures are uploaded into their existing images, so materials keep pointing at them
+void upload_reloaded_textures() {
+	AssetReloader& reloader = assets.reloader;
+	if (reloader.reloading_textures.length == 0 || reloader.texture_counter != 0) return;
+
+	//the previous contents may still be read by frames in flight
+	wait_for_frames_in_flight();
+	begin_gpu_upload();
+
+	for (TextureReloadJob& job : reloader.reloading_textures) {
+		if (!job.loaded) {
+			log("Could not reload texture ", job.path, "\n");
+			continue;
+		}
+
+		//a streamed texture may still share the image of a default texture, the streamer loads the new file instead
+		if (restream_Texture(job.handle)) {
+			free_cooked_texture(job.texture);
+			continue;
+		}
+
+		Texture* texture = assets.textures.get(job.handle);
+		if (texture && update_TextureImage(rhi.texture_allocator, *texture, job.texture.image)) log("Reloaded texture ", job.path, "\n");
+		else log("Texture ", job.path, " changed size or format, it is picked up the next time it is loaded\n");
+
+		free_cooked_texture(job.texture);
+	}
+
+	end_gpu_upload();
+	reloader.reloading_textures.clear();
+}
+
+void queue_texture_reload(AssetReloader& reloader, WatchedAsset& watched) {
+	for (TextureReloadJob& job : reloader.queued_textures) {
+		if (job.path == watched.path) return;
+	}
+
+	TextureReloadJob job;
+	job.handle = { watched.handle };
+	job.path = watched.path;
+	job.loaded = false;
+	reloader.queued_textures.append(std::move(job));
+}
+
+//Imported on this thread, assimp allocates the model from the permanent allocator
+void reload_model(WatchedAsset& watched) {
+	Model* model = assets.models.get({ watched.handle });
+	if (!model) return;
+
+	Model reloaded;
+	reloaded.lod_distance = model->lod_distance;
+
+	//the cooked model is rewritten below, which windows refuses while it is mapped
+	io_unmapf(model->file);
+
+	begin_gpu_upload();
+	load_model_cached(&reloaded, watched.path, watched.transform);
+	end_gpu_upload();
+
+	//the meshes live in the permanent allocator, so they outlive the frames still drawing their buffers
+	for (Mesh& mesh : model->meshes) {
+		queue_for_destruction(&mesh, [](void* ptr) {
+			Mesh& mesh = *(Mesh*)ptr;
+			for (uint lod = 0; lod < mesh.lod_count; lod++) dealloc_vertex_buffer(mesh.buffer[lod]);
+		});
+	}
+
+	//assigning the handle again would append another slot
+	*model = std::move(reloaded);
+	log("Reloaded model ", watched.path, "\n");
+}
+
 void reload_modified() {
+	AssetReloader& reloader = assets.reloader;
 
+	if (reloader.watcher_count == 0) {
+		if (!io_pack_mounted()) reload_modified_shaders();
+		return;
+	}
+
+	vector<string_buffer> modified;
+	for (uint i = 0; i < reloader.watcher_count; i++) poll_FileWatcher(reloader.watchers[i], modified);
+
+	for (string_buffer& path : modified) {
+		string_view view = path;
+
+		//written by the asset pipeline itself
+		if (view.ends_with(".cooked") || view.ends_with(".cooked.tmp") || view.starts_with("shaders/cache/")) continue;
+
+		if (view.starts_with("shaders/")) {
+			reload_shaders_using(view);
+			continue;
+		}
+
+		for (WatchedAsset& watched : reloader.watched) {
+			if (watched.path != view) continue;
+
+			if (watched.type == WatchedAssetType::Texture) queue_texture_reload(reloader, watched);
+			if (watched.type == WatchedAssetType::Model) reload_model(watched);
+		}
+	}
+
+	start_texture_reloads(reloader);
 }
 
 //cubemaps are somewhat of a special case as they require 
 //processing on the graphics queue which is somewhat awkward
 
 void load_assets_in_queue() {
-	return;
+	update_TextureStreamer(assets.streamer);
+
 	/*begin_gpu_upload();
 
 	EquirectangularToCubemapJob job;
@@ -664,26 +867,16 @@ void load_assets_in_queue() {
 cubemap_handle load_HDR(string_view filename) {
 	if (uint* cached = assets.path_to_handle.get(filename)) return { *cached };
 
-	string_buffer real_filename = tasset_path(filename);
-
-    int width, height, num_channels;
-    
-	Image image = {};
-	image.data = stbi_loadf(real_filename.c_str(), &width, &height, &num_channels, STBI_rgb_alpha);
-    image.width = width;
-    image.height = height;
-    image.num_channels = 4;
-	image.format = TextureFormat::HDR;
-
-	assert(image.data);
+	CookedTexture cooked;
+	bool loaded = load_texture_cached(filename, TextureCookUsage::HDR, &cooked);
+	assert(loaded);
 
-	Texture texture = make_TextureImage(rhi.texture_allocator, image);
+	Texture texture = make_TextureImage(rhi.texture_allocator, cooked.image);
 	texture_handle env_map = assets.textures.assign_handle(std::move(texture));
 
 	printf("LOADED ENV MAP %p\n", texture.image);
 
-	stbi_image_free(image.data);
-	
+	free_cooked_texture(cooked);
 
 	//texture_handle env_map = load_Texture("Wood_2//Stylized_Wood_basecolor.jpg");
 
@@ -6,6 +6,9 @@
 #include "engine/vfs.h"
 #include "core/io/logger.h"
 #include "graphics/assets/model.h"
+#include "graphics/assets/vertex_compression.h"
+#include "graphics/assets/mesh_optimizer.h"
+#include "graphics/assets/mesh_simplify.h"
 #include "core/memory/linear_allocator.h"
 
 struct ModelLoadingScratch {
@@ -170,18 +173,21 @@ void load_assimp(Model* model, string_view real_path, const glm::mat4& apply_tra
 	model->meshes.data = scratch.meshes_base;
 	model->aabb = AABB();
 	
-	//todo merge into one upload
 	for (int i = 0; i < scratch.mesh_count; i++) {
 		Mesh* mesh = scratch.meshes_base + i;
 		mesh->lod_count = lods.length;
 
 		model->aabb.update_aabb(mesh->aabb);
+	}
 
-		for (uint lod = 0; lod < lods.length; lod++) {
-			mesh->buffer[lod] = alloc_vertex_buffer<Vertex>(VERTEX_LAYOUT_DEFAULT, mesh->vertices[lod], mesh->indices[lod]);
-		}
+	uint lod_count = lods.length;
+	if (lod_count == 1) {
+		lod_count = generate_model_lods(model, GENERATED_LOD_COUNT, GENERATED_LOD_RATIO, GENERATED_LOD_MAX_ERROR);
 	}
 
+	//welds, reorders for the vertex cache and overdraw, and drops unreferenced vertices
+	optimize_model_meshes(model);
+
 	model->materials.length = lods[0]->mNumMaterials;
 	model->materials.data = PERMANENT_ARRAY(sstring, model->materials.length);
 	
@@ -196,19 +202,49 @@ void load_assimp(Model* model, string_view real_path, const glm::mat4& apply_tra
 		model->materials[i] = c_name.data;
 	}
 
+	assign_lod_distances(model, lod_count);
+}
+
+//todo merge into one upload
+//Compact vertices are only decoded for the upload, the vertex shaders still consume the full Vertex
+void upload_model_buffers(Model* model) {
+	for (Mesh& mesh : model->meshes) {
+		for (uint lod = 0; lod < mesh.lod_count; lod++) {
+			slice<Vertex> vertices = mesh.vertices[lod];
+
+			LinearAllocator& allocator = get_temporary_allocator();
+			LinearRegion region(allocator);
+
+			if (mesh.compact_vertices[lod].length > 0) {
+				vertices = { TEMPORARY_ARRAY(Vertex, mesh.compact_vertices[lod].length), mesh.compact_vertices[lod].length };
+				decode_vertices(mesh.compact_vertices[lod], mesh.quantization_aabb, vertices.data);
+			}
+
+			mesh.buffer[lod] = alloc_vertex_buffer<Vertex>(VERTEX_LAYOUT_DEFAULT, vertices, mesh.indices[lod]);
+		}
+	}
+}
+
+void assign_lod_distances(Model* model, uint lod_count) {
 	float MESH_CULL_DISTANCE = 100.0f;
+	//Distance at which lod 0 is dropped, relative to the radius of the model. Each lod halves the triangles,
+	//so the next one is kept for twice as far. Small props lose detail sooner than buildings
+	float LOD0_DISTANCE_PER_RADIUS = 10.0f;
 
-	uint dist_per_lod = MESH_CULL_DISTANCE / lods.length;
-	
 	if (model->lod_distance.length == 0) {
+		float radius = 0.5f * glm::length(model->aabb.size());
+		float lod_dist = LOD0_DISTANCE_PER_RADIUS * radius;
 
-		//todo this is a pretty shitty distribution
-		for (int i = 0; i < lods.length; i++) {
-			model->lod_distance.append((i + 1) * dist_per_lod);
+		for (int i = 0; i < (int)lod_count - 1; i++) {
+			model->lod_distance.append(glm::min(lod_dist, MESH_CULL_DISTANCE));
+			lod_dist *= 2.0f;
 		}
+
+		//the last lod is kept until the mesh is culled
+		model->lod_distance.append(MESH_CULL_DISTANCE);
 	}
 	else {
-		int diff = lods.length - model->lod_distance.length;
+		int diff = lod_count - model->lod_distance.length;
 		int last_lod = model->lod_distance.last();
 
 		for (int i = 0; i < diff; i++) {
@@ -216,7 +252,5 @@ void load_assimp(Model* model, string_view real_path, const glm::mat4& apply_tra
 			model->lod_distance.append(lod_dist);
 			last_lod = lod_dist;
 		}
-
-		for (int i = 0; i < -diff; i++) lods.pop();
 	}
 }
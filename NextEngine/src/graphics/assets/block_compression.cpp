@@ -0,0 +1,269 @@
+#include "graphics/assets/block_compression.h"
+#include "core/memory/linear_allocator.h"
+#include "core/container/tvector.h"
+#include "core/job_system/job.h"
+#include <glm/glm.hpp>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+const uint COMPRESS_BLOCK_ROWS_PER_JOB = 16;
+
+inline u16 pack_565(glm::vec3 color) {
+	uint r = (uint)glm::clamp(color.r * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f);
+	uint g = (uint)glm::clamp(color.g * 63.0f / 255.0f + 0.5f, 0.0f, 63.0f);
+	uint b = (uint)glm::clamp(color.b * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f);
+	return (u16)(r << 11 | g << 5 | b);
+}
+
+inline glm::vec3 unpack_565(u16 color) {
+	uint r = (color >> 11) & 31;
+	uint g = (color >> 5) & 63;
+	uint b = color & 31;
+	return glm::vec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+}
+
+struct BC1Fit {
+	u16 color0;
+	u16 color1;
+	uint indices;
+	float error;
+};
+
+//color0 > color1 selects the opaque four color mode
+BC1Fit fit_bc1_indices(const glm::vec3 colors[16], u16 color0, u16 color1) {
+	if (color0 < color1) {
+		u16 tmp = color0;
+		color0 = color1;
+		color1 = tmp;
+	}
+
+	glm::vec3 palette[4];
+	palette[0] = unpack_565(color0);
+	palette[1] = unpack_565(color1);
+	palette[2] = (2.0f * palette[0] + palette[1]) / 3.0f;
+	palette[3] = (palette[0] + 2.0f * palette[1]) / 3.0f;
+
+	//equal endpoints decode as the three color mode, where only index 0 is the same color
+	uint palette_size = color0 == color1 ? 1 : 4;
+
+	BC1Fit fit = { color0, color1, 0, 0.0f };
+
+	for (uint i = 0; i < 16; i++) {
+		uint best = 0;
+		float best_dist = FLT_MAX;
+
+		for (uint p = 0; p < palette_size; p++) {
+			glm::vec3 diff = colors[i] - palette[p];
+			float dist = glm::dot(diff, diff);
+			if (dist < best_dist) {
+				best_dist = dist;
+				best = p;
+			}
+		}
+
+		fit.indices |= best << (2 * i);
+		fit.error += best_dist;
+	}
+
+	return fit;
+}
+
+void encode_bc1_block(const u8 rgba[64], u8 output[8]) {
+	glm::vec3 colors[16];
+	glm::vec3 mean(0.0f);
+
+	for (uint i = 0; i < 16; i++) {
+		colors[i] = glm::vec3(rgba[i * 4 + 0], rgba[i * 4 + 1], rgba[i * 4 + 2]);
+		mean += colors[i];
+	}
+
+	mean /= 16.0f;
+
+	//Principal axis of the colors by power iteration on the covariance
+	float c00 = 0, c01 = 0, c02 = 0, c11 = 0, c12 = 0, c22 = 0;
+
+	for (uint i = 0; i < 16; i++) {
+		glm::vec3 d = colors[i] - mean;
+		c00 += d.r * d.r; c01 += d.r * d.g; c02 += d.r * d.b;
+		c11 += d.g * d.g; c12 += d.g * d.b; c22 += d.b * d.b;
+	}
+
+	glm::vec3 axis(1.0f);
+
+	for (uint i = 0; i < 8; i++) {
+		glm::vec3 next(
+			c00 * axis.r + c01 * axis.g + c02 * axis.b,
+			c01 * axis.r + c11 * axis.g + c12 * axis.b,
+			c02 * axis.r + c12 * axis.g + c22 * axis.b
+		);
+
+		float scale = glm::max(fabsf(next.r), glm::max(fabsf(next.g), fabsf(next.b)));
+		if (scale == 0.0f) break;
+
+		axis = next / scale;
+	}
+
+	uint min_index = 0;
+	uint max_index = 0;
+	float min_proj = FLT_MAX;
+	float max_proj = -FLT_MAX;
+
+	for (uint i = 0; i < 16; i++) {
+		float proj = glm::dot(colors[i] - mean, axis);
+		if (proj < min_proj) { min_proj = proj; min_index = i; }
+		if (proj > max_proj) { max_proj = proj; max_index = i; }
+	}
+
+	BC1Fit best = fit_bc1_indices(colors, pack_565(colors[max_index]), pack_565(colors[min_index]));
+
+	//Least squares fit of the endpoints to the chosen indices, kept only while it lowers the error
+	const float weight0[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+	for (uint iteration = 0; iteration < 2 && best.color0 != best.color1; iteration++) {
+		float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+		glm::vec3 ax(0.0f), bx(0.0f);
+
+		for (uint i = 0; i < 16; i++) {
+			float alpha = weight0[(best.indices >> (2 * i)) & 3];
+			float beta = 1.0f - alpha;
+
+			aa += alpha * alpha;
+			bb += beta * beta;
+			ab += alpha * beta;
+			ax += alpha * colors[i];
+			bx += beta * colors[i];
+		}
+
+		float det = aa * bb - ab * ab;
+		if (fabsf(det) < 1e-6f) break;
+
+		glm::vec3 a = (bb * ax - ab * bx) / det;
+		glm::vec3 b = (aa * bx - ab * ax) / det;
+
+		BC1Fit fit = fit_bc1_indices(colors, pack_565(a), pack_565(b));
+		if (fit.error >= best.error) break;
+
+		best = fit;
+	}
+
+	output[0] = best.color0 & 0xff;
+	output[1] = best.color0 >> 8;
+	output[2] = best.color1 & 0xff;
+	output[3] = best.color1 >> 8;
+
+	for (uint i = 0; i < 4; i++) output[4 + i] = (best.indices >> (8 * i)) & 0xff;
+}
+
+void encode_bc4_block(const u8* values, uint stride, u8 output[8]) {
+	u8 lo = 255;
+	u8 hi = 0;
+
+	for (uint i = 0; i < 16; i++) {
+		u8 value = values[i * stride];
+		lo = glm::min(lo, value);
+		hi = glm::max(hi, value);
+	}
+
+	//hi > lo selects the eight value mode
+	output[0] = hi;
+	output[1] = lo;
+
+	u64 bits = 0;
+
+	if (hi != lo) {
+		float palette[8];
+		palette[0] = hi;
+		palette[1] = lo;
+		for (uint i = 1; i < 7; i++) palette[i + 1] = ((7 - i) * hi + i * lo) / 7.0f;
+
+		for (uint i = 0; i < 16; i++) {
+			float value = values[i * stride];
+			uint best = 0;
+			float best_dist = FLT_MAX;
+
+			for (uint p = 0; p < 8; p++) {
+				float dist = fabsf(value - palette[p]);
+				if (dist < best_dist) {
+					best_dist = dist;
+					best = p;
+				}
+			}
+
+			bits |= (u64)best << (3 * i);
+		}
+	}
+
+	for (uint i = 0; i < 6; i++) output[2 + i] = (bits >> (8 * i)) & 0xff;
+}
+
+void encode_bc3_block(const u8 rgba[64], u8 output[16]) {
+	encode_bc4_block(rgba + 3, 4, output);
+	encode_bc1_block(rgba, output + 8);
+}
+
+void encode_bc5_block(const u8 rgba[64], u8 output[16]) {
+	encode_bc4_block(rgba + 0, 4, output);
+	encode_bc4_block(rgba + 1, 4, output + 8);
+}
+
+void fetch_block(const u8* rgba, uint width, uint height, uint block_x, uint block_y, u8 block[64]) {
+	for (uint y = 0; y < 4; y++) {
+		uint sy = min(block_y * 4 + y, height - 1);
+
+		for (uint x = 0; x < 4; x++) {
+			uint sx = min(block_x * 4 + x, width - 1);
+			memcpy(block + (y * 4 + x) * 4, rgba + ((u64)sy * width + sx) * 4, 4);
+		}
+	}
+}
+
+struct CompressBlocksJob {
+	const u8* rgba;
+	uint width;
+	uint height;
+	TextureFormat format;
+	u8* output;
+	uint row_begin;
+	uint row_end;
+};
+
+void compress_blocks(CompressBlocksJob& job) {
+	uint blocks_x = (job.width + 3) / 4;
+	uint bytes = block_size(job.format);
+	u8 block[64];
+
+	for (uint block_y = job.row_begin; block_y < job.row_end; block_y++) {
+		for (uint block_x = 0; block_x < blocks_x; block_x++) {
+			fetch_block(job.rgba, job.width, job.height, block_x, block_y, block);
+			u8* output = job.output + ((u64)block_y * blocks_x + block_x) * bytes;
+
+			switch (job.format) {
+			case TextureFormat::BC1: encode_bc1_block(block, output); break;
+			case TextureFormat::BC3: encode_bc3_block(block, output); break;
+			case TextureFormat::BC5: encode_bc5_block(block, output); break;
+			default: break;
+			}
+		}
+	}
+}
+
+void compress_image_level(const u8* rgba, uint width, uint height, TextureFormat format, u8* output) {
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
+	uint blocks_y = (height + 3) / 4;
+
+	tvector<CompressBlocksJob> jobs;
+	tvector<JobDesc> desc;
+	jobs.reserve((blocks_y + COMPRESS_BLOCK_ROWS_PER_JOB - 1) / COMPRESS_BLOCK_ROWS_PER_JOB);
+
+	for (uint row = 0; row < blocks_y; row += COMPRESS_BLOCK_ROWS_PER_JOB) {
+		CompressBlocksJob job = { rgba, width, height, format, output, row, min(row + COMPRESS_BLOCK_ROWS_PER_JOB, blocks_y) };
+		jobs.append(job);
+	}
+
+	for (CompressBlocksJob& job : jobs) desc.append(JobDesc(compress_blocks, &job));
+
+	wait_for_jobs(PRIORITY_HIGH, desc);
+}
@@ -0,0 +1,310 @@
+#include "graphics/assets/texture.h"
+#include "graphics/assets/assets.h"
+#include "core/memory/linear_allocator.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <stb_image.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#include <emmintrin.h>
+#define IMAGE_SSE
+#endif
+
+const float KAISER_ALPHA = 4.0f;
+//In destination texels
+const float KAISER_RADIUS = 2.0f;
+
+bool decode_Image(string_view filename, Image* image, uint num_channels) {
+	string_buffer real_filename = tasset_path(filename);
+
+	int width, height, file_channels;
+
+	image->data = stbi_load(real_filename.c_str(), &width, &height, &file_channels, num_channels);
+	image->width = width;
+	image->height = height;
+	image->num_channels = num_channels;
+	image->num_mips = 1;
+	image->format = TextureFormat::UNORM;
+
+	return image->data != nullptr;
+}
+
+uint texel_size(TextureFormat format) {
+	if (format == TextureFormat::HDR) return sizeof(float);
+	if (format == TextureFormat::HALF) return sizeof(u16);
+	return 1;
+}
+
+bool is_block_compressed(TextureFormat format) {
+	return format == TextureFormat::BC1 || format == TextureFormat::BC3 || format == TextureFormat::BC5;
+}
+
+uint block_size(TextureFormat format) {
+	return format == TextureFormat::BC1 ? 8 : 16;
+}
+
+inline uint mip_size(uint size, uint mip) {
+	return max(size >> mip, 1);
+}
+
+uint max_mip_count(uint width, uint height) {
+	uint count = 1;
+	while ((width >> count) > 0 || (height >> count) > 0) count++;
+	return count;
+}
+
+u64 image_level_size(const TextureDesc& desc, uint mip) {
+	uint width = mip_size(desc.width, mip);
+	uint height = mip_size(desc.height, mip);
+
+	if (is_block_compressed(desc.format)) return (u64)((width + 3) / 4) * ((height + 3) / 4) * block_size(desc.format);
+	return (u64)width * height * texel_size(desc.format) * desc.num_channels;
+}
+
+u64 image_level_offset(const TextureDesc& desc, uint mip) {
+	u64 offset = 0;
+	for (uint i = 0; i < mip; i++) offset += image_level_size(desc, i);
+	return offset;
+}
+
+u64 image_data_size(const TextureDesc& desc) {
+	return image_level_offset(desc, desc.num_mips);
+}
+
+template<typename T>
+void downsample_box(const T* src, uint src_width, uint src_height, T* dst, uint dst_width, uint dst_height, uint channels) {
+	for (uint y = 0; y < dst_height; y++) {
+		const T* row0 = src + (u64)min(y * 2, src_height - 1) * src_width * channels;
+		const T* row1 = src + (u64)min(y * 2 + 1, src_height - 1) * src_width * channels;
+		T* out = dst + (u64)y * dst_width * channels;
+
+		for (uint x = 0; x < dst_width; x++) {
+			uint x0 = min(x * 2, src_width - 1) * channels;
+			uint x1 = min(x * 2 + 1, src_width - 1) * channels;
+
+			for (uint c = 0; c < channels; c++) {
+				out[x * channels + c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]) * 0.25f;
+			}
+		}
+	}
+}
+
+void downsample_box(const u8* src, uint src_width, uint src_height, u8* dst, uint dst_width, uint dst_height, uint channels) {
+	for (uint y = 0; y < dst_height; y++) {
+		const u8* row0 = src + (u64)min(y * 2, src_height - 1) * src_width * channels;
+		const u8* row1 = src + (u64)min(y * 2 + 1, src_height - 1) * src_width * channels;
+		u8* out = dst + (u64)y * dst_width * channels;
+
+		uint x = 0;
+
+#ifdef IMAGE_SSE
+		//Two RGBA texels out of four per row, summed in 16 bits
+		if (channels == 4 && src_width == dst_width * 2) {
+			__m128i zero = _mm_setzero_si128();
+			__m128i round = _mm_set1_epi16(2);
+
+			for (; x + 2 <= dst_width; x += 2) {
+				__m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+				__m128i b = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+
+				__m128i sum_lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+				__m128i sum_hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+				sum_lo = _mm_add_epi16(sum_lo, _mm_srli_si128(sum_lo, 8));
+				sum_hi = _mm_add_epi16(sum_hi, _mm_srli_si128(sum_hi, 8));
+
+				__m128i result = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sum_lo, sum_hi), round), 2);
+				_mm_storel_epi64((__m128i*)(out + x * 4), _mm_packus_epi16(result, result));
+			}
+		}
+#endif
+
+		for (; x < dst_width; x++) {
+			uint x0 = min(x * 2, src_width - 1) * channels;
+			uint x1 = min(x * 2 + 1, src_width - 1) * channels;
+
+			for (uint c = 0; c < channels; c++) {
+				out[x * channels + c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4;
+			}
+		}
+	}
+}
+
+float bessel_i0(float x) {
+	float sum = 1.0f;
+	float term = 1.0f;
+
+	for (uint k = 1; k < 32; k++) {
+		float t = x / (2.0f * k);
+		term *= t * t;
+		sum += term;
+		if (term < sum * 1e-7f) break;
+	}
+
+	return sum;
+}
+
+float kaiser_weight(float x) {
+	float t = x / KAISER_RADIUS;
+	if (fabsf(t) >= 1.0f) return 0.0f;
+
+	float sinc = x == 0.0f ? 1.0f : sinf(glm::pi<float>() * x) / (glm::pi<float>() * x);
+	return sinc * bessel_i0(KAISER_ALPHA * sqrtf(1.0f - t * t)) / bessel_i0(KAISER_ALPHA);
+}
+
+//Same taps for every row or column, weights is dst * tap_count
+struct KaiserTaps {
+	uint tap_count;
+	int* first;
+	float* weights;
+};
+
+KaiserTaps compute_kaiser_taps(uint src, uint dst) {
+	float scale = (float)src / dst;
+
+	KaiserTaps taps;
+	taps.tap_count = (uint)ceilf(2.0f * KAISER_RADIUS * scale) + 1;
+	taps.first = TEMPORARY_ARRAY(int, dst);
+	taps.weights = TEMPORARY_ARRAY(float, dst * taps.tap_count);
+
+	for (uint i = 0; i < dst; i++) {
+		float center = (i + 0.5f) * scale;
+		int first = (int)floorf(center - KAISER_RADIUS * scale);
+		float* weights = taps.weights + i * taps.tap_count;
+		float total = 0.0f;
+
+		for (uint j = 0; j < taps.tap_count; j++) {
+			weights[j] = kaiser_weight(((first + (int)j + 0.5f) - center) / scale);
+			total += weights[j];
+		}
+
+		for (uint j = 0; j < taps.tap_count; j++) weights[j] /= total;
+		taps.first[i] = first;
+	}
+
+	return taps;
+}
+
+inline void madd(glm::vec4& acc, const glm::vec4& texel, float weight) {
+#ifdef IMAGE_SSE
+	_mm_storeu_ps(&acc.x, _mm_add_ps(_mm_loadu_ps(&acc.x), _mm_mul_ps(_mm_loadu_ps(&texel.x), _mm_set1_ps(weight))));
+#else
+	acc += texel * weight;
+#endif
+}
+
+template<typename T>
+void load_row(const T* src, uint width, uint channels, glm::vec4* out) {
+	for (uint x = 0; x < width; x++) {
+		out[x] = glm::vec4(0.0f);
+		for (uint c = 0; c < channels; c++) out[x][c] = src[x * channels + c];
+	}
+}
+
+inline void store_texel(const glm::vec4& texel, u8* out, uint channels) {
+	for (uint c = 0; c < channels; c++) out[c] = (u8)glm::clamp(texel[c] + 0.5f, 0.0f, 255.0f);
+}
+
+inline void store_texel(const glm::vec4& texel, float* out, uint channels) {
+	for (uint c = 0; c < channels; c++) out[c] = texel[c];
+}
+
+//Separable windowed sinc, the horizontally filtered rows are kept in a ring so each one is only computed once
+template<typename T>
+void downsample_kaiser(const T* src, uint src_width, uint src_height, T* dst, uint dst_width, uint dst_height, uint channels) {
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
+	KaiserTaps horizontal = compute_kaiser_taps(src_width, dst_width);
+	KaiserTaps vertical = compute_kaiser_taps(src_height, dst_height);
+
+	uint ring_size = vertical.tap_count;
+	glm::vec4* ring = TEMPORARY_ARRAY(glm::vec4, ring_size * dst_width);
+	int* ring_row = TEMPORARY_ARRAY(int, ring_size);
+	glm::vec4* source_row = TEMPORARY_ARRAY(glm::vec4, src_width);
+	glm::vec4* out_row = TEMPORARY_ARRAY(glm::vec4, dst_width);
+
+	for (uint i = 0; i < ring_size; i++) ring_row[i] = -1;
+
+	auto filtered_row = [&](int y) {
+		y = glm::clamp(y, 0, (int)src_height - 1);
+
+		uint slot = y % ring_size;
+		glm::vec4* row = ring + slot * dst_width;
+		if (ring_row[slot] == y) return row;
+
+		load_row(src + (u64)y * src_width * channels, src_width, channels, source_row);
+
+		for (uint x = 0; x < dst_width; x++) {
+			glm::vec4 acc(0.0f);
+			const float* weights = horizontal.weights + x * horizontal.tap_count;
+
+			for (uint j = 0; j < horizontal.tap_count; j++) {
+				int sx = glm::clamp(horizontal.first[x] + (int)j, 0, (int)src_width - 1);
+				madd(acc, source_row[sx], weights[j]);
+			}
+
+			row[x] = acc;
+		}
+
+		ring_row[slot] = y;
+		return row;
+	};
+
+	for (uint y = 0; y < dst_height; y++) {
+		const float* weights = vertical.weights + y * vertical.tap_count;
+
+		for (uint x = 0; x < dst_width; x++) out_row[x] = glm::vec4(0.0f);
+
+		for (uint j = 0; j < vertical.tap_count; j++) {
+			if (weights[j] == 0.0f) continue;
+
+			glm::vec4* row = filtered_row(vertical.first[y] + (int)j);
+			for (uint x = 0; x < dst_width; x++) madd(out_row[x], row[x], weights[j]);
+		}
+
+		T* out = dst + (u64)y * dst_width * channels;
+		for (uint x = 0; x < dst_width; x++) store_texel(out_row[x], out + x * channels, channels);
+	}
+}
+
+template<typename T>
+void downsample(const T* src, uint src_width, uint src_height, T* dst, uint dst_width, uint dst_height, uint channels, MipFilter filter) {
+	if (filter == MipFilter::Box) downsample_box(src, src_width, src_height, dst, dst_width, dst_height, channels);
+	else downsample_kaiser(src, src_width, src_height, dst, dst_width, dst_height, channels);
+}
+
+void generate_mips(Image& image, MipFilter filter) {
+	uint num_mips = max_mip_count(image.width, image.height);
+	if (num_mips <= 1 || !image.data) return;
+
+	TextureDesc desc = image;
+	desc.num_mips = num_mips;
+
+	//stb allocates with malloc, so free_Image still releases the whole chain
+	void* data = realloc(image.data, image_data_size(desc));
+	if (!data) return;
+
+	image.data = data;
+	image.num_mips = num_mips;
+
+	for (uint mip = 1; mip < num_mips; mip++) {
+		char* src = (char*)data + image_level_offset(desc, mip - 1);
+		char* dst = (char*)data + image_level_offset(desc, mip);
+
+		uint src_width = mip_size(desc.width, mip - 1);
+		uint src_height = mip_size(desc.height, mip - 1);
+		uint dst_width = mip_size(desc.width, mip);
+		uint dst_height = mip_size(desc.height, mip);
+
+		if (desc.format == TextureFormat::HDR) {
+			downsample((float*)src, src_width, src_height, (float*)dst, dst_width, dst_height, desc.num_channels, filter);
+		}
+		else {
+			downsample((u8*)src, src_width, src_height, (u8*)dst, dst_width, dst_height, desc.num_channels, filter);
+		}
+	}
+}
@@ -0,0 +1,508 @@
+#include "graphics/assets/mesh_optimizer.h"
+#include "core/memory/linear_allocator.h"
+#include "core/job_system/job.h"
+#include "core/profiler.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <limits.h>
+#include <string.h>
+#include <stdio.h>
+
+const uint INVALID_VERTEX = UINT_MAX;
+
+//FNV-1a over the raw bits, welding only merges vertices that are bitwise identical
+inline uint hash_vertex(const Vertex& vertex) {
+	const uint* words = (const uint*)&vertex;
+	uint hash = 2166136261u;
+
+	for (uint i = 0; i < sizeof(Vertex) / sizeof(uint); i++) {
+		hash = (hash ^ words[i]) * 16777619u;
+	}
+
+	return hash;
+}
+
+uint weld_vertices(Vertex* vertices, uint vertex_count, uint* indices, uint index_count) {
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
+	uint table_size = 1;
+	while (table_size < vertex_count * 2) table_size <<= 1;
+
+	uint* table = TEMPORARY_ARRAY(uint, table_size);
+	uint* remap = TEMPORARY_ARRAY(uint, vertex_count);
+	memset(table, 0xff, sizeof(uint) * table_size);
+
+	//Unique vertices are compacted in place, the slot they move to has always been visited already
+	uint unique_count = 0;
+
+	for (uint i = 0; i < vertex_count; i++) {
+		uint slot = hash_vertex(vertices[i]) & (table_size - 1);
+
+		while (table[slot] != INVALID_VERTEX && memcmp(vertices + table[slot], vertices + i, sizeof(Vertex)) != 0) {
+			slot = (slot + 1) & (table_size - 1);
+		}
+
+		if (table[slot] == INVALID_VERTEX) {
+			table[slot] = unique_count;
+			vertices[unique_count++] = vertices[i];
+		}
+
+		remap[i] = table[slot];
+	}
+
+	for (uint i = 0; i < index_count; i++) indices[i] = remap[indices[i]];
+
+	return unique_count;
+}
+
+float compute_acmr(const uint* indices, uint index_count, uint vertex_count, uint cache_size) {
+	if (index_count < 3) return 0.0f;
+
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
+	//A vertex is still cached while fewer than cache_size misses happened since it was loaded
+	uint* cache_time = TEMPORARY_ZEROED_ARRAY(uint, vertex_count);
+	uint time = cache_size + 1;
+	uint misses = 0;
+
+	for (uint i = 0; i < index_count; i++) {
+		uint v = indices[i];
+		if (time - cache_time[v] > cache_size) {
+			cache_time[v] = time++;
+			misses++;
+		}
+	}
+
+	return (float)misses / (index_count / 3);
+}
+
+//Sander et al. 2007, Fast Triangle Reordering for Vertex Locality and Reduced Overdraw
+void optimize_vertex_cache(uint* indices, uint index_count, uint vertex_count, uint cache_size, tvector<uint>* clusters) {
+	if (index_count < 3) return;
+
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
+	uint triangle_count = index_count / 3;
+
+	//Vertex to triangle adjacency
+	uint* live = TEMPORARY_ZEROED_ARRAY(uint, vertex_count);
+	uint* offsets = TEMPORARY_ARRAY(uint, vertex_count + 1);
+	uint* cursor = TEMPORARY_ARRAY(uint, vertex_count);
+	uint* adjacency = TEMPORARY_ARRAY(uint, index_count);
+
+	for (uint i = 0; i < index_count; i++) live[indices[i]]++;
+
+	offsets[0] = 0;
+	for (uint v = 0; v < vertex_count; v++) offsets[v + 1] = offsets[v] + live[v];
+	memcpy(cursor, offsets, sizeof(uint) * vertex_count);
+
+	for (uint i = 0; i < index_count; i++) adjacency[cursor[indices[i]]++] = i / 3;
+
+	uint* cache_time = TEMPORARY_ZEROED_ARRAY(uint, vertex_count);
+	bool* emitted = TEMPORARY_ZEROED_ARRAY(bool, triangle_count);
+	uint* dead_end = TEMPORARY_ARRAY(uint, index_count); //every emitted corner is pushed once
+	uint* output = TEMPORARY_ARRAY(uint, index_count);
+	uint dead_end_count = 0;
+	uint output_count = 0;
+
+	tvector<uint> candidates;
+
+	uint time = cache_size + 1;
+	uint scan = 0;
+
+	auto skip_dead_end = [&]() {
+		while (dead_end_count > 0) {
+			uint v = dead_end[--dead_end_count];
+			if (live[v] > 0) return v;
+		}
+
+		for (; scan < vertex_count; scan++) {
+			if (live[scan] > 0) return scan;
+		}
+
+		return INVALID_VERTEX;
+	};
+
+	uint fanning = skip_dead_end();
+	if (clusters) clusters->append(0);
+
+	while (fanning != INVALID_VERTEX) {
+		candidates.length = 0;
+
+		for (uint i = offsets[fanning]; i < offsets[fanning + 1]; i++) {
+			uint triangle = adjacency[i];
+			if (emitted[triangle]) continue;
+			emitted[triangle] = true;
+
+			for (uint k = 0; k < 3; k++) {
+				uint v = indices[triangle * 3 + k];
+
+				output[output_count++] = v;
+				dead_end[dead_end_count++] = v;
+				candidates.append(v);
+				live[v]--;
+
+				if (time - cache_time[v] > cache_size) cache_time[v] = time++;
+			}
+		}
+
+		//Prefer the vertex that will still be in the cache after its remaining triangles are emitted
+		uint best = INVALID_VERTEX;
+		int best_priority = -1;
+
+		for (uint v : candidates) {
+			if (live[v] == 0) continue;
+
+			int priority = 0;
+			if (time - cache_time[v] + 2 * live[v] <= cache_size) priority = time - cache_time[v];
+
+			if (priority > best_priority) {
+				best_priority = priority;
+				best = v;
+			}
+		}
+
+		//No locality left, whatever comes next starts a new cluster
+		if (best == INVALID_VERTEX) {
+			best = skip_dead_end();
+			if (clusters && best != INVALID_VERTEX) clusters->append(output_count / 3);
+		}
+
+		fanning = best;
+	}
+
+	memcpy(indices, output, sizeof(uint) * output_count);
+}
+
+struct OverdrawCluster {
+	uint begin;
+	uint end;
+	float sort_key;
+};
+
+void optimize_overdraw(uint* indices, uint index_count, const Vertex* vertices, uint vertex_count, slice<uint> clusters, uint cache_size, float threshold) {
+	uint triangle_count = index_count / 3;
+	if (clusters.length == 0 || triangle_count == 0) return;
+
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
+	//Split the hard clusters further wherever the cache is doing well enough that the flush a reorder causes is cheap
+	float mesh_acmr = compute_acmr(indices, index_count, vertex_count, cache_size);
+
+	uint* cache_time = TEMPORARY_ZEROED_ARRAY(uint, vertex_count);
+	uint time = cache_size + 1;
+
+	tvector<uint> split;
+
+	for (uint c = 0; c < clusters.length; c++) {
+		uint begin = clusters[c];
+		uint end = c + 1 < clusters.length ? clusters[c + 1] : triangle_count;
+
+		split.append(begin);
+		time += cache_size + 1;
+
+		uint cluster_begin = begin;
+		uint misses = 0;
+
+		for (uint t = begin; t < end; t++) {
+			for (uint k = 0; k < 3; k++) {
+				uint v = indices[t * 3 + k];
+				if (time - cache_time[v] > cache_size) {
+					cache_time[v] = time++;
+					misses++;
+				}
+			}
+
+			uint cluster_triangles = t + 1 - cluster_begin;
+			if (t + 1 < end && misses <= threshold * mesh_acmr * cluster_triangles) {
+				split.append(t + 1);
+				cluster_begin = t + 1;
+				misses = 0;
+				time += cache_size + 1;
+			}
+		}
+	}
+
+	//Area weighted centroids and normals
+	glm::vec3 mesh_centroid(0.0f);
+	float mesh_area = 0.0f;
+
+	tvector<OverdrawCluster> sorted;
+	sorted.reserve(split.length);
+
+	tvector<glm::vec3> centroids;
+	tvector<glm::vec3> normals;
+	centroids.resize(split.length);
+	normals.resize(split.length);
+
+	for (uint c = 0; c < split.length; c++) {
+		uint begin = split[c];
+		uint end = c + 1 < split.length ? split[c + 1] : triangle_count;
+
+		glm::vec3 centroid(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+
+		for (uint t = begin; t < end; t++) {
+			glm::vec3 p0 = vertices[indices[t * 3 + 0]].position;
+			glm::vec3 p1 = vertices[indices[t * 3 + 1]].position;
+			glm::vec3 p2 = vertices[indices[t * 3 + 2]].position;
+
+			glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			float triangle_area = glm::length(n);
+
+			centroid += (p0 + p1 + p2) * (triangle_area / 3.0f);
+			normal += n;
+			area += triangle_area;
+		}
+
+		mesh_centroid += centroid;
+		mesh_area += area;
+
+		centroids[c] = area > 0.0f ? centroid / area : vertices[indices[begin * 3]].position;
+		normals[c] = glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f);
+
+		sorted.append({ begin, end, 0.0f });
+	}
+
+	if (mesh_area > 0.0f) mesh_centroid /= mesh_area;
+
+	//Clusters facing away from the center are likely to occlude the rest of the mesh, so they go first
+	for (uint c = 0; c < sorted.length; c++) {
+		sorted[c].sort_key = glm::dot(centroids[c] - mesh_centroid, normals[c]);
+	}
+
+	std::stable_sort(sorted.begin(), sorted.end(), [](const OverdrawCluster& a, const OverdrawCluster& b) {
+		return a.sort_key > b.sort_key;
+	});
+
+	uint* output = TEMPORARY_ARRAY(uint, index_count);
+	uint output_count = 0;
+
+	for (OverdrawCluster& cluster : sorted) {
+		uint count = (cluster.end - cluster.begin) * 3;
+		memcpy(output + output_count, indices + cluster.begin * 3, sizeof(uint) * count);
+		output_count += count;
+	}
+
+	memcpy(indices, output, sizeof(uint) * output_count);
+}
+
+uint optimize_vertex_fetch(Vertex* vertices, uint vertex_count, uint* indices, uint index_count) {
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
+	uint* remap = TEMPORARY_ARRAY(uint, vertex_count);
+	Vertex* reordered = TEMPORARY_ARRAY(Vertex, vertex_count);
+	memset(remap, 0xff, sizeof(uint) * vertex_count);
+
+	//Vertices that are never referenced are dropped
+	uint next = 0;
+
+	for (uint i = 0; i < index_count; i++) {
+		uint v = indices[i];
+		if (remap[v] == INVALID_VERTEX) {
+			remap[v] = next;
+			reordered[next++] = vertices[v];
+		}
+
+		indices[i] = remap[v];
+	}
+
+	memcpy(vertices, reordered, sizeof(Vertex) * next);
+
+	return next;
+}
+
+void compute_meshlet_bounds(Meshlet& meshlet, const MeshletBuffers& output, const Vertex* vertices) {
+	const uint* meshlet_vertices = output.vertices.data + meshlet.vertex_offset;
+	const u8* meshlet_triangles = output.triangles.data + meshlet.triangle_offset;
+
+	AABB aabb;
+	for (uint i = 0; i < meshlet.vertex_count; i++) aabb.update(vertices[meshlet_vertices[i]].position);
+
+	meshlet.center = (aabb.min + aabb.max) * 0.5f;
+	meshlet.radius = 0.0f;
+
+	for (uint i = 0; i < meshlet.vertex_count; i++) {
+		meshlet.radius = glm::max(meshlet.radius, glm::length(vertices[meshlet_vertices[i]].position - meshlet.center));
+	}
+
+	glm::vec3 normals[MESHLET_MAX_TRIANGLES];
+	uint normal_count = 0;
+	glm::vec3 axis(0.0f);
+
+	for (uint t = 0; t < meshlet.triangle_count; t++) {
+		glm::vec3 p0 = vertices[meshlet_vertices[meshlet_triangles[t * 3 + 0]]].position;
+		glm::vec3 p1 = vertices[meshlet_vertices[meshlet_triangles[t * 3 + 1]]].position;
+		glm::vec3 p2 = vertices[meshlet_vertices[meshlet_triangles[t * 3 + 2]]].position;
+
+		glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+		float length = glm::length(n);
+		if (length == 0.0f) continue;
+
+		normals[normal_count++] = n / length;
+		axis += n / length;
+	}
+
+	meshlet.cone_axis = glm::vec3(0, 0, 1);
+	meshlet.cone_cutoff = 1.0f;
+
+	float axis_length = glm::length(axis);
+	if (normal_count == 0 || axis_length == 0.0f) return;
+
+	axis /= axis_length;
+
+	float min_dot = 1.0f;
+	for (uint i = 0; i < normal_count; i++) min_dot = glm::min(min_dot, glm::dot(normals[i], axis));
+
+	//The cone spans more than a hemisphere, some triangle always faces the camera
+	if (min_dot <= 0.0f) return;
+
+	meshlet.cone_axis = axis;
+	meshlet.cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+}
+
+void build_meshlets(MeshletBuffers& output, const Vertex* vertices, uint vertex_count, const uint* indices, uint index_count) {
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
+	uint* local = TEMPORARY_ARRAY(uint, vertex_count);
+	memset(local, 0xff, sizeof(uint) * vertex_count);
+
+	Meshlet meshlet = {};
+	meshlet.vertex_offset = output.vertices.length;
+	meshlet.triangle_offset = output.triangles.length;
+
+	auto finish_meshlet = [&]() {
+		for (uint i = 0; i < meshlet.vertex_count; i++) local[output.vertices[meshlet.vertex_offset + i]] = INVALID_VERTEX;
+
+		compute_meshlet_bounds(meshlet, output, vertices);
+		output.meshlets.append(meshlet);
+
+		meshlet = {};
+		meshlet.vertex_offset = output.vertices.length;
+		meshlet.triangle_offset = output.triangles.length;
+	};
+
+	//Greedy in index order, which after the cache optimization keeps neighbouring triangles together
+	for (uint i = 0; i + 2 < index_count; i += 3) {
+		uint a = indices[i + 0];
+		uint b = indices[i + 1];
+		uint c = indices[i + 2];
+
+		if (a == b || b == c || a == c) continue;
+
+		uint new_vertices = (local[a] == INVALID_VERTEX) + (local[b] == INVALID_VERTEX) + (local[c] == INVALID_VERTEX);
+
+		if (meshlet.vertex_count + new_vertices > MESHLET_MAX_VERTICES || meshlet.triangle_count + 1 > MESHLET_MAX_TRIANGLES) {
+			finish_meshlet();
+		}
+
+		uint corners[3] = { a, b, c };
+
+		for (uint v : corners) {
+			if (local[v] == INVALID_VERTEX) {
+				local[v] = meshlet.vertex_count++;
+				output.vertices.append(v);
+			}
+
+			output.triangles.append((u8)local[v]);
+		}
+
+		meshlet.triangle_count++;
+	}
+
+	if (meshlet.triangle_count > 0) finish_meshlet();
+}
+
+MeshOptimizeStats optimize_mesh(Mesh& mesh, uint lod) {
+	slice<Vertex>& vertices = mesh.vertices[lod];
+	slice<uint>& indices = mesh.indices[lod];
+
+	MeshOptimizeStats stats = {};
+	stats.vertices_before = vertices.length;
+	stats.triangles = indices.length / 3;
+	stats.acmr_before = compute_acmr(indices.data, indices.length, vertices.length, VERTEX_CACHE_SIZE);
+
+	//Point and line meshes are left as they are
+	if (indices.length % 3 != 0) {
+		stats.vertices_after = vertices.length;
+		stats.acmr_after = stats.acmr_before;
+		return stats;
+	}
+
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
+	vertices.length = weld_vertices(vertices.data, vertices.length, indices.data, indices.length);
+
+	tvector<uint> clusters;
+	optimize_vertex_cache(indices.data, indices.length, vertices.length, VERTEX_CACHE_SIZE, &clusters);
+	optimize_overdraw(indices.data, indices.length, vertices.data, vertices.length, clusters, VERTEX_CACHE_SIZE, OVERDRAW_ACMR_THRESHOLD);
+
+	vertices.length = optimize_vertex_fetch(vertices.data, vertices.length, indices.data, indices.length);
+
+	stats.vertices_after = vertices.length;
+	stats.acmr_after = compute_acmr(indices.data, indices.length, vertices.length, VERTEX_CACHE_SIZE);
+
+	return stats;
+}
+
+struct OptimizeMeshJob {
+	Mesh* mesh;
+	uint lod;
+	MeshOptimizeStats stats;
+};
+
+void optimize_mesh_job(OptimizeMeshJob& job) {
+	job.stats = optimize_mesh(*job.mesh, job.lod);
+}
+
+void optimize_model_meshes(Model* model) {
+	Profile profile("Optimize meshes");
+
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
+	tvector<OptimizeMeshJob> jobs;
+	tvector<JobDesc> desc;
+
+	for (Mesh& mesh : model->meshes) {
+		for (uint lod = 0; lod < mesh.lod_count; lod++) {
+			if (mesh.vertices[lod].length == 0) continue;
+			jobs.append({ &mesh, lod });
+		}
+	}
+
+	for (OptimizeMeshJob& job : jobs) desc.append(JobDesc(optimize_mesh_job, &job));
+
+	wait_for_jobs(PRIORITY_HIGH, desc);
+
+	//Totals per lod, the ACMR is weighted by the triangle count of each mesh
+	MeshOptimizeStats total[MAX_MESH_LOD] = {};
+
+	for (OptimizeMeshJob& job : jobs) {
+		MeshOptimizeStats& stats = total[job.lod];
+		stats.vertices_before += job.stats.vertices_before;
+		stats.vertices_after += job.stats.vertices_after;
+		stats.triangles += job.stats.triangles;
+		stats.acmr_before += job.stats.acmr_before * job.stats.triangles;
+		stats.acmr_after += job.stats.acmr_after * job.stats.triangles;
+	}
+
+	for (uint lod = 0; lod < MAX_MESH_LOD; lod++) {
+		MeshOptimizeStats& stats = total[lod];
+		if (stats.triangles == 0) continue;
+
+		printf("\tLod %i ACMR: %.3f -> %.3f, Vertices: %i -> %i\n", lod,
+			stats.acmr_before / stats.triangles, stats.acmr_after / stats.triangles,
+			stats.vertices_before, stats.vertices_after);
+	}
+
+	profile.end();
+}
@@ -0,0 +1,459 @@
+#include "graphics/assets/mesh_simplify.h"
+#include "graphics/assets/mesh_optimizer.h"
+#include "core/memory/linear_allocator.h"
+#include "core/container/vector.h"
+#include "core/container/tvector.h"
+#include "core/job_system/job.h"
+#include "core/profiler.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <limits.h>
+#include <string.h>
+#include <stdio.h>
+
+const uint INVALID_SIMPLIFY_VERTEX = UINT_MAX;
+const u64 INVALID_EDGE = ~0ull;
+
+//Symmetric 4x4 matrix, error(p) = p^T A p + 2 b^T p + c
+struct Quadric {
+	float a00, a11, a22;
+	float a01, a12, a02;
+	float b0, b1, b2;
+	float c;
+};
+
+inline Quadric plane_quadric(glm::vec3 n, float d, float weight) {
+	Quadric q;
+	q.a00 = n.x * n.x * weight;
+	q.a11 = n.y * n.y * weight;
+	q.a22 = n.z * n.z * weight;
+	q.a01 = n.x * n.y * weight;
+	q.a12 = n.y * n.z * weight;
+	q.a02 = n.x * n.z * weight;
+	q.b0 = n.x * d * weight;
+	q.b1 = n.y * d * weight;
+	q.b2 = n.z * d * weight;
+	q.c = d * d * weight;
+	return q;
+}
+
+inline void add_quadric(Quadric& q, const Quadric& r) {
+	q.a00 += r.a00; q.a11 += r.a11; q.a22 += r.a22;
+	q.a01 += r.a01; q.a12 += r.a12; q.a02 += r.a02;
+	q.b0 += r.b0; q.b1 += r.b1; q.b2 += r.b2;
+	q.c += r.c;
+}
+
+inline float quadric_error(const Quadric& q, glm::vec3 p) {
+	float rx = q.a00 * p.x + q.a01 * p.y + q.a02 * p.z;
+	float ry = q.a01 * p.x + q.a11 * p.y + q.a12 * p.z;
+	float rz = q.a02 * p.x + q.a12 * p.y + q.a22 * p.z;
+
+	float error = rx * p.x + ry * p.y + rz * p.z + 2.0f * (q.b0 * p.x + q.b1 * p.y + q.b2 * p.z) + q.c;
+	return fabsf(error);
+}
+
+inline uint hash_position(glm::vec3 p) {
+	uint words[3];
+	memcpy(words, &p, sizeof(words));
+	return (words[0] * 73856093u) ^ (words[1] * 19349663u) ^ (words[2] * 83492791u);
+}
+
+inline uint hash_edge(u64 edge) {
+	edge ^= edge >> 33;
+	edge *= 0xff51afd7ed558ccdull;
+	edge ^= edge >> 33;
+	return (uint)edge;
+}
+
+inline uint next_power_of_two(uint n) {
+	uint result = 1;
+	while (result < n) result <<= 1;
+	return result;
+}
+
+//Maps every vertex to the first vertex with the same position
+void build_position_remap(uint* remap, const glm::vec3* positions, uint vertex_count) {
+	uint table_size = next_power_of_two(vertex_count * 2);
+	uint* table = TEMPORARY_ARRAY(uint, table_size);
+	memset(table, 0xff, sizeof(uint) * table_size);
+
+	for (uint i = 0; i < vertex_count; i++) {
+		uint slot = hash_position(positions[i]) & (table_size - 1);
+
+		while (table[slot] != INVALID_SIMPLIFY_VERTEX && positions[table[slot]] != positions[i]) {
+			slot = (slot + 1) & (table_size - 1);
+		}
+
+		if (table[slot] == INVALID_SIMPLIFY_VERTEX) table[slot] = i;
+		remap[i] = table[slot];
+	}
+}
+
+//Locks every vertex on a UV seam and every vertex on an open or non manifold edge
+void lock_seams_and_borders(bool* locked, const uint* position_remap, const uint* indices, uint index_count, uint vertex_count) {
+	uint* wedges = TEMPORARY_ZEROED_ARRAY(uint, vertex_count);
+	for (uint i = 0; i < vertex_count; i++) wedges[position_remap[i]]++;
+	for (uint i = 0; i < vertex_count; i++) locked[i] = wedges[position_remap[i]] > 1;
+
+	//Directed edges in position space, an edge without its opposite is on the border
+	uint table_size = next_power_of_two(index_count * 2);
+	u64* edges = TEMPORARY_ARRAY(u64, table_size);
+	uint* counts = TEMPORARY_ZEROED_ARRAY(uint, table_size);
+	memset(edges, 0xff, sizeof(u64) * table_size);
+
+	auto find_edge = [&](uint a, uint b) {
+		u64 key = (u64)a << 32 | b;
+		uint slot = hash_edge(key) & (table_size - 1);
+
+		while (edges[slot] != INVALID_EDGE && edges[slot] != key) slot = (slot + 1) & (table_size - 1);
+		return slot;
+	};
+
+	for (uint i = 0; i < index_count; i++) {
+		uint a = position_remap[indices[i]];
+		uint b = position_remap[indices[i % 3 == 2 ? i - 2 : i + 1]];
+
+		uint slot = find_edge(a, b);
+		edges[slot] = (u64)a << 32 | b;
+		counts[slot]++;
+	}
+
+	for (uint i = 0; i < index_count; i++) {
+		uint a = position_remap[indices[i]];
+		uint b = position_remap[indices[i % 3 == 2 ? i - 2 : i + 1]];
+
+		uint forward = counts[find_edge(a, b)];
+		uint opposite = counts[find_edge(b, a)];
+
+		if (forward != 1 || opposite != 1) {
+			locked[indices[i]] = true;
+			locked[indices[i % 3 == 2 ? i - 2 : i + 1]] = true;
+		}
+	}
+
+	//Lock the whole position, not just the wedge that was on the edge
+	for (uint i = 0; i < vertex_count; i++) {
+		if (locked[i]) locked[position_remap[i]] = true;
+	}
+	for (uint i = 0; i < vertex_count; i++) {
+		if (locked[position_remap[i]]) locked[i] = true;
+	}
+}
+
+struct Collapse {
+	uint from;
+	uint to;
+	float error;
+};
+
+struct TriangleAdjacency {
+	uint* offsets;
+	uint* triangles;
+};
+
+void build_triangle_adjacency(TriangleAdjacency& adjacency, const uint* indices, uint index_count, uint vertex_count) {
+	uint* counts = TEMPORARY_ZEROED_ARRAY(uint, vertex_count);
+	adjacency.offsets = TEMPORARY_ARRAY(uint, vertex_count + 1);
+	adjacency.triangles = TEMPORARY_ARRAY(uint, index_count);
+
+	for (uint i = 0; i < index_count; i++) counts[indices[i]]++;
+
+	adjacency.offsets[0] = 0;
+	for (uint v = 0; v < vertex_count; v++) adjacency.offsets[v + 1] = adjacency.offsets[v] + counts[v];
+
+	memcpy(counts, adjacency.offsets, sizeof(uint) * vertex_count);
+	for (uint i = 0; i < index_count; i++) adjacency.triangles[counts[indices[i]]++] = i / 3;
+}
+
+//Rejects collapses that would turn a triangle around from over
+bool collapse_flips_triangle(const TriangleAdjacency& adjacency, const uint* indices, const glm::vec3* positions, uint from, uint to) {
+	for (uint i = adjacency.offsets[from]; i < adjacency.offsets[from + 1]; i++) {
+		const uint* triangle = indices + adjacency.triangles[i] * 3;
+		if (triangle[0] == to || triangle[1] == to || triangle[2] == to) continue;
+
+		glm::vec3 p[3];
+		glm::vec3 moved[3];
+
+		for (uint k = 0; k < 3; k++) {
+			p[k] = positions[triangle[k]];
+			moved[k] = triangle[k] == from ? positions[to] : p[k];
+		}
+
+		glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+		glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+
+		if (glm::dot(before, after) <= 0.0f) return true;
+	}
+
+	return false;
+}
+
+uint simplify_mesh(uint* output, const uint* indices, uint index_count, const Vertex* vertices, uint vertex_count, uint target_index_count, float target_error, float* result_error) {
+	memcpy(output, indices, sizeof(uint) * index_count);
+	if (result_error) *result_error = 0.0f;
+
+	if (index_count % 3 != 0 || index_count <= target_index_count) return index_count;
+
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
+	//Normalized so the error is independent of the scale of the mesh
+	AABB aabb;
+	for (uint i = 0; i < vertex_count; i++) aabb.update(vertices[i].position);
+
+	glm::vec3 extent = aabb.max - aabb.min;
+	float size = glm::max(extent.x, glm::max(extent.y, extent.z));
+	float inv_size = size > 0.0f ? 1.0f / size : 1.0f;
+
+	glm::vec3* positions = TEMPORARY_ARRAY(glm::vec3, vertex_count);
+	for (uint i = 0; i < vertex_count; i++) positions[i] = (vertices[i].position - aabb.min) * inv_size;
+
+	uint* position_remap = TEMPORARY_ARRAY(uint, vertex_count);
+	bool* locked = TEMPORARY_ZEROED_ARRAY(bool, vertex_count);
+
+	build_position_remap(position_remap, positions, vertex_count);
+	lock_seams_and_borders(locked, position_remap, indices, index_count, vertex_count);
+
+	//Area weighted plane quadrics of the surrounding triangles
+	Quadric* quadrics = TEMPORARY_ZEROED_ARRAY(Quadric, vertex_count);
+
+	for (uint i = 0; i < index_count; i += 3) {
+		glm::vec3 p0 = positions[indices[i + 0]];
+		glm::vec3 p1 = positions[indices[i + 1]];
+		glm::vec3 p2 = positions[indices[i + 2]];
+
+		glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+		float area = glm::length(n);
+		if (area == 0.0f) continue;
+
+		n /= area;
+		Quadric q = plane_quadric(n, -glm::dot(n, p0), area);
+
+		for (uint k = 0; k < 3; k++) add_quadric(quadrics[indices[i + k]], q);
+	}
+
+	uint* remap = TEMPORARY_ARRAY(uint, vertex_count);
+	bool* touched = TEMPORARY_ARRAY(bool, vertex_count);
+	for (uint i = 0; i < vertex_count; i++) remap[i] = i;
+
+	tvector<Collapse> collapses;
+	collapses.reserve(index_count * 2);
+
+	//The quadric error is a squared distance
+	float error_limit = target_error * target_error;
+	float max_error = 0.0f;
+
+	uint current_count = index_count;
+
+	//Every pass collapses a set of edges that don't share any triangles, then compacts the index buffer
+	while (current_count > target_index_count) {
+		LinearRegion pass_region(temporary);
+
+		collapses.length = 0;
+
+		for (uint i = 0; i < current_count; i++) {
+			uint a = output[i];
+			uint b = output[i % 3 == 2 ? i - 2 : i + 1];
+
+			uint ends[2][2] = { { a, b }, { b, a } };
+
+			for (auto& end : ends) {
+				uint from = end[0];
+				uint to = end[1];
+				if (locked[from]) continue;
+
+				Quadric q = quadrics[from];
+				add_quadric(q, quadrics[to]);
+
+				float error = quadric_error(q, positions[to]);
+				if (error <= error_limit) collapses.append({ from, to, error });
+			}
+		}
+
+		if (collapses.length == 0) break;
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+			return a.error < b.error;
+		});
+
+		TriangleAdjacency adjacency;
+		build_triangle_adjacency(adjacency, output, current_count, vertex_count);
+
+		memset(touched, 0, sizeof(bool) * vertex_count);
+
+		uint goal = (current_count - target_index_count) / 3;
+		uint removed_triangles = 0;
+		uint applied = 0;
+
+		for (Collapse& collapse : collapses) {
+			if (removed_triangles >= goal) break;
+
+			uint from = collapse.from;
+			uint to = collapse.to;
+
+			if (touched[from] || touched[to]) continue;
+			if (collapse_flips_triangle(adjacency, output, positions, from, to)) continue;
+
+			remap[from] = to;
+			add_quadric(quadrics[to], quadrics[from]);
+			max_error = glm::max(max_error, collapse.error);
+			applied++;
+
+			//Every triangle around from changes, so none of its vertices can take part in another collapse this pass
+			for (uint i = adjacency.offsets[from]; i < adjacency.offsets[from + 1]; i++) {
+				const uint* triangle = output + adjacency.triangles[i] * 3;
+				if (triangle[0] == to || triangle[1] == to || triangle[2] == to) removed_triangles++;
+
+				for (uint k = 0; k < 3; k++) touched[triangle[k]] = true;
+			}
+		}
+
+		if (applied == 0) break;
+
+		uint write = 0;
+
+		for (uint i = 0; i < current_count; i += 3) {
+			uint a = remap[output[i + 0]];
+			uint b = remap[output[i + 1]];
+			uint c = remap[output[i + 2]];
+
+			if (a == b || b == c || a == c) continue;
+
+			output[write++] = a;
+			output[write++] = b;
+			output[write++] = c;
+		}
+
+		current_count = write;
+	}
+
+	if (result_error) *result_error = sqrtf(max_error);
+
+	return current_count;
+}
+
+struct GenerateLodsJob {
+	Mesh* mesh;
+	uint lod_count;
+	float ratio;
+	float max_error;
+
+	vector<Vertex> vertices[MAX_MESH_LOD];
+	vector<uint> indices[MAX_MESH_LOD];
+	float error[MAX_MESH_LOD];
+	uint lod_count_reached;
+};
+
+//The results are heap allocated, the permanent allocator can only be used from the calling thread
+void generate_lods_job(GenerateLodsJob& job) {
+	Mesh& mesh = *job.mesh;
+	slice<Vertex>& vertices = mesh.vertices[0];
+	slice<uint>& indices = mesh.indices[0];
+
+	//Welding first lets the simplifier see the connectivity across duplicated vertices
+	vertices.length = weld_vertices(vertices.data, vertices.length, indices.data, indices.length);
+
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
+	uint* simplified = TEMPORARY_ARRAY(uint, indices.length);
+	uint* remap = TEMPORARY_ARRAY(uint, vertices.length);
+
+	uint source_count = indices.length;
+	uint previous_count = source_count;
+	float target_ratio = 1.0f;
+
+	job.lod_count_reached = 1;
+
+	for (uint lod = 1; lod < job.lod_count; lod++) {
+		//Every lod is simplified from lod 0, so the error is measured against the source mesh
+		target_ratio *= job.ratio;
+		uint target = (uint)(source_count / 3 * target_ratio) * 3;
+		uint count = simplify_mesh(simplified, indices.data, source_count, vertices.data, vertices.length, target, job.max_error, job.error + lod);
+
+		//The simplifier got stuck on locked vertices or the error bound, further lods would only repeat this one
+		if (count > previous_count * GENERATED_LOD_MIN_SHRINK) break;
+
+		//Each lod gets its own buffer with only the vertices it references
+		vector<Vertex>& lod_vertices = job.vertices[lod];
+		vector<uint>& lod_indices = job.indices[lod];
+
+		memset(remap, 0xff, sizeof(uint) * vertices.length);
+		lod_indices.resize(count);
+
+		for (uint i = 0; i < count; i++) {
+			uint v = simplified[i];
+			if (remap[v] == INVALID_SIMPLIFY_VERTEX) {
+				remap[v] = lod_vertices.length;
+				lod_vertices.append(vertices[v]);
+			}
+
+			lod_indices[i] = remap[v];
+		}
+
+		previous_count = count;
+		job.lod_count_reached = lod + 1;
+	}
+}
+
+uint generate_model_lods(Model* model, uint lod_count, float ratio, float max_error) {
+	Profile profile("Generate lods");
+
+	lod_count = min(lod_count, MAX_MESH_LOD);
+
+	vector<GenerateLodsJob> jobs;
+	jobs.resize(model->meshes.length);
+
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
+	tvector<JobDesc> desc;
+
+	for (uint i = 0; i < model->meshes.length; i++) {
+		GenerateLodsJob& job = jobs[i];
+		job.mesh = &model->meshes[i];
+		job.lod_count = lod_count;
+		job.ratio = ratio;
+		job.max_error = max_error;
+		job.error[0] = 0.0f;
+
+		desc.append(JobDesc(generate_lods_job, &job));
+	}
+
+	wait_for_jobs(PRIORITY_HIGH, desc);
+
+	uint triangles[MAX_MESH_LOD] = {};
+	float error[MAX_MESH_LOD] = {};
+	uint model_lod_count = 1;
+
+	for (GenerateLodsJob& job : jobs) {
+		Mesh& mesh = *job.mesh;
+		mesh.lod_count = job.lod_count_reached;
+		model_lod_count = max(model_lod_count, mesh.lod_count);
+
+		triangles[0] += mesh.indices[0].length / 3;
+
+		for (uint lod = 1; lod < mesh.lod_count; lod++) {
+			uint vertex_count = job.vertices[lod].length;
+			uint index_count = job.indices[lod].length;
+
+			mesh.vertices[lod] = { PERMANENT_ARRAY(Vertex, vertex_count), vertex_count };
+			mesh.indices[lod] = { PERMANENT_ARRAY(uint, index_count), index_count };
+
+			memcpy(mesh.vertices[lod].data, job.vertices[lod].data, sizeof(Vertex) * vertex_count);
+			memcpy(mesh.indices[lod].data, job.indices[lod].data, sizeof(uint) * index_count);
+
+			triangles[lod] += index_count / 3;
+			error[lod] = glm::max(error[lod], job.error[lod]);
+		}
+	}
+
+	for (uint lod = 1; lod < model_lod_count; lod++) {
+		printf("\tGenerated lod %i, Triangles: %i, Error: %f\n", lod, triangles[lod], error[lod]);
+	}
+
+	profile.end();
+
+	return model_lod_count;
+}
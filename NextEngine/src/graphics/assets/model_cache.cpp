@@ -0,0 +1,245 @@
+#include "graphics/assets/model.h"
+#include "graphics/assets/vertex_compression.h"
+#include "graphics/assets/assets.h"
+#include "graphics/rhi/buffer.h"
+#include "core/memory/linear_allocator.h"
+#include "core/memory/allocator.h"
+#include "core/io/logger.h"
+#include "core/container/string_buffer.h"
+#include "engine/vfs.h"
+#include <string.h>
+
+const uint COOKED_MODEL_MAGIC = 'N' | 'E' << 8 | 'M' << 16 | 'D' << 24;
+const u64 COOKED_MODEL_ALIGNMENT = 4096;
+
+struct CookedModelHeader {
+	uint magic;
+	uint version;
+	i64 source_time_modified;
+	glm::mat4 apply_transform;
+	AABB aabb;
+	uint lod_count;
+	uint mesh_count;
+	uint material_count;
+	uint vertex_count;
+	uint index_count;
+	uint vertex_format;
+	u64 meshes_offset;
+	u64 materials_offset;
+	u64 vertices_offset;
+	u64 indices_offset;
+	u64 size;
+};
+
+//Offsets are in elements, relative to the start of the vertex and index sections
+struct CookedMesh {
+	uint lod_count;
+	uint vertex_offset[MAX_MESH_LOD];
+	uint vertex_count[MAX_MESH_LOD];
+	uint index_offset[MAX_MESH_LOD];
+	uint index_count[MAX_MESH_LOD];
+	AABB aabb;
+	AABB quantization_aabb;
+	uint material_id;
+	MeshFlags flags;
+};
+
+inline u64 align_section(u64 offset) {
+	return (offset + COOKED_MODEL_ALIGNMENT - 1) & ~(COOKED_MODEL_ALIGNMENT - 1);
+}
+
+//Bounds of every lod, so all of them can share one quantization
+AABB quantization_bounds(const Mesh& mesh) {
+	if (mesh.compact_vertices[0].length > 0) return mesh.quantization_aabb;
+
+	AABB bounds;
+	for (uint lod = 0; lod < mesh.lod_count; lod++) {
+		for (const Vertex& vertex : mesh.vertices[lod]) bounds.update(vertex.position);
+	}
+	return bounds;
+}
+
+bool save_cooked_model(const Model& model, string_view cooked_path, i64 source_time_modified, const glm::mat4& apply_transform, CookedVertexFormat format) {
+	CookedModelHeader header = {};
+	header.magic = COOKED_MODEL_MAGIC;
+	header.version = COOKED_MODEL_VERSION;
+	header.source_time_modified = source_time_modified;
+	header.apply_transform = apply_transform;
+	header.aabb = model.aabb;
+	header.mesh_count = model.meshes.length;
+	header.material_count = model.materials.length;
+	header.vertex_format = format;
+
+	for (const Mesh& mesh : model.meshes) {
+		header.lod_count = max(header.lod_count, mesh.lod_count);
+
+		for (uint lod = 0; lod < mesh.lod_count; lod++) {
+			header.vertex_count += mesh_vertex_count(mesh, lod);
+			header.index_count += mesh.indices[lod].length;
+		}
+	}
+
+	header.meshes_offset = align_section(sizeof(CookedModelHeader));
+	header.materials_offset = header.meshes_offset + sizeof(CookedMesh) * header.mesh_count;
+	header.vertices_offset = align_section(header.materials_offset + sizeof(sstring) * header.material_count);
+	uint vertex_size = format == COOKED_VERTEX_COMPACT ? sizeof(CompactVertex) : sizeof(Vertex);
+	header.indices_offset = align_section(header.vertices_offset + (u64)vertex_size * header.vertex_count);
+	header.size = header.indices_offset + sizeof(uint) * header.index_count;
+
+	Allocator& allocator = get_allocator();
+	char* blob = (char*)allocator.allocate(header.size);
+	memset(blob, 0, header.size);
+
+	memcpy(blob, &header, sizeof(CookedModelHeader));
+	memcpy(blob + header.materials_offset, model.materials.data, sizeof(sstring) * header.material_count);
+
+	CookedMesh* cooked_meshes = (CookedMesh*)(blob + header.meshes_offset);
+	Vertex* vertices = (Vertex*)(blob + header.vertices_offset);
+	CompactVertex* compact_vertices = (CompactVertex*)(blob + header.vertices_offset);
+	uint* indices = (uint*)(blob + header.indices_offset);
+
+	uint vertex_offset = 0;
+	uint index_offset = 0;
+
+	for (uint i = 0; i < header.mesh_count; i++) {
+		const Mesh& mesh = model.meshes[i];
+		CookedMesh& cooked = cooked_meshes[i];
+
+		cooked.lod_count = mesh.lod_count;
+		cooked.aabb = mesh.aabb;
+		cooked.material_id = mesh.material_id;
+		cooked.flags = mesh.flags;
+		cooked.quantization_aabb = quantization_bounds(mesh);
+
+		for (uint lod = 0; lod < mesh.lod_count; lod++) {
+			slice<Vertex> lod_vertices = mesh.vertices[lod];
+			slice<CompactVertex> lod_compact_vertices = mesh.compact_vertices[lod];
+			slice<uint> lod_indices = mesh.indices[lod];
+			uint vertex_count = mesh_vertex_count(mesh, lod);
+
+			cooked.vertex_offset[lod] = vertex_offset;
+			cooked.vertex_count[lod] = vertex_count;
+			cooked.index_offset[lod] = index_offset;
+			cooked.index_count[lod] = lod_indices.length;
+
+			if (format == COOKED_VERTEX_COMPACT) {
+				CompactVertex* output = compact_vertices + vertex_offset;
+				if (lod_compact_vertices.length > 0) memcpy(output, lod_compact_vertices.data, sizeof(CompactVertex) * vertex_count);
+				else for (uint j = 0; j < vertex_count; j++) output[j] = encode_vertex(lod_vertices[j], cooked.quantization_aabb);
+			}
+			else {
+				if (lod_vertices.length > 0) memcpy(vertices + vertex_offset, lod_vertices.data, sizeof(Vertex) * vertex_count);
+				else decode_vertices(lod_compact_vertices, cooked.quantization_aabb, vertices + vertex_offset);
+			}
+
+			memcpy(indices + index_offset, lod_indices.data, sizeof(uint) * lod_indices.length);
+
+			vertex_offset += vertex_count;
+			index_offset += lod_indices.length;
+		}
+	}
+
+	bool written = io_writef(cooked_path, { blob, (uint)header.size });
+	allocator.deallocate(blob);
+
+	return written;
+}
+
+//A corrupt or truncated file must not send the mesh slices outside of the mapping
+bool cooked_sections_in_bounds(const CookedModelHeader& header) {
+	if (header.vertex_format != COOKED_VERTEX_COMPACT && header.vertex_format != COOKED_VERTEX_FULL) return false;
+	if (header.lod_count > MAX_MESH_LOD) return false;
+
+	u64 vertex_size = header.vertex_format == COOKED_VERTEX_COMPACT ? sizeof(CompactVertex) : sizeof(Vertex);
+
+	return header.meshes_offset + (u64)sizeof(CookedMesh) * header.mesh_count <= header.size
+		&& header.materials_offset + (u64)sizeof(sstring) * header.material_count <= header.size
+		&& header.vertices_offset + vertex_size * header.vertex_count <= header.size
+		&& header.indices_offset + (u64)sizeof(uint) * header.index_count <= header.size;
+}
+
+bool cooked_mesh_in_bounds(const CookedModelHeader& header, const CookedMesh& cooked) {
+	if (cooked.lod_count == 0 || cooked.lod_count > MAX_MESH_LOD) return false;
+	if (cooked.material_id >= header.material_count) return false;
+
+	for (uint lod = 0; lod < cooked.lod_count; lod++) {
+		if ((u64)cooked.vertex_offset[lod] + cooked.vertex_count[lod] > header.vertex_count) return false;
+		if ((u64)cooked.index_offset[lod] + cooked.index_count[lod] > header.index_count) return false;
+	}
+
+	return true;
+}
+
+bool load_cooked_model(Model* model, string_view cooked_path, i64 source_time_modified, const glm::mat4& apply_transform) {
+	MappedFile file;
+	if (!io_mapf(cooked_path, &file)) return false;
+
+	char* blob = (char*)file.data;
+	CookedModelHeader& header = *(CookedModelHeader*)blob;
+
+	bool valid = file.length >= sizeof(CookedModelHeader)
+		&& header.magic == COOKED_MODEL_MAGIC
+		&& header.version == COOKED_MODEL_VERSION
+		&& header.source_time_modified == source_time_modified
+		&& header.apply_transform == apply_transform
+		&& header.size <= file.length;
+
+	if (!valid || !cooked_sections_in_bounds(header)) {
+		io_unmapf(file);
+		return false;
+	}
+
+	CookedMesh* cooked_meshes = (CookedMesh*)(blob + header.meshes_offset);
+	Vertex* vertices = (Vertex*)(blob + header.vertices_offset);
+	CompactVertex* compact_vertices = (CompactVertex*)(blob + header.vertices_offset);
+	uint* indices = (uint*)(blob + header.indices_offset);
+	bool compact = header.vertex_format == COOKED_VERTEX_COMPACT;
+
+	for (uint i = 0; i < header.mesh_count; i++) {
+		if (!cooked_mesh_in_bounds(header, cooked_meshes[i])) {
+			io_unmapf(file);
+			return false;
+		}
+	}
+
+	//The vertices and indices are used in place, the file stays mapped for the lifetime of the model.
+	//Meshes and materials are small and written to at runtime, so they are copied out of the read only mapping
+	model->meshes.length = header.mesh_count;
+	model->meshes.data = PERMANENT_ARRAY(Mesh, header.mesh_count);
+	model->materials.length = header.material_count;
+	model->materials.data = PERMANENT_ARRAY(sstring, header.material_count);
+	model->aabb = header.aabb;
+	model->file = file;
+
+	memcpy(model->materials.data, blob + header.materials_offset, sizeof(sstring) * header.material_count);
+
+	for (uint i = 0; i < header.mesh_count; i++) {
+		CookedMesh& cooked = cooked_meshes[i];
+		Mesh& mesh = model->meshes[i];
+
+		mesh.lod_count = cooked.lod_count;
+		mesh.aabb = cooked.aabb;
+		mesh.material_id = cooked.material_id;
+		mesh.flags = cooked.flags;
+		mesh.quantization_aabb = cooked.quantization_aabb;
+
+		for (uint lod = 0; lod < cooked.lod_count; lod++) {
+			if (compact) mesh.compact_vertices[lod] = { compact_vertices + cooked.vertex_offset[lod], cooked.vertex_count[lod] };
+			else mesh.vertices[lod] = { vertices + cooked.vertex_offset[lod], cooked.vertex_count[lod] };
+			mesh.indices[lod] = { indices + cooked.index_offset[lod], cooked.index_count[lod] };
+		}
+	}
+
+	upload_model_buffers(model);
+	assign_lod_distances(model, header.lod_count);
+
+	return true;
+}
+
+bool cook_model(string_view path, const glm::mat4& apply_transform) {
+	Model model;
+	load_assimp(&model, tasset_path(path), apply_transform);
+
+	string_buffer cooked_path = tformat(path, ".cooked");
+	return save_cooked_model(model, cooked_path, io_time_modified(path), apply_transform);
+}
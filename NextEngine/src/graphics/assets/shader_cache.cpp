@@ -0,0 +1,129 @@
+#include "graphics/assets/shader_cache.h"
+#include "core/memory/allocator.h"
+#include "core/container/string_buffer.h"
+#include "engine/vfs.h"
+#include <shaderc/shaderc.h>
+#include <vulkan/vulkan.h>
+#include <string.h>
+
+const char* SHADER_CACHE_PATH = "shaders/cache/spirv.cache";
+const uint SHADER_CACHE_MAGIC = 'N' | 'E' << 8 | 'S' << 16 | 'C' << 24;
+
+//shaderc does not expose its own version, but it is linked from the Vulkan SDK,
+//so the SDK the headers come from identifies the compiler build
+const uint SHADER_COMPILER_VERSION = VK_HEADER_VERSION_COMPLETE;
+
+struct ShaderCacheHeader {
+	uint magic;
+	uint version;
+	uint compiler_version;
+	uint entry_count;
+	uint spirv_size;
+};
+
+//FNV-1a
+u64 hash_bytes(u64 hash, const void* data, u64 length) {
+	const u8* bytes = (const u8*)data;
+	for (u64 i = 0; i < length; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+u64 shader_cache_key(string_view preprocessed, Stage stage, shader_flags flags) {
+	uint spirv_version = 0;
+	uint spirv_revision = 0;
+	shaderc_get_spv_version(&spirv_version, &spirv_revision);
+
+	uint version = SHADER_CACHE_VERSION;
+	uint compiler_version = SHADER_COMPILER_VERSION;
+
+	u64 hash = 14695981039346656037ull;
+	hash = hash_bytes(hash, preprocessed.data, preprocessed.length);
+	hash = hash_bytes(hash, &stage, sizeof(Stage));
+	hash = hash_bytes(hash, &flags, sizeof(shader_flags));
+	hash = hash_bytes(hash, &spirv_version, sizeof(uint));
+	hash = hash_bytes(hash, &spirv_revision, sizeof(uint));
+	hash = hash_bytes(hash, &version, sizeof(uint));
+	hash = hash_bytes(hash, &compiler_version, sizeof(uint));
+	return hash;
+}
+
+void load_ShaderCache(ShaderCache& cache) {
+	if (cache.loaded) return;
+	cache.loaded = true;
+
+	string_buffer contents;
+	if (!io_readfb(SHADER_CACHE_PATH, &contents)) return;
+	if (contents.length < sizeof(ShaderCacheHeader)) return;
+
+	ShaderCacheHeader header;
+	memcpy(&header, contents.data, sizeof(ShaderCacheHeader));
+
+	u64 entries_size = sizeof(ShaderCacheEntry) * (u64)header.entry_count;
+
+	bool valid = header.magic == SHADER_CACHE_MAGIC
+		&& header.version == SHADER_CACHE_VERSION
+		&& header.compiler_version == SHADER_COMPILER_VERSION
+		&& sizeof(ShaderCacheHeader) + entries_size + header.spirv_size <= contents.length;
+
+	if (!valid) return;
+
+	cache.entries.resize(header.entry_count);
+	cache.spirv.resize(header.spirv_size);
+
+	memcpy(cache.entries.data, contents.data + sizeof(ShaderCacheHeader), entries_size);
+	memcpy(cache.spirv.data, contents.data + sizeof(ShaderCacheHeader) + entries_size, header.spirv_size);
+}
+
+bool save_ShaderCache(ShaderCache& cache) {
+	if (!cache.dirty) return true;
+
+	ShaderCacheHeader header = {};
+	header.magic = SHADER_CACHE_MAGIC;
+	header.version = SHADER_CACHE_VERSION;
+	header.compiler_version = SHADER_COMPILER_VERSION;
+	header.entry_count = cache.entries.length;
+	header.spirv_size = cache.spirv.length;
+
+	u64 entries_size = sizeof(ShaderCacheEntry) * (u64)header.entry_count;
+	u64 size = sizeof(ShaderCacheHeader) + entries_size + header.spirv_size;
+
+	Allocator& allocator = get_allocator();
+	char* blob = (char*)allocator.allocate(size);
+
+	memcpy(blob, &header, sizeof(ShaderCacheHeader));
+	memcpy(blob + sizeof(ShaderCacheHeader), cache.entries.data, entries_size);
+	memcpy(blob + sizeof(ShaderCacheHeader) + entries_size, cache.spirv.data, header.spirv_size);
+
+	bool written = io_writef(SHADER_CACHE_PATH, { blob, (uint)size });
+	allocator.deallocate(blob);
+
+	if (written) cache.dirty = false;
+	return written;
+}
+
+bool shader_cache_lookup(const ShaderCache& cache, u64 key, string_view* spirv) {
+	for (uint i = 0; i < cache.entries.length; i++) {
+		const ShaderCacheEntry& entry = cache.entries.data[i];
+		if (entry.key != key) continue;
+
+		*spirv = { cache.spirv.data + entry.offset, entry.length };
+		return true;
+	}
+
+	return false;
+}
+
+//Stale permutations are never removed, deleting the archive rebuilds it from the permutations still in use
+void shader_cache_insert(ShaderCache& cache, u64 key, string_view spirv) {
+	ShaderCacheEntry entry = {};
+	entry.key = key;
+	entry.offset = cache.spirv.length;
+	entry.length = spirv.length;
+
+	cache.spirv += slice<char>((char*)spirv.data, spirv.length);
+	cache.entries.append(entry);
+	cache.dirty = true;
+}
@@ -0,0 +1,236 @@
+#include "graphics/assets/texture.h"
+#include "graphics/assets/block_compression.h"
+#include "graphics/assets/vertex_compression.h"
+#include "core/memory/allocator.h"
+#include "core/io/logger.h"
+#include "core/container/string_buffer.h"
+#include "engine/vfs.h"
+#include <stb_image.h>
+#include <string.h>
+
+const uint COOKED_TEXTURE_MAGIC = 'N' | 'E' << 8 | 'T' << 16 | 'X' << 24;
+const u64 COOKED_TEXTURE_ALIGNMENT = 16;
+
+struct CookedTextureHeader {
+	uint magic;
+	uint version;
+	i64 source_time_modified;
+	u64 source_hash;
+	TextureCookUsage usage;
+	TextureFormat format;
+	uint width;
+	uint height;
+	uint num_channels;
+	uint num_mips;
+	u64 data_offset;
+	u64 data_size;
+};
+
+//FNV-1a over the source file
+u64 hash_source(string_view contents) {
+	u64 hash = 14695981039346656037ull;
+	for (uint i = 0; i < contents.length; i++) {
+		hash ^= (u8)contents.data[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+bool name_has_token(const char* name, slice<const char*> tokens) {
+	const char* begin = name;
+
+	while (true) {
+		const char* end = begin;
+		while (*end && *end != '_' && *end != '-' && *end != '.' && *end != ' ') end++;
+
+		uint length = end - begin;
+		for (const char* token : tokens) {
+			if (strlen(token) == length && strncmp(begin, token, length) == 0) return true;
+		}
+
+		if (!*end) return false;
+		begin = end + 1;
+	}
+}
+
+//Classifies by whole words of the file name, so "storm_n.png" is a normal map but "platform.png" is not a mask
+TextureCookUsage texture_usage_from_path(string_view path) {
+	char name[256];
+	int slash = path.find_last_of('/');
+	uint begin = slash == -1 ? 0 : slash + 1;
+	uint length = min(path.length - begin, (uint)sizeof(name) - 1);
+
+	for (uint i = 0; i < length; i++) name[i] = to_lower_case(path.data[begin + i]);
+	name[length] = '\0';
+
+	char* ext = strrchr(name, '.');
+	if (ext) {
+		if (strcmp(ext, ".hdr") == 0) return TextureCookUsage::HDR;
+		*ext = '\0';
+	}
+
+	const char* normals[] = { "normal", "normals", "n", "nrm", "nor" };
+	if (name_has_token(name, normals)) return TextureCookUsage::Normal;
+
+	const char* masks[] = { "rough", "roughness", "metal", "metallic", "metalness", "ao", "ambient", "occlusion", "orm", "height", "mask", "specular" };
+	if (name_has_token(name, masks)) return TextureCookUsage::Mask;
+
+	return TextureCookUsage::Albedo;
+}
+
+bool has_alpha(const Image& image) {
+	const u8* texels = (const u8*)image.data;
+	u64 count = (u64)image.width * image.height;
+
+	for (u64 i = 0; i < count; i++) {
+		if (texels[i * 4 + 3] != 255) return true;
+	}
+
+	return false;
+}
+
+bool cook_texture(string_view path, TextureCookUsage usage) {
+	string_buffer source;
+	if (!io_readfb(path, &source)) return false;
+
+	CookedTextureHeader header = {};
+	header.magic = COOKED_TEXTURE_MAGIC;
+	header.version = COOKED_TEXTURE_VERSION;
+	header.source_time_modified = io_time_modified(path);
+	header.source_hash = hash_source(source);
+	header.usage = usage;
+	header.data_offset = (sizeof(CookedTextureHeader) + COOKED_TEXTURE_ALIGNMENT - 1) & ~(COOKED_TEXTURE_ALIGNMENT - 1);
+
+	Allocator& allocator = get_allocator();
+	char* blob = nullptr;
+	int width, height, file_channels;
+
+	//HDR environment maps only sample the base level when they are converted to a cubemap
+	if (usage == TextureCookUsage::HDR) {
+		float* texels = stbi_loadf_from_memory((const stbi_uc*)source.data, source.length, &width, &height, &file_channels, STBI_rgb_alpha);
+		if (!texels) return false;
+
+		TextureDesc desc = {};
+		desc.format = TextureFormat::HALF;
+		desc.width = width;
+		desc.height = height;
+		desc.num_channels = 4;
+
+		header.data_size = image_data_size(desc);
+		blob = (char*)allocator.allocate(header.data_offset + header.data_size);
+
+		u16* output = (u16*)(blob + header.data_offset);
+		u64 count = (u64)width * height * 4;
+		for (u64 i = 0; i < count; i++) output[i] = float_to_half(texels[i]);
+
+		stbi_image_free(texels);
+
+		header.format = desc.format;
+		header.width = desc.width;
+		header.height = desc.height;
+		header.num_channels = desc.num_channels;
+		header.num_mips = desc.num_mips;
+	}
+	else {
+		Image image = {};
+		image.data = stbi_load_from_memory((const stbi_uc*)source.data, source.length, &width, &height, &file_channels, STBI_rgb_alpha);
+		if (!image.data) return false;
+
+		image.width = width;
+		image.height = height;
+		image.num_channels = 4;
+
+		//Averaging normals with a wide kernel rings at the edges of details, the box filter keeps them stable
+		generate_mips(image, usage == TextureCookUsage::Normal ? MipFilter::Box : MipFilter::Kaiser);
+
+		TextureDesc desc = image;
+		if (usage == TextureCookUsage::Normal) desc.format = TextureFormat::BC5;
+		else if (usage == TextureCookUsage::Albedo && has_alpha(image)) desc.format = TextureFormat::BC3;
+		else desc.format = TextureFormat::BC1;
+
+		header.data_size = image_data_size(desc);
+		blob = (char*)allocator.allocate(header.data_offset + header.data_size);
+
+		for (uint mip = 0; mip < image.num_mips; mip++) {
+			const u8* level = (const u8*)image.data + image_level_offset(image, mip);
+			u8* output = (u8*)blob + header.data_offset + image_level_offset(desc, mip);
+
+			compress_image_level(level, max(image.width >> mip, 1), max(image.height >> mip, 1), desc.format, output);
+		}
+
+		free_Image(image);
+
+		header.format = desc.format;
+		header.width = desc.width;
+		header.height = desc.height;
+		header.num_channels = desc.num_channels;
+		header.num_mips = desc.num_mips;
+	}
+
+	memset(blob, 0, header.data_offset);
+	memcpy(blob, &header, sizeof(CookedTextureHeader));
+
+	//A streaming job may still have the previous version mapped, rewriting it in place would change the file under it
+	string_buffer cooked_path = tformat(path, ".cooked");
+	string_buffer staging_path = tformat(path, ".cooked.tmp");
+	bool written = io_writef(staging_path, { blob, (uint)(header.data_offset + header.data_size) });
+	allocator.deallocate(blob);
+
+	return written && io_replacef(staging_path, cooked_path);
+}
+
+bool load_cooked_texture(string_view path, CookedTexture* output) {
+	string_buffer cooked_path = tformat(path, ".cooked");
+
+	MappedFile file;
+	if (!io_mapf(cooked_path, &file)) return false;
+
+	char* blob = (char*)file.data;
+	CookedTextureHeader& header = *(CookedTextureHeader*)blob;
+
+	bool valid = file.length >= sizeof(CookedTextureHeader)
+		&& header.magic == COOKED_TEXTURE_MAGIC
+		&& header.version == COOKED_TEXTURE_VERSION
+		&& header.data_offset + header.data_size <= file.length;
+
+	//Copying or checking out the source changes the time but not the contents, so the hash decides
+	i64 source_time_modified = valid ? io_time_modified(path) : -1;
+	if (source_time_modified != -1 && source_time_modified != header.source_time_modified) {
+		string_buffer source;
+		valid = io_readfb(path, &source) && hash_source(source) == header.source_hash;
+	}
+
+	if (!valid) {
+		io_unmapf(file);
+		return false;
+	}
+
+	Image& image = output->image;
+	image = {};
+	image.format = header.format;
+	image.width = header.width;
+	image.height = header.height;
+	image.num_channels = header.num_channels;
+	image.num_mips = header.num_mips;
+	image.data = blob + header.data_offset;
+
+	output->usage = header.usage;
+	output->file = file;
+
+	return true;
+}
+
+bool load_texture_cached(string_view path, TextureCookUsage usage, CookedTexture* output) {
+	if (load_cooked_texture(path, output)) {
+		if (output->usage == usage) return true;
+		free_cooked_texture(*output);
+	}
+
+	if (!cook_texture(path, usage)) return false;
+	return load_cooked_texture(path, output);
+}
+
+void free_cooked_texture(CookedTexture& texture) {
+	io_unmapf(texture.file);
+	texture.image.data = nullptr;
+}
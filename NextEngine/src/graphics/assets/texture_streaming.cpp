@@ -0,0 +1,351 @@
+#include "graphics/assets/texture_streaming.h"
+#include "graphics/assets/assets.h"
+#include "graphics/assets/assets_store.h"
+#include "graphics/assets/material.h"
+#include "graphics/rhi/rhi.h"
+#include "core/io/logger.h"
+#include "core/time.h"
+#include <math.h>
+
+const uint NOT_STREAMED = ~0u;
+
+StreamedTexture* streamed_texture(TextureStreamer& streamer, texture_handle handle) {
+	if (handle.id >= streamer.index_of_handle.length) return nullptr;
+
+	uint index = streamer.index_of_handle[handle.id];
+	return index == NOT_STREAMED ? nullptr : &streamer.textures[index];
+}
+
+texture_handle stream_Texture(string_view path, float priority) {
+	if (uint* cached = assets.path_to_handle.get(path)) {
+		request_Texture({ *cached }, priority);
+		return { *cached };
+	}
+
+	texture_handle handle = assets.textures.assign_handle(Texture());
+	stream_Texture(handle, path, priority);
+	return handle;
+}
+
+void stream_Texture(texture_handle handle, string_view path, float priority) {
+	TextureStreamer& streamer = assets.streamer;
+
+	if (streamed_texture(streamer, handle)) {
+		request_Texture(handle, priority);
+		return;
+	}
+
+	//shares the image of a default texture until it is resident, so it is never destroyed
+	texture_handle placeholder = texture_usage_from_path(path) == TextureCookUsage::Normal ? default_textures.normal : default_textures.white;
+	assets.textures.assign_handle(handle, Texture(*assets.textures.get(placeholder)));
+
+	StreamedTexture streamed = {};
+	streamed.handle = handle;
+	streamed.path = path;
+	streamed.state = StreamState::Queued;
+	streamed.placeholder = true;
+	streamed.priority = priority;
+	streamed.last_requested_frame = streamer.frame;
+	streamed.request_time = Time::now();
+
+	while (streamer.index_of_handle.length <= handle.id) streamer.index_of_handle.append(NOT_STREAMED);
+	streamer.index_of_handle[handle.id] = streamer.textures.length;
+	streamer.textures.append(streamed);
+
+	assets.path_to_handle.set(path, handle.id);
+	watch_asset(WatchedAssetType::Texture, path, handle.id);
+	streamer.stats.requested++;
+}
+
+void request_Texture(texture_handle handle, float priority) {
+	TextureStreamer& streamer = assets.streamer;
+
+	StreamedTexture* texture = streamed_texture(streamer, handle);
+	if (!texture) return;
+
+	//the first request of a frame replaces the priority of the last frame
+	if (texture->last_requested_frame != streamer.frame) texture->priority = priority;
+	else texture->priority = fminf(texture->priority, priority);
+
+	texture->last_requested_frame = streamer.frame;
+
+	//a texture that lost mips to the budget is loaded at full resolution again once it fits
+	bool reduced = texture->state == StreamState::Resident && texture->resident_mip > 0;
+	if (reduced && streamer.resident_size - texture->resident_size + texture->full_size <= streamer.budget) {
+		texture->requested_mip = 0;
+		texture->state = StreamState::Queued;
+	}
+}
+
+bool is_texture_param(const ParamDesc& param) {
+	return param.type == Param_Image
+		|| param.type == Param_Channel1
+		|| param.type == Param_Channel2
+		|| param.type == Param_Channel3
+		|| param.type == Param_Channel4;
+}
+
+void request_material_textures(material_handle handle, float priority) {
+	Material* material = assets.materials.get(handle);
+	if (!material) return;
+
+	for (ParamDesc& param : material->desc.params) {
+		if (is_texture_param(param) && param.image != INVALID_HANDLE) request_Texture({ param.image }, priority);
+	}
+}
+
+bool material_textures_resident(material_handle handle) {
+	Material* material = assets.materials.get(handle);
+	if (!material) return true;
+
+	for (ParamDesc& param : material->desc.params) {
+		if (!is_texture_param(param) || param.image == INVALID_HANDLE) continue;
+
+		StreamedTexture* texture = streamed_texture(assets.streamer, { param.image });
+		if (texture && texture->placeholder && texture->state != StreamState::Failed) return false;
+	}
+
+	return true;
+}
+
+bool restream_Texture(texture_handle handle) {
+	StreamedTexture* texture = streamed_texture(assets.streamer, handle);
+	if (!texture) return false;
+
+	//a texture that is loading picks up the new file the next time it is requested at another resolution
+	if (texture->state == StreamState::Resident || texture->state == StreamState::Failed) texture->state = StreamState::Queued;
+	return true;
+}
+
+void set_texture_streaming_budget(u64 budget) {
+	assets.streamer.budget = budget;
+}
+
+TextureStreamingStats texture_streaming_stats() {
+	TextureStreamer& streamer = assets.streamer;
+
+	TextureStreamingStats stats = streamer.stats;
+	stats.resident_size = streamer.resident_size;
+	stats.budget = streamer.budget;
+	stats.average_latency = stats.completed > 0 ? streamer.total_latency / stats.completed : 0.0;
+	stats.queued = 0;
+
+	for (StreamedTexture& texture : streamer.textures) {
+		if (texture.state == StreamState::Queued || texture.state == StreamState::Loading) stats.queued++;
+	}
+
+	return stats;
+}
+
+//The cooked mip chain starting at mip, the smaller levels follow each other in the same order
+Image mip_chain(const Image& image, uint mip) {
+	Image result = image;
+	result.width = max(image.width >> mip, 1);
+	result.height = max(image.height >> mip, 1);
+	result.num_mips = image.num_mips - mip;
+	result.data = (char*)image.data + image_level_offset(image, mip);
+	return result;
+}
+
+bool evict_mip(TextureStreamer& streamer, StreamedTexture& except, u64* freed);
+
+u64 upload_streamed_texture(TextureStreamer& streamer, StreamedTexture& texture, const Image& cooked) {
+	texture.full_size = image_data_size(cooked);
+
+	uint mip = min(texture.requested_mip, cooked.num_mips - 1);
+
+	auto overflow = [&](uint level) -> u64 {
+		u64 size = streamer.resident_size - texture.resident_size + image_data_size(mip_chain(cooked, level));
+		return size > streamer.budget ? size - streamer.budget : 0;
+	};
+
+	//The evicted mips are dropped by later stream jobs, until then this texture is uploaded at a lower
+	//resolution and request_Texture brings it back to full resolution once it fits
+	u64 freed = 0;
+	if (!texture.evicting) {
+		while (freed < overflow(mip) && evict_mip(streamer, texture, &freed)) {}
+	}
+
+	while (mip + 1 < cooked.num_mips && overflow(mip) > 0) mip++;
+
+	Image image = mip_chain(cooked, mip);
+	u64 size = image_data_size(image);
+
+	Texture* slot = assets.textures.get(texture.handle);
+	if (!texture.placeholder) streamer.retired.append({ *slot, streamer.frame });
+	*slot = make_TextureImage(rhi.texture_allocator, image);
+
+	if (texture.placeholder) {
+		double latency = Time::now() - texture.request_time;
+		streamer.total_latency += latency;
+		streamer.stats.max_latency = fmax(streamer.stats.max_latency, latency);
+		streamer.stats.completed++;
+	}
+
+	streamer.resident_size += size - texture.resident_size;
+
+	texture.placeholder = false;
+	texture.evicting = false;
+	texture.state = StreamState::Resident;
+	texture.requested_mip = mip;
+	texture.resident_mip = mip;
+	texture.resident_size = size;
+
+	streamer.changed.append(texture.handle);
+	return size;
+}
+
+//Queues the texture that was requested least recently to be loaded again from the cooked file without its highest mip
+bool evict_mip(TextureStreamer& streamer, StreamedTexture& except, u64* freed) {
+	StreamedTexture* victim = nullptr;
+
+	for (StreamedTexture& texture : streamer.textures) {
+		if (&texture == &except || texture.state != StreamState::Resident) continue;
+		if (streamer.frame - texture.last_requested_frame < TEXTURE_STREAMING_EVICT_AFTER) continue;
+		if (assets.textures.get(texture.handle)->desc.num_mips <= 1) continue;
+
+		if (!victim || texture.last_requested_frame < victim->last_requested_frame) victim = &texture;
+	}
+
+	if (!victim) return false;
+
+	victim->requested_mip = victim->resident_mip + 1;
+	victim->state = StreamState::Queued;
+	victim->evicting = true;
+
+	//the next mip chain is about a quarter of the size
+	*freed += victim->resident_size - victim->resident_size / 4;
+	streamer.stats.evicted++;
+	return true;
+}
+
+void stream_texture_job(TextureStreamJob& job) {
+	job.loaded = load_texture_cached(job.path, texture_usage_from_path(job.path), &job.texture);
+}
+
+//Textures requested this frame come first, then the closest ones
+bool more_urgent(const StreamedTexture& a, const StreamedTexture& b) {
+	if (a.last_requested_frame != b.last_requested_frame) return a.last_requested_frame > b.last_requested_frame;
+	return a.priority < b.priority;
+}
+
+void start_stream_batch(TextureStreamer& streamer) {
+	streamer.job_count = 0;
+
+	while (streamer.job_count < TEXTURE_STREAMING_BATCH) {
+		int next = -1;
+
+		for (uint i = 0; i < streamer.textures.length; i++) {
+			StreamedTexture& texture = streamer.textures[i];
+			if (texture.state != StreamState::Queued) continue;
+			if (next == -1 || more_urgent(texture, streamer.textures[next])) next = i;
+		}
+
+		if (next == -1) break;
+
+		StreamedTexture& texture = streamer.textures[next];
+		texture.state = StreamState::Loading;
+
+		TextureStreamJob& job = streamer.jobs[streamer.job_count++];
+		job.index = next;
+		job.path = texture.path;
+		job.texture = {};
+		job.loaded = false;
+		job.uploaded = false;
+	}
+
+	if (streamer.job_count == 0) return;
+
+	JobDesc desc[TEXTURE_STREAMING_BATCH];
+	for (uint i = 0; i < streamer.job_count; i++) desc[i] = JobDesc(stream_texture_job, streamer.jobs + i);
+
+	add_jobs(PRIORITY_LOW, { desc, streamer.job_count }, &streamer.counter);
+}
+
+//Returns true once every job of the batch was uploaded
+bool upload_stream_batch(TextureStreamer& streamer) {
+	u64 uploaded = 0;
+	bool uploading = false;
+
+	for (uint i = 0; i < streamer.job_count; i++) {
+		TextureStreamJob& job = streamer.jobs[i];
+		if (job.uploaded) continue;
+		if (uploaded >= TEXTURE_STREAMING_UPLOAD_PER_FRAME) return false;
+
+		StreamedTexture& texture = streamer.textures[job.index];
+		job.uploaded = true;
+
+		if (!job.loaded) {
+			log("Could not stream texture ", job.path, "\n");
+			texture.state = StreamState::Failed;
+			streamer.stats.failed++;
+			continue;
+		}
+
+		if (!uploading) begin_gpu_upload();
+		uploading = true;
+
+		uploaded += upload_streamed_texture(streamer, texture, job.texture.image);
+		free_cooked_texture(job.texture);
+	}
+
+	if (uploading) end_gpu_upload();
+	return true;
+}
+
+//Destroyed once the frames in flight that could sample them have finished
+void release_retired_textures(TextureStreamer& streamer) {
+	for (uint i = 0; i < streamer.retired.length;) {
+		RetiredTexture& retired = streamer.retired[i];
+		if (streamer.frame - retired.frame <= MAX_FRAMES_IN_FLIGHT) {
+			i++;
+			continue;
+		}
+
+		destroy_TextureImage(rhi.texture_allocator, retired.texture);
+
+		if (i + 1 < streamer.retired.length) retired = streamer.retired.last();
+		streamer.retired.pop();
+	}
+}
+
+//Every material is made again at most once a frame, MaterialAllocator::make writes the descriptor set of the next frame
+void rebuild_changed_materials(TextureStreamer& streamer) {
+	if (streamer.changed.length == 0) return;
+
+	for (Material* material : assets.materials.by_handle) {
+		if (!material) continue;
+
+		bool changed = false;
+		for (ParamDesc& param : material->desc.params) {
+			if (!is_texture_param(param)) continue;
+
+			for (texture_handle handle : streamer.changed) changed |= param.image == handle.id;
+		}
+
+		if (changed) rhi.material_allocator.make(material->desc, material);
+	}
+
+	streamer.changed.clear();
+}
+
+void update_TextureStreamer(TextureStreamer& streamer) {
+	streamer.frame++;
+
+	release_retired_textures(streamer);
+
+	if (streamer.counter == 0 && upload_stream_batch(streamer)) start_stream_batch(streamer);
+
+	rebuild_changed_materials(streamer);
+}
+
+void destroy_TextureStreamer(TextureStreamer& streamer) {
+	wait_for_counter(&streamer.counter, 0);
+
+	for (uint i = 0; i < streamer.job_count; i++) {
+		TextureStreamJob& job = streamer.jobs[i];
+		if (job.loaded && !job.uploaded) free_cooked_texture(job.texture);
+	}
+
+	streamer.job_count = 0;
+}
@@ -0,0 +1,52 @@
+#include "graphics/assets/vertex_compression.h"
+
+CompactVertex encode_vertex(const Vertex& vertex, const AABB& bounds) {
+	CompactVertex result;
+
+	glm::vec3 extent = bounds.max - bounds.min;
+	for (uint i = 0; i < 3; i++) {
+		float t = extent[i] > 0.0f ? (vertex.position[i] - bounds.min[i]) / extent[i] : 0.0f;
+		result.position[i] = (u16)roundf(glm::clamp(t, 0.0f, 1.0f) * 65535.0f);
+	}
+
+	glm::vec2 normal = octahedral_encode(vertex.normal);
+	glm::vec2 tangent = octahedral_encode(vertex.tangent);
+
+	result.normal[0] = float_to_snorm16(normal.x);
+	result.normal[1] = float_to_snorm16(normal.y);
+	result.tangent[0] = float_to_snorm16(tangent.x);
+	result.tangent[1] = float_to_snorm16(tangent.y);
+
+	bool flipped = glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.bitangent) < 0.0f;
+	result.bitangent_sign = flipped ? -32767 : 32767;
+
+	result.tex_coord[0] = float_to_half(vertex.tex_coord.x);
+	result.tex_coord[1] = float_to_half(vertex.tex_coord.y);
+
+	return result;
+}
+
+Vertex decode_vertex(const CompactVertex& vertex, const AABB& bounds) {
+	Vertex result;
+	result.position = decode_compact_position(vertex, bounds);
+	result.normal = octahedral_decode(glm::vec2(snorm16_to_float(vertex.normal[0]), snorm16_to_float(vertex.normal[1])));
+	result.tangent = octahedral_decode(glm::vec2(snorm16_to_float(vertex.tangent[0]), snorm16_to_float(vertex.tangent[1])));
+	result.bitangent = glm::cross(result.normal, result.tangent) * (vertex.bitangent_sign < 0 ? -1.0f : 1.0f);
+	result.tex_coord = glm::vec2(half_to_float(vertex.tex_coord[0]), half_to_float(vertex.tex_coord[1]));
+	return result;
+}
+
+void decode_vertices(slice<CompactVertex> vertices, const AABB& bounds, Vertex* output) {
+	for (uint i = 0; i < vertices.length; i++) {
+		output[i] = decode_vertex(vertices[i], bounds);
+	}
+}
+
+uint mesh_vertex_count(const Mesh& mesh, uint lod) {
+	return mesh.compact_vertices[lod].length > 0 ? mesh.compact_vertices[lod].length : mesh.vertices[lod].length;
+}
+
+glm::vec3 mesh_vertex_position(const Mesh& mesh, uint lod, uint index) {
+	if (mesh.compact_vertices[lod].length > 0) return decode_compact_position(mesh.compact_vertices[lod][index], mesh.quantization_aabb);
+	return mesh.vertices[lod][index].position;
+}
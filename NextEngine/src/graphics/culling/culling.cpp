@@ -29,49 +29,80 @@ void extract_planes(Viewport& viewport) {
 	for (int i = 0; i < 4; i++) viewport.frustum_planes[5][i] = mat[i][3] - mat[i][2]; //back
 }
 
+//dist_p is the distance of the corner furthest along the plane normal, dist_n of the nearest
+inline void plane_distances(const glm::vec4& plane, const AABB& aabb, float& dist_p, float& dist_n) {
+	glm::vec3 plane_normal(plane);
+	glm::vec3 vmin, vmax;
+
+	if (plane.x < 0) {
+		vmin.x = aabb.min.x;
+		vmax.x = aabb.max.x;
+	}
+	else {
+		vmin.x = aabb.max.x;
+		vmax.x = aabb.min.x;
+	}
+
+	if (plane.y < 0) {
+		vmin.y = aabb.min.y;
+		vmax.y = aabb.max.y;
+	}
+	else {
+		vmin.y = aabb.max.y;
+		vmax.y = aabb.min.y;
+	}
+
+	if (plane.z < 0) {
+		vmin.z = aabb.min.z;
+		vmax.z = aabb.max.z;
+	}
+	else {
+		vmin.z = aabb.max.z;
+		vmax.z = aabb.min.z;
+	}
+
+	dist_p = glm::dot(plane_normal, vmin) + plane.w;
+	dist_n = glm::dot(plane_normal, vmax) + plane.w;
+}
+
 CullResult frustum_test(const glm::vec4 planes[6], const AABB& aabb) {	
 	CullResult result = INSIDE;
 
 	for (int planeID = 0; planeID < 6; planeID++) {
-		glm::vec3 planeNormal(planes[planeID]);
-		float planeConstant(planes[planeID].w);
-
-		glm::vec3 vmin, vmax;
+		float dist_p, dist_n;
+		plane_distances(planes[planeID], aabb, dist_p, dist_n);
 
-		if (planes[planeID].x < 0) {
-			vmin.x = aabb.min.x;
-			vmax.x = aabb.max.x;
-		}
-		else {
-			vmin.x = aabb.max.x;
-			vmax.x = aabb.min.x;
+		if (dist_p < 0.0f) {
+			return OUTSIDE;
 		}
 
-		if (planes[planeID].y < 0) {
-			vmin.y = aabb.min.y;
-			vmax.y = aabb.max.y;
-		}
-		else {
-			vmin.y = aabb.max.y;
-			vmax.y = aabb.min.y;
+		if (dist_n <= 0.0f) {
+			result = INTERSECT;
 		}
+	}
 
-		if (planes[planeID].z < 0) {
-			vmin.z = aabb.min.z;
-			vmax.z = aabb.max.z;
-		}
-		else {
-			vmin.z = aabb.max.z;
-			vmax.z = aabb.min.z;
-		}
+	return result;
+}
 
-		if (glm::dot(planeNormal, vmin) + planeConstant < 0.0f) {
+CullResult frustum_test(const glm::vec4 planes[6], const AABB& aabb, float& margin) {
+	CullResult result = INSIDE;
+	margin = FLT_MAX;
+
+	for (int planeID = 0; planeID < 6; planeID++) {
+		float dist_p, dist_n;
+		plane_distances(planes[planeID], aabb, dist_p, dist_n);
+
+		//stays outside as long as this plane does not move past the box
+		if (dist_p < 0.0f) {
+			margin = -dist_p;
 			return OUTSIDE;
 		}
 
-		//if (glm::dot(planeNormal, vmax) + planeConstant <= 0.0f) {
-		//	result = INTERSECT;
-		//}
+		if (dist_n <= 0.0f) {
+			result = INTERSECT;
+		}
+
+		margin = glm::min(margin, glm::min(dist_p, glm::abs(dist_n)));
 	}
 
 	return result;
@@ -241,28 +272,10 @@ void build_acceleration_structure(ScenePartition& scene_partition, hash_set<Mesh
 	job.models_m = models_m.data;
 
 	subdivide_BVH(job);
+	scene_partition.version++;
 }
 
 
-#define MAX_DEPTH_CHECK_EACH 5
-
-void cull_node(CulledMeshBucket* culled, const ScenePartition& partition, const Node& node, int depth, glm::vec4 planes[6]) {
-	CullResult cull_result = frustum_test(planes, node.aabb);
-	if (cull_result == OUTSIDE) return;
-	
-	bool test_children = depth < MAX_DEPTH_CHECK_EACH;
-
-	for (int i = node.offset; i < node.offset + node.count; i++) {
-		if (test_children && frustum_test(planes, partition.aabbs[i]) == OUTSIDE) continue;
-
-		culled[partition.meshes[i]].model_m.append(partition.model_m[i]);
-	}
-
-	for (int i = 0; i < node.child_count; i++) {
-		cull_node(culled, partition, partition.nodes[node.child[i]], depth, planes);
-	}
-}
-
 void update_acceleration_structure(ScenePartition& scene_partition, MeshBuckets& mesh_buckets, World& world) {
 	if (scene_partition.node_count == 0) {
 		build_acceleration_structure(scene_partition, mesh_buckets, world);
@@ -289,6 +302,170 @@ void cull_static_meshes(const ScenePartition& scene_partition, CulledMeshBucket*
 }
 */
 
+//Upper bound for how far any point within radius of the origin moved relative to the planes
+struct PlaneDrift {
+	float normal = 0.0f;
+	float constant = 0.0f;
+
+	inline float at(float radius) const { return normal * radius + constant; }
+};
+
+inline float radius_of(const AABB& aabb) {
+	return glm::length(glm::max(glm::abs(aabb.min), glm::abs(aabb.max)));
+}
+
+inline void set_instance_visible(ViewCullingCache& cache, const ScenePartition& partition, uint i, bool visible) {
+	if (cache.instance_visible[i] == visible) return;
+	cache.instance_visible[i] = visible;
+
+	if (visible) cache.became_visible.append(i);
+	else cache.became_hidden.append(i);
+}
+
+//An instance can flip more than once in an update, so the lists follow its final state
+void apply_culling_delta(ViewCullingCache& cache, const ScenePartition& partition, uint i) {
+	uint bucket = partition.meshes[i];
+	vector<uint>& instances = cache.bucket_instances[bucket];
+	vector<glm::mat4>& model_m = cache.bucket_model_m[bucket];
+	uint slot = cache.instance_slot[i];
+
+	if (cache.instance_visible[i] && slot == INVALID_INSTANCE_SLOT) {
+		cache.instance_slot[i] = instances.length;
+		instances.append(i);
+		model_m.append(partition.model_m[i]);
+	}
+	else if (!cache.instance_visible[i] && slot != INVALID_INSTANCE_SLOT) {
+		uint last = instances.pop();
+		glm::mat4 last_model_m = model_m.pop();
+		if (last != i) {
+			instances[slot] = last;
+			model_m[slot] = last_model_m;
+			cache.instance_slot[last] = slot;
+		}
+		cache.instance_slot[i] = INVALID_INSTANCE_SLOT;
+	}
+}
+
+void apply_culling_deltas(ViewCullingCache& cache, const ScenePartition& partition) {
+	for (uint i : cache.became_hidden) apply_culling_delta(cache, partition, i);
+	for (uint i : cache.became_visible) apply_culling_delta(cache, partition, i);
+}
+
+//A box inside the node can only be further from flipping than the node itself,
+//so the whole subtree inherits the state and margin
+void set_subtree_state(ViewCullingCache& cache, const ScenePartition& partition, uint node_index, CullResult state, float margin) {
+	const Node& node = partition.nodes[node_index];
+	cache.node_state[node_index] = state;
+	cache.node_margin[node_index] = margin;
+
+	for (uint i = node.offset; i < node.offset + node.count; i++) {
+		cache.instance_margin[i] = margin;
+		set_instance_visible(cache, partition, i, state != OUTSIDE);
+	}
+
+	for (uint i = 0; i < node.child_count; i++) {
+		set_subtree_state(cache, partition, node.child[i], state, margin);
+	}
+}
+
+struct CacheUpdate {
+	ViewCullingCache& cache;
+	const ScenePartition& partition;
+	const glm::vec4* planes;
+	PlaneDrift drift;
+	uint retested;
+};
+
+void update_node_visibility(CacheUpdate& update, uint node_index) {
+	ViewCullingCache& cache = update.cache;
+	const ScenePartition& partition = update.partition;
+	const Node& node = partition.nodes[node_index];
+
+	CullResult state = (CullResult)cache.node_state[node_index];
+	float drift = update.drift.at(radius_of(node.aabb));
+
+	if (drift > cache.node_margin[node_index]) {
+		float margin;
+		CullResult result = frustum_test(update.planes, node.aabb, margin);
+		margin -= drift;
+		update.retested++;
+
+		if (result != INTERSECT) {
+			set_subtree_state(cache, partition, node_index, result, margin);
+			return;
+		}
+
+		cache.node_state[node_index] = result;
+		cache.node_margin[node_index] = margin;
+		state = result;
+	}
+
+	//nothing below a node that is still completely inside or outside can have changed
+	if (state != INTERSECT) return;
+
+	for (uint i = node.offset; i < node.offset + node.count; i++) {
+		const AABB& aabb = partition.aabbs[i];
+		float instance_drift = update.drift.at(radius_of(aabb));
+		if (instance_drift <= cache.instance_margin[i]) continue;
+
+		float margin;
+		CullResult result = frustum_test(update.planes, aabb, margin);
+		cache.instance_margin[i] = margin - instance_drift;
+		set_instance_visible(cache, partition, i, result != OUTSIDE);
+		update.retested++;
+	}
+
+	for (uint i = 0; i < node.child_count; i++) {
+		update_node_visibility(update, node.child[i]);
+	}
+}
+
+void update_culling_cache(ViewCullingCache& cache, const ScenePartition& partition, const glm::vec4 planes[6]) {
+	cache.became_visible.clear();
+	cache.became_hidden.clear();
+	cache.became_visible.allocator = &get_thread_local_temporary_allocator();
+	cache.became_hidden.allocator = &get_thread_local_temporary_allocator();
+
+	if (partition.node_count == 0) return;
+
+	bool rebuilt = !cache.initialized || cache.partition_version != partition.version;
+	if (!rebuilt && memcmp(cache.last_planes, planes, sizeof(cache.last_planes)) == 0) return;
+	memcpy(cache.last_planes, planes, sizeof(cache.last_planes));
+
+	if (rebuilt) {
+		for (uint i = 0; i < MAX_MESH_BUCKETS; i++) {
+			cache.bucket_instances[i].clear();
+			cache.bucket_model_m[i].clear();
+		}
+		memset(cache.instance_visible, 0, sizeof(cache.instance_visible));
+		memset(cache.instance_slot, 0xff, sizeof(cache.instance_slot));
+
+		cache.partition_version = partition.version;
+		cache.initialized = true;
+		cache.rebase_reference = true;
+	}
+
+	//margins are only meaningful relative to the reference planes, when too many
+	//of them are exceeded every test is redone against the current planes
+	if (cache.rebase_reference) {
+		memcpy(cache.reference_planes, planes, sizeof(cache.reference_planes));
+		for (uint i = 0; i < MAX_NODES; i++) cache.node_margin[i] = -FLT_MAX;
+		for (uint i = 0; i < MAX_MESH_INSTANCES; i++) cache.instance_margin[i] = -FLT_MAX;
+		cache.rebase_reference = false;
+	}
+
+	CacheUpdate update = { cache, partition, planes };
+	for (uint i = 0; i < 6; i++) {
+		glm::vec4 diff = planes[i] - cache.reference_planes[i];
+		update.drift.normal = glm::max(update.drift.normal, glm::length(glm::vec3(diff)));
+		update.drift.constant = glm::max(update.drift.constant, glm::abs(diff.w));
+	}
+
+	update_node_visibility(update, 0);
+
+	cache.rebase_reference = update.retested * 4 > (uint)(partition.node_count + partition.count);
+}
+
 struct CullMeshJob {
 	const ScenePartition* partition;
 	MeshBuckets* buckets;
@@ -296,6 +473,7 @@ struct CullMeshJob {
 	slice<glm::mat4> model_m;
 	slice<int> meshes;
 	glm::vec4* planes;
+	ViewCullingCache* cache;
 	CulledMeshBucket* result;
 };
 
@@ -309,10 +487,15 @@ void cull_mesh_job(CullMeshJob& job) {
 		job.result[job.meshes[i]].model_m.append(job.model_m[i]);
 	}
 
-	cull_node(job.result, *job.partition, job.partition->nodes[0], 0, job.planes);
+	update_culling_cache(*job.cache, *job.partition, job.planes);
+	apply_culling_deltas(*job.cache, *job.partition);
+
+	for (int i = 0; i < MAX_MESH_BUCKETS; i++) {
+		job.result[i].static_model_m = job.cache->bucket_model_m[i];
+	}
 }
 
-void cull_meshes(const ScenePartition& scene_partition, World& world, MeshBuckets& buckets, uint count, CulledMeshBucket** culled_mesh_bucket, Viewport viewports[], EntityQuery query) {
+void cull_meshes(const ScenePartition& scene_partition, World& world, MeshBuckets& buckets, uint count, CulledMeshBucket** culled_mesh_bucket, ViewCullingCache* culling_cache, Viewport viewports[], EntityQuery query) {
 	tvector<AABB> aabbs;
 	tvector<glm::mat4> model_m;
 	tvector<int> meshes;
@@ -324,7 +507,7 @@ void cull_meshes(const ScenePartition& scene_partition, World& world, MeshBucket
 	assert(count <= 10);
 
 	for (uint pass = 0; pass < count; pass++) {
-		job[pass] = { &scene_partition, &buckets, aabbs, model_m, meshes, viewports[pass].frustum_planes, culled_mesh_bucket[pass] };
+		job[pass] = { &scene_partition, &buckets, aabbs, model_m, meshes, viewports[pass].frustum_planes, culling_cache + pass, culled_mesh_bucket[pass] };
 		desc[pass] = { cull_mesh_job, job + pass };
 	}
 
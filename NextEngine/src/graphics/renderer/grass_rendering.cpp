@@ -25,7 +25,8 @@ glm::mat4* compute_model_matrices(vector<Transform>& transforms) {
 struct CullGrassInput {
 	glm::vec3 cam_pos;
 	uint lod_bias;
-	AABB model_aabb;
+	float bounding_radius;
+	float bounding_center_y;
 	float culling_distance;
 	glm::vec4 planes[6];
 	uint lod_count;
@@ -34,44 +35,75 @@ struct CullGrassInput {
 
 struct CullGrassJob {
 	CullGrassInput* input;
-	slice<glm::vec3> positions;
-	slice<glm::mat4> model_m;
+	const Grass* grass;
+	slice<GrassCell> cells;
 	tvector<glm::mat4> output[MAX_MESH_LOD];
 };
 
+//expects normalized planes
+inline bool sphere_outside_frustum(const glm::vec4 planes[6], glm::vec3 center, float radius) {
+	for (uint i = 0; i < 6; i++) {
+		if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius) return true;
+	}
+	return false;
+}
+
+inline float dist_sq_to_aabb(const AABB& aabb, glm::vec3 point) {
+	glm::vec3 vec = glm::max(glm::max(aabb.min - point, point - aabb.max), glm::vec3(0));
+	return glm::dot(vec, vec);
+}
+
 void cull_grass_particles(CullGrassJob& job) {
 	CullGrassInput input = *job.input;
+	const Grass& grass = *job.grass;
 	LinearAllocator& allocator = get_thread_local_temporary_allocator();
 	for (uint i = 0; i < MAX_MESH_LOD; i++) {
 		job.output[i].allocator = &allocator;
 	}
 
-	for (uint i = 0; i < job.positions.length; i++) {
-		glm::vec3 position = job.positions[i];
+	const float* position_x = grass.position_x.data;
+	const float* position_y = grass.position_y.data;
+	const float* position_z = grass.position_z.data;
+	const float* scale = grass.scale.data;
+
+	for (const GrassCell& cell : job.cells) {
+		if (dist_sq_to_aabb(cell.aabb, input.cam_pos) > input.culling_distance) continue;
 
-		glm::vec3 vec = position - input.cam_pos;
-		float dist = (vec.x*vec.x + vec.y*vec.y + vec.z*vec.z);
+		CullResult cull_result = frustum_test(input.planes, cell.aabb);
+		if (cull_result == OUTSIDE) continue;
 
-		if (dist > input.culling_distance) continue;
+		//cells completely inside the frustum skip the per instance test
+		bool test_instances = cull_result == INTERSECT;
 
-		AABB aabb = input.model_aabb.apply(job.model_m[i]);
-		if (frustum_test(input.planes, aabb) == OUTSIDE) continue;
+		for (uint i = cell.offset; i < cell.offset + cell.count; i++) {
+			glm::vec3 position(position_x[i], position_y[i], position_z[i]);
 
-		//float grazing_multiplier = glm::abs(glm::dot(glm::normalize(position - cam_pos), glm::vec3(0,1,0)));
-		//grazing_multiplier = 1.0 - grazing_multiplier;
+			glm::vec3 vec = position - input.cam_pos;
+			float dist = (vec.x*vec.x + vec.y*vec.y + vec.z*vec.z);
 
-		int lod = input.lod_count - 1;
+			if (dist > input.culling_distance) continue;
 
-		for (uint i = 0; i < input.lod_count; i++) {
-			if (dist <= input.lod_distance_sq[i]) {
-				lod = i;
-				break;
+			if (test_instances) {
+				glm::vec3 center = position + glm::vec3(0, input.bounding_center_y * scale[i], 0);
+				if (sphere_outside_frustum(input.planes, center, input.bounding_radius * scale[i])) continue;
 			}
-		}
 
-		lod = glm::min(lod + input.lod_bias, input.lod_count - 1);
+			//float grazing_multiplier = glm::abs(glm::dot(glm::normalize(position - cam_pos), glm::vec3(0,1,0)));
+			//grazing_multiplier = 1.0 - grazing_multiplier;
 
-		job.output[lod].append(job.model_m[i]);
+			int lod = input.lod_count - 1;
+
+			for (uint j = 0; j < input.lod_count; j++) {
+				if (dist <= input.lod_distance_sq[j]) {
+					lod = j;
+					break;
+				}
+			}
+
+			lod = glm::min(lod + input.lod_bias, input.lod_count - 1);
+
+			job.output[lod].append(grass_model_matrix(grass, i));
+		}
 	}
 }
 
@@ -84,7 +116,15 @@ void extract_grass_render_data(GrassRenderData& data, World& world, Viewport vie
 		Model* model = get_Model(grass.placement_model);
 		if (model == NULL) continue;
 
-		InstanceBuffer instance_buffers[RenderPass::ScenePassCount][MAX_MESH_LOD] = {};
+		//cells are not serialized, so they are rebuilt after loading or changing the model
+		if (grass.cells_built_for.id != grass.placement_model.id) {
+			build_grass_cells(grass, model->aabb);
+			grass.cells_built_for = grass.placement_model;
+		}
+
+		AABB model_aabb = model->aabb;
+		glm::vec3 half_extent = glm::max(glm::abs(model_aabb.min), glm::abs(model_aabb.max));
+
 		CullGrassInput input[RenderPass::ScenePassCount];
 		input[0].lod_count = model->lod_distance.length;
 		input[0].lod_distance_sq = model->lod_distance;
@@ -93,12 +133,29 @@ void extract_grass_render_data(GrassRenderData& data, World& world, Viewport vie
 		}
 
 		input[0].culling_distance = input[0].lod_distance_sq.last();
-		input[0].model_aabb = model->aabb;
+		input[0].bounding_center_y = 0.5f * (model_aabb.min.y + model_aabb.max.y);
+		input[0].bounding_radius = glm::length(glm::vec3(half_extent.x, 0.5f * (model_aabb.max.y - model_aabb.min.y), half_extent.z));
 
 		for (uint i = 1; i < RenderPass::ScenePassCount; i++) {
 			input[i] = input[0];
 		}
 
+		//group cells into jobs of roughly bucket_size instances
+		const uint bucket_size = 10000;
+		tvector<slice<GrassCell>> buckets;
+		
+		for (uint begin = 0; begin < grass.cells.length;) {
+			uint end = begin;
+			uint instances = 0;
+
+			while (end < grass.cells.length && instances < bucket_size) {
+				instances += grass.cells[end++].count;
+			}
+
+			buckets.append({ grass.cells.data + begin, end - begin });
+			begin = end;
+		}
+
 		slice<CullGrassJob> job_results[RenderPass::ScenePassCount];
 		tvector<JobDesc> job_desc;
 
@@ -108,11 +165,13 @@ void extract_grass_render_data(GrassRenderData& data, World& world, Viewport vie
 				continue;
 			}
 
-			tvector<glm::mat4> model_m[MAX_MESH_LOD];
-
 			input[pass].lod_bias = shadow_pass ? 1 : 0;
 			input[pass].cam_pos = viewports[0].cam_pos;
-			memcpy(input[pass].planes, viewports[pass].frustum_planes, sizeof(Viewport::frustum_planes));
+
+			for (uint i = 0; i < 6; i++) {
+				glm::vec4 plane = viewports[pass].frustum_planes[i];
+				input[pass].planes[i] = plane / glm::length(glm::vec3(plane));
+			}
 
 			//glm::mat4 view_m = viewports[pass].view;
 			//glm::vec2 horizontal_cam_pos(cam_pos.x, cam_pos.z);
@@ -120,23 +179,18 @@ void extract_grass_render_data(GrassRenderData& data, World& world, Viewport vie
 			//glm::vec3 viewing_dir = glm::normalize(view_m * glm::vec4(0,0,1,1) - view_m * glm::vec4(0,0,0,1));
 			//float looking_down = glm::abs(glm::dot(viewing_dir, glm::vec3(0,1,0)));
 
-			uint bucket_size = 10000;
-			uint buckets = (uint)ceilf(grass.positions.length / (float)bucket_size);
-
-			CullGrassJob* jobs = (CullGrassJob*)temporary.allocate(sizeof(CullGrassJob) * buckets);
+			CullGrassJob* jobs = (CullGrassJob*)temporary.allocate(sizeof(CullGrassJob) * buckets.length);
 
-			for (uint i = 0; i < buckets; i++) {
+			for (uint i = 0; i < buckets.length; i++) {
 				jobs[i] = {};
 				jobs[i].input = input + pass;
-				jobs[i].model_m.data = grass.model_m.data + (size_t)i * bucket_size;
-				jobs[i].positions.data = grass.positions.data + (size_t)i * bucket_size;
-				jobs[i].model_m.length = i + 1 == buckets ? grass.positions.length - i * bucket_size : bucket_size;
-				jobs[i].positions.length = jobs[i].model_m.length;
+				jobs[i].grass = &grass;
+				jobs[i].cells = buckets[i];
 
 				job_desc.append(JobDesc{ cull_grass_particles, jobs + i });
 			}
 
-			job_results[pass] = {jobs, buckets};
+			job_results[pass] = {jobs, buckets.length};
 		}
 
 		wait_for_jobs(PRIORITY_HIGH, job_desc);
@@ -158,7 +212,8 @@ void extract_grass_render_data(GrassRenderData& data, World& world, Viewport vie
 				for (uint lod = 0; lod < input[pass].lod_count; lod++) {
 					if (model_m[lod].length == 0) continue;
 
-					VertexBuffer vertex_buffer = mesh.buffer[lod];
+					//generated lods stop early for meshes that can not be simplified further
+					VertexBuffer vertex_buffer = mesh.buffer[glm::min(lod, mesh.lod_count - 1)];
 
 					GrassInstance instance = {};
 					instance.vertex_buffer = vertex_buffer;
@@ -1,15 +1,16 @@
 #include "graphics/assets/material.h"
 #include "graphics/assets/assets.h"
+#include "graphics/assets/texture_streaming.h"
 #include "core/io/logger.h"
 
 material_handle make_SubstanceMaterial(Assets& assets, string_view folder, string_view name) {
 	auto shad = load_Shader("shaders/pbr.vert", "shaders/pbr.frag");
 	
 	MaterialDesc mat{ shad };
-	mat_image(mat, "material.diffuse", load_Texture(tformat(folder, "\\", name, "_basecolor.jpg")));
-	mat_image(mat, "material.metallic", load_Texture(tformat(folder, "\\", name, "_metallic.jpg")));
-	mat_image(mat, "material.roughness", load_Texture(tformat(folder, "\\", name, "_roughness.jpg")));
-	mat_image(mat, "material.normal", load_Texture(tformat(folder, "\\", name, "_normal.jpg")));
+	mat_image(mat, "material.diffuse", stream_Texture(tformat(folder, "\\", name, "_basecolor.jpg")));
+	mat_image(mat, "material.metallic", stream_Texture(tformat(folder, "\\", name, "_metallic.jpg")));
+	mat_image(mat, "material.roughness", stream_Texture(tformat(folder, "\\", name, "_roughness.jpg")));
+	mat_image(mat, "material.normal", stream_Texture(tformat(folder, "\\", name, "_normal.jpg")));
 	mat_vec2(mat, "transformUVs", glm::vec2(1, 1));
 
 	return make_Material(mat);
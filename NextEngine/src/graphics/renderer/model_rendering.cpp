@@ -8,6 +8,9 @@
 #include "graphics/assets/assets.h"
 
 #include "graphics/assets/material.h"
+#include "graphics/assets/texture_streaming.h"
+#include <float.h>
+#include <math.h>
 
 //todo IT MIGHT BE MORE EFFICIENT TO ALLOCATE THE INSTANCE BUFFER ON THE FLY
 //INSTEAD OF PREALLOCATING, AS IT MEMORY CAN BE DISTRIBUTED MORE DYNAMICALLY
@@ -74,7 +77,7 @@ bool bit_set(uint* bit_visible, int i) {
 }
 
 
-void render_meshes(const MeshBucketCache& mesh_buckets, CulledMeshBucket* buckets, RenderPass& ctx) {
+void render_meshes(const MeshBucketCache& mesh_buckets, const ScenePartition& partition, CulledMeshBucket* buckets, RenderPass& ctx) {
 	bool depth_only = ctx.type == RenderPass::Depth;
 	bool depth_prepass = depth_only && ctx.id == RenderPass::Scene; //probably want a way of quering this
 	CommandBuffer& cmd_buffer = ctx.cmd_buffer;
@@ -84,14 +87,18 @@ void render_meshes(const MeshBucketCache& mesh_buckets, CulledMeshBucket* bucket
 	for (uint i = 0; i < MAX_MESH_BUCKETS; i++) {
 		const MeshBucket& bucket = mesh_buckets.keys[i];
 		CulledMeshBucket& instances = buckets[i];
-		int count = instances.model_m.length;
+		int count = instances.model_m.length + instances.static_model_m.length;
 
 		if (!(bucket.flags & CAST_SHADOWS) && ctx.id != RenderPass::Scene) continue;
 		if (count == 0) continue;
 
 		//todo performance: this goes through three levels of indirection
 		VertexBuffer vertex_buffer = get_vertex_buffer(bucket.model, bucket.mesh_id);
-		InstanceBuffer instance_offset = frame_alloc_instance_buffer<glm::mat4>(INSTANCE_LAYOUT_MAT4X4, instances.model_m);
+		glm::mat4* mapped;
+		InstanceBuffer instance_offset = frame_alloc_instance_buffer(INSTANCE_LAYOUT_MAT4X4, count, (void**)&mapped);
+
+		memcpy(mapped, instances.model_m.data, sizeof(glm::mat4) * instances.model_m.length);
+		memcpy(mapped + instances.model_m.length, instances.static_model_m.data, sizeof(glm::mat4) * instances.static_model_m.length);
 
 		bind_pipeline(cmd_buffer, depth_prepass ? bucket.depth_prepass : depth_only ? bucket.depth_only_pipeline :  bucket.color_pipeline);
 		
@@ -99,4 +106,17 @@ void render_meshes(const MeshBucketCache& mesh_buckets, CulledMeshBucket* bucket
 		
 		draw_mesh(cmd_buffer, vertex_buffer, instance_offset);
 	}
-}
\ No newline at end of file
+}
+
+void request_visible_textures(const MeshBucketCache& mesh_buckets, const ScenePartition& partition, CulledMeshBucket* buckets, glm::vec3 cam_pos) {
+	for (uint i = 0; i < MAX_MESH_BUCKETS; i++) {
+		const CulledMeshBucket& instances = buckets[i];
+		if (instances.model_m.length + instances.static_model_m.length == 0) continue;
+
+		float distance = FLT_MAX;
+		for (const glm::mat4& model_m : instances.model_m) distance = fminf(distance, glm::length(glm::vec3(model_m[3]) - cam_pos));
+		for (const glm::mat4& model_m : instances.static_model_m) distance = fminf(distance, glm::length(glm::vec3(model_m[3]) - cam_pos));
+
+		request_material_textures(mesh_buckets.keys[i].mat, distance);
+	}
+}
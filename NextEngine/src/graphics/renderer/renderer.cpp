@@ -143,7 +143,8 @@ void extract_render_data(Renderer& renderer, Viewport& viewport, FrameData& fram
 	fill_volumetric_ubo(frame.volumetric_ubo, frame.composite_ubo, world, renderer.settings.volumetric, viewport, camera_layermask);
 	fill_composite_ubo(frame.composite_ubo, viewport);
 
-	cull_meshes(renderer.scene_partition, world, renderer.mesh_buckets, RenderPass::ScenePassCount, frame.culled_mesh_bucket, viewports, layermask);
+	cull_meshes(renderer.scene_partition, world, renderer.mesh_buckets, RenderPass::ScenePassCount, frame.culled_mesh_bucket, renderer.culling_cache, viewports, layermask);
+	request_visible_textures(renderer.mesh_buckets, renderer.scene_partition, frame.culled_mesh_bucket[RenderPass::Scene], viewport.cam_pos);
 		
 	extract_grass_render_data(frame.grass_data, world, viewports);
 	extract_render_data_terrain(frame.terrain_data, world, &viewport, layermask);
@@ -179,7 +180,7 @@ GPUSubmission build_command_buffers(Renderer& renderer, const FrameData& frame)
 	renderer.update_materials.clear();
 
 	if (renderer.settings.hotreload_shaders) {
-		reload_modified_shaders();
+		reload_modified();
 	}
 
 	GPUSubmission submission = {
@@ -210,14 +211,14 @@ GPUSubmission build_command_buffers(Renderer& renderer, const FrameData& frame)
 	
 	for (uint i = 0; i < MAX_SHADOW_CASCADES; i++) {
 		RenderPass& render_pass = submission.render_passes[RenderPass::Shadow0 + i];
-		render_meshes(renderer.mesh_buckets, frame.culled_mesh_bucket[RenderPass::Shadow0 + i], render_pass);
+		render_meshes(renderer.mesh_buckets, renderer.scene_partition, frame.culled_mesh_bucket[RenderPass::Shadow0 + i], render_pass);
 		render_grass(frame.grass_data, render_pass);
 	}
 
 	//Z-PREPASS	
 	bind_scene_pass_z_prepass(renderer, main_pass, frame);
 
-	render_meshes(renderer.mesh_buckets, frame.culled_mesh_bucket[RenderPass::Scene], main_pass);
+	render_meshes(renderer.mesh_buckets, renderer.scene_partition, frame.culled_mesh_bucket[RenderPass::Scene], main_pass);
 	render_grass(frame.grass_data, main_pass);
 	
 	next_subpass(main_pass); 
@@ -230,7 +231,7 @@ GPUSubmission build_command_buffers(Renderer& renderer, const FrameData& frame)
 
 	//todo paritition into lit, unlit, transparent passes
 	
-	render_meshes(renderer.mesh_buckets, frame.culled_mesh_bucket[RenderPass::Scene], main_pass);
+	render_meshes(renderer.mesh_buckets, renderer.scene_partition, frame.culled_mesh_bucket[RenderPass::Scene], main_pass);
 	render_grass(frame.grass_data, main_pass);
 	render_skybox(frame.skybox_data, main_pass);
 
@@ -249,6 +250,10 @@ void submit_frame(Renderer& renderer, GPUSubmission& submission) {
 	}
 
 	end_render_frame(submission.screen_render_pass);
+
+	if (renderer.settings.hotreload_shaders) {
+		upload_reloaded_textures();
+	}
 }
 
 /*
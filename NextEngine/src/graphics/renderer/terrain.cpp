@@ -194,60 +194,214 @@ void update_terrain_material(TerrainRenderResources& resources, Terrain& terrain
 
 	memcpy_ubo_buffer(resources.ubo, sizeof(TerrainUBO), &terrain_ubo);
 	update_descriptor_set(resources.descriptor, terrain_descriptor); 
+
+	build_terrain_quadtree(terrain);
+}
+
+//lod ranges scale with the chunk size, for the default block size of 10 the
+//mesh lod switches at 50 and 100 units
+const float TERRAIN_LOD_RANGE_IN_CHUNKS = 5.0f;
+
+//The integer part selects the subdivided plane, the fraction blends between displacement mips
+float lod_from_dist(float dist, float lod_range) {
+	float lod = log2f(glm::max(dist, 0.001f) / lod_range) + 1.0f;
+	return glm::clamp(lod, 0.0f, MAX_TERRAIN_CHUNK_LOD - 1.0f);
 }
 
-uint lod_from_dist(float dist) {
-	if (dist < 50) return 0;
-	else if (dist < 100) return 1;
-	else return 2;
+float dist_to_aabb(const AABB& aabb, glm::vec3 point) {
+	glm::vec3 vec = glm::max(glm::max(aabb.min - point, point - aabb.max), glm::vec3(0));
+	return glm::length(vec);
 }
 
 glm::vec3 position_of_chunk(glm::vec3 position, float size_of_block, uint w, uint h) {
 	return position + glm::vec3(w * size_of_block, 0, (h + 1) * size_of_block);
 }
 
+AABB aabb_of_chunk(const Terrain& terrain, uint w, uint h) {
+	glm::vec2 heights = terrain.chunk_heights[w + h * terrain.width];
+	float size = terrain.size_of_block;
+
+	AABB aabb;
+	aabb.min = glm::vec3(w * size, heights.x, h * size);
+	aabb.max = glm::vec3((w + 1) * size, heights.y, (h + 1) * size);
+	return aabb;
+}
+
+uint build_terrain_node(Terrain& terrain, uint x, uint y, uint size) {
+	if (x >= terrain.width || y >= terrain.height) return 0;
+
+	uint index = terrain.quadtree.length;
+	terrain.quadtree.append({});
+
+	TerrainQuadNode node = {};
+	node.x = x;
+	node.y = y;
+	node.size = size;
+
+	if (size == 1) {
+		node.aabb = aabb_of_chunk(terrain, x, y);
+	}
+	else {
+		uint half = size / 2;
+		uint offsets[4][2] = { {0,0}, {half,0}, {0,half}, {half,half} };
+
+		for (uint i = 0; i < 4; i++) {
+			uint child = build_terrain_node(terrain, x + offsets[i][0], y + offsets[i][1], half);
+			if (child) node.aabb.update_aabb(terrain.quadtree[child].aabb);
+			node.children[i] = child;
+		}
+	}
+
+	terrain.quadtree[index] = node;
+	return index;
+}
+
+void build_terrain_quadtree(Terrain& terrain) {
+	uint width = terrain.width * TERRAIN_RESOLUTION;
+	uint height = terrain.height * TERRAIN_RESOLUTION;
+	vector<float>& displacement = terrain.displacement_map[0];
+	bool has_displacement = displacement.length >= width * height;
+
+	terrain.quadtree.clear();
+	terrain.chunk_heights.clear();
+	terrain.chunk_heights.resize(terrain.width * terrain.height);
+
+	for (uint h = 0; h < terrain.height; h++) {
+		for (uint w = 0; w < terrain.width; w++) {
+			glm::vec2 range(FLT_MAX, -FLT_MAX);
+
+			if (has_displacement) {
+				//include a border of one texel for bilinear filtering
+				uint x0 = w * TERRAIN_RESOLUTION, x1 = glm::min((w + 1) * TERRAIN_RESOLUTION + 1, width);
+				uint y0 = h * TERRAIN_RESOLUTION, y1 = glm::min((h + 1) * TERRAIN_RESOLUTION + 1, height);
+
+				for (uint y = y0; y < y1; y++) {
+					for (uint x = x0; x < x1; x++) {
+						float sample = displacement[x + y * width];
+						range.x = glm::min(range.x, sample);
+						range.y = glm::max(range.y, sample);
+					}
+				}
+			}
+			else {
+				range = glm::vec2(0, terrain.max_height);
+			}
+
+			terrain.chunk_heights[w + h * terrain.width] = range;
+		}
+	}
+
+	uint size = 1;
+	while (size < terrain.width || size < terrain.height) size *= 2;
+
+	build_terrain_node(terrain, 0, 0, size);
+}
+
+struct TerrainSelection {
+	const Terrain* terrain;
+	glm::vec3 offset;
+	const glm::vec4* planes;
+	glm::vec3 cam_pos;
+	float lod_range;
+	u8* chunk_lod;
+	tvector<uint> visible;
+	tvector<float> visible_lod;
+};
+
+const u8 TERRAIN_LOD_UNRESOLVED = 0xff;
+
+void select_terrain_node(TerrainSelection& selection, uint node_index, bool test_frustum) {
+	const Terrain& terrain = *selection.terrain;
+	const TerrainQuadNode& node = terrain.quadtree[node_index];
+
+	AABB aabb;
+	aabb.min = node.aabb.min + selection.offset;
+	aabb.max = node.aabb.max + selection.offset;
+
+	//once a node is completely inside, none of its children need to be tested
+	if (test_frustum) {
+		CullResult cull_result = frustum_test(selection.planes, aabb);
+		if (cull_result == OUTSIDE) return;
+		test_frustum = cull_result == INTERSECT;
+	}
+
+	if (node.size == 1) {
+		uint chunk = node.x + node.y * terrain.width;
+		float lod = lod_from_dist(dist_to_aabb(aabb, selection.cam_pos), selection.lod_range);
+
+		selection.chunk_lod[chunk] = (u8)lod;
+		selection.visible.append(chunk);
+		selection.visible_lod.append(lod);
+		return;
+	}
+
+	for (uint i = 0; i < 4; i++) {
+		if (node.children[i]) select_terrain_node(selection, node.children[i], test_frustum);
+	}
+}
+
+//neighbours outside of the frustum were never visited, so their lod is derived from the leaf bounds
+uint lod_of_neighbour(TerrainSelection& selection, int w, int h) {
+	const Terrain& terrain = *selection.terrain;
+	if (w < 0 || h < 0 || w >= (int)terrain.width || h >= (int)terrain.height) return 0;
+
+	uint chunk = w + h * terrain.width;
+	if (selection.chunk_lod[chunk] == TERRAIN_LOD_UNRESOLVED) {
+		AABB aabb = aabb_of_chunk(terrain, w, h);
+		aabb.min += selection.offset;
+		aabb.max += selection.offset;
+
+		selection.chunk_lod[chunk] = (u8)lod_from_dist(dist_to_aabb(aabb, selection.cam_pos), selection.lod_range);
+	}
+
+	return selection.chunk_lod[chunk];
+}
+
 void extract_render_data_terrain(TerrainRenderData& render_data, World& world, const Viewport viewports[RenderPass::ScenePassCount], EntityQuery layermask) {
 	uint render_pass_count = 1;
 
 	//TODO THIS ASSUMES EITHER 0 or 1 TERRAINS
-	for (auto[e, self, self_trans] : world.filter<Terrain, Transform>(layermask)) { //todo heavily optimize terrain
-		for (uint w = 0; w < self.width; w++) {
-			for (uint h = 0; h < self.height; h++) {
-				//Calculate position of chunk
+	for (auto[e, self, self_trans] : world.filter<Terrain, Transform>(layermask)) {
+		uint chunk_count = self.width * self.height;
+		if (self.chunk_heights.length != chunk_count) build_terrain_quadtree(self);
+		if (self.quadtree.length == 0) continue;
+
+		for (uint pass = 0; pass < render_pass_count; pass++) {
+			TerrainSelection selection = {};
+			selection.terrain = &self;
+			selection.offset = self_trans.position;
+			selection.planes = viewports[pass].frustum_planes;
+			selection.cam_pos = viewports[pass].cam_pos;
+			selection.lod_range = TERRAIN_LOD_RANGE_IN_CHUNKS * self.size_of_block;
+			selection.chunk_lod = TEMPORARY_ARRAY(u8, chunk_count);
+			memset(selection.chunk_lod, TERRAIN_LOD_UNRESOLVED, chunk_count);
+
+			select_terrain_node(selection, 0, true);
+
+			for (uint i = 0; i < selection.visible.length; i++) {
+				uint chunk = selection.visible[i];
+				uint w = chunk % self.width;
+				uint h = chunk / self.width;
+
 				Transform t;
 				t.position = position_of_chunk(self_trans.position, self.size_of_block, w, h);
 				t.scale = glm::vec3((float)self.size_of_block);
 				t.scale.y = 1.0f;
 
-				glm::mat4 model_m = compute_model_matrix(t);
-				glm::vec2 displacement_offset = glm::vec2(1.0 / self.width * w, 1.0 / self.height * h);
+				uint lod = selection.chunk_lod[chunk];
+				uint edge_lod = lod;
+				edge_lod = max(edge_lod, lod_of_neighbour(selection, (int)w - 1, h));
+				edge_lod = max(edge_lod, lod_of_neighbour(selection, (int)w + 1, h));
+				edge_lod = max(edge_lod, lod_of_neighbour(selection, w, (int)h - 1));
+				edge_lod = max(edge_lod, lod_of_neighbour(selection, w, (int)h + 1));
 
-				//Cull and compute lod of chunk
-				AABB aabb;
-				aabb.min = glm::vec3(0, 0, -(int)self.size_of_block) + t.position;
-				aabb.max = glm::vec3(self.size_of_block, self.max_height, 0) + t.position;
+				ChunkInfo chunk_info = {};
+				chunk_info.model_m = compute_model_matrix(t);
+				chunk_info.displacement_offset = glm::vec2(1.0 / self.width * w, 1.0 / self.height * h);
+				chunk_info.lod = selection.visible_lod[i];
+				chunk_info.edge_lod = edge_lod;
 
-				for (uint pass = 0; pass < render_pass_count; pass++) {
-					if (frustum_test(viewports[pass].frustum_planes, aabb) == OUTSIDE) continue;
-
-					glm::vec3 cam_pos = viewports[pass].cam_pos;
-
-					float dist = glm::length(t.position - cam_pos);
-					uint lod = lod_from_dist(dist);
-					uint edge_lod = lod;
-					edge_lod = max(edge_lod, lod_from_dist(glm::length(cam_pos - position_of_chunk(self_trans.position, self.size_of_block, w - 1, h))));
-					edge_lod = max(edge_lod, lod_from_dist(glm::length(cam_pos - position_of_chunk(self_trans.position, self.size_of_block, w + 1, h))));
-					edge_lod = max(edge_lod, lod_from_dist(glm::length(cam_pos - position_of_chunk(self_trans.position, self.size_of_block, w, h - 1))));
-					edge_lod = max(edge_lod, lod_from_dist(glm::length(cam_pos - position_of_chunk(self_trans.position, self.size_of_block, w, h + 1))));
-
-					ChunkInfo chunk_info = {};
-					chunk_info.model_m = model_m;
-					chunk_info.displacement_offset = displacement_offset;
-					chunk_info.lod = lod;
-					chunk_info.edge_lod = edge_lod;
-
-					render_data.lod_chunks[pass][lod].append(chunk_info);
-				}
+				render_data.lod_chunks[pass][lod].append(chunk_info);
 			}
 		}
 	}
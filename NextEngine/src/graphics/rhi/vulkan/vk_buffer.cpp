@@ -244,6 +244,48 @@ void alloc_instance_layout_allocator(InstanceAllocator& m, uint frame, InstanceL
 	*offset += capacity;
 }
 
+//A released range is reused before the arena grows. Uploads below the start of the frame
+//move it down, so the ownership transfer still covers them
+u64 alloc_arena_range(vector<VertexArenaRange>& free, u64& offset, u64& start_of_frame, u64 capacity, u64 size) {
+	for (uint i = 0; i < free.length; i++) {
+		VertexArenaRange& range = free[i];
+		if (range.size < size) continue;
+
+		u64 result = range.offset;
+		range.offset += size;
+		range.size -= size;
+		if (range.size == 0) {
+			free[i] = free.last();
+			free.pop();
+		}
+
+		if (result < start_of_frame) start_of_frame = result;
+		return result;
+	}
+
+	assert(capacity >= offset + size);
+
+	u64 result = offset;
+	offset += size;
+	return result;
+}
+
+void dealloc_arena_range(vector<VertexArenaRange>& free, u64& offset, u64 range_offset, u64 size) {
+	if (size == 0) return;
+	if (range_offset + size == offset) offset = range_offset;
+	else free.append({ range_offset, size });
+}
+
+void dealloc_vertex_buffer(VertexStreaming& self, VertexBuffer& buffer) {
+	VertexArena& allocator = self.arenas[buffer.layout];
+	u64 vert_size = self.layouts[buffer.layout].binding_desc.stride;
+
+	dealloc_arena_range(allocator.free_vertices, allocator.vertex_offset, buffer.vertex_base * vert_size, buffer.vertex_capacity * vert_size);
+	dealloc_arena_range(allocator.free_indices, allocator.index_offset, buffer.index_base * sizeof(uint), buffer.length * sizeof(uint));
+
+	buffer = {};
+}
+
 //Caller is responsible for batching alloc vertex buffer, into reasonable large chunks
 //otherwise this will generate unnecessary vkCmdCopy commands,
 //buffer allocator could batch these, but that's more complicated
@@ -257,23 +299,17 @@ VertexBuffer alloc_vertex_buffer(VertexStreaming& self, VertexLayout layout, int
 
 	log("UPLOADING VERTEX BUFFER Vertex: (", vert_size, ") ", vertices_length, " ", indices_length, ", size ",  vertices_size, " ", indices_size, "\n");
 
-	assert(allocator.vertex_capacity >= allocator.vertex_offset + vertices_size);
-	assert(allocator.index_capacity >= allocator.index_offset + indices_length * sizeof(uint));
-		
 	VertexBuffer buffer;
 	buffer.layout = layout;
 	buffer.length = indices_length;
 	buffer.vertex_capacity = vertices_length;
 	buffer.instance_capacity = indices_length;
 
-	int vertex_offset = allocator.vertex_offset;
-	int index_offset  = allocator.index_offset;
+	int vertex_offset = alloc_arena_range(allocator.free_vertices, allocator.vertex_offset, allocator.vertex_offset_start_of_frame, allocator.vertex_capacity, vertices_size);
+	int index_offset  = alloc_arena_range(allocator.free_indices, allocator.index_offset, allocator.index_offset_start_of_frame, allocator.index_capacity, indices_size);
 	
 	buffer.vertex_base = vertex_offset / vert_size;
 	buffer.index_base = index_offset / index_size;	
-	
-	allocator.vertex_offset += vertices_size;
-	allocator.index_offset += indices_size;
 
 	printf("OFFSET vertex : %i, index : %i\n", vertex_offset, index_offset);
     printf("Requires: %i index, %i vertex", indices_size, vertices_size);
@@ -313,7 +349,7 @@ void transfer_vertex_ownership(VertexStreaming& self, VkCommandBuffer cmd_buffer
 	//todo urgent: this should be refactored into a loop, which has to execute per vertex buffer layout
 	//as data uploads are only continous within each vertex buffer layout chunk
 	vertex_barrier.size = vertex_buffer.vertex_offset - self.arenas->vertex_offset_start_of_frame;
-	vertex_barrier.offset = vertex_buffer.vertex_offset;
+	vertex_barrier.offset = vertex_buffer.vertex_offset_start_of_frame;
 
 	VkBufferMemoryBarrier& index_barrier = buffer_barriers[1];
 	index_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
@@ -323,7 +359,7 @@ void transfer_vertex_ownership(VertexStreaming& self, VkCommandBuffer cmd_buffer
 	index_barrier.dstQueueFamilyIndex = staging.dst_queue_family;
 	index_barrier.buffer = self.index_buffer;
 	index_barrier.size = vertex_buffer.index_offset - vertex_buffer.index_offset_start_of_frame;
-	index_barrier.offset = vertex_buffer.index_offset;
+	index_barrier.offset = vertex_buffer.index_offset_start_of_frame;
 
 	if (vertex_barrier.size == 0 && index_barrier.size == 0) {
 		return;
@@ -724,6 +760,10 @@ VertexBuffer alloc_vertex_buffer(VertexLayout vertex_layout, int vertices_length
 	return alloc_vertex_buffer(rhi.vertex_streaming, vertex_layout, vertices_length, vertices, indices_length, indices);
 }
 
+void dealloc_vertex_buffer(VertexBuffer& buffer) {
+	dealloc_vertex_buffer(rhi.vertex_streaming, buffer);
+}
+
 //in theory allocating an instance buffer does not depend on VertexLayout
 InstanceBuffer frame_alloc_instance_buffer(InstanceLayout instance_layout, uint length, void** ptr) {
 	return alloc_instance_buffer(render_thread.instance_allocator, instance_layout, length, ptr);
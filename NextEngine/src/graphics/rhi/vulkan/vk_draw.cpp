@@ -58,7 +58,7 @@ void draw_mesh(CommandBuffer& cmd_buffer, model_handle model_handle, slice<mater
 
 		bind_pipeline(cmd_buffer, pipeline_handle);
 		bind_material(cmd_buffer, mat_handle);
-		draw_mesh(cmd_buffer, mesh.buffer[lod], instance_buffer);
+		draw_mesh(cmd_buffer, mesh.buffer[min(lod, mesh.lod_count - 1)], instance_buffer);
 	}
 }
 
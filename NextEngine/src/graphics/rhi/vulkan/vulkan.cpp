@@ -230,7 +230,6 @@ void make_RHI(const VulkanDesc& desc, Window& window) {
 	VkSurfaceKHR surface = make_Device(device, desc, window);
 
 	rhi.window = &window;
-	rhi.shader_compiler = shaderc_compiler_initialize();
 
 	make_Swapchain(rhi.swapchain, device, window, surface);
 	make_SyncObjects(swapchain);
@@ -327,7 +326,9 @@ void vk_destroy() {
 
 	vkDeviceWaitIdle(device);
 
-	shaderc_compiler_release(rhi.shader_compiler);
+	for (shaderc_compiler_t compiler : rhi.shader_compilers) {
+		if (compiler) shaderc_compiler_release(compiler);
+	}
 
 	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
 	vkDestroyDescriptorPool(device, rhi.descriptor_pool, nullptr);
@@ -375,6 +376,10 @@ void acquire_swapchain_image(Swapchain& swapchain) {
 	swapchain.images_in_flight[swapchain.image_index] = swapchain.in_flight_fences[swapchain.current_frame];
 }
 
+void wait_for_frames_in_flight() {
+	vkWaitForFences(rhi.device, MAX_FRAMES_IN_FLIGHT, rhi.swapchain.in_flight_fences, VK_TRUE, UINT64_MAX);
+}
+
 void queue_for_destruction(void* data, void(*func)(void*)) {
 	rhi.queued_for_destruction[rhi.frame_index].append({data, func});
 }
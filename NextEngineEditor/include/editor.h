@@ -76,6 +76,10 @@ struct Editor {
 	Framebuffer scene_view_fbo;
 
 	int selected_id = -1;
+	vector<ID> selected_ids; //every selected entity, selected_id is the first of them
+
+	bool box_selecting = false;
+	glm::vec2 box_select_start;
 
 	bool playing_game = false;
 	bool game_fullscreen = false;
@@ -125,6 +129,7 @@ struct Editor {
 	void end_imgui(struct CommandBuffer&);
 
 	void select(int);
+	void select(slice<ID>);
 };
 
 namespace ImGui {
@@ -4,6 +4,8 @@
 #include "graphics/assets/material.h"
 #include "graphics/culling/culling.h"
 #include "core/container/slice.h"
+#include "core/container/vector.h"
+#include "core/container/tvector.h"
 #include "ecs/id.h"
 #include <limits.h>
 
@@ -16,13 +18,27 @@ struct Assets;
 struct Ray;
 
 const uint GIZMO_TAG = 1 << 0;
-const uint MAX_PICKING_NODES = 100;
-const uint MAX_PICKING_INSTANCES = 1000;
+const uint INVALID_PICKING_NODE = UINT_MAX;
 
-struct PickingScenePartition : Partition {
-	AABB aabbs[MAX_PICKING_INSTANCES];
-	ID ids[MAX_PICKING_INSTANCES];
-	uint tags[MAX_PICKING_INSTANCES];
+//Leaves hold the bounds of a single entity, or of a terrain block.
+//Internal nodes always have two children
+struct PickingNode {
+	AABB aabb; //leaves are fattened, so small transform edits only refit the ancestors
+	AABB bounds; //tight bounds of a leaf, used for the actual hit
+	uint parent = INVALID_PICKING_NODE;
+	uint child[2] = { INVALID_PICKING_NODE, INVALID_PICKING_NODE }; //child[1] links the free list for freed nodes
+	uint next_leaf = INVALID_PICKING_NODE; //next leaf of the same entity
+	ID id = 0;
+	uint tags = 0;
+
+	inline bool is_leaf() const { return child[0] == INVALID_PICKING_NODE; }
+};
+
+struct PickingScenePartition {
+	vector<PickingNode> nodes;
+	vector<uint> leaf_of_entity; //first leaf of each entity, INVALID_PICKING_NODE if it can't be picked
+	uint root = INVALID_PICKING_NODE;
+	uint free_list = INVALID_PICKING_NODE;
 };
 
 struct RayHit {
@@ -37,8 +53,15 @@ struct PickingSystem {
 
 	PickingSystem();
 	void rebuild_acceleration_structure(World& world);
+	//Refits or reinserts the leaves of a single entity, removes them if it no longer has bounds
+	void update_entity(World& world, ID id);
+	void remove_entity(ID id);
 	bool ray_cast(const Ray&, RayHit&);
 	bool ray_cast(Viewport&, glm::vec2 position, RayHit& hit);
+	//Traces the rays in packets of 4, hits must have the same length as rays
+	void ray_cast(slice<Ray> rays, RayHit* hits);
+	//Appends every entity whose bounds overlap the screen rectangle
+	void pick_rect(Viewport&, glm::vec2 a, glm::vec2 b, tvector<ID>& ids);
 	void visualize(Viewport&, glm::vec2, RenderPass& ctx);
 	int pick(Viewport&, glm::vec2);
 };
@@ -3,18 +3,19 @@
 #include "engine/core.h"
 #include <glm/vec4.hpp>
 
-const uint KRIGING_MAX_WEIGHTS = 12;
+const uint KRIGING_MAX_WEIGHTS = 512;
 
+//Dual kriging, the estimate at p is mean + sum(cov(|p - positions[i].xy|) * positions[i].w)
 struct KrigingUBO {
 	float a; // (sill - nugget)
 	float b; // (-3.0f / range)
 	int N;
-	int padding;
+	float mean;
 
-	glm::vec4 positions[KRIGING_MAX_WEIGHTS];
-	float c1[KRIGING_MAX_WEIGHTS * KRIGING_MAX_WEIGHTS];
+	glm::vec4 positions[KRIGING_MAX_WEIGHTS]; //xy position, z height, w weight
 };
 
-ENGINE_API bool compute_kriging_matrix(KrigingUBO& kriging_ubo, uint width, uint height);
-
-//void kriging_estimate_surface(int N_POINTS, glm::vec2* positions, float* heights, int width, int height, float* output);
\ No newline at end of file
+//Solves for the weights of the control points, returns false if the system is singular
+ENGINE_API bool compute_kriging_weights(KrigingUBO& kriging_ubo, uint width, uint height);
+//Evaluates the surface at the pixel centers, output is width * height floats in row major order
+ENGINE_API void cpu_estimate_terrain_surface(const KrigingUBO& kriging_ubo, uint width, uint height, float* output);
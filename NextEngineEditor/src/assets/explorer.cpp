@@ -10,6 +10,7 @@
 #include "graphics/assets/assets.h"
 #include "graphics/assets/model.h"
 #include "graphics/assets/material.h"
+#include "graphics/assets/texture_streaming.h"
 #include "graphics/rhi/draw.h"
 #include "components/transform.h"
 #include "components/camera.h"
@@ -397,7 +398,10 @@ bool load_asset_info(AssetPreviewResources& resources, AssetInfo& info, Deserial
 
 	recursively_load_asset_node(resources, info, jobs, info.toplevel);
 	
-	load_TextureBatch(jobs.textures);
+	//the materials are rebuilt as their textures become resident
+	for (TextureLoadJob& job : jobs.textures) {
+		stream_Texture(job.handle, job.path);
+	}
 
 	if (jobs.materials.length > 0) {
 		info.default_material = jobs.materials[0].handle;
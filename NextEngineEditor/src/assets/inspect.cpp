@@ -78,6 +78,10 @@ void texture_properties(TextureAsset* tex, Editor& editor) {
             case TextureFormat::UNORM: format_str = "UNORM"; break;
             case TextureFormat::SRGB: format_str = "SRGB"; break;
             case TextureFormat::HDR: format_str = "HDR"; break;
+            case TextureFormat::HALF: format_str = "HALF"; break;
+            case TextureFormat::BC1: format_str = "BC1"; break;
+            case TextureFormat::BC3: format_str = "BC3"; break;
+            case TextureFormat::BC5: format_str = "BC5"; break;
         }
         
         ImGui::Text("Format : %s", format_str);
@@ -5,6 +5,7 @@
 #include "graphics/renderer/renderer.h"
 #include "components/camera.h"
 #include "graphics/assets/assets.h"
+#include "graphics/assets/texture_streaming.h"
 #include "core/time.h"
 
 const uint ATLAS_PREVIEWS_WIDTH = 10;
@@ -204,9 +205,26 @@ void make_AssetPreviewRenderData(AssetPreviewResources& resources, Renderer& ren
 //todo although it is possible to render multiple previews in one frame
 //this would require several ubo buffers, possibly with push constants to get the right one!
 //in theory this also has a frame sychronization issue, as it's not using multiple ubo for different frames
+//A preview is only rendered once the streamed textures it uses are resident, otherwise it would capture the placeholders
+bool preview_textures_resident(AssetNode* node) {
+	if (node->type == AssetNode::Material) return material_textures_resident(node->material.handle);
+
+	if (node->type == AssetNode::Model) {
+		for (material_handle material : node->model.materials) {
+			if (!material_textures_resident(material)) return false;
+		}
+	}
+
+	return true;
+}
+
 void render_previews(AssetPreviewResources& self, AssetInfo& info) {
-	while (self.render_preview_for.length > 0) {
-		AssetNode* node = get_asset(info, self.render_preview_for.pop());
+	for (int i = self.render_preview_for.length - 1; i >= 0; i--) {
+		AssetNode* node = get_asset(info, self.render_preview_for[i]);
+		if (!preview_textures_resident(node)) continue;
+
+		self.render_preview_for[i] = self.render_preview_for.last();
+		self.render_preview_for.pop();
 
 		if (node->type == AssetNode::Material) render_preview_for(self, node->material);
 		if (node->type == AssetNode::Model) render_preview_for(self, node->model);
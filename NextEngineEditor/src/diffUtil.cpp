@@ -397,10 +397,7 @@ void apply_selection_and_move_to(Editor& editor, ActionStack& actions, EditorAct
     slice<ID> currently_selected;
 
     if (action->type == SelectionAction::Entity) {
-        if (editor.selected_id != -1) {
-            currently_selected_id = editor.selected_id;
-            currently_selected = currently_selected_id;
-        }
+        currently_selected = editor.selected_ids;
     } else {
         if (!editor.asset_tab.explorer.selected.id) {
             currently_selected_id = editor.selected_id;
@@ -417,6 +414,8 @@ void apply_selection_and_move_to(Editor& editor, ActionStack& actions, EditorAct
     
     if (action->type == SelectionAction::Entity) {
         editor.selected_id = action->ids.length == 0 ? -1 : action->ids[0];
+        editor.selected_ids.clear();
+        for (ID id : action->ids) editor.selected_ids.append(id);
     } else {
         editor.asset_tab.explorer.selected = action->ids.length == 0 ? asset_handle{0} : asset_handle{action->ids[0]};
     }
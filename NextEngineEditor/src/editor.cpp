@@ -31,6 +31,7 @@
 #include "engine/engine.h"
 #include "graphics/assets/assets.h"
 #include <imgui/imgui_internal.h>
+#include <algorithm>
 
 
 #include "generated.h"
@@ -184,15 +185,18 @@ void override_mouse_button_callback(GLFWwindow* window_ptr, int button, int acti
 }
 
 void Editor::select(int id) {
-	if (id != -1) {
-        ID uint_id = selected_id != -1 ? selected_id : 0;
-        entity_selection_action(actions, {&uint_id, selected_id != -1});
-        this->selected_id = id;
-		this->selected.broadcast(id);
-    } else {
-        entity_selection_action(actions, {nullptr, 0});
-        this->selected_id = -1;
-    }
+	ID uint_id = id;
+	select(id != -1 ? slice<ID>(&uint_id, 1) : slice<ID>());
+}
+
+void Editor::select(slice<ID> ids) {
+	entity_selection_action(actions, selected_ids);
+
+	selected_ids.clear();
+	for (ID id : ids) selected_ids.append(id);
+
+	this->selected_id = ids.length > 0 ? ids[0] : -1;
+	if (ids.length > 0) this->selected.broadcast(ids[0]);
 }
 
 /*
@@ -242,76 +246,159 @@ void recurisively_register_id(Lister& lister, EntityNode& node) {
 	}
 }
 
+//World saves store the schema of every component once, the blocks after it only hold the columns.
+//Columns of components whose layout changed since the save are migrated when they are loaded
+const uint WORLD_SAVE_MAGIC = 'N' | 'E' << 8 | 'W' << 16 | 'D' << 24;
+const uint WORLD_SAVE_VERSION = 2;
+
+void skip_n_from_buffer(DeserializerBuffer& buffer, u64 size) {
+	char skipped[1024];
+
+	while (size > 0 && !buffer.overflow) {
+		u64 length = min(size, (u64)sizeof(skipped));
+		read_n_from_buffer(buffer, skipped, length);
+		size -= length;
+	}
+}
+
+uint find_component_by_name(World& world, string_view name) {
+	for (uint i = 0; i < MAX_COMPONENTS; i++) {
+		if (world.component_type[i] && world.component_schema[i].name == name) return i;
+	}
+	return MAX_COMPONENTS;
+}
+
 bool load_world(Editor& editor, DeserializerBuffer& buffer, const char** err) {
 	World& world = get_World(editor);
 	ComponentLifetimeFunc* funcs = world.component_lifetime_funcs;
 
-	world.clear();
+	uint magic = 0;
+	uint version = 0;
+	read_uint_from_buffer(buffer, magic);
+	read_uint_from_buffer(buffer, version);
 
-	read_uint_from_buffer(buffer, world.free_ids.length);
-	read_n_from_buffer(buffer, world.free_ids.data, world.free_ids.length * sizeof(ID));
+	if (magic != WORLD_SAVE_MAGIC || version != WORLD_SAVE_VERSION) {
+		*err = "World save file was written by an incompatible version";
+		return false;
+	}
 
-	uint num_archetypes;
-	read_uint_from_buffer(buffer, num_archetypes);
+	//the current world is kept until every component of the save is known to load
+	LinearRegion region(get_temporary_allocator());
 
-	for (uint i = 0; i < num_archetypes; i++) {
-		Archetype arch;
-		ArchetypeStore store;
+	uint free_id_count = read_uint_from_buffer(buffer);
+	if (free_id_count > MAX_ENTITIES) {
+		*err = "World save file is corrupt";
+		return false;
+	}
 
-		read_u64_from_buffer(buffer, arch);
-		read_ArchetypeStore_from_buffer(buffer, store);
+	ID* free_ids = TEMPORARY_ARRAY(ID, free_id_count);
+	read_n_from_buffer(buffer, free_ids, free_id_count * sizeof(ID));
 
-		//todo find bug that causes block count to wrap
-		if (store.block_count > 1000) {
-			store.block_count = 0;
+	//Component ids of the save are mapped to the current ones by name, flags are not registered and keep their id
+	uint current_id[MAX_COMPONENTS];
+	bool trivial[MAX_COMPONENTS] = {};
+	refl::MigrationPlan plans[MAX_COMPONENTS];
+
+	for (uint i = 0; i < MAX_COMPONENTS; i++) current_id[i] = i;
+
+	uint num_components = read_uint_from_buffer(buffer);
+
+	for (uint i = 0; i < num_components; i++) {
+		uint component_id = read_uint_from_buffer(buffer);
+		char is_trivial = 0;
+		read_char_from_buffer(buffer, is_trivial);
+
+		refl::Schema schema;
+		read_Schema_from_buffer(buffer, schema);
+
+		if (buffer.overflow || component_id >= MAX_COMPONENTS) {
+			*err = "World save file is corrupt";
+			return false;
 		}
-		
-		if (store.block_count == 0) {
+
+		uint id = find_component_by_name(world, schema.name);
+		current_id[component_id] = id;
+		trivial[component_id] = is_trivial;
+
+		if (id == MAX_COMPONENTS) {
+			log("Skipping component ", schema.name.data, ", it no longer exists\n");
 			continue;
 		}
 
-		uint entities = store.entity_count_last_block;
+		refl::MigrationPlan& plan = plans[id];
+		refl::make_MigrationPlan(plan, schema, world.component_schema[id]);
+		if (is_trivial) plan.dropped.clear(); //the columns are read from the file, they own nothing
 
-		BlockHeader** next_block_chain = &store.blocks;
+		//the columns were written field by field in the old layout, which only the old build can read
+		if (!is_trivial && (!plan.identity || !funcs[id].deserialize)) {
+			log("Component ", schema.name.data, " changed and is not trivially copyable, the save cannot be migrated\n");
+			*err = "World save file has a component that changed and is not trivially copyable";
+			return false;
+		}
+	}
 
-		printf("=========\n");
-		printf("Loading archetype %i, Entities (%i), Block Header (%i)\n", arch, entities, store.block_count);
+	world.clear();
 
-		for (uint i = 0; i < store.block_count; i++) {
-			BlockHeader* block_header = world.alloc_block();
-			*next_block_chain = block_header;
+	world.free_ids.length = free_id_count;
+	memcpy(world.free_ids.data, free_ids, free_id_count * sizeof(ID));
 
-			u8* data = (u8*)(block_header + 1);
+	vector<u8> columns;
+
+	uint num_archetypes = read_uint_from_buffer(buffer);
+
+	for (uint i = 0; i < num_archetypes; i++) {
+		Archetype saved_arch = 0;
+		read_u64_from_buffer(buffer, saved_arch);
+		uint block_count = read_uint_from_buffer(buffer);
+
+		Archetype arch = 0;
+		for (uint component_id = 0; component_id < MAX_COMPONENTS; component_id++) {
+			if (has_component(saved_arch, component_id) && current_id[component_id] < MAX_COMPONENTS) arch |= 1ull << current_id[component_id];
+		}
+
+		ArchetypeStore& store = world.find_archetype(arch);
+
+		for (uint block = 0; block < block_count; block++) {
+			uint entities = read_uint_from_buffer(buffer);
+			uint offsets[MAX_COMPONENTS] = {};
+			u64 offset = 0;
 
 			for (uint component_id = 0; component_id < MAX_COMPONENTS; component_id++) {
-				if (has_component(arch, component_id)) {
-					refl::Type* type = world.component_type[component_id];
-					printf("Component name %s\n", type ? type->name : "");
-					u8* base_component = data + store.offsets[component_id];
-					uint size = world.component_size[component_id];
+				if (!has_component(saved_arch, component_id)) continue;
 
-					if (auto constructor = funcs[component_id].constructor) constructor(base_component, entities); 
+				u64 size = 0;
+				read_u64_from_buffer(buffer, size);
 
-					if (auto deserialize_non_trivial = funcs[component_id].deserialize) deserialize_non_trivial(buffer, base_component, entities);
-					else read_n_from_buffer(buffer, base_component, world.component_size[component_id] * entities);
+				uint id = current_id[component_id];
 
-					for (uint i = 0; i < entities; i++) {
-						ID id = ((Entity*)(data + sizeof(Entity) * i))->id;
-						world.id_to_ptr[component_id][id] = base_component + size * i;
-					}
+				if (id == MAX_COMPONENTS || buffer.overflow) {
+					skip_n_from_buffer(buffer, size);
+					continue;
+				}
+
+				offset = (offset + 15) & ~15ull;
+				if (columns.length < offset + size) columns.resize(offset + size);
+
+				u8* column = columns.data + offset;
+				offsets[id] = offset;
+				offset += size;
+
+				if (trivial[component_id]) {
+					read_n_from_buffer(buffer, column, size);
+				}
+				else {
+					if (auto constructor = funcs[id].constructor) constructor(column, entities);
+					funcs[id].deserialize(buffer, column, entities);
 				}
 			}
 
-			for (uint i = 0; i < entities; i++) {
-				ID id = ((Entity*)(data + sizeof(Entity) * i))->id;
-				world.id_to_arch[id] = arch;
+			if (buffer.overflow) {
+				*err = "World save file is truncated";
+				return false;
 			}
 
-			next_block_chain = &block_header->next;
-			entities = store.max_per_block;
+			world.append_migrated(store, arch, columns.data, offsets, plans, entities);
 		}
-
-		world.arches.set(arch, store);
 	}
 
 	return true;
@@ -335,32 +422,32 @@ bool load_scene_partition(Renderer& renderer, ScenePartition& partition, Deseria
 	return true;
 }
 
-bool load_picking_scene_partition(PickingScenePartition& partition, DeserializerBuffer& buffer, const char** err) {
-	read_n_from_buffer(buffer, &partition, sizeof(PickingScenePartition));
-	return true;
-}
-
 void default_scene(Editor& editor);
 
 bool load_scene(Editor& editor, const char** err) {
 	World& world = get_World(editor);
 	Renderer& renderer = editor.renderer;
 
-	string_buffer contents;
-	if (!io_readf(scene_save_path, &contents)) {
+	DeserializerBuffer buffer;
+	DeserializerSource source;
+	if (!open_file_source(buffer, source, tasset_path(scene_save_path).c_str())) {
 		*err = "Could not read world save path"; 
 		return false;
 	}
 
-	DeserializerBuffer buffer = {};
-	buffer.length = contents.length;
-	buffer.data = contents.data;
+	bool loaded = load_world(editor, buffer, err)
+		&& load_scene_hierarchy(editor.lister, buffer, err)
+		&& load_asset_info(editor.asset_tab.preview_resources, editor.asset_info, buffer, err);
+	//&& load_scene_partition(editor.renderer.scene_partition, buffer, err)
 
-	if (!load_world(editor, buffer, err)) return false;
-	if (!load_scene_hierarchy(editor.lister, buffer, err)) return false;
-	if (!load_asset_info(editor.asset_tab.preview_resources, editor.asset_info, buffer, err)) return false;
-	//if (!load_scene_partition(editor.renderer.scene_partition, buffer, err)) return false;
-	if (!load_picking_scene_partition(editor.picking.partition, buffer, err)) return false;
+	bool truncated = buffer.overflow;
+	close_file_source(buffer);
+
+	if (!loaded) return false;
+	if (truncated) {
+		*err = "World save file is truncated";
+		return false;
+	}
 
     if (auto has_terrain = world.first<Terrain>(); has_terrain) {
         auto [_,terrain] = *has_terrain;
@@ -373,6 +460,7 @@ bool load_scene(Editor& editor, const char** err) {
     }
 	
 	update_acceleration_structure(renderer.scene_partition, renderer.mesh_buckets, world);
+	editor.picking.rebuild_acceleration_structure(world);
 
     printf("Loaded sucessfully!");
 	//submit_framegraph();
@@ -393,16 +481,38 @@ bool save_world(Editor& editor, SerializerBuffer& buffer, const char** err) {
 	World& world = get_World(editor);
 	ComponentLifetimeFunc* funcs = world.component_lifetime_funcs;
 
+	write_uint_to_buffer(buffer, WORLD_SAVE_MAGIC);
+	write_uint_to_buffer(buffer, WORLD_SAVE_VERSION);
+
 	write_uint_to_buffer(buffer, world.free_ids.length);
 	write_n_to_buffer(buffer, world.free_ids.data, world.free_ids.length * sizeof(ID));
 
+	uint num_components = 0;
+	for (uint i = 0; i < MAX_COMPONENTS; i++) {
+		if (world.component_type[i]) num_components++;
+	}
+
+	write_uint_to_buffer(buffer, num_components);
+
+	for (uint i = 0; i < MAX_COMPONENTS; i++) {
+		if (!world.component_type[i]) continue;
+
+		write_uint_to_buffer(buffer, i);
+		write_char_to_buffer(buffer, funcs[i].serialize == nullptr);
+		write_Schema_to_buffer(buffer, world.component_schema[i]);
+	}
+
 	uint num_archetypes = 0;
 	for (int i = 0; i < ARCHETYPE_HASH; i++) {
-		if (world.arches.is_full(i) && world.arches.values[i].block_count > 0) num_archetypes++;
+		if (world.arches.is_full(i) && world.arches.values[i].blocks) num_archetypes++;
 	}
 
 	write_uint_to_buffer(buffer, num_archetypes);
 
+	//Serialized columns are staged to prefix them with their size, so a loader can skip them
+	SerializerBuffer column;
+	column.allocator = &default_allocator;
+
 	//SAVE ECS
 	for (int i = 0; i < ARCHETYPE_HASH; i++) {
 		if (!world.arches.is_full(i)) continue;
@@ -410,25 +520,39 @@ bool save_world(Editor& editor, SerializerBuffer& buffer, const char** err) {
 		Archetype arch = world.arches.keys[i];
 		ArchetypeStore& store = world.arches.values[i];
 
-		if (store.block_count == 0) continue;
+		if (!store.blocks) continue;
 
 		printf("Saving archetype %i\n", arch);
 
+		uint block_count = 0;
+		for (BlockHeader* block_header = store.blocks; block_header; block_header = block_header->next) block_count++;
+
 		write_u64_to_buffer(buffer, arch);
-		write_ArchetypeStore_to_buffer(buffer, store);
+		write_uint_to_buffer(buffer, block_count);
 
 		uint entities = store.entity_count_last_block;
 		BlockHeader* block_header = store.blocks;
 		
 		while (block_header) {
 			u8* data = (u8*)(block_header + 1);
+			write_uint_to_buffer(buffer, entities);
 
 			for (uint i = 0; i < MAX_COMPONENTS; i++) {
-				if (arch & 1ul << i) {
+				if (arch & 1ull << i) {
 					u8* base_component = data + store.offsets[i];
 
-					if (auto serialize_non_trivial = funcs[i].serialize) serialize_non_trivial(buffer, base_component, entities);
-					else write_n_to_buffer(buffer, base_component, world.component_size[i] * entities);
+					if (auto serialize_non_trivial = funcs[i].serialize) {
+						column.index = 0;
+						serialize_non_trivial(column, base_component, entities);
+
+						write_u64_to_buffer(buffer, column.index);
+						write_n_to_buffer(buffer, column.data, column.index);
+					}
+					else {
+						u64 size = world.component_size[i] * entities;
+						write_u64_to_buffer(buffer, size);
+						write_n_to_buffer(buffer, base_component, size);
+					}
 				}
 			}
 
@@ -437,6 +561,8 @@ bool save_world(Editor& editor, SerializerBuffer& buffer, const char** err) {
 		}
 	}
 
+	default_allocator.deallocate(column.data);
+
 	return true;
 }
 
@@ -450,28 +576,26 @@ bool save_scene_paritition(ScenePartition& partition, SerializerBuffer& buffer,
 	return true;
 }
 
-bool save_picking_scene_partition(PickingScenePartition& partition, SerializerBuffer& buffer, const char** err) {
-	write_n_to_buffer(buffer, &partition, sizeof(PickingScenePartition));
-	return true;
-}
-
 bool save_scene(Editor& editor, const char** err) {
-	SerializerBuffer buffer = {};
-	buffer.capacity = mb(10);
-	buffer.data = TEMPORARY_ARRAY(char, buffer.capacity);
+	//streamed to the file in chunks, so the size of the scene is not limited by a preallocated buffer
+	SerializerBuffer buffer;
+	SerializerSink sink;
+	if (!open_file_sink(buffer, sink, tasset_path(scene_save_path).c_str(), true)) {
+		*err = "Could not write world to save file!";
+		return false;
+	}
 
-	if (!save_world(editor, buffer, err)) return false;
-	if (!save_scene_hierarchy(editor.lister, buffer, err)) return false;
-	if (!save_asset_info(editor.asset_tab.preview_resources, editor.asset_info, buffer, err)) return false;
-	//if (!save_scene_paritition(editor.renderer.scene_partition, buffer, err)) return false;
-	if (!save_picking_scene_partition(editor.picking.partition, buffer, err)) return false;
+	bool saved = save_world(editor, buffer, err)
+		&& save_scene_hierarchy(editor.lister, buffer, err)
+		&& save_asset_info(editor.asset_tab.preview_resources, editor.asset_info, buffer, err);
+	//&& save_scene_paritition(editor.renderer.scene_partition, buffer, err)
 
-	if (!io_writef(scene_save_path, { buffer.data, buffer.index })) {
+	if (!close_file_sink(buffer) && saved) {
 		*err = "Could not write world to save file!";
 		return false;
 	}
 
-	return true;
+	return saved;
 }
 
 void on_save(Editor& editor) {
@@ -829,9 +953,8 @@ void render_frame(Editor& editor, World& world) {
 		//bind_descriptor(scene_pass.cmd_buffer, 1, editor.renderer.lighting_system.pbr_descriptor);
 
 		render_special_gizmos(editor.gizmo_resources, gizmo_render_data, scene_pass);
-        if (editor.selected_id != -1) {
-            ID selected_id = editor.selected_id;
-            render_object_selected_outline(editor.outline_selected, world, selected_id, scene_pass);
+        if (editor.selected_ids.length > 0) {
+            render_object_selected_outline(editor.outline_selected, world, editor.selected_ids, scene_pass);
         }
         if (editor.visibility & SHOW_PHYSICS) render_colliders(editor.physics_resources, scene_pass.cmd_buffer, world, mask);
         render_overlay(editor, scene_pass);
@@ -1002,6 +1125,7 @@ void render_Viewport(Editor& editor, EditorViewport& editor_viewport) {
 
 		if (!editor.playing_game) {
 			editor.gizmo.render(world, editor, editor.editor_viewport.viewport, input);
+			render_box_selection(editor);
 		}
 	}
 	
@@ -1144,10 +1268,10 @@ Editor::~Editor() {
 void delete_object(Editor& editor) {
 	World& world = get_World(editor);
 
-	if (editor.selected_id >= 0) {
-		entity_destroy_action(editor.actions, editor.selected_id);
-		editor.selected_id = -1;
-	}
+	for (ID id : editor.selected_ids) entity_destroy_action(editor.actions, id);
+
+	editor.selected_ids.clear();
+	editor.selected_id = -1;
 }
 
 void mouse_click_select(Editor& editor) {
@@ -1158,6 +1282,70 @@ void mouse_click_select(Editor& editor) {
 	editor.select(selected);
 }
 
+const float BOX_SELECT_MIN_DRAG = 4.0f; //pixels, shorter drags are clicks
+const uint BOX_SELECT_RAY_SPACING = 4; //pixels between the rays of a visible only box selection
+
+//Selects what was hit by a grid of rays over the rectangle, so entities hidden behind others are skipped
+void box_select_visible(Editor& editor, glm::vec2 a, glm::vec2 b, tvector<ID>& ids) {
+	Viewport& viewport = editor.editor_viewport.viewport;
+	glm::vec2 min = glm::min(a, b);
+	glm::vec2 max = glm::max(a, b);
+
+	uint columns = (uint)(max.x - min.x) / BOX_SELECT_RAY_SPACING + 1;
+	uint rows = (uint)(max.y - min.y) / BOX_SELECT_RAY_SPACING + 1;
+
+	tvector<Ray> rays;
+	rays.reserve(columns * rows);
+
+	for (uint y = 0; y < rows; y++) {
+		for (uint x = 0; x < columns; x++) {
+			glm::vec2 position = min + glm::vec2(x, y) * (float)BOX_SELECT_RAY_SPACING;
+			rays.append(ray_from_mouse(viewport, glm::min(position, max)));
+		}
+	}
+
+	RayHit* hits = TEMPORARY_ARRAY(RayHit, rays.length);
+	editor.picking.ray_cast(rays, hits);
+
+	for (uint i = 0; i < rays.length; i++) {
+		if (hits[i].t < FLT_MAX) ids.append(hits[i].id);
+	}
+
+	std::sort(ids.begin(), ids.end());
+	ids.length = std::unique(ids.begin(), ids.end()) - ids.begin();
+}
+
+//A drag with the left mouse selects every entity in the rectangle, or with alt held only the visible ones
+void mouse_box_select(Editor& editor) {
+	EditorViewport& viewport = editor.editor_viewport;
+	Input& input = viewport.input;
+
+	if (input.mouse_button_down(MouseButton::Left)) return;
+	editor.box_selecting = false;
+
+	glm::vec2 a = editor.box_select_start;
+	glm::vec2 b = input.mouse_position;
+	if (glm::length(b - a) < BOX_SELECT_MIN_DRAG) return;
+
+	LinearRegion region(get_temporary_allocator());
+	tvector<ID> ids;
+
+	if (input.key_down(Key::Left_Alt)) box_select_visible(editor, a, b, ids);
+	else editor.picking.pick_rect(viewport.viewport, a, b, ids);
+
+	editor.select(ids);
+}
+
+void render_box_selection(Editor& editor) {
+	if (!editor.box_selecting) return;
+
+	Input& input = editor.editor_viewport.input;
+	glm::vec2 a = input.region_min + editor.box_select_start;
+	glm::vec2 b = input.region_min + input.mouse_position;
+
+	ImGui::GetWindowDrawList()->AddRect(ImVec2(a.x, a.y), ImVec2(b.x, b.y), IM_COL32(255, 255, 255, 200));
+}
+
 void respond_to_shortcut(Editor& editor) {
 	Input& input = editor.editor_viewport.input;
 	World& world = get_World(editor);
@@ -1174,7 +1362,12 @@ void respond_to_shortcut(Editor& editor) {
 	if (editor.game_fullscreen && editor.playing_game) return;
 
 	if (input.key_pressed(Key::X)) delete_object(editor);
-	if (input.mouse_button_pressed(MouseButton::Left) && !ImGuizmo::IsOver()) mouse_click_select(editor);
+	if (input.mouse_button_pressed(MouseButton::Left) && !ImGuizmo::IsOver()) {
+		mouse_click_select(editor);
+		editor.box_selecting = true;
+		editor.box_select_start = input.mouse_position;
+	}
+	else if (editor.box_selecting) mouse_box_select(editor);
 	if (input.key_mod_pressed(Key::Z)) undo_action(editor.actions);
 	if (input.key_mod_pressed(Key::Y)) redo_action(editor.actions);
 	if (input.key_mod_pressed(Key::S)) on_save(editor);
@@ -1204,11 +1397,13 @@ void respond_to_framediffs(Editor& editor) {
             
 			if (has_component(arch, type_id<Transform>()) || has_component(arch, type_id<LocalTransform>())) {
 				rebuild_acceleration = true;
+				editor.picking.update_entity(world, id);
 			}
 
 			if (has_component(arch, type_id<Terrain>())) {
 				Terrain& terrain = *get_component_ptr<Terrain>(diff->element);
 				update_terrain_material(editor.renderer.terrain_render_resources, terrain);
+				editor.picking.update_entity(world, id);
 			}
 
 			if (type->name == "Materials") {
@@ -1236,6 +1431,7 @@ void respond_to_framediffs(Editor& editor) {
 		case EditorActionHeader::Create_Entity: {
 			EntityCopy* copy = (EntityCopy*)header.ptr;
 			rebuild_acceleration = true;
+			editor.picking.update_entity(world, copy->id); //also handles undo, which destroys it again
 
 			//it shouldn't be necessary to check both from and to, since when creating a framediff the header could be set accordingly
 			if (copy->from & terrain_control_point || copy->to & terrain_control_point) update_terrain = true;
@@ -1246,6 +1442,7 @@ void respond_to_framediffs(Editor& editor) {
 		case EditorActionHeader::Destroy_Entity: {
 			EntityCopy* copy = (EntityCopy*)header.ptr;
 			rebuild_acceleration = true;
+			editor.picking.update_entity(world, copy->id);
 
 			//it shouldn't be necessary to check both from and to, since when creating a framediff the header could be set accordingly
 			if (copy->from & terrain_control_point || copy->to & terrain_control_point) update_terrain = true;
@@ -1267,11 +1464,8 @@ void respond_to_framediffs(Editor& editor) {
 		bool is_static = true;
 
 		renderer.scene_partition.node_count = 0;
-		editor.picking.partition.node_count = 0;
 		renderer.scene_partition.count = 0;
-		editor.picking.partition.count = 0;
 
-		editor.picking.rebuild_acceleration_structure(editor.world);
 		build_acceleration_structure(renderer.scene_partition, renderer.mesh_buckets, editor.world);
 	}
 
@@ -2,6 +2,8 @@
 #include "grass.h"
 #include "components/terrain.h"
 #include "graphics/renderer/grass.h"
+#include "graphics/assets/assets.h"
+#include "graphics/assets/model.h"
 #include "core/event.h"
 
 void place_Grass(World& world, ID id) {
@@ -13,8 +15,7 @@ void place_Grass(World& world, ID id) {
 	auto [transform, grass] = *world.get_by_id<Transform, Grass>(id);
 
 	float step = 1.0f / grass.density;
-	grass.positions.clear();
-	grass.model_m.clear();
+	clear_grass_instances(grass);
 
 	//todo fade out edges
 	for (float a = -.5f * grass.width; a < .5f * grass.width; a += step) {
@@ -22,23 +23,23 @@ void place_Grass(World& world, ID id) {
 			float x = step * ((float)rand() / RAND_MAX - 0.5);
 			float y = step * ((float)rand() / RAND_MAX - 0.5);
 
-			Transform trans = {
-				glm::vec3(a + x, 0, b + y),
-				glm::angleAxis(glm::radians(grass.random_rotation * (rand() % 360)), glm::vec3(0, 1.0f,0)),
-				glm::vec3(1)
-			};
-
-			trans.position += transform.position;
-			trans.position.y = sample_terrain_height(terrain, terrain_transform, glm::vec2(trans.position.x, trans.position.z));
-			
-			if (trans.position.y > grass.max_height) continue;
+			glm::vec3 position = glm::vec3(a + x, 0, b + y) + transform.position;
+			position.y = sample_terrain_height(terrain, terrain_transform, glm::vec2(position.x, position.z));
 			
-			grass.positions.append(trans.position);
-			grass.model_m.append(compute_model_matrix(trans));
+			if (position.y > grass.max_height) continue;
+
+			float rotation = glm::radians(grass.random_rotation * (rand() % 360));
+			add_grass_instance(grass, position, rotation, 1.0f);
 		}
 	}
 
-	printf("Placed %i instances\n", grass.positions.length);
+	Model* model = get_Model(grass.placement_model);
+	if (model) {
+		build_grass_cells(grass, model->aabb);
+		grass.cells_built_for = grass.placement_model;
+	}
+
+	printf("Placed %i instances\n", grass.position_x.length);
 
 	//ComponentEdit edit{ EDIT_GRASS_PLACEMENT };
 	//edit.id = world.id_of(grass);
@@ -15,257 +15,601 @@
 #include "components/terrain.h"
 #include "graphics/renderer/renderer.h"
 #include "core/container/tvector.h"
-#include "graphics/culling/build_bvh.h"
 #include "core/profiler.h"
 #include "core/job_system/job.h"
 #include "graphics/rhi/primitives.h"
 #include "core/math/intersection.h"
 
-#define MAX_ENTITIES_PER_NODE 10
-#define MAX_PICKING_DEPTH 6
-
-struct SubdivideBVHJob {
-	PickingScenePartition* scene_partition;
-	AABB node_aabb;
-	uint depth;
-	uint mesh_count;
-	AABB* aabbs;
-	ID* ids;
-	uint* tags;
-	uint child_idx;
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define PICKING_SSE
+#include <xmmintrin.h>
+#endif
+
+#define PICKING_PARALLEL_BUILD_THRESHOLD 1024
+
+const float PICKING_FAT_MARGIN = 0.1f;
+
+struct PickingBounds {
+	AABB aabb;
+	ID id;
+	uint tags;
 };
 
-void subdivide_BVH(SubdivideBVHJob& job) {
-	PickingScenePartition& scene_partition = *job.scene_partition;
-	
-	LinearAllocator& temporary = get_thread_local_temporary_allocator();
-    //LinearRegion region(temporary);
-	//printf("=== Watermark(%i) === %i\n", job.depth, region.watermark);
-        
-	BranchNodeInfo info = alloc_branch_node(scene_partition, job.node_aabb);
+inline float surface_area(const AABB& aabb) {
+	glm::vec3 d = aabb.size();
+	return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
 
-	tvector<AABB> subdivided_aabbs[2];
-	tvector<ID> subdivided_ids[2];
-	tvector<uint> subdivided_tags[2];
+inline AABB merge_aabb(AABB a, const AABB& b) {
+	a.update_aabb(b);
+	return a;
+}
 
-	for (uint i = 0; i < 2; i++) {
-		subdivided_aabbs[i].allocator = &temporary;
-		subdivided_ids[i].allocator = &temporary;
-		subdivided_tags[i].allocator = &temporary;
-	}
-        
-    int* split_idx = alloc_t<int>(temporary, job.mesh_count);
-    uint offset = split_aabbs(scene_partition, info, {job.aabbs, job.mesh_count}, split_idx);
-        
-	for (uint i = 0; i < job.mesh_count; i++) {
-        int split_index = split_idx[i];
-        if (split_index == -1) {
-			scene_partition.aabbs[offset] = job.aabbs[i];
-			scene_partition.ids[offset] = job.ids[i];
-			scene_partition.tags[offset] = job.tags[i];
-            offset++;
-		}
-		else {
-			subdivided_aabbs[split_index].append(job.aabbs[i]);
-			subdivided_ids[split_index].append(job.ids[i]);
-			subdivided_tags[split_index].append(job.tags[i]);
+AABB fatten_aabb(const AABB& aabb) {
+	glm::vec3 margin = aabb.size() * PICKING_FAT_MARGIN + glm::vec3(0.05f);
+
+	AABB result;
+	result.min = aabb.min - margin;
+	result.max = aabb.max + margin;
+	return result;
+}
+
+void add_model_bounds(tvector<PickingBounds>& bounds, ID id, Transform& trans, ModelRenderer& model_renderer) {
+	Model* model = get_Model(model_renderer.model_id);
+	if (model == NULL) return;
+
+	bounds.append({ model->aabb.apply(compute_model_matrix(trans)), id, 0 });
+}
+
+void add_gizmo_bounds(tvector<PickingBounds>& bounds, ID id, Transform& trans) {
+	AABB aabb;
+	aabb.min = trans.position + glm::vec3(-0.5, -0.5, -0.5);
+	aabb.max = trans.position + glm::vec3(0.5, 0.5, 0.5);
+
+	bounds.append({ aabb, id, GIZMO_TAG });
+}
+
+void add_terrain_bounds(tvector<PickingBounds>& bounds, ID id, Transform& trans, Terrain& terrain) {
+	uint width = terrain.width;
+	uint height = terrain.height;
+
+	AABB terrain_aabb;
+	terrain_aabb.min = trans.position;
+	terrain_aabb.max = trans.position + glm::vec3(width * terrain.size_of_block, terrain.max_height, height * terrain.size_of_block);
+
+	float* displacement_map = terrain.displacement_map[1].data;
+
+	uint width_quads = width * 32;
+
+	for (uint block_y = 0; block_y < height; block_y++) {
+		for (uint block_x = 0; block_x < width; block_x++) {
+			float heighest = displacement_map ? FLT_MAX : terrain.max_height; //todo add support for ray traced heightmap
+
+			uint offset_y = (block_y * 32) / 4;
+			uint offset_x = (block_x * 32) / 4;
+
+			for (uint y1 = offset_y; displacement_map && y1 < offset_y + 8; y1++) {
+				uint offset = y1 * width_quads;
+
+				for (uint x1 = offset_x; x1 < offset_x + 8; x1++) {
+					heighest = fminf(heighest, displacement_map[x1 + offset]);
+				}
+			}
+
+			AABB aabb;
+			aabb.min = terrain_aabb.min + glm::vec3(block_x * terrain.size_of_block, 0, block_y * terrain.size_of_block);
+			aabb.max = aabb.min + glm::vec3(terrain.size_of_block, heighest, terrain.size_of_block);
+
+			bounds.append({ aabb, id, 0 });
 		}
 	}
+}
 
-	JobDesc desc[2];
-    SubdivideBVHJob jobs[2];
+void gather_entity_bounds(World& world, ID id, tvector<PickingBounds>& bounds) {
+	if (auto has = world.get_by_id<Transform, ModelRenderer>(id)) {
+		auto [trans, model_renderer] = *has;
+		add_model_bounds(bounds, id, trans, model_renderer);
+	}
 
-	uint child_count = 0;
-	uint job_count = 0;
+	if (auto has = world.get_by_id<Transform, TerrainControlPoint>(id)) {
+		auto [trans, control] = *has;
+		add_gizmo_bounds(bounds, id, trans);
+	}
 
-	for (int i = 0; i < 2; i++) {
-		if (subdivided_aabbs[i].length == 0) continue;
-		
-		if (subdivided_aabbs[i].length <= MAX_ENTITIES_PER_NODE || job.depth + 1 >= MAX_PICKING_DEPTH) {
-			Node& node = alloc_leaf_node(scene_partition, info.child_aabbs[i], MAX_PICKING_INSTANCES, subdivided_aabbs[i].length);
+	if (auto has = world.get_by_id<Transform, TerrainSplat>(id)) {
+		auto [trans, splat] = *has;
+		add_gizmo_bounds(bounds, id, trans);
+	}
 
-			copy_into_node(node, scene_partition.ids, subdivided_ids[i].data);
-			copy_into_node(node, scene_partition.aabbs, subdivided_aabbs[i].data);
+	if (auto has = world.get_by_id<Transform, Terrain>(id)) {
+		auto [trans, terrain] = *has;
+		add_terrain_bounds(bounds, id, trans, terrain);
+	}
+}
 
-			jobs[child_count].child_idx = &node - scene_partition.nodes;
-			jobs[child_count].node_aabb = info.child_aabbs[i];
-		}
-		else {
-			jobs[child_count].scene_partition = job.scene_partition;
-			jobs[child_count].node_aabb = info.child_aabbs[i];
-			jobs[child_count].depth = job.depth + 1;
-			jobs[child_count].mesh_count = subdivided_aabbs[i].length;
-			jobs[child_count].aabbs = subdivided_aabbs[i].data;
-			jobs[child_count].ids = subdivided_ids[i].data;
-			jobs[child_count].tags = subdivided_tags[i].data;
-
-			desc[job_count] = JobDesc{ subdivide_BVH, jobs + child_count };
-			job_count++;
+uint& first_leaf(PickingScenePartition& partition, ID id) {
+	while (partition.leaf_of_entity.length <= id) partition.leaf_of_entity.append(INVALID_PICKING_NODE);
+	return partition.leaf_of_entity[id];
+}
+
+uint alloc_node(PickingScenePartition& partition) {
+	if (partition.free_list != INVALID_PICKING_NODE) {
+		uint index = partition.free_list;
+		partition.free_list = partition.nodes[index].child[1];
+		partition.nodes[index] = PickingNode();
+		return index;
+	}
+
+	partition.nodes.append(PickingNode());
+	return partition.nodes.length - 1;
+}
+
+void free_node(PickingScenePartition& partition, uint index) {
+	partition.nodes[index] = PickingNode();
+	partition.nodes[index].child[1] = partition.free_list;
+	partition.free_list = index;
+}
+
+void refit_ancestors(PickingScenePartition& partition, uint index) {
+	while (index != INVALID_PICKING_NODE) {
+		PickingNode& node = partition.nodes[index];
+		node.aabb = merge_aabb(partition.nodes[node.child[0]].aabb, partition.nodes[node.child[1]].aabb);
+		index = node.parent;
+	}
+}
+
+//Descends towards the sibling which increases the total surface area the least
+void insert_leaf(PickingScenePartition& partition, uint leaf) {
+	if (partition.root == INVALID_PICKING_NODE) {
+		partition.root = leaf;
+		partition.nodes[leaf].parent = INVALID_PICKING_NODE;
+		return;
+	}
+
+	AABB leaf_aabb = partition.nodes[leaf].aabb;
+	uint index = partition.root;
+
+	while (!partition.nodes[index].is_leaf()) {
+		PickingNode& node = partition.nodes[index];
+
+		float combined_area = surface_area(merge_aabb(node.aabb, leaf_aabb));
+		float cost = 2.0f * combined_area;
+		float inheritance_cost = 2.0f * (combined_area - surface_area(node.aabb));
+
+		float child_cost[2];
+		for (uint i = 0; i < 2; i++) {
+			PickingNode& child = partition.nodes[node.child[i]];
+			float area = surface_area(merge_aabb(child.aabb, leaf_aabb));
+			if (!child.is_leaf()) area -= surface_area(child.aabb);
+			child_cost[i] = area + inheritance_cost;
 		}
 
-		child_count++;
+		if (cost < child_cost[0] && cost < child_cost[1]) break;
+		index = child_cost[0] < child_cost[1] ? node.child[0] : node.child[1];
+	}
+
+	uint sibling = index;
+	uint old_parent = partition.nodes[sibling].parent;
+	uint new_parent = alloc_node(partition);
+
+	PickingNode& parent = partition.nodes[new_parent];
+	parent.parent = old_parent;
+	parent.child[0] = sibling;
+	parent.child[1] = leaf;
+	parent.aabb = merge_aabb(partition.nodes[sibling].aabb, leaf_aabb);
+
+	partition.nodes[sibling].parent = new_parent;
+	partition.nodes[leaf].parent = new_parent;
+
+	if (old_parent == INVALID_PICKING_NODE) {
+		partition.root = new_parent;
+	}
+	else {
+		PickingNode& grand_parent = partition.nodes[old_parent];
+		if (grand_parent.child[0] == sibling) grand_parent.child[0] = new_parent;
+		else grand_parent.child[1] = new_parent;
+
+		refit_ancestors(partition, old_parent);
+	}
+}
+
+void remove_leaf(PickingScenePartition& partition, uint leaf) {
+	if (leaf == partition.root) {
+		partition.root = INVALID_PICKING_NODE;
+		return;
+	}
+
+	uint parent = partition.nodes[leaf].parent;
+	uint grand_parent = partition.nodes[parent].parent;
+	uint sibling = partition.nodes[parent].child[0] == leaf ? partition.nodes[parent].child[1] : partition.nodes[parent].child[0];
+
+	partition.nodes[sibling].parent = grand_parent;
+
+	if (grand_parent == INVALID_PICKING_NODE) {
+		partition.root = sibling;
+	}
+	else {
+		PickingNode& node = partition.nodes[grand_parent];
+		if (node.child[0] == parent) node.child[0] = sibling;
+		else node.child[1] = sibling;
+
+		refit_ancestors(partition, grand_parent);
 	}
 
-	wait_for_jobs(PRIORITY_HIGH, { desc, job_count });
+	free_node(partition, parent);
+	partition.nodes[leaf].parent = INVALID_PICKING_NODE;
+}
+
+struct BuildPickingJob {
+	PickingScenePartition* partition;
+	PickingBounds* bounds;
+	uint count;
+	uint node;
+	uint parent;
+};
+
+//A subtree over count leaves uses exactly 2 * count - 1 nodes,
+//so every job knows where its children are stored without synchronization
+void build_picking_subtree(BuildPickingJob& job) {
+	PickingNode& node = job.partition->nodes[job.node];
+	node = PickingNode();
+	node.parent = job.parent;
+
+	if (job.count == 1) {
+		node.bounds = job.bounds[0].aabb;
+		node.aabb = fatten_aabb(node.bounds);
+		node.id = job.bounds[0].id;
+		node.tags = job.bounds[0].tags;
+		return;
+	}
+
+	AABB centroids;
+	for (uint i = 0; i < job.count; i++) centroids.update(job.bounds[i].aabb.centroid());
 
-	for (int i = 0; i < child_count; i++) {
-		uint child_idx = jobs[i].child_idx;
-		info.node.child[i] = child_idx;
-		info.node.aabb.update_aabb(scene_partition.nodes[child_idx].aabb);
+	glm::vec3 extent = centroids.size();
+	int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+	uint mid = job.count / 2;
+
+	std::nth_element(job.bounds, job.bounds + mid, job.bounds + job.count, [axis](const PickingBounds& a, const PickingBounds& b) {
+		return a.aabb.centroid()[axis] < b.aabb.centroid()[axis];
+	});
+
+	BuildPickingJob children[2] = {
+		{ job.partition, job.bounds, mid, job.node + 1, job.node },
+		{ job.partition, job.bounds + mid, job.count - mid, job.node + 2 * mid, job.node },
+	};
+
+	if (job.count >= PICKING_PARALLEL_BUILD_THRESHOLD) {
+		JobDesc desc[2] = { JobDesc(build_picking_subtree, children), JobDesc(build_picking_subtree, children + 1) };
+		wait_for_jobs(PRIORITY_HIGH, { desc, 2 });
+	}
+	else {
+		build_picking_subtree(children[0]);
+		build_picking_subtree(children[1]);
 	}
-    info.node.child_count = child_count;
-	job.child_idx = &info.node - scene_partition.nodes;
 
-	//printf("=== Resetting Watermark(%i) === %i\n", job.depth, region.watermark);
+	PickingNode* nodes = job.partition->nodes.data;
+	node.child[0] = children[0].node;
+	node.child[1] = children[1].node;
+	node.aabb = merge_aabb(nodes[children[0].node].aabb, nodes[children[1].node].aabb);
 }
 
-void build_acceleration_structure(PickingScenePartition& scene_partition, World& world) { 
+void build_acceleration_structure(PickingScenePartition& partition, World& world) { 
 	Profile profile("rebuild picking acceleration");
-	
-	AABB world_bounds;
     
     LinearAllocator& allocator = get_temporary_allocator();
     LinearRegion region(allocator);
 
-	tvector<AABB> aabbs;
-	tvector<ID> ids;
-	tvector<uint> tags;
+	tvector<PickingBounds> bounds;
 
 	//todo only generate bvh for static elements
 	for (auto [e, trans, model_renderer] : world.filter<Transform, ModelRenderer>()) {
-		auto model_m = compute_model_matrix(trans);
-
-		Model* model = get_Model(model_renderer.model_id);		
-		if (model == NULL) continue;
-
-		AABB aabb = model->aabb.apply(model_m);
-		world_bounds.update_aabb(aabb);
-		aabbs.append(aabb);
-		ids.append(e.id);
-		tags.append(0);
+		add_model_bounds(bounds, e.id, trans, model_renderer);
 	}
 
 	for (auto[e, trans, control] : world.filter<Transform, TerrainControlPoint>()) {
-		AABB aabb;
-		aabb.min = trans.position + glm::vec3(-0.5, -0.5, -0.5);
-		aabb.max = trans.position + glm::vec3(0.5, 0.5, 0.5);
-
-		world_bounds.update_aabb(aabb);
-		aabbs.append(aabb);
-		ids.append(e.id);
-		tags.append(GIZMO_TAG);
+		add_gizmo_bounds(bounds, e.id, trans);
 	}
 
 	for (auto[e, trans, control] : world.filter<Transform, TerrainSplat>()) {
-		AABB aabb;
-		aabb.min = trans.position + glm::vec3(-0.5, -0.5, -0.5);
-		aabb.max = trans.position + glm::vec3(0.5, 0.5, 0.5);
-
-		world_bounds.update_aabb(aabb);
-		aabbs.append(aabb);
-		ids.append(e.id);
-		tags.append(GIZMO_TAG);
+		add_gizmo_bounds(bounds, e.id, trans);
 	}
+
 	for (auto[e, trans, terrain] : world.filter<Transform, Terrain>()) {
-		auto model_m = compute_model_matrix(trans);
+		add_terrain_bounds(bounds, e.id, trans, terrain);
+	}
 
-		uint width = terrain.width;
-		uint height = terrain.height;
+	partition.nodes.clear();
+	partition.root = INVALID_PICKING_NODE;
+	partition.free_list = INVALID_PICKING_NODE;
+	for (uint i = 0; i < partition.leaf_of_entity.length; i++) partition.leaf_of_entity[i] = INVALID_PICKING_NODE;
 
-		AABB terrain_aabb;
-		terrain_aabb.min = trans.position;
-		terrain_aabb.max = trans.position + glm::vec3(width * terrain.size_of_block, terrain.max_height, height * terrain.size_of_block);
+	if (bounds.length == 0) return;
 
-		float* displacement_map = terrain.displacement_map[1].data;
+	partition.nodes.resize(2 * bounds.length - 1);
 
-		uint width_quads = width * 32;
+	BuildPickingJob job = { &partition, bounds.data, bounds.length, 0, INVALID_PICKING_NODE };
+	build_picking_subtree(job);
 
-		for (uint block_y = 0; block_y < height; block_y++) {
-			for (uint block_x = 0; block_x < width; block_x++) {
-				float heighest = FLT_MAX; //todo add support for ray traced heightmap
+	partition.root = 0;
 
-				uint offset_y = (block_y * 32) / 4;
-				uint offset_x = (block_x * 32) / 4;
+	//leaves of the same entity can be built by different jobs, so they are linked afterwards
+	for (uint i = 0; i < partition.nodes.length; i++) {
+		PickingNode& node = partition.nodes[i];
+		if (!node.is_leaf()) continue;
 
-				for (uint y1 = offset_y; y1 < offset_y + 8; y1++) {
-					uint offset = y1 * width_quads;
+		uint& first = first_leaf(partition, node.id);
+		node.next_leaf = first;
+		first = i;
+	}
+}
 
-					for (uint x1 = offset_x; x1 < offset_x + 8; x1++) {
-						heighest = fminf(heighest, displacement_map[x1 + offset]);
-					}
-				}
+#undef max
 
-				AABB aabb;
-				aabb.min = terrain_aabb.min + glm::vec3(block_x * terrain.size_of_block, 0, block_y * terrain.size_of_block);
-				aabb.max = aabb.min + glm::vec3(terrain.size_of_block, heighest, terrain.size_of_block);
+float max(glm::vec3 vec) {
+	return vec.x > vec.y ? (vec.x > vec.z ? vec.x : vec.z) : (vec.y > vec.z ? vec.y : vec.z);
+}
 
+PickingSystem::PickingSystem() {
 
-				world_bounds.update_aabb(aabb);
-				aabbs.append(aabb);
-				ids.append(e.id);
-				tags.append(0);
-			}
-		}
+}
+
+void PickingSystem::rebuild_acceleration_structure(World& world) {
+	build_acceleration_structure(partition, world);
+}
+
+void PickingSystem::remove_entity(ID id) {
+	if (id >= partition.leaf_of_entity.length) return;
+
+	uint leaf = partition.leaf_of_entity[id];
+	while (leaf != INVALID_PICKING_NODE) {
+		uint next = partition.nodes[leaf].next_leaf;
+		remove_leaf(partition, leaf);
+		free_node(partition, leaf);
+		leaf = next;
 	}
 
-	/*for (uint i = 0; i < aabbs.length; i++) {
-		if (aabbs[i].max.y > 30) {
-			printf("AABB with id %i is insanely tall\n", ids[i]);
+	partition.leaf_of_entity[id] = INVALID_PICKING_NODE;
+}
+
+void PickingSystem::update_entity(World& world, ID id) {
+	LinearAllocator& allocator = get_temporary_allocator();
+	LinearRegion region(allocator);
+
+	tvector<PickingBounds> bounds;
+	gather_entity_bounds(world, id, bounds);
+
+	uint leaf = first_leaf(partition, id);
+	bool single_leaf = leaf != INVALID_PICKING_NODE && partition.nodes[leaf].next_leaf == INVALID_PICKING_NODE;
+
+	//Small moves only refit the ancestors, large ones reinsert to keep the tree tight
+	if (single_leaf && bounds.length == 1) {
+		PickingNode& node = partition.nodes[leaf];
+		node.bounds = bounds[0].aabb;
+		node.tags = bounds[0].tags;
+
+		if (node.bounds.inside(node.aabb)) return;
+
+		AABB fat = fatten_aabb(node.bounds);
+		if (fat.intersects(node.aabb)) {
+			node.aabb = fat;
+			refit_ancestors(partition, node.parent);
 		}
-	}*/
+		else {
+			remove_leaf(partition, leaf);
+			partition.nodes[leaf].aabb = fat;
+			insert_leaf(partition, leaf);
+		}
+		return;
+	}
 
-	SubdivideBVHJob job = {&scene_partition, world_bounds};
-	job.depth = 0;
-	job.mesh_count = aabbs.length;
-	job.aabbs = aabbs.data;
-	job.ids = ids.data;
-	job.tags = tags.data;
+	remove_entity(id);
 
-	subdivide_BVH(job);
-}
+	for (PickingBounds& entity_bounds : bounds) {
+		uint new_leaf = alloc_node(partition);
+		uint& first = first_leaf(partition, id);
 
-#undef max
+		PickingNode& node = partition.nodes[new_leaf];
+		node.bounds = entity_bounds.aabb;
+		node.aabb = fatten_aabb(entity_bounds.aabb);
+		node.id = id;
+		node.tags = entity_bounds.tags;
+		node.next_leaf = first;
+		first = new_leaf;
 
-float max(glm::vec3 vec) {
-	return vec.x > vec.y ? (vec.x > vec.z ? vec.x : vec.z) : (vec.y > vec.z ? vec.y : vec.z);
+		insert_leaf(partition, new_leaf);
+	}
 }
 
-void ray_cast_node(PickingScenePartition& partition, Node& node, const Ray& ray, RayHit& hit) {
-	for (int i = 0; i < node.child_count; i++) { //could use count instead
-		Node& child = partition.nodes[node.child[i]];
-		if (ray_aabb_intersect(child.aabb, ray)) ray_cast_node(partition, child, ray, hit);
-	}
+bool PickingSystem::ray_cast(const Ray& ray, RayHit& hit_result) {
+	if (partition.root == INVALID_PICKING_NODE) return false;
+
+	LinearAllocator& allocator = get_temporary_allocator();
+	LinearRegion region(allocator);
 
-	for (int i = node.offset; i < node.offset + node.count; i++) {
-		AABB& aabb = partition.aabbs[i];
+	tvector<uint> stack;
+	stack.append(partition.root);
 
-		glm::vec3 new_hit;
+	while (stack.length > 0) {
+		PickingNode& node = partition.nodes[stack.pop()];
+
+		//the fat bounds enclose the tight ones, so can't be entered later than them
 		float t;
-		bool always_visible = partition.tags[i] & GIZMO_TAG;
+		if (!ray_aabb_intersect(node.aabb, ray, &t) || t >= hit_result.t) continue;
 
-		if (ray_aabb_intersect(aabb, ray, &t)) {
-			hit.id = partition.ids[i];
-			hit.t = t;
+		if (node.is_leaf()) {
+			if (ray_aabb_intersect(node.bounds, ray, &t) && t < hit_result.t) {
+				hit_result.id = node.id;
+				hit_result.t = t;
+			}
+		}
+		else {
+			stack.append(node.child[0]);
+			stack.append(node.child[1]);
 		}
 	}
+
+	bool hit = hit_result.t < FLT_MAX;
+	if (hit) hit_result.position = ray.orig + ray.dir * hit_result.t;
+
+	return hit;
 }
 
-PickingSystem::PickingSystem() {
+#ifdef PICKING_SSE
+struct RayPacket {
+	__m128 orig[3];
+	__m128 invdir[3];
+};
+
+//Slab test of 4 rays against one box, returns the mask of the rays which enter it before closest
+inline __m128 ray_packet_aabb_intersect(const RayPacket& packet, const AABB& aabb, __m128 closest, __m128& entry) {
+	__m128 tmin = _mm_set1_ps(-FLT_MAX);
+	__m128 tmax = _mm_set1_ps(FLT_MAX);
 
+	for (uint axis = 0; axis < 3; axis++) {
+		__m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.min[axis]), packet.orig[axis]), packet.invdir[axis]);
+		__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.max[axis]), packet.orig[axis]), packet.invdir[axis]);
+
+		tmin = _mm_max_ps(tmin, _mm_min_ps(t0, t1));
+		tmax = _mm_min_ps(tmax, _mm_max_ps(t0, t1));
+	}
+
+	entry = tmin;
+
+	__m128 hit = _mm_and_ps(_mm_cmple_ps(tmin, tmax), _mm_cmpge_ps(tmax, _mm_setzero_ps()));
+	return _mm_and_ps(hit, _mm_cmplt_ps(tmin, closest));
 }
+#endif
 
-void PickingSystem::rebuild_acceleration_structure(World& world) {
-	build_acceleration_structure(partition, world);
+void PickingSystem::ray_cast(slice<Ray> rays, RayHit* hits) {
+	if (partition.root == INVALID_PICKING_NODE) return;
+
+#ifdef PICKING_SSE
+	LinearAllocator& allocator = get_temporary_allocator();
+	LinearRegion region(allocator);
+
+	tvector<uint> stack;
+
+	//Rays of a packet share the traversal, a node is only skipped once all of them miss it
+	for (uint base = 0; base < rays.length; base += 4) {
+		uint count = min(4, rays.length - base);
+
+		alignas(16) float orig[3][4] = {};
+		alignas(16) float invdir[3][4] = {};
+		alignas(16) float closest[4];
+
+		for (uint lane = 0; lane < 4; lane++) {
+			if (lane >= count) {
+				closest[lane] = -FLT_MAX; //inactive lanes never hit
+				continue;
+			}
+
+			const Ray& ray = rays[base + lane];
+			for (uint axis = 0; axis < 3; axis++) {
+				orig[axis][lane] = ray.orig[axis];
+				invdir[axis][lane] = ray.invdir[axis];
+			}
+			closest[lane] = fminf(ray.t, hits[base + lane].t);
+		}
+
+		RayPacket packet;
+		for (uint axis = 0; axis < 3; axis++) {
+			packet.orig[axis] = _mm_load_ps(orig[axis]);
+			packet.invdir[axis] = _mm_load_ps(invdir[axis]);
+		}
+
+		stack.length = 0;
+		stack.append(partition.root);
+
+		while (stack.length > 0) {
+			PickingNode& node = partition.nodes[stack.pop()];
+
+			__m128 closest_t = _mm_load_ps(closest);
+			__m128 entry;
+
+			if (!_mm_movemask_ps(ray_packet_aabb_intersect(packet, node.aabb, closest_t, entry))) continue;
+
+			if (!node.is_leaf()) {
+				stack.append(node.child[0]);
+				stack.append(node.child[1]);
+				continue;
+			}
+
+			int mask = _mm_movemask_ps(ray_packet_aabb_intersect(packet, node.bounds, closest_t, entry));
+
+			alignas(16) float t[4];
+			_mm_store_ps(t, entry);
+
+			for (uint lane = 0; lane < count; lane++) {
+				if (!(mask & (1 << lane))) continue;
+
+				closest[lane] = t[lane];
+				hits[base + lane].t = t[lane];
+				hits[base + lane].id = node.id;
+			}
+		}
+
+		for (uint lane = 0; lane < count; lane++) {
+			RayHit& hit = hits[base + lane];
+			const Ray& ray = rays[base + lane];
+			if (hit.t < FLT_MAX) hit.position = ray.orig + ray.dir * hit.t;
+		}
+	}
+#else
+	for (uint i = 0; i < rays.length; i++) ray_cast(rays[i], hits[i]);
+#endif
 }
 
-bool PickingSystem::ray_cast(const Ray& ray, RayHit& hit_result) {
-	if (partition.count == 0) return false;
-	ray_cast_node(partition, partition.nodes[0], ray, hit_result);
+void pick_node(PickingScenePartition& partition, uint index, glm::vec4 planes[6], bool inside, tvector<ID>& ids) {
+	PickingNode& node = partition.nodes[index];
 
-	bool hit = hit_result.t < FLT_MAX;
-	if (hit) hit_result.position = ray.orig + ray.dir * hit_result.t;
+	//once a node is inside the frustum, its whole subtree is
+	if (!inside) {
+		CullResult result = frustum_test(planes, node.is_leaf() ? node.bounds : node.aabb);
+		if (result == OUTSIDE) return;
+		inside = result == INSIDE;
+	}
 
-	return hit;
+	if (node.is_leaf()) {
+		ids.append(node.id);
+		return;
+	}
+
+	pick_node(partition, node.child[0], planes, inside, ids);
+	pick_node(partition, node.child[1], planes, inside, ids);
+}
+
+void PickingSystem::pick_rect(Viewport& viewport, glm::vec2 a, glm::vec2 b, tvector<ID>& ids) {
+	if (partition.root == INVALID_PICKING_NODE) return;
+
+	glm::vec2 resolution(viewport.width, viewport.height);
+	glm::vec2 min_clip = glm::min(a, b) / resolution * 2.0f - 1.0f;
+	glm::vec2 max_clip = glm::max(a, b) / resolution * 2.0f - 1.0f;
+
+	//same convention as ray_from_mouse, y points down on screen and up in clip space
+	float x0 = min_clip.x, x1 = max_clip.x;
+	float y0 = -max_clip.y, y1 = -min_clip.y;
+
+	glm::mat4 mat = viewport.proj * viewport.view;
+	glm::vec4 planes[6];
+
+	for (int i = 0; i < 4; i++) {
+		planes[0][i] = mat[i][0] - x0 * mat[i][3];
+		planes[1][i] = x1 * mat[i][3] - mat[i][0];
+		planes[2][i] = mat[i][1] - y0 * mat[i][3];
+		planes[3][i] = y1 * mat[i][3] - mat[i][1];
+		planes[4][i] = mat[i][3] + mat[i][2];
+		planes[5][i] = mat[i][3] - mat[i][2];
+	}
+
+	uint first = ids.length;
+	pick_node(partition, partition.root, planes, false, ids);
+
+	//terrain has a leaf per block
+	std::sort(ids.begin() + first, ids.end());
+	ids.length = std::unique(ids.begin() + first, ids.end()) - ids.begin();
 }
 
 bool PickingSystem::ray_cast(Viewport& viewport, glm::vec2 position, RayHit& hit) {
@@ -291,17 +635,17 @@ void render_cube(RenderPass& ctx, material_handle mat_handle, glm::vec3 center,
 
 struct Material;
 
-void render_node(RenderPass& ctx, material_handle mat, PickingScenePartition& partition, Node& node, Ray& ray) {
-	render_cube(ctx, mat, (node.aabb.max + node.aabb.min) * 0.5f, node.aabb.max - node.aabb.min);
+void render_node(RenderPass& ctx, material_handle mat, PickingScenePartition& partition, uint index, Ray& ray) {
+	PickingNode& node = partition.nodes[index];
+	AABB& aabb = node.is_leaf() ? node.bounds : node.aabb;
 
-	for (int i = 0; i < node.child_count; i++) {
-		Node& child = partition.nodes[node.child[i]];
-		if (ray_aabb_intersect(child.aabb, ray)) render_node(ctx, mat, partition, child, ray);
-	}
+	render_cube(ctx, mat, (aabb.max + aabb.min) * 0.5f, aabb.max - aabb.min);
 
-	for (int i = node.offset; i < node.offset + node.count; i++) {
-		AABB& aabb = partition.aabbs[i];
-		if (ray_aabb_intersect(aabb, ray)) render_cube(ctx, mat, (aabb.max + aabb.min) * 0.5f, aabb.max - aabb.min);
+	if (node.is_leaf()) return;
+
+	for (uint i = 0; i < 2; i++) {
+		PickingNode& child = partition.nodes[node.child[i]];
+		if (ray_aabb_intersect(child.aabb, ray)) render_node(ctx, mat, partition, node.child[i], ray);
 	}
 }
 
@@ -311,7 +655,7 @@ void render_node(RenderPass& ctx, material_handle mat, PickingScenePartition& pa
 
 void PickingSystem::visualize(Viewport& viewport, glm::vec2 position, RenderPass& ctx) {
 	return;
-	if (partition.count == 0) return;
+	if (partition.root == INVALID_PICKING_NODE) return;
 	
 	Ray ray = ray_from_mouse(viewport, position);
 
@@ -332,7 +676,7 @@ void PickingSystem::visualize(Viewport& viewport, glm::vec2 position, RenderPass
 
 	render_cube(ctx, material, hit_result.position, glm::vec3(0.1));
 
-	render_node(ctx, material, partition, partition.nodes[0], ray);
+	render_node(ctx, material, partition, partition.root, ray);
 
 	//ray.dir = glm::vec3(0, 0, -1) * world.by_id<Transform>(get_camera(world, EDITOR_LAYER))->rotation;
 
@@ -166,7 +166,10 @@ void regenerate_terrain(World& world, TerrainEditorResources& generation_resourc
 		auto width_quads = TERRAIN_RESOLUTION * terrain.width;
 		auto height_quads = TERRAIN_RESOLUTION * terrain.height;
 
-		receive_generated_heightmap(generation_resources, terrain);
+		//without render resources (e.g. headless) the heightmap is estimated on the cpu
+		bool use_gpu = generation_resources.async_copy != nullptr;
+
+		if (use_gpu) receive_generated_heightmap(generation_resources, terrain);
 
 		//receive_transfer(resources.async_copy, width_quads * height_quads * sizeof(float), terrain.displacement_map[0].data);
 
@@ -180,6 +183,8 @@ void regenerate_terrain(World& world, TerrainEditorResources& generation_resourc
 		KrigingUBO kriging_ubo = {};
 
 		for (auto [e, control, trans] : world.filter<TerrainControlPoint, Transform>()) {
+			if (kriging_ubo.N + 4 >= KRIGING_MAX_WEIGHTS) break; //reserve space for the corners
+
 			glm::vec2 position = glm::vec2(trans.position.x - terrain_position.x, trans.position.z - terrain_position.z) / size_per_quad;
 			float height = trans.position.y - terrain_position.y;
 
@@ -198,7 +203,7 @@ void regenerate_terrain(World& world, TerrainEditorResources& generation_resourc
 		glm::mat4 view = glm::lookAt(center, center + glm::vec3(0, -1, 0), glm::vec3(0, 0, -1.0f));
 		glm::mat4 proj_view = proj * view;
 
-		memcpy_ubo_buffer(generation_resources.splat_ubo, &proj_view);
+		if (use_gpu) memcpy_ubo_buffer(generation_resources.splat_ubo, &proj_view);
 
 		for (auto [e, control, trans] : world.filter<TerrainSplat, Transform>()) {
 			glm::mat4 model = compute_model_matrix(trans);
@@ -255,8 +260,19 @@ void regenerate_terrain(World& world, TerrainEditorResources& generation_resourc
 
 		edit_terrain.end();
 
-		if (kriging_ubo.N > 4) {
-			compute_kriging_matrix(kriging_ubo, width_quads, height_quads);
+		bool has_surface = kriging_ubo.N > 4 && compute_kriging_weights(kriging_ubo, width_quads, height_quads);
+
+		if (!use_gpu) {
+			heightmap[0].resize(size);
+			if (has_surface) cpu_estimate_terrain_surface(kriging_ubo, width_quads, height_quads, heightmap[0].data);
+			else for (uint i = 0; i < size; i++) heightmap[0][i] = 1.0f;
+
+			//update_terrain_material rebuilds it on the gpu path, which needs the render resources
+			build_terrain_quadtree(terrain);
+			continue;
+		}
+
+		if (has_surface) {
 			gpu_estimate_terrain_surface(generation_resources, terrain_resources, kriging_ubo);
 		}
 		else {
@@ -3,21 +3,30 @@
 #include <glm/vec2.hpp>
 #include <glm/glm.hpp>
 #include "core/container/slice.h"
+#include "core/container/tvector.h"
 #include "core/memory/linear_allocator.h"
+#include "core/job_system/job.h"
 #include <string.h>
 #include "core/profiler.h"
 #include "terrain_tools/kriging.h"
 
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define KRIGING_SSE
+#include <emmintrin.h>
+#endif
+
 /*struct HeightmapPoint {
 	glm::vec2 position;
 	float height;
 };*/
 
+//Only the lower triangle is used, the factorization is done in double
+//as hundreds of nearby control points make the covariance matrix badly conditioned
 struct Matrix {
 	uint N;
-	float* values;
+	double* values;
 
-	float* operator[](uint row) {
+	double* operator[](uint row) {
 		return values + (size_t)row * N;
 	}
 };
@@ -28,42 +37,13 @@ struct Matrix {
 	float range;
 };*/
 
+const uint CHOLESKY_BLOCK = 32;
+const uint ESTIMATE_ROWS_PER_JOB = 16;
+
 float cov(float nugget, float sill, float range, float h) {
 	return (sill - nugget) * expf(-3.0f * h / range);
 }
 
-void lu(Matrix mat, Matrix lower, Matrix upper) {
-	int N = mat.N;
-	int i = 0, j = 0, k = 0;
-	for (i = 0; i < N; i++) {
-		for (j = 0; j < N; j++) {
-			if (j < i) {
-				lower[j][i] = 0;
-			}
-			else {
-				lower[j][i] = mat[j][i];
-				for (k = 0; k < i; k++) {
-					lower[j][i] = lower[j][i] - lower[j][k] * upper[k][i];
-				}
-			}
-		}
-		for (j = 0; j < N; j++) {
-			if (j < i) {
-				upper[i][j] = 0;
-			}
-			else if (j == i) {
-				upper[i][j] = 1;
-			}
-			else {
-				upper[i][j] = mat[i][j] / lower[i][i];
-				for (k = 0; k < i; k++) {
-					upper[i][j] = upper[i][j] - ((lower[i][k] * upper[k][j]) / lower[i][i]);
-				}
-			}
-		}
-	}
-}
-
 void output_float(float value) {
 	printf("%-6.2f ", value);
 }
@@ -81,7 +61,7 @@ void output_mat(Matrix matrix) {
 
 	for (int i = 0; i < N; i++) {
 		printf("[ ");
-		for (int j = 0; j < N; j++) {
+		for (int j = 0; j <= i; j++) {
 			output_float(matrix[i][j]);
 		}
 
@@ -89,92 +69,123 @@ void output_mat(Matrix matrix) {
 	}
 }
 
-float compute_z(int col, int row, Matrix lower, Matrix Z, Matrix I) {
-	int N = I.N;
+Matrix alloc_temporary_matrix(uint N) {
+	return { N, TEMPORARY_ZEROED_ARRAY(double, N * N) };
+}
 
-	float sum = 0;
-	for (int i = 0; i < N; i++) {
-		if (i != row) {
-			sum += lower[row][i] * Z[i][col];
-		}
-	}
+double dot(const double* a, const double* b, uint n) {
+	double sum = 0.0;
+	for (uint i = 0; i < n; i++) sum += a[i] * b[i];
+	return sum;
+}
+
+//Right looking blocked cholesky, A = L * L^T
+//Each step factors the diagonal block, then solves the panel below it and
+//applies the rank-k update to the trailing matrix, both split into row blocks across jobs.
+//Rows are stored contiguously, so every inner loop is a dot product of two row segments
+struct CholeskyJob {
+	Matrix mat;
+	uint kb, kend;
+	uint row_begin, row_end;
+};
 
-	float result = I[row][col] - sum;
-	result = result / lower[row][row];
+void cholesky_panel(CholeskyJob& job) {
+	Matrix A = job.mat;
 
-	return result;
+	for (uint i = job.row_begin; i < job.row_end; i++) {
+		for (uint j = job.kb; j < job.kend; j++) {
+			double s = A[i][j] - dot(A[i] + job.kb, A[j] + job.kb, j - job.kb);
+			A[i][j] = s / A[j][j];
+		}
+	}
 }
 
-float compute_inverse(int col, int row, Matrix inverse, Matrix upper, Matrix Z) {
-	int N = inverse.N;
+void cholesky_trailing_update(CholeskyJob& job) {
+	Matrix A = job.mat;
+	uint k = job.kend - job.kb;
 
-	float sum = 0;
-	for (int i = 0; i < N; i++) {
-		if (i != row) {
-			sum += upper[row][i] * inverse[i][col];
+	for (uint i = job.row_begin; i < job.row_end; i++) {
+		for (uint j = job.kend; j <= i; j++) {
+			A[i][j] -= dot(A[i] + job.kb, A[j] + job.kb, k);
 		}
 	}
+}
 
-	float result = Z[row][col] - sum;
-	result = result / upper[row][row];
+bool cholesky_diagonal_block(Matrix A, uint kb, uint kend) {
+	for (uint j = kb; j < kend; j++) {
+		double d = A[j][j] - dot(A[j] + kb, A[j] + kb, j - kb);
+		if (d <= 0.0) return false;
+		A[j][j] = sqrt(d);
 
+		for (uint i = j + 1; i < kend; i++) {
+			A[i][j] = (A[i][j] - dot(A[i] + kb, A[j] + kb, j - kb)) / A[j][j];
+		}
+	}
 
-	return result;
+	return true;
 }
 
-void inverse_matrix(Matrix mat, Matrix inverse, Matrix upper, Matrix lower, Matrix Z, Matrix I) {
-	int N = mat.N;
+bool cholesky(Matrix A) {
+	uint N = A.N;
+	uint max_jobs = (N + CHOLESKY_BLOCK - 1) / CHOLESKY_BLOCK;
+
+	CholeskyJob* jobs = TEMPORARY_ARRAY(CholeskyJob, max_jobs);
+	JobDesc* desc = TEMPORARY_ARRAY(JobDesc, max_jobs);
 
-	lu(mat, lower, upper);
+	for (uint kb = 0; kb < N; kb += CHOLESKY_BLOCK) {
+		uint kend = min(kb + CHOLESKY_BLOCK, N);
+		if (!cholesky_diagonal_block(A, kb, kend)) return false;
 
-	// compute z
-	for (int col = 0; col < N; col++) {
-		for (int row = 0; row < N; row++) {
-			Z[row][col] = compute_z(col, row, lower, Z, I);
+		uint count = 0;
+		for (uint row = kend; row < N; row += CHOLESKY_BLOCK) {
+			jobs[count] = { A, kb, kend, row, min(row + CHOLESKY_BLOCK, N) };
+			count++;
 		}
-	}
 
+		if (count == 0) break;
 
-	// compute inverse
-	for (int col = 0; col < N; col++) {
-		for (int row = N - 1; row >= 0; row--) {
-			inverse[row][col] = compute_inverse(col, row, inverse, upper, Z);
-		}
+		for (uint i = 0; i < count; i++) desc[i] = JobDesc(cholesky_panel, jobs + i);
+		wait_for_jobs(PRIORITY_HIGH, { desc, count });
+
+		//the update of a row reads the panel of every row above it
+		for (uint i = 0; i < count; i++) desc[i] = JobDesc(cholesky_trailing_update, jobs + i);
+		wait_for_jobs(PRIORITY_HIGH, { desc, count });
 	}
 
+	return true;
 }
 
-void mul_matrix(Matrix mat, float* vec, float* result) {
-	for (int i = 0; i < mat.N; i++) {
-		float sum = 0.0f;
-		for (int j = 0; j < mat.N; j++) {
-			sum += mat[i][j] * vec[j];
-		}
+//Solves L * L^T x = b in place
+void cholesky_solve(Matrix L, double* b) {
+	uint N = L.N;
 
-		result[i] = sum;
+	for (uint i = 0; i < N; i++) {
+		b[i] = (b[i] - dot(L[i], b, i)) / L[i][i];
 	}
-}
-
 
-Matrix alloc_temporary_matrix(uint N) {
-	return { N, TEMPORARY_ZEROED_ARRAY(float, N * N) };
+	for (int i = N - 1; i >= 0; i--) {
+		double sum = b[i];
+		for (uint k = i + 1; k < N; k++) sum -= L[k][i] * b[k];
+		b[i] = sum / L[i][i];
+	}
 }
 
-
-
-bool compute_kriging_matrix(KrigingUBO& kriging_ubo, uint width, uint height) {
-	const uint N_POINTS = kriging_ubo.N;
-	const glm::vec4* positions = kriging_ubo.positions;
+bool compute_kriging_weights(KrigingUBO& kriging_ubo, uint width, uint height) {
+	const uint N = kriging_ubo.N;
+	glm::vec4* positions = kriging_ubo.positions;
 
 	Profile kriging("Kriging");
 
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
 	float max_dist = ceilf(sqrt(width * width + height * height));
 
+	/*
+	//COMPUTE VARIOGRAM
 	int bin_width = max_dist / 20;
 	int max_bin = 21;
 
-	/*
-	//COMPUTE VARIOGRAM
 	float* variance_bins = TEMPORARY_ZEROED_ARRAY(float, max_bin, 0);
 	int* variance_bins_count = TEMPORARY_ZEROED_ARRAY(int, max_bin, 0);
 
@@ -227,91 +238,181 @@ bool compute_kriging_matrix(KrigingUBO& kriging_ubo, uint width, uint height) {
 	float sill = 0.5f * powf(radius, 2);
 	float range = radius;
 
-	uint N = ++kriging_ubo.N;
-
-	//ALLOCATE MATRICES
-	Matrix c1 = alloc_temporary_matrix(N); //todo remove with static array allocations
-	Matrix c1_inv = { N, kriging_ubo.c1 };
-	Matrix I = alloc_temporary_matrix(N);
-	Matrix Z = alloc_temporary_matrix(N);
-	Matrix lower = alloc_temporary_matrix(N);
-	Matrix upper = alloc_temporary_matrix(N);
+	kriging_ubo.a = (sill - nugget);
+	kriging_ubo.b = -3.0f / range;
 
-	//printf("Allocated matrices!\n");
+	if (N == 0) return false;
 
 	//COMPUTE COVARIANCE MATRIX
-	for (int i = 0; i < N; i++) {
-		I[i][i] = 1.0;
+	//small jitter on the diagonal keeps coincident control points from making it singular
+	Matrix c = alloc_temporary_matrix(N);
+	double jitter = 1e-6 * (sill - nugget);
+
+	for (uint i = 0; i < N; i++) {
+		for (uint j = 0; j <= i; j++) {
+			float dist = glm::length(glm::vec2(positions[i]) - glm::vec2(positions[j]));
+			c[i][j] = cov(nugget, sill, range, dist);
+		}
+		c[i][i] += jitter;
 	}
 
-	for (int i = 0; i < N_POINTS; i++) {
-		c1[i][N - 1] = 1;
-		c1[N - 1][i] = 1;
+	if (!cholesky(c)) {
+		printf("Kriging covariance matrix is not positive definite!\n");
+		return false;
 	}
 
-	for (int i = 0; i < N_POINTS; i++) {
-		for (int j = i; j < N_POINTS; j++) {
-			float dist = glm::length(positions[i] - positions[j]);
-			c1[i][j] = cov(nugget, sill, range, dist);
-		}
-	}
+	//The unknown mean is the generalized least squares estimate,
+	//which is equivalent to the lagrange multiplier row of ordinary kriging
+	double* ones = TEMPORARY_ARRAY(double, N);
+	double* weights = TEMPORARY_ARRAY(double, N);
 
-	for (int i = 0; i < N_POINTS; i++) {
-		for (int j = 0; j < i; j++) {
-			c1[i][j] = c1[j][i];
-		}
+	for (uint i = 0; i < N; i++) {
+		ones[i] = 1.0;
+		weights[i] = positions[i].z;
 	}
 
-	//printf("=== C1 ===\n");
-	//output_mat(c1);
+	cholesky_solve(c, ones);
+	cholesky_solve(c, weights);
 
-	inverse_matrix(c1, c1_inv, upper, lower, Z, I);
+	double sum_ones = 0.0;
+	double sum_weights = 0.0;
+	for (uint i = 0; i < N; i++) {
+		sum_ones += ones[i];
+		sum_weights += weights[i];
+	}
 
-	//printf("=== C1 INV ===\n");
-	//output_mat(c1_inv);
+	double mean = sum_weights / sum_ones;
 
+	for (uint i = 0; i < N; i++) {
+		positions[i].w = (float)(weights[i] - mean * ones[i]);
+	}
 
-	kriging_ubo.a = (sill - nugget);
-	kriging_ubo.b = -3.0f / range;
+	kriging_ubo.mean = (float)mean;
 
 	kriging.end();
 
 	return true;
+}
+
+struct EstimateSurfaceJob {
+	const float* x;
+	const float* y;
+	const float* weight;
+	uint N;
+	float b;
+	float mean;
+	uint width;
+	uint row_begin, row_end;
+	float* output;
+};
 
+#ifdef KRIGING_SSE
+//exp(x) = 2^i * 2^f, with i = round(x * log2(e)) and |f| <= 0.5 so a short series is accurate to float precision
+inline __m128 exp_ps(__m128 x) {
+	__m128 t = _mm_mul_ps(x, _mm_set1_ps(1.44269504f));
+	t = _mm_max_ps(t, _mm_set1_ps(-126.0f));
 
-	//if (total_weight > 1.1) {
-	//	printf("total weight %f\n", total_weight);
-	//}
-	//
+	__m128i i = _mm_cvtps_epi32(t);
+	__m128 f = _mm_sub_ps(t, _mm_cvtepi32_ps(i));
+
+	__m128 p = _mm_set1_ps(1.33335581e-3f);
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(9.61812911e-3f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.55041087e-2f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.40226507e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(6.93147181e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+
+	__m128i exponent = _mm_slli_epi32(_mm_add_epi32(i, _mm_set1_epi32(127)), 23);
+	return _mm_mul_ps(p, _mm_castsi128_ps(exponent));
 }
+#endif
 
-void cpu_estimate_terrain_surface(uint width, uint height) {
-	/*
-	float* c0 = TEMPORARY_ARRAY(float, N);
-	float* weights = TEMPORARY_ARRAY(float, N);
-	c0[N - 1] = 1;
+void estimate_surface_rows(EstimateSurfaceJob& job) {
+	uint N = job.N;
+	uint width = job.width;
 
+	for (uint row = job.row_begin; row < job.row_end; row++) {
+		float* output = job.output + (size_t)row * width;
+		float py = row + 0.5f;
+		uint x = 0;
 
-	Profile surface("Terrain surface generation");
+#ifdef KRIGING_SSE
+		__m128 b = _mm_set1_ps(job.b);
+		__m128 dy_base = _mm_set1_ps(py);
+		__m128 lane = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+		for (; x + 4 <= width; x += 4) {
+			__m128 px = _mm_add_ps(_mm_set1_ps((float)x), lane);
+			__m128 height = _mm_setzero_ps();
+
+			for (uint i = 0; i < N; i++) {
+				__m128 dx = _mm_sub_ps(px, _mm_set1_ps(job.x[i]));
+				__m128 dy = _mm_sub_ps(dy_base, _mm_set1_ps(job.y[i]));
+				__m128 h = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
 
-	for (int y = 0; y < height; y++) {
-		for (int x = 0; x < width; x++) {
-			for (int i = 0; i < N_POINTS; i++) {
-				float dist = glm::length(positions[i] - glm::vec2(x, y));
-				c0[i] = cov(nugget, sill, range, dist);
+				height = _mm_add_ps(height, _mm_mul_ps(_mm_set1_ps(job.weight[i]), exp_ps(_mm_mul_ps(b, h))));
 			}
 
-			mul_matrix(c1_inv, c0, weights);
+			_mm_storeu_ps(output + x, _mm_add_ps(height, _mm_set1_ps(job.mean)));
+		}
+#endif
+
+		for (; x < width; x++) {
+			glm::vec2 pos(x + 0.5f, py);
+			float height = job.mean;
 
-			float weighted_sum = 0.0f;
-			for (int i = 0; i < N_POINTS; i++) {
-				weighted_sum += weights[i] * heights[i];
+			for (uint i = 0; i < N; i++) {
+				float h = glm::length(pos - glm::vec2(job.x[i], job.y[i]));
+				height += job.weight[i] * expf(job.b * h);
 			}
 
-			output[x + height * y] = weighted_sum;
+			output[x] = height;
 		}
 	}
+}
+
+void cpu_estimate_terrain_surface(const KrigingUBO& kriging_ubo, uint width, uint height, float* output) {
+	Profile surface("Terrain surface generation");
+
+	LinearAllocator& temporary = get_temporary_allocator();
+	LinearRegion region(temporary);
+
+	uint N = kriging_ubo.N;
+
+	//Structure of arrays so each point is a broadcast, with the sill folded into the weight
+	float* x = TEMPORARY_ARRAY(float, N);
+	float* y = TEMPORARY_ARRAY(float, N);
+	float* weight = TEMPORARY_ARRAY(float, N);
+
+	for (uint i = 0; i < N; i++) {
+		x[i] = kriging_ubo.positions[i].x;
+		y[i] = kriging_ubo.positions[i].y;
+		weight[i] = kriging_ubo.a * kriging_ubo.positions[i].w;
+	}
+
+	tvector<EstimateSurfaceJob> jobs;
+	tvector<JobDesc> desc;
+	jobs.reserve((height + ESTIMATE_ROWS_PER_JOB - 1) / ESTIMATE_ROWS_PER_JOB);
+
+	for (uint row = 0; row < height; row += ESTIMATE_ROWS_PER_JOB) {
+		EstimateSurfaceJob job = {};
+		job.x = x;
+		job.y = y;
+		job.weight = weight;
+		job.N = N;
+		job.b = kriging_ubo.b;
+		job.mean = kriging_ubo.mean;
+		job.width = width;
+		job.row_begin = row;
+		job.row_end = min(row + ESTIMATE_ROWS_PER_JOB, height);
+		job.output = output;
+
+		jobs.append(job);
+	}
+
+	for (EstimateSurfaceJob& job : jobs) desc.append(JobDesc(estimate_surface_rows, &job));
+
+	wait_for_jobs(PRIORITY_HIGH, desc);
 
 	surface.end();
-	*/
 }
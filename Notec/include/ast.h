@@ -3,67 +3,161 @@
 #include "core/core.h"
 #include "lexer.h"
 #include "core/container/vector.h"
+#include "core/container/slice.h"
 
 struct AST;
 
-struct Operator {
-    enum Type { Add, Sub, Mul, Div, } type;
-    AST* left;
-    AST* right;
-};
+//Notec only has 64 bit integers and doubles, every other arithmetic type is read as one of the two
+enum class ValueType : u8 { Void, Int, Float };
 
+//Nodes refer to each other by their index in the module, 0 is no node
+using ast_handle = uint;
+
+//Names are interned once per pool, so identifiers compare as integers
 using symbol_handle = uint;
 
+struct Operator {
+    enum Type : u8 { Add, Sub, Mul, Div, Mod, Lt, Gt, Lte, Gte, Eq, Neq, Neg } type;
+    ast_handle left;
+    ast_handle right; //0 for Neg
+};
+
 struct Identifier {
-    char name[100];
+    symbol_handle symbol;
 };
 
 struct IntLiteral {
     u64 value;
 };
 
+struct FloatLiteral {
+    double value;
+};
+
+//The statements of a block, like the arguments of a call, are a range of AstModule::children
 struct Block {
-    vector<AST*> children;
+    uint first;
+    uint count;
+};
+
+struct Declaration {
+    ValueType type;
+    ast_handle id;
+    ast_handle value; //0 when zero initialized
+};
+
+struct Assign {
+    bool compound;
+    Operator::Type op; //applied to the target and the value when compound
+    ast_handle target;
+    ast_handle value;
+};
+
+struct If {
+    ast_handle condition;
+    ast_handle then;
+    ast_handle otherwise; //a block, a chained If or 0
 };
 
 struct While {
-    AST* condition;
-    Block block;
+    ast_handle condition;
+    ast_handle body;
+};
+
+struct For {
+    ast_handle init;
+    ast_handle condition;
+    ast_handle step;
+    ast_handle body;
 };
 
 struct FuncCall {
-    AST* function;
-    vector<AST*> children;
+    ast_handle function;
+    uint first_arg;
+    uint arg_count;
 };
 
-struct Location {};
+struct Return {
+    ast_handle value;
+};
+
+struct Location {
+    uint offset; //into the source, like Token::loc
+};
+
+struct Diagnostic {
+    Location loc;
+    char message[100];
+};
 
 struct AST {
-    enum Type { Operator, Identifier, IntLiteral, If, Elif, Else, While, For, FuncCall } type;
-    
+    enum Type : u8 { Operator, Identifier, IntLiteral, FloatLiteral, Declaration, Assign, Block, If, While, For, FuncCall, Return, Break, Continue } type;
+    Location loc;
+
     union {
         struct Operator op;
         struct Identifier id;
         struct IntLiteral int_lit;
-        AST* free_next;
+        struct FloatLiteral float_lit;
+        struct Declaration decl;
+        struct Assign assign;
+        struct Block block;
+        struct If if_stmt;
+        struct While while_stmt;
+        struct For for_stmt;
+        struct FuncCall call;
+        struct Return ret;
     };
-    
-    Location loc;
-    AST* parent;
 };
 
+static_assert(sizeof(AST) == 24, "AST nodes are kept small so a cell fits in few cache lines");
+
+//Nodes are allocated in chunks that never move, so a node can be filled in while its children are parsed
+const uint AST_CHUNK = 1024;
+
 struct AstPool;
 
-struct AstModule;
+//Owns the nodes of one parse. The chunks and arrays are kept when the module is reset or
+//returned to its pool, so parsing a cell again does not allocate once they are large enough
+struct AstModule {
+    vector<AST*> chunks;
+    uint node_count;
+    vector<ast_handle> children;
+    vector<ast_handle> pending; //children of the blocks still being parsed
+    ast_handle root;
+    AstPool* pool;
+    AstModule* next;
+};
+
+//Null for the null handle
+inline AST* get_node(AstModule& module, ast_handle handle) {
+    return handle ? module.chunks[handle / AST_CHUNK] + handle % AST_CHUNK : nullptr;
+}
+
+inline slice<ast_handle> get_statements(AstModule& module, AST* block) {
+    return { module.children.data + block->block.first, block->block.count };
+}
+
+inline slice<ast_handle> get_args(AstModule& module, AST* call) {
+    return { module.children.data + call->call.first_arg, call->call.arg_count };
+}
+
+ast_handle make_ast_node(AstModule&, AST::Type, Location);
+ast_handle make_op_node(AstModule&, Operator::Type, ast_handle left, ast_handle right, Location);
+//Moves the children pending since begin into a range of the children array and returns its start
+uint commit_children(AstModule&, uint begin);
 
-AST* make_ast_node(AstModule&, AST::Type);
-AST* make_op_node(AstModule&, Operator::Type, AST* left, AST* right);
 AST* get_root(AstModule&);
+void set_root(AstModule&, ast_handle);
 
-void destroy_ast_node(AstModule&, AST*);
+symbol_handle intern_symbol(AstModule&, string_view name);
+const char* symbol_name(AstModule&, symbol_handle);
 
 AstPool* make_ast_pool();
+//Frees the modules that were returned to the pool
 void destroy_ast_pool(AstPool*);
 
 AstModule* make_ast_module(AstPool*);
+//Releases every node at once, the memory is kept for the next parse
+void reset_ast_module(AstModule&);
 void destroy_ast_module(AstModule*);
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "core/core.h"
+#include "core/container/vector.h"
+#include "ast.h"
+
+//Register bytecode for Notec. Int and float values live in separate register files, so every
+//opcode knows the type of its operands and the interpreter never checks the type of a value.
+//An instruction is 32 bits, the opcode and either three registers a, b, c or a register a and a 16 bit bx.
+//Jumps are relative to the instruction after them. The Test opcodes compare a and b and skip the next
+//instruction, always a jump, unless the result equals c, so a condition and its branch take one dispatch
+#define NOTEC_OPCODES(X) \
+    X(LoadInt) X(LoadIntImm) X(LoadFloat) \
+    X(MovInt) X(MovFloat) X(IntToFloat) X(FloatToInt) \
+    X(AddInt) X(AddIntImm) X(SubInt) X(MulInt) X(DivInt) X(ModInt) X(NegInt) \
+    X(AddFloat) X(SubFloat) X(MulFloat) X(DivFloat) X(NegFloat) \
+    X(LtInt) X(LteInt) X(EqInt) X(NeqInt) \
+    X(LtFloat) X(LteFloat) X(EqFloat) X(NeqFloat) \
+    X(Jump) X(JumpIfZero) X(JumpIfNotZero) \
+    X(TestLtInt) X(TestLteInt) X(TestEqInt) X(TestNeqInt) \
+    X(TestLtFloat) X(TestLteFloat) X(TestEqFloat) X(TestNeqFloat) \
+    X(CallFloat) X(PrintInt) X(PrintFloat) \
+    X(ReturnInt) X(ReturnFloat) X(Return)
+
+#define NOTEC_OPCODE_ENUM(name) name,
+
+enum class Opcode : u8 {
+    NOTEC_OPCODES(NOTEC_OPCODE_ENUM)
+    Count
+};
+
+struct Instruction {
+    Opcode op;
+    u8 a;
+    u8 b;
+    u8 c;
+
+    uint bx() const { return b | c << 8; }
+    int sbx() const { return (short)(b | c << 8); }
+};
+
+const uint MAX_REGISTERS = 256;
+
+struct Bytecode {
+    vector<Instruction> code;
+    vector<uint> locs; //source offset of every instruction, for runtime errors
+    vector<i64> int_constants;
+    vector<double> float_constants;
+    uint int_registers = 0;
+    uint float_registers = 0;
+};
+
+struct Value {
+    ValueType type;
+    union {
+        i64 int_value;
+        double float_value;
+    };
+};
+
+//Unary float functions that can be called from Notec, indexed by the c operand of CallFloat
+struct Builtin {
+    const char* name;
+    double (*func)(double);
+};
+
+slice<Builtin> get_builtins();
+
+//Integer arithmetic wraps and division by -1 never traps, the bytecode, the constant folding and
+//the AST interpreter all use these so they agree on every result
+inline i64 add_int(i64 a, i64 b) { return (i64)((u64)a + (u64)b); }
+inline i64 sub_int(i64 a, i64 b) { return (i64)((u64)a - (u64)b); }
+inline i64 mul_int(i64 a, i64 b) { return (i64)((u64)a * (u64)b); }
+inline i64 neg_int(i64 a) { return (i64)(0 - (u64)a); }
+inline i64 div_int(i64 a, i64 b) { return b == -1 ? neg_int(a) : a / b; }
+inline i64 mod_int(i64 a, i64 b) { return b == -1 ? 0 : a % b; }
+
+//Constant sub expressions are folded and branches on constant conditions are dropped. Notec is statically
+//typed, so a type error fails the cell even in a branch that is dropped or a loop that never runs
+bool compile_ast(Bytecode& bytecode, AstModule& module, Diagnostic* error);
+//Integer division by zero is the only runtime error
+bool run_bytecode(const Bytecode& bytecode, Value* result, Diagnostic* error);
+void dump_bytecode(const Bytecode& bytecode);
@@ -2,24 +2,27 @@
 
 #include "core/core.h"
 #include "ui/ui.h"
-#include "gap.h"
+#include "rope.h"
+#include "line_index.h"
 
 struct Lexer;
 
+const uint MAX_UNDO = 256;
+
+//Text and cursor before an edit, the text shares everything the edit did not change
+struct UndoState {
+    Rope text;
+    uint cursor;
+};
+
 struct CodeBlockState {
     Lexer* lexer;
     
-    GapBuffer buffer;
-    
-    uint lines = 1;
-    
-    uint cursor_line;
-    uint cursor_column;
+    Rope text;
+    LineIndex line_index;
+    vector<UndoState> undo;
     
-    uint visible_line_begin;
-    uint visible_line_end;
-    uint visible_begin;
-    uint visible_end;
+    uint cursor;
 };
 
 struct CodeBlockView : UIView {
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "core/container/string_view.h"
+#include "bytecode.h"
+
+//Lexes, parses, compiles and runs a cell, then prints its result or the first error
+void execute(string_view src);
+
+//Walks the AST directly, looking variables up by symbol. Kept as the reference the bytecode is checked
+//and measured against, results are the same as run_bytecode. The types are checked before it runs, like compile_ast does
+bool eval_ast(AstModule& module, Value* result, Diagnostic* error);
+
+//Runs a set of programs with both interpreters and prints the time each took
+void benchmark_interpreter();
+//Parses a large cell a few times and prints the best time
+void benchmark_parser();
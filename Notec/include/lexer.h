@@ -29,6 +29,7 @@ struct Token {
         Op_Add, Op_Sub, Op_Mul, Op_Div, Op_Mod, Op_Gt, Op_Lt,
         Assign_Add, Assign_Sub, Assign_Mul, Assign_Div, Assign_Mod, Op_Gte, Op_Lte,
         Assign,
+        Op_Eq, Op_Neq,
         Struct, Class,
         Template, Typename,
         Namespace,
@@ -70,10 +71,15 @@ struct Token {
     };
 };
 
+//What the lexer was in the middle of at the end of a line, the only state carried from one line to the next
+enum class LexState : u8 { Code, String };
+
 struct Lexer;
 
 Lexer* make_lexer();
 void destroy_lexer(Lexer*);
 
 slice<Token> lex_src(Lexer& lex, string_view src);
-void init_lexer_tables();
+//Lexes a single line, including its newline, starting in the state the previous line ended in.
+//Token::loc is relative to the start of the line and no End_Of_File token is added
+slice<Token> lex_line(Lexer& lex, string_view line, LexState* state);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "core/core.h"
+#include "core/container/vector.h"
+#include "lexer.h"
+
+struct Rope;
+
+//Enough to color a line, the value of the token is not kept
+struct LineToken {
+    Token::Type type;
+    uint end; //column after the last character of the token
+};
+
+struct Line {
+    LexState state; //lexer state at the start of the line, lexing resumes from it
+    bool dirty;
+    vector<LineToken> tokens;
+};
+
+//Cached tokens of every line, kept in step with the rope on each edit instead of being rebuilt from the text.
+//Edited lines are marked dirty and lexed again when they are needed, the lines after them
+//only while the state they start in changed. Line offsets come from the rope
+struct LineIndex {
+    vector<Line> lines;
+    uint first_dirty;
+};
+
+//The line was edited, the removed lines after it were joined into it and the added lines follow it
+void update_lines(LineIndex& index, uint line, uint removed, uint added);
+//Forgets every cached line, for when the whole text was replaced
+void reset_lines(LineIndex& index, uint line_count);
+
+//Lexes the dirty lines before end_line again
+void update_line_tokens(LineIndex& index, Lexer& lexer, Rope& text, uint end_line);
@@ -3,12 +3,8 @@
 #include "core/container/slice.h"
 
 struct Token;
-struct AST;
 struct AstModule;
+struct Diagnostic;
 
-struct Parser;
-
-Parser* make_parser();
-void destroy_parser(Parser*);
-
-AST* parse_tokens(AstModule&, slice<Token> tokens);
+//Replaces the nodes of the module, the root block is set as its root. Fills in the error on failure
+bool parse_tokens(AstModule&, slice<Token> tokens, Diagnostic* error);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "core/core.h"
+#include "core/container/string_view.h"
+
+//Largest leaf, edits that stay inside a leaf only copy it and the path to it
+const uint ROPE_CHUNK = 512;
+
+struct RopeNode;
+
+//Text stored as a balanced tree of chunks, every node knows the length and the number of newlines below it.
+//Nodes are never modified once built, an edit copies the path to the leaves it changes and shares everything else,
+//so a snapshot for undo or for lexing on another thread is a reference to the root
+struct Rope {
+    RopeNode* root;
+};
+
+Rope make_rope(string_view text);
+//Shares the text, later edits to either rope do not affect the other
+Rope snapshot(Rope& rope);
+void destroy_rope(Rope& rope);
+
+uint text_length(Rope& rope);
+char char_at(Rope& rope, uint offset);
+
+uint line_count(Rope& rope);
+//The line the offset is on, a newline belongs to the line it ends
+uint line_of_offset(Rope& rope, uint offset);
+uint line_start(Rope& rope, uint line);
+//Offset one past the newline of the line, or the length of the text for the last line
+uint line_end(Rope& rope, uint line);
+
+void insert_text(Rope& rope, uint offset, string_view text);
+void remove_text(Rope& rope, uint offset, uint length);
+
+//Text from the offset to the end of the chunk that contains it, chunks are walked by advancing the offset by its length
+string_view rope_chunk(Rope& rope, uint offset);
+//Points into the chunk when the range does not cross into the next one, otherwise copies into temporary memory
+string_view copy_temporary_text(Rope& rope, uint begin, uint end);
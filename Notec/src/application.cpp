@@ -13,15 +13,12 @@
 
 #include "lexer.h"
 #include "ast.h"
-#include "gap.h"
 #include "code_block.h"
 
 struct Notec {
     UI* ui;
     UIRenderer* ui_renderer;
     
-    GapBuffer gap;
-    
     Lexer* lexer;
     CodeBlockState state;
     
@@ -70,8 +67,6 @@ APPLICATION_API Notec* init(void* args, Modules& engine) {
     notec->ast_module = make_ast_module(notec->ast_pool);
     notec->state.lexer = notec->lexer;
     
-    init_lexer_tables();
-    
     load_font(*notec->ui, "fonts/RobotoMono-VariableFont_wght.ttf");
     set_theme(get_ui_theme(*notec->ui));
     
@@ -87,7 +82,7 @@ APPLICATION_API Notec* init(void* args, Modules& engine) {
 }
 
 APPLICATION_API void reload(Notec& app, Modules& modules) {
-    init_lexer_tables();
+    
 }
 
 APPLICATION_API bool is_running(Notec& app, Modules& modules) {
@@ -1,106 +1,142 @@
 #include "ast.h"
 #include <stdlib.h>
+#include <string.h>
 #include "core/memory/linear_allocator.h"
 
-#define MALLOC(T, n) (T*)malloc(sizeof(T) * n)
-#define CALLOC(T, n) (T*)calloc(n, sizeof(T))
-
-const uint MAX_SYMBOLS_PER_BLOCK = 10000;
-
+//Every name followed by a null in one array, found through an open addressing table
 struct SymbolTable {
-    struct SymbolBlock {
-        char names[MAX_SYMBOLS_PER_BLOCK][100];
-    };
-    
-    uint num_blocks;
-    SymbolBlock* blocks;
-};
-
-struct AstModule {
-    AST* blocks;
-    AST* free_chain;
-    AST* root;
-    AstPool* pool;
-    AstModule* next;
+    vector<char> names;
+    vector<uint> offsets; //into names, indexed by symbol
+    vector<uint> slots; //symbol + 1, or 0 when empty
 };
 
 struct AstPool {
+    SymbolTable symbols;
     AstModule* free_module;
-    AST* free_block;
 };
 
+uint symbol_hash(const char* name, uint length) {
+    uint hash = 2166136261u;
+    for (uint i = 0; i < length; i++) hash = (hash ^ (u8)name[i]) * 16777619u;
+    return hash;
+}
+
+//Keeps at most half of the slots used, so probes stay short
+void grow_symbol_slots(SymbolTable& table) {
+    uint capacity = table.slots.length ? table.slots.length * 2 : 256;
+    table.slots.clear();
+    table.slots.resize(capacity);
+
+    for (uint symbol = 0; symbol < table.offsets.length; symbol++) {
+        const char* name = table.names.data + table.offsets[symbol];
+        uint slot = symbol_hash(name, strlen(name)) & (capacity - 1);
+        while (table.slots[slot]) slot = (slot + 1) & (capacity - 1);
+        table.slots[slot] = symbol + 1;
+    }
+}
+
+symbol_handle intern_symbol(AstModule& module, string_view name) {
+    SymbolTable& table = module.pool->symbols;
+    if ((table.offsets.length + 1) * 2 > table.slots.length) grow_symbol_slots(table);
+
+    uint mask = table.slots.length - 1;
+    uint slot = symbol_hash(name.data, name.length) & mask;
+
+    for (; table.slots[slot]; slot = (slot + 1) & mask) {
+        symbol_handle symbol = table.slots[slot] - 1;
+        const char* existing = table.names.data + table.offsets[symbol];
+        if (strncmp(existing, name.data, name.length) == 0 && existing[name.length] == '\0') return symbol;
+    }
+
+    symbol_handle symbol = table.offsets.length;
+    uint offset = table.names.length;
+    table.offsets.append(offset);
+    table.names.resize(offset + name.length + 1);
+    memcpy(table.names.data + offset, name.data, name.length);
+    table.names[offset + name.length] = '\0';
+
+    table.slots[slot] = symbol + 1;
+    return symbol;
+}
+
+//Only valid until the next name is interned
+const char* symbol_name(AstModule& module, symbol_handle symbol) {
+    SymbolTable& table = module.pool->symbols;
+    return table.names.data + table.offsets[symbol];
+}
+
 AstPool* make_ast_pool() {
-    AstPool* pool = PERMANENT_ALLOC(AstPool, {});
+    AstPool* pool = PERMANENT_ALLOC(AstPool);
     return pool;
 }
 
-void destroy_ast_pool(AstPool*) {
-    
+void destroy_ast_pool(AstPool* pool) {
+    while (AstModule* module = pool->free_module) {
+        pool->free_module = module->next;
+        for (AST* chunk : module->chunks) free(chunk);
+        module->~AstModule();
+    }
+    pool->~AstPool();
 }
 
 AstModule* make_ast_module(AstPool* pool) {
-    AstModule* code = pool->free_module;
-    if (!code) {
-        const uint AST_MODULE_BLOCK = 10;
-        
-        AstModule* block = PERMANENT_ARRAY(AstModule, AST_MODULE_BLOCK);
-        memset(block, 0, sizeof(AstModule)*AST_MODULE_BLOCK);
-        for (uint i = 2; i < AST_MODULE_BLOCK-1; i++) {
-            block[i].next = block[i+1].next;
-        }
-        code = block+1; //todo avoid wasting one AstModule each time
-    } else {
-        pool->free_module = code->next;
-    }
-    return code;
+    AstModule* module = pool->free_module;
+    if (module) pool->free_module = module->next;
+    else module = PERMANENT_ALLOC(AstModule);
+
+    module->pool = pool;
+    module->next = nullptr;
+    reset_ast_module(*module);
+    return module;
+}
+
+//Node 0 is never handed out, so that handle can mean no node
+void reset_ast_module(AstModule& module) {
+    module.node_count = 1;
+    module.children.length = 0;
+    module.pending.length = 0;
+    module.root = 0;
+}
+
+void destroy_ast_module(AstModule* module) {
+    module->next = module->pool->free_module;
+    module->pool->free_module = module;
 }
 
 AST* get_root(AstModule& module) {
-    return module.root;
+    return get_node(module, module.root);
 }
 
-void destroy_ast_module(AstModule* code) {
-    while (code->blocks) {
-        AST* block = code->blocks;
-        block->free_next = code->pool->free_block;
-        code->pool->free_block = block;
-    }
-    code->next = code->pool->free_module;
-    code->pool->free_module = code;
+void set_root(AstModule& module, ast_handle root) {
+    module.root = root;
 }
 
-const uint AST_BLOCK_CHUNK = 1024;
-
-AST* make_ast_node(AstModule& code, AST::Type type) {
-    AST* node = code.free_chain;
-    if (!node) {
-        AST* block = code.pool->free_block;
-        if (!block) {
-            block = PERMANENT_ARRAY(AST, AST_BLOCK_CHUNK);
-            memset(block, 0, sizeof(AST)*AST_BLOCK_CHUNK);
-        } else {
-            code.pool->free_block = block->free_next;
-        }
-            
-        block->free_next = code.blocks;
-        code.blocks = block;
-        
-        code.free_chain = block + 2;
-        for (uint i = 2; i < AST_BLOCK_CHUNK-1; i++) {
-            block[i].free_next = block[i+1].free_next;
-        }
-            
-        node = block+1;
-    } else {
-        code.free_chain = node->free_next;
+ast_handle make_ast_node(AstModule& module, AST::Type type, Location loc) {
+    if (module.node_count >= module.chunks.length * AST_CHUNK) {
+        module.chunks.append((AST*)malloc(sizeof(AST) * AST_CHUNK));
     }
-    
-    *node = {type};
-    return node;
+
+    ast_handle handle = module.node_count++;
+    AST* node = get_node(module, handle);
+    memset(node, 0, sizeof(AST));
+    node->type = type;
+    node->loc = loc;
+    return handle;
 }
 
-void destroy_ast_node(AstModule& code, AST* ast) {
-    ast->free_next = code.free_chain;
-    code.free_chain = ast;
+ast_handle make_op_node(AstModule& module, Operator::Type type, ast_handle left, ast_handle right, Location loc) {
+    ast_handle handle = make_ast_node(module, AST::Operator, loc);
+    AST* node = get_node(module, handle);
+    node->op.type = type;
+    node->op.left = left;
+    node->op.right = right;
+    return handle;
 }
 
+//Nested blocks finish before the block around them, so their children are always at the end of pending
+uint commit_children(AstModule& module, uint begin) {
+    uint first = module.children.length;
+    module.children += slice<ast_handle>(module.pending.data + begin, module.pending.length - begin);
+    module.pending.length = begin;
+    return first;
+}
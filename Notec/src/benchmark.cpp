@@ -0,0 +1,153 @@
+#include "interpreter.h"
+#include "lexer.h"
+#include "parser.h"
+#include "core/time.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+struct BenchmarkProgram {
+    const char* name;
+    const char* src;
+};
+
+BenchmarkProgram benchmark_programs[] = {
+    { "int loop",
+        "int sum = 0;\n"
+        "int i = 0;\n"
+        "while (i < 1000000) {\n"
+        "    sum = sum + i * 3 % 7;\n"
+        "    i = i + 1;\n"
+        "}\n"
+        "sum" },
+    { "float loop",
+        "double x = 0.0;\n"
+        "for (int i = 0; i < 1000000; i += 1) {\n"
+        "    x = x + 1.5 * i / 3.0;\n"
+        "}\n"
+        "x" },
+    { "collatz",
+        "int steps = 0;\n"
+        "for (int n = 1; n < 20000; n += 1) {\n"
+        "    int k = n;\n"
+        "    while (k != 1) {\n"
+        "        if (k % 2 == 0) k = k / 2;\n"
+        "        else k = 3 * k + 1;\n"
+        "        steps += 1;\n"
+        "    }\n"
+        "}\n"
+        "steps" },
+    { "constant folding",
+        "int total = 0;\n"
+        "for (int i = 0; i < 1000000; i += 1) {\n"
+        "    total += i * (60 * 60 * 24) / (4 * 2 - 4) - (1 + 2 + 3);\n"
+        "}\n"
+        "total" },
+    { "builtins",
+        "double acc = 0.0;\n"
+        "for (int i = 1; i <= 200000; i += 1) {\n"
+        "    acc += sqrt(i) * sin(i * 0.001);\n"
+        "}\n"
+        "acc" },
+};
+
+const uint BENCHMARK_RUNS = 5;
+
+bool same_value(Value a, Value b) {
+    if (a.type != b.type) return false;
+    if (a.type == ValueType::Int) return a.int_value == b.int_value;
+    if (a.type == ValueType::Float) return a.float_value == b.float_value;
+    return true;
+}
+
+//Best of a few runs, the programs are parsed and compiled once and only execution is timed
+void benchmark_interpreter() {
+    Lexer* lexer = make_lexer();
+    AstPool* pool = make_ast_pool();
+
+    printf("%-18s %14s %14s %8s\n", "program", "ast (ms)", "bytecode (ms)", "speedup");
+
+    for (BenchmarkProgram& program : benchmark_programs) {
+        AstModule* module = make_ast_module(pool);
+        Diagnostic error = {};
+        Bytecode bytecode;
+
+        bool parsed = parse_tokens(*module, lex_src(*lexer, program.src), &error);
+        if (!parsed || !compile_ast(bytecode, *module, &error)) {
+            printf("%-18s failed to compile: %s\n", program.name, error.message);
+            destroy_ast_module(module);
+            continue;
+        }
+
+        double ast_time = 1e9;
+        double bytecode_time = 1e9;
+        Value ast_result, bytecode_result;
+        bool ok = true;
+
+        for (uint run = 0; run < BENCHMARK_RUNS && ok; run++) {
+            double start = Time::now();
+            ok &= eval_ast(*module, &ast_result, &error);
+            double middle = Time::now();
+            ok &= run_bytecode(bytecode, &bytecode_result, &error);
+            double end = Time::now();
+
+            ast_time = fmin(ast_time, middle - start);
+            bytecode_time = fmin(bytecode_time, end - middle);
+        }
+
+        if (!ok) printf("%-18s failed: %s\n", program.name, error.message);
+        else if (!same_value(ast_result, bytecode_result)) printf("%-18s results differ\n", program.name);
+        else printf("%-18s %14.2f %14.2f %7.1fx\n", program.name, ast_time * 1000, bytecode_time * 1000, ast_time / bytecode_time);
+
+        destroy_ast_module(module);
+    }
+
+    destroy_lexer(lexer);
+    destroy_ast_pool(pool);
+}
+
+const uint PARSER_BENCHMARK_COPIES = 200;
+
+void append_text(vector<char>& text, const char* str) {
+    text += slice<char>((char*)str, strlen(str));
+}
+
+//Parses one large cell made of every program, each in its own block. The module is parsed again
+//in place every run, so after the first run its nodes come from memory it already owns
+void benchmark_parser() {
+    Lexer* lexer = make_lexer();
+    AstPool* pool = make_ast_pool();
+    AstModule* module = make_ast_module(pool);
+
+    vector<char> src;
+    for (uint copy = 0; copy < PARSER_BENCHMARK_COPIES; copy++) {
+        for (BenchmarkProgram& program : benchmark_programs) {
+            append_text(src, "{\n");
+            append_text(src, program.src);
+            append_text(src, ";\n}\n");
+        }
+    }
+
+    slice<Token> tokens = lex_src(*lexer, { src.data, src.length });
+
+    double parse_time = 1e9;
+    bool ok = true;
+
+    for (uint run = 0; run < BENCHMARK_RUNS && ok; run++) {
+        Diagnostic error = {};
+        double start = Time::now();
+        ok = parse_tokens(*module, tokens, &error);
+        parse_time = fmin(parse_time, Time::now() - start);
+
+        if (!ok) printf("parser failed: %s\n", error.message);
+    }
+
+    if (ok) {
+        printf("parsed %u bytes, %u tokens into %u nodes in %.2f ms, %.1f MB/s\n", src.length, tokens.length, module->node_count,
+            parse_time * 1000, src.length / parse_time / 1e6);
+    }
+
+    destroy_ast_module(module);
+    destroy_lexer(lexer);
+    destroy_ast_pool(pool);
+}
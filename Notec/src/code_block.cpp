@@ -15,7 +15,7 @@
 #include "ui/draw.h"
 
 #include "code_block.h"
-#include "gap.h"
+#include "rope.h"
 #include "lexer.h"
 
 CodeBlockView code_block(UI& ui, CodeBlockState* state) {
@@ -38,7 +38,7 @@ struct CodeBlockLayedOutView : LayedOutUIView {
 
 LayedOutUIView& CodeBlockView::compute_layout(UI &ui, const BoxConstraint& constraint) {
     CodeBlockState& state = *this->state;
-    uint num_lines = state.lines;
+    uint num_lines = line_count(state.text);
     
     float font_size;
     glm::vec2 font_scale;
@@ -64,41 +64,50 @@ LayedOutUIView& CodeBlockView::compute_layout(UI &ui, const BoxConstraint& const
     return result;
 }
 
-uint find_line(GapBuffer& buffer, uint target, uint current_line, uint start) {
-    if (target == current_line) return start;
+void execute(string_view str);
+
+//Every edit goes through here, so the line index follows the text and the edit can be undone
+void replace_text(CodeBlockState& state, uint offset, uint length, string_view text) {
+    Rope& rope = state.text;
+    
+    if (state.undo.length == MAX_UNDO) {
+        destroy_rope(state.undo[0].text);
+        memmove(state.undo.data, state.undo.data + 1, sizeof(UndoState) * (MAX_UNDO - 1));
+        state.undo.length--;
+    }
+    state.undo.append({ snapshot(rope), state.cursor });
     
-    int dir = target > current_line ? 1 : -1;
+    uint line = line_of_offset(rope, offset);
+    uint removed = line_of_offset(rope, offset + length) - line;
     
-    for (int i = start; i >= 0 && i < buffer.length; i += dir) {
-        if (buffer.buffer[i] == '\n') {
-            current_line += dir;
-            if (current_line == target) return i;
-        }
-    }
+    remove_text(rope, offset, length);
+    insert_text(rope, offset, text);
     
-    return dir==1 ? buffer.length : 0;
-}
-
-string_view copy_temporary_contigous_chunk(GapBuffer& buffer, uint begin, uint end) {
-    if (buffer.gap_end < begin || buffer.gap_begin > end) {
-        return {buffer.buffer + begin, end-begin};
-    }
+    uint added = 0;
+    for (uint i = 0; i < text.length; i++) added += text[i] == '\n';
     
-    uint len = (end-begin) - (buffer.gap_end-buffer.gap_begin);
-    char* contigous = TEMPORARY_ARRAY(char, len+1);
+    update_lines(state.line_index, line, removed, added);
+    state.cursor = offset + text.length;
+}
 
-    memcpy(contigous, buffer.buffer + begin, buffer.gap_begin-begin);
-    memcpy(contigous+(buffer.gap_begin-begin), buffer.buffer + buffer.gap_end, end-buffer.gap_end);
+void undo(CodeBlockState& state) {
+    if (state.undo.length == 0) return;
     
-    contigous[len] = '\0';
+    UndoState& last = state.undo.last();
+    destroy_rope(state.text);
+    state.text = last.text;
+    state.cursor = last.cursor;
+    state.undo.length--;
     
-    return {contigous, len};
+    reset_lines(state.line_index, line_count(state.text));
 }
 
-void execute(string_view str);
+void insert(CodeBlockState& state, char c) {
+    replace_text(state, state.cursor, 0, {&c, 1});
+}
 
 void insert_tab(CodeBlockState& state) {
-    for (uint i = 0; i < 4; i++) insert_char(state.buffer, ' ');
+    replace_text(state, state.cursor, 0, "    ");
 }
 
 void indent(CodeBlockState& state) {
@@ -106,75 +115,66 @@ void indent(CodeBlockState& state) {
 }
 
 void insert_newline(CodeBlockState& state) {
-    insert_char(state.buffer, '\n');
-    state.cursor_line++;
-    state.lines++;
+    char last = char_at(state.text, state.cursor - 1);
+    insert(state, '\n');
     
-    char last = state.buffer.buffer[max(0,(int)state.buffer.gap_begin-2)];
     if (last == '{') {
         insert_tab(state);
-        int cursor = state.buffer.gap_begin;
+        uint cursor = state.cursor;
         insert_newline(state);
-        insert_char(state.buffer, '}');
-        move_cursor(state.buffer, cursor-state.buffer.gap_begin);
+        insert(state, '}');
+        state.cursor = cursor;
     }
 }
 
-uint determine_column(GapBuffer& buffer, uint start) {
-    if (start >= buffer.length) return 0;
-        
-    uint column = 0;
-    for (int i = start; i >= 0; i--) {
-        if (i >= buffer.gap_begin && i < buffer.gap_end) i = buffer.gap_begin;
-        else if (buffer.buffer[i] == '\n') break;
-        else column++;
-    }
-    return column;
+//Length of the line without its newline
+uint line_length(Rope& text, uint line) {
+    uint start = line_start(text, line);
+    uint end = line_end(text, line);
+    if (end > start && char_at(text, end - 1) == '\n') end--;
+    return end - start;
 }
 
-uint determine_line_end(GapBuffer& buffer, uint start, uint max = 0) {
-    if (max == 0 || max > buffer.length) max = buffer.length;
-
-    for (int i = start; i < max; i++) {
-        if (i >= buffer.gap_begin && i < buffer.gap_end) i = buffer.gap_end-1;
-        else if (buffer.buffer[i] == '\n') return i;
-    }
-    return max;
+void move_to_line(CodeBlockState& state, uint line) {
+    Rope& text = state.text;
+    uint column = state.cursor - line_start(text, line_of_offset(text, state.cursor));
+    
+    state.cursor = line_start(text, line) + min(column, line_length(text, line));
 }
 
 bool handle_key_input(CodeBlockState& state, Input& input) {
-    bool edit = false;
+    Rope& text = state.text;
+    
     if (input.key_pressed(Key::Backspace)) {
-        state.cursor_column--;
-        remove_char(state.buffer);
+        if (state.cursor > 0) replace_text(state, state.cursor - 1, 1, {});
         return true;
     }
     
-    GapBuffer& buffer = state.buffer;
+    if (input.key_pressed(Key::Z, ModKeys::Control)) {
+        undo(state);
+        return true;
+    }
     
     if (input.key_pressed(Key::Enter, ModKeys::Control)) {
-        execute(copy_temporary_contigous_chunk(state.buffer, 0, state.buffer.length));
+        execute(copy_temporary_text(text, 0, text_length(text)));
     }
     
-    if (input.key_pressed(Key::Left)) {
-        move_cursor(state.buffer, -1);
+    if (input.key_pressed(Key::Left) && state.cursor > 0) {
+        state.cursor--;
     }
     
-    if (input.key_pressed(Key::Right)) {
-        move_cursor(state.buffer, 1);
+    if (input.key_pressed(Key::Right) && state.cursor < text_length(text)) {
+        state.cursor++;
     }
     
     if (input.key_pressed(Key::L, ModKeys::Control)) {
-        uint column = determine_column(buffer, buffer.gap_begin-1);
-        uint end = determine_line_end(buffer, buffer.gap_end);
-        
-        buffer.gap_begin -= column;        
-        buffer.gap_end = end;
-        if (buffer.gap_end < buffer.length) buffer.gap_end++;
+        uint line = line_of_offset(text, state.cursor);
+        uint start = line_start(text, line);
+        replace_text(state, start, line_end(text, line) - start, {});
     }
     
-    if (input.key_pressed(Key::M, ModKeys::Control) && buffer.gap_begin>0) {
-        char c = buffer.buffer[buffer.gap_begin-1];
+    if (input.key_pressed(Key::M, ModKeys::Control) && state.cursor > 0) {
+        char c = char_at(text, state.cursor - 1);
         char opp = '\0';
         int dir = 0;
         
@@ -188,40 +188,28 @@ bool handle_key_input(CodeBlockState& state, Input& input) {
         if (c == ']') opp = '[', dir = -1;
         
         int count = 0;
-            
+        
         if (opp) {
-            int i = buffer.gap_begin-1;
-            for (; i >= 0 && i < buffer.length; i += dir) {
-                if (i >= buffer.gap_begin && i < buffer.gap_end) i = (dir==1 ? buffer.gap_end-1 : buffer.gap_begin);
-                else if (buffer.buffer[i] == c) count++;
-                else if (buffer.buffer[i] == opp && --count == 0) break;
-            }
-            
-            if (i != buffer.gap_begin) {
-                move_cursor(buffer, dir==1 ? i+1-buffer.gap_end : i-buffer.gap_begin+1);
+            int length = text_length(text);
+            for (int i = state.cursor - 1; i >= 0 && i < length; i += dir) {
+                char at = char_at(text, i);
+                if (at == c) count++;
+                else if (at == opp && --count == 0) {
+                    state.cursor = i + 1;
+                    break;
+                }
             }
         }
     }
     
     if (input.key_pressed(Key::Up)) {
-        int cursor = buffer.gap_begin-1;
-        int target = determine_column(buffer, cursor);
-        
-        if (cursor-target > 0) {
-            uint column = determine_column(buffer, cursor - target - 1);
-            move_cursor(state.buffer, -target - 1 - max(column - target,0));
-        }
+        uint line = line_of_offset(text, state.cursor);
+        if (line > 0) move_to_line(state, line - 1);
     }
     
     if (input.key_pressed(Key::Down)) {
-        int cursor = buffer.gap_begin;
-        int column = determine_column(buffer, cursor);
-        int newline = determine_line_end(buffer, cursor)+1;
-        
-        if (newline < buffer.length) {
-            int target = determine_line_end(buffer, newline, newline+column); //ensures that we do not move past the line
-            move_cursor(state.buffer, target - cursor - (buffer.gap_end-buffer.gap_begin));
-        }
+        uint line = line_of_offset(text, state.cursor);
+        if (line + 1 < line_count(text)) move_to_line(state, line + 1);
     }
     
     uint c = input.last_key;
@@ -233,14 +221,32 @@ bool handle_key_input(CodeBlockState& state, Input& input) {
     if (input.key_pressed(Key::Tab)) insert_tab(state);
     
     if (c != 0 && c < 256) {
-        state.cursor_column++;
-        edit = true;
-        insert_char(state.buffer, c);
+        insert(state, c);
     }
     
     return true;
 }
 
+Color token_color(Token::Type type) {
+    Color color = white;
+    if (Token::Keyword_Begin <= type && type <= Token::Keyword_End) {
+        color = color4(255,0,100);
+    }
+    if (Token::Number_Begin <= type && type <= Token::Number_End) {
+        color = color4(255,230,0);
+    }
+    else if (Token::Preprocessor_Begin <= type && type <= Token::Preprocessor_End) {
+        color = color4(255, 200, 100);
+    }
+    else if (type == Token::Identifier) {
+        color = color4(255,255,255);
+    }
+    else if (type == Token::String) {
+        color = color4(255, 150, 100);
+    }
+    return color;
+}
+
 bool CodeBlockLayedOutView::render(UI& ui, LayedOutUIView& parent) {
     to_absolute_position(geo, parent);
     
@@ -250,23 +256,10 @@ bool CodeBlockLayedOutView::render(UI& ui, LayedOutUIView& parent) {
     
     float yoffset = rect.pos.y - geo.inner.pos.y;
     
-    uint line_begin = yoffset / line_height;
-    uint line_end = line_begin + ceilf(rect.size.y / line_height);
-    
     CodeBlockState& state = *this->state;
     
-    GapBuffer& buffer = state.buffer;
-
-    uint begin = 0;
-    //find_line(buffer, line_begin, state.visible_line_begin, state.visible_begin);
-    uint end = buffer.length;
-    //find_line(buffer, line_end, state.visible_line_end, state.visible_end);
-    
-    string_view src = copy_temporary_contigous_chunk(buffer, begin, end);
-    
-    auto tokens = lex_src(*state.lexer, src);
-    uint curr = 0;
-    
+    Rope& text = state.text;
+    LineIndex& index = state.line_index;
     
     Input& input = get_input(ui);
     
@@ -275,13 +268,18 @@ bool CodeBlockLayedOutView::render(UI& ui, LayedOutUIView& parent) {
         handle_key_input(state, input);
     }
     
+    //only the visible lines are lexed and drawn
+    uint visible_begin = max(0, (int)(yoffset / line_height));
+    uint visible_end = min(visible_begin + (uint)ceilf(rect.size.y / line_height) + 1, line_count(text));
+    
+    update_line_tokens(index, *state.lexer, text, visible_end);
+    
     float line_number_width = 50*font_scale.x;
     float margin = 100*font_scale.x;
     
     glm::vec2 pos = geo.inner.pos;
     pos.x += margin;
-    
-    uint line = 1;
+    pos.y += visible_begin * line_height;
     
     auto draw_line_number = [&](uint n) {
         glm::vec4 line_color = color4(150,150,150);
@@ -297,63 +295,43 @@ bool CodeBlockLayedOutView::render(UI& ui, LayedOutUIView& parent) {
     };
     
     auto draw_cursor = [&](uint i) {
-        if (i == state.buffer.gap_begin) { //cursor
+        if (i == state.cursor) {
             draw_quad(cmd_buffer, pos + glm::vec2(0,(0.9/2.0)*line_height), glm::vec2(2.0*font_scale.x,12), white);
         }
     };
     
-    draw_line_number(1);
-    
-    uint i = 0;
-    for (; i < src.length; i++) {
-        while (tokens[curr].loc<i) {
-            if (curr+1 < tokens.length) curr++;
-            else break;
-        }
+    for (uint line = visible_begin; line < visible_end; line++) {
+        uint start = line_start(text, line);
+        string_view src = copy_temporary_text(text, start, line_end(text, line));
+        slice<LineToken> tokens = index.lines[line].tokens;
+        uint curr = 0;
         
-        Token& token = tokens[curr];
+        pos.x = geo.inner.pos.x + margin;
+        draw_line_number(line + 1);
         
-        Color color = white;
-        if (Token::Keyword_Begin <= token.type && token.type <= Token::Keyword_End) {
-            color = color4(255,0,100);
-        }
-        if (Token::Number_Begin <= token.type && token.type <= Token::Number_End) {
-            color = color4(255,230,0);
-        }
-        else if (Token::Preprocessor_Begin <= token.type && token.type <= Token::Preprocessor_End) {
-            color = color4(255, 200, 100);
-        }
-        else if (token.type == Token::Identifier) {
-            color = color4(255,255,255);
-        }
-        else if (token.type == Token::String) {
-            color = color4(255, 150, 100);
-        }
-        
-        if (src[i] == '\n') {
-            draw_cursor(i);
-            pos.x = geo.inner.pos.x + margin;
-            pos.y += line_height;
+        uint i = 0;
+        for (; i < src.length && src[i] != '\n'; i++) {
+            while (curr+1 < tokens.length && tokens[curr].end <= i) curr++;
+            
+            Color color = tokens.length > 0 ? token_color(tokens[curr].type) : white;
+            
+            Character ch = font->chars[src[i]];
+            
+            float xpos = pos.x + ch.bearing.x * font_scale.x;
+            float ypos = pos.y + (ch.size.y - ch.bearing.y) * font_scale.y;
             
-            draw_line_number(++line);
+            float w = ch.size.x * font_scale.x;
+            float h = ch.size.y * font_scale.y;
+            float advance = (ch.advance >> 6) * font_scale.x;
             
-            continue;
+            draw_cursor(start + i);
+            draw_quad(cmd_buffer, glm::vec2(xpos, ypos - h + line_height), glm::vec2(w, h), font->atlas, color, ch.a, ch.b);
+            pos.x += advance;
         }
+        draw_cursor(start + i);
         
-        Character ch = font->chars[src[i]];
-        
-        float xpos = pos.x + ch.bearing.x * font_scale.x;
-        float ypos = pos.y + (ch.size.y - ch.bearing.y) * font_scale.y;
-        
-        float w = ch.size.x * font_scale.x;
-        float h = ch.size.y * font_scale.y;
-        float advance = (ch.advance >> 6) * font_scale.x;
-        
-        draw_cursor(i);
-        draw_quad(cmd_buffer, glm::vec2(xpos, ypos - h + line_height), glm::vec2(w, h), font->atlas, color, ch.a, ch.b);
-        pos.x += advance;
+        pos.y += line_height;
     }
-    draw_cursor(i);
     
     return false;
 }
@@ -0,0 +1,741 @@
+#include "bytecode.h"
+#include <stdio.h>
+#include <string.h>
+
+const uint NO_JUMP = ~0u;
+
+struct Local {
+    symbol_handle symbol;
+    ValueType type;
+    u8 reg;
+};
+
+//Locals are given a register when they are declared, temporaries are allocated above them and
+//released after every statement, so registers are used like a stack
+struct Compiler {
+    Bytecode& out;
+    AstModule& module;
+    Diagnostic* error;
+    bool failed;
+    uint loc;
+
+    vector<Local> locals;
+    uint scope_begin;
+    uint next_reg[3]; //indexed by ValueType
+    uint max_reg[3];
+
+    bool in_loop;
+    vector<uint> breaks;
+    vector<uint> continues;
+};
+
+//The result of an expression, either folded to a constant or held in a register
+struct Operand {
+    ValueType type;
+    bool is_const;
+    u8 reg;
+    union {
+        i64 int_value;
+        double float_value;
+    };
+};
+
+//Register the result should be written to, when the result has the same type
+struct Dest {
+    ValueType type;
+    int reg;
+};
+
+const Dest NO_DEST = { ValueType::Void, -1 };
+
+void fail(Compiler& c, const char* format, const char* arg = "") {
+    if (c.failed) return;
+    c.failed = true;
+    c.error->loc = { c.loc };
+    snprintf(c.error->message, sizeof(c.error->message), format, arg);
+}
+
+uint emit(Compiler& c, Opcode op, uint a = 0, uint b = 0, uint cc = 0) {
+    c.out.code.append({ op, (u8)a, (u8)b, (u8)cc });
+    c.out.locs.append(c.loc);
+    return c.out.code.length - 1;
+}
+
+uint emit_bx(Compiler& c, Opcode op, uint a, uint bx) {
+    return emit(c, op, a, bx & 0xff, bx >> 8);
+}
+
+uint emit_jump(Compiler& c, Opcode op = Opcode::Jump, uint a = 0) {
+    return emit_bx(c, op, a, 0);
+}
+
+void patch_jump(Compiler& c, uint jump, uint target) {
+    if (jump == NO_JUMP) return;
+
+    int offset = (int)target - (int)(jump + 1);
+    if (offset < -32768 || offset > 32767) return fail(c, "Jump is too far, the cell is too large");
+
+    Instruction& ins = c.out.code[jump];
+    ins.b = (u16)offset & 0xff;
+    ins.c = (u16)offset >> 8;
+}
+
+uint here(Compiler& c) {
+    return c.out.code.length;
+}
+
+u8 alloc_reg(Compiler& c, ValueType type) {
+    uint& next = c.next_reg[(uint)type];
+    if (next >= MAX_REGISTERS) {
+        fail(c, "Expression needs too many registers");
+        return 0;
+    }
+
+    c.max_reg[(uint)type] = max(c.max_reg[(uint)type], next + 1);
+    return next++;
+}
+
+u8 dest_reg(Compiler& c, ValueType type, Dest dest) {
+    return dest.type == type && dest.reg >= 0 ? dest.reg : alloc_reg(c, type);
+}
+
+Operand const_int(i64 value) {
+    Operand result = { ValueType::Int, true };
+    result.int_value = value;
+    return result;
+}
+
+Operand const_float(double value) {
+    Operand result = { ValueType::Float, true };
+    result.float_value = value;
+    return result;
+}
+
+Operand in_reg(ValueType type, u8 reg) {
+    Operand result = { type, false, reg };
+    return result;
+}
+
+template<typename T>
+uint add_constant(Compiler& c, vector<T>& constants, T value) {
+    for (uint i = 0; i < constants.length; i++) {
+        if (memcmp(&constants[i], &value, sizeof(T)) == 0) return i;
+    }
+
+    if (constants.length > 0xffff) fail(c, "Too many constants");
+    constants.append(value);
+    return constants.length - 1;
+}
+
+void load_const(Compiler& c, Operand operand, u8 reg) {
+    if (operand.type == ValueType::Int) {
+        if (operand.int_value >= -32768 && operand.int_value <= 32767) emit_bx(c, Opcode::LoadIntImm, reg, (u16)operand.int_value);
+        else emit_bx(c, Opcode::LoadInt, reg, add_constant(c, c.out.int_constants, operand.int_value));
+    }
+    else {
+        emit_bx(c, Opcode::LoadFloat, reg, add_constant(c, c.out.float_constants, operand.float_value));
+    }
+}
+
+Operand to_reg(Compiler& c, Operand operand, Dest dest = NO_DEST) {
+    if (!operand.is_const) return operand;
+
+    u8 reg = dest_reg(c, operand.type, dest);
+    load_const(c, operand, reg);
+    return in_reg(operand.type, reg);
+}
+
+bool has_value(Compiler& c, Operand operand) {
+    if (operand.type == ValueType::Void) fail(c, "Expression has no value");
+    return !c.failed;
+}
+
+Operand convert(Compiler& c, Operand operand, ValueType type, Dest dest = NO_DEST) {
+    if (operand.type == type || !has_value(c, operand)) return operand;
+
+    if (operand.is_const) {
+        return type == ValueType::Float ? const_float((double)operand.int_value) : const_int((i64)operand.float_value);
+    }
+
+    u8 reg = dest_reg(c, type, dest);
+    emit(c, type == ValueType::Float ? Opcode::IntToFloat : Opcode::FloatToInt, reg, operand.reg);
+    return in_reg(type, reg);
+}
+
+Local* find_local(Compiler& c, symbol_handle symbol) {
+    for (int i = c.locals.length - 1; i >= 0; i--) {
+        if (c.locals[i].symbol == symbol) return &c.locals[i];
+    }
+    return nullptr;
+}
+
+AST* get_node(Compiler& c, ast_handle handle) {
+    return get_node(c.module, handle);
+}
+
+bool is_comparison(Operator::Type op) {
+    return op >= Operator::Lt && op <= Operator::Neq;
+}
+
+//Gt and Gte are Lt and Lte with the operands swapped
+Operator::Type swap_comparison(Operator::Type op, Operand& left, Operand& right) {
+    if (op != Operator::Gt && op != Operator::Gte) return op;
+
+    Operand tmp = left;
+    left = right;
+    right = tmp;
+    return op == Operator::Gt ? Operator::Lt : Operator::Lte;
+}
+
+bool fold_binary(Operator::Type op, Operand l, Operand r, Operand* result) {
+    if (l.type == ValueType::Int) {
+        i64 a = l.int_value;
+        i64 b = r.int_value;
+        switch (op) {
+        case Operator::Add: *result = const_int(add_int(a, b)); return true;
+        case Operator::Sub: *result = const_int(sub_int(a, b)); return true;
+        case Operator::Mul: *result = const_int(mul_int(a, b)); return true;
+        case Operator::Div: if (b == 0) return false; *result = const_int(div_int(a, b)); return true;
+        case Operator::Mod: if (b == 0) return false; *result = const_int(mod_int(a, b)); return true;
+        case Operator::Lt: *result = const_int(a < b); return true;
+        case Operator::Gt: *result = const_int(a > b); return true;
+        case Operator::Lte: *result = const_int(a <= b); return true;
+        case Operator::Gte: *result = const_int(a >= b); return true;
+        case Operator::Eq: *result = const_int(a == b); return true;
+        case Operator::Neq: *result = const_int(a != b); return true;
+        default: return false;
+        }
+    }
+
+    double a = l.float_value;
+    double b = r.float_value;
+    switch (op) {
+    case Operator::Add: *result = const_float(a + b); return true;
+    case Operator::Sub: *result = const_float(a - b); return true;
+    case Operator::Mul: *result = const_float(a * b); return true;
+    case Operator::Div: *result = const_float(a / b); return true;
+    case Operator::Lt: *result = const_int(a < b); return true;
+    case Operator::Gt: *result = const_int(a > b); return true;
+    case Operator::Lte: *result = const_int(a <= b); return true;
+    case Operator::Gte: *result = const_int(a >= b); return true;
+    case Operator::Eq: *result = const_int(a == b); return true;
+    case Operator::Neq: *result = const_int(a != b); return true;
+    default: return false;
+    }
+}
+
+Opcode binary_opcode(Operator::Type op, ValueType type) {
+    bool is_int = type == ValueType::Int;
+    switch (op) {
+    case Operator::Add: return is_int ? Opcode::AddInt : Opcode::AddFloat;
+    case Operator::Sub: return is_int ? Opcode::SubInt : Opcode::SubFloat;
+    case Operator::Mul: return is_int ? Opcode::MulInt : Opcode::MulFloat;
+    case Operator::Div: return is_int ? Opcode::DivInt : Opcode::DivFloat;
+    case Operator::Mod: return Opcode::ModInt;
+    case Operator::Lt: return is_int ? Opcode::LtInt : Opcode::LtFloat;
+    case Operator::Lte: return is_int ? Opcode::LteInt : Opcode::LteFloat;
+    case Operator::Eq: return is_int ? Opcode::EqInt : Opcode::EqFloat;
+    default: return is_int ? Opcode::NeqInt : Opcode::NeqFloat;
+    }
+}
+
+Opcode test_opcode(Operator::Type op, ValueType type) {
+    bool is_int = type == ValueType::Int;
+    switch (op) {
+    case Operator::Lt: return is_int ? Opcode::TestLtInt : Opcode::TestLtFloat;
+    case Operator::Lte: return is_int ? Opcode::TestLteInt : Opcode::TestLteFloat;
+    case Operator::Eq: return is_int ? Opcode::TestEqInt : Opcode::TestEqFloat;
+    default: return is_int ? Opcode::TestNeqInt : Opcode::TestNeqFloat;
+    }
+}
+
+//Both operands are converted to the common type, so l and r can be passed to the opcode
+ValueType unify_operands(Compiler& c, Operator::Type op, Operand& l, Operand& r) {
+    if (!has_value(c, l) || !has_value(c, r)) return ValueType::Int;
+
+    ValueType type = l.type == ValueType::Float || r.type == ValueType::Float ? ValueType::Float : ValueType::Int;
+    if (op == Operator::Mod && type == ValueType::Float) {
+        fail(c, "Operator %% needs int operands");
+        return ValueType::Int;
+    }
+
+    l = convert(c, l, type);
+    r = convert(c, r, type);
+    return type;
+}
+
+Operand compile_binary(Compiler& c, Operator::Type op, Operand l, Operand r, Dest dest, const uint saved[3]) {
+    ValueType type = unify_operands(c, op, l, r);
+    if (c.failed) return const_int(0);
+
+    Operand folded;
+    if (l.is_const && r.is_const && fold_binary(op, l, r, &folded)) {
+        memcpy(c.next_reg, saved, sizeof(c.next_reg));
+        return folded;
+    }
+
+    //x + 1, the most common operation in loops, does not need a register for the constant
+    if (type == ValueType::Int && (op == Operator::Add || op == Operator::Sub)) {
+        if (op == Operator::Add && l.is_const) {
+            Operand tmp = l;
+            l = r;
+            r = tmp;
+        }
+
+        i64 imm = r.is_const && op == Operator::Sub ? neg_int(r.int_value) : r.int_value;
+        if (r.is_const && imm >= -128 && imm <= 127) {
+            memcpy(c.next_reg, saved, sizeof(c.next_reg));
+            u8 reg = dest_reg(c, ValueType::Int, dest);
+            emit(c, Opcode::AddIntImm, reg, l.reg, (u8)imm);
+            return in_reg(ValueType::Int, reg);
+        }
+    }
+
+    if (is_comparison(op)) op = swap_comparison(op, l, r);
+
+    l = to_reg(c, l);
+    r = to_reg(c, r);
+
+    //the operands are read before the result is written, so the result can reuse their registers
+    memcpy(c.next_reg, saved, sizeof(c.next_reg));
+
+    ValueType result_type = is_comparison(op) ? ValueType::Int : type;
+    u8 reg = dest_reg(c, result_type, dest);
+    emit(c, binary_opcode(op, type), reg, l.reg, r.reg);
+    return in_reg(result_type, reg);
+}
+
+Operand compile_expr(Compiler& c, AST* node, Dest dest = NO_DEST);
+
+Operand compile_call(Compiler& c, AST* node, Dest dest) {
+    const char* name = symbol_name(c.module, get_node(c, node->call.function)->id.symbol);
+    bool is_print = strcmp(name, "print") == 0;
+
+    slice<Builtin> builtins = get_builtins();
+    uint builtin = 0;
+    while (builtin < builtins.length && strcmp(builtins[builtin].name, name) != 0) builtin++;
+
+    if (!is_print && builtin == builtins.length) {
+        fail(c, "Unknown function %s", name);
+        return const_int(0);
+    }
+    if (node->call.arg_count != 1) {
+        fail(c, "%s takes one argument", name);
+        return const_int(0);
+    }
+
+    uint saved[3];
+    memcpy(saved, c.next_reg, sizeof(saved));
+
+    Operand arg = compile_expr(c, get_node(c, get_args(c.module, node)[0]));
+    if (!has_value(c, arg)) return arg;
+
+    if (is_print) {
+        arg = to_reg(c, arg);
+        emit(c, arg.type == ValueType::Int ? Opcode::PrintInt : Opcode::PrintFloat, arg.reg);
+        memcpy(c.next_reg, saved, sizeof(saved));
+        return { ValueType::Void };
+    }
+
+    arg = convert(c, arg, ValueType::Float);
+    if (arg.is_const) return const_float(builtins[builtin].func(arg.float_value));
+
+    memcpy(c.next_reg, saved, sizeof(saved));
+    u8 reg = dest_reg(c, ValueType::Float, dest);
+    emit(c, Opcode::CallFloat, reg, arg.reg, builtin);
+    return in_reg(ValueType::Float, reg);
+}
+
+Operand compile_expr(Compiler& c, AST* node, Dest dest) {
+    if (c.failed) return const_int(0);
+    c.loc = node->loc.offset;
+
+    switch (node->type) {
+    case AST::IntLiteral: return const_int((i64)node->int_lit.value);
+    case AST::FloatLiteral: return const_float(node->float_lit.value);
+    case AST::Identifier: {
+        Local* local = find_local(c, node->id.symbol);
+        if (!local) {
+            fail(c, "Undefined variable %s", symbol_name(c.module, node->id.symbol));
+            return const_int(0);
+        }
+        return in_reg(local->type, local->reg);
+    }
+    case AST::FuncCall: return compile_call(c, node, dest);
+    case AST::Operator: {
+        uint saved[3];
+        memcpy(saved, c.next_reg, sizeof(saved));
+
+        if (node->op.type == Operator::Neg) {
+            Operand operand = compile_expr(c, get_node(c, node->op.left));
+            if (!has_value(c, operand)) return operand;
+
+            if (operand.is_const) {
+                return operand.type == ValueType::Int ? const_int(neg_int(operand.int_value)) : const_float(-operand.float_value);
+            }
+
+            memcpy(c.next_reg, saved, sizeof(saved));
+            u8 reg = dest_reg(c, operand.type, dest);
+            emit(c, operand.type == ValueType::Int ? Opcode::NegInt : Opcode::NegFloat, reg, operand.reg);
+            return in_reg(operand.type, reg);
+        }
+
+        Operand l = compile_expr(c, get_node(c, node->op.left));
+        Operand r = compile_expr(c, get_node(c, node->op.right));
+        c.loc = node->loc.offset;
+        return compile_binary(c, node->op.type, l, r, dest, saved);
+    }
+    default:
+        fail(c, "Expecting expression");
+        return const_int(0);
+    }
+}
+
+//Writes the value into the register, converting it to the type of the register
+void compile_store(Compiler& c, Operand value, ValueType type, u8 reg) {
+    Dest dest = { type, reg };
+
+    value = convert(c, value, type, dest);
+    if (c.failed) return;
+
+    if (value.is_const) load_const(c, value, reg);
+    else if (value.reg != reg) emit(c, type == ValueType::Int ? Opcode::MovInt : Opcode::MovFloat, reg, value.reg);
+}
+
+//Emits a jump that is taken when the condition is equal to when_true and returns it, to be patched.
+//Constant conditions either never jump, returning NO_JUMP, or always do
+uint compile_condition_jump(Compiler& c, AST* condition, bool when_true) {
+    uint saved[3];
+    memcpy(saved, c.next_reg, sizeof(saved));
+
+    if (condition->type == AST::Operator && is_comparison(condition->op.type)) {
+        Operand l = compile_expr(c, get_node(c, condition->op.left));
+        Operand r = compile_expr(c, get_node(c, condition->op.right));
+        c.loc = condition->loc.offset;
+
+        Operator::Type op = condition->op.type;
+        ValueType type = unify_operands(c, op, l, r);
+        if (c.failed) return NO_JUMP;
+
+        Operand folded;
+        if (l.is_const && r.is_const && fold_binary(op, l, r, &folded)) {
+            memcpy(c.next_reg, saved, sizeof(saved));
+            return (folded.int_value != 0) == when_true ? emit_jump(c) : NO_JUMP;
+        }
+
+        op = swap_comparison(op, l, r);
+        l = to_reg(c, l);
+        r = to_reg(c, r);
+
+        emit(c, test_opcode(op, type), l.reg, r.reg, when_true);
+        memcpy(c.next_reg, saved, sizeof(saved));
+        return emit_jump(c);
+    }
+
+    Operand value = compile_expr(c, condition);
+    if (!has_value(c, value)) return NO_JUMP;
+
+    if (value.is_const) {
+        bool truthy = value.type == ValueType::Int ? value.int_value != 0 : value.float_value != 0.0;
+        memcpy(c.next_reg, saved, sizeof(saved));
+        return truthy == when_true ? emit_jump(c) : NO_JUMP;
+    }
+
+    if (value.type == ValueType::Float) {
+        Operand zero = to_reg(c, const_float(0.0));
+        emit(c, Opcode::TestNeqFloat, value.reg, zero.reg, when_true);
+        memcpy(c.next_reg, saved, sizeof(saved));
+        return emit_jump(c);
+    }
+
+    memcpy(c.next_reg, saved, sizeof(saved));
+    return emit_jump(c, when_true ? Opcode::JumpIfNotZero : Opcode::JumpIfZero, value.reg);
+}
+
+//Whether the condition is a constant, and so never changes which branch is taken
+bool is_const_condition(AST* condition, bool* truthy) {
+    if (condition->type == AST::IntLiteral) *truthy = condition->int_lit.value != 0;
+    else if (condition->type == AST::FloatLiteral) *truthy = condition->float_lit.value != 0.0;
+    else return false;
+    return true;
+}
+
+void compile_stmt(Compiler& c, AST* node);
+
+void compile_scope(Compiler& c, AST* node) {
+    uint locals = c.locals.length;
+    uint scope_begin = c.scope_begin;
+    uint saved[3];
+    memcpy(saved, c.next_reg, sizeof(saved));
+
+    c.scope_begin = locals;
+    compile_stmt(c, node);
+
+    c.scope_begin = scope_begin;
+    c.locals.resize(locals);
+    memcpy(c.next_reg, saved, sizeof(saved));
+}
+
+//Branches that never run are still type checked like the rest of the cell, only their code is dropped
+void check_scope(Compiler& c, AST* node) {
+    uint code = c.out.code.length;
+    uint breaks = c.breaks.length;
+    uint continues = c.continues.length;
+
+    compile_scope(c, node);
+
+    c.out.code.resize(code);
+    c.out.locs.resize(code);
+    c.breaks.resize(breaks);
+    c.continues.resize(continues);
+}
+
+void compile_declaration(Compiler& c, AST* node) {
+    symbol_handle symbol = get_node(c, node->decl.id)->id.symbol;
+    for (uint i = c.scope_begin; i < c.locals.length; i++) {
+        if (c.locals[i].symbol == symbol) return fail(c, "%s is already declared", symbol_name(c.module, symbol));
+    }
+
+    ValueType type = node->decl.type;
+    u8 reg = alloc_reg(c, type);
+
+    uint saved[3];
+    memcpy(saved, c.next_reg, sizeof(saved));
+
+    Operand value = node->decl.value ? compile_expr(c, get_node(c, node->decl.value), { type, reg }) : const_int(0);
+    c.loc = node->loc.offset;
+    compile_store(c, value, type, reg);
+
+    memcpy(c.next_reg, saved, sizeof(saved));
+    c.locals.append({ symbol, type, reg });
+}
+
+void compile_assign(Compiler& c, AST* node) {
+    symbol_handle symbol = get_node(c, node->assign.target)->id.symbol;
+    Local* local = find_local(c, symbol);
+    if (!local) return fail(c, "Undefined variable %s", symbol_name(c.module, symbol));
+
+    Dest dest = { local->type, local->reg };
+    Local target = *local;
+
+    uint saved[3];
+    memcpy(saved, c.next_reg, sizeof(saved));
+
+    Operand value;
+    if (node->assign.compound) {
+        Operand r = compile_expr(c, get_node(c, node->assign.value));
+        c.loc = node->loc.offset;
+        value = compile_binary(c, node->assign.op, in_reg(target.type, target.reg), r, dest, saved);
+    }
+    else {
+        value = compile_expr(c, get_node(c, node->assign.value), dest);
+    }
+
+    c.loc = node->loc.offset;
+    compile_store(c, value, target.type, target.reg);
+    memcpy(c.next_reg, saved, sizeof(saved));
+}
+
+void begin_loop(Compiler& c, uint* breaks, uint* continues, bool* in_loop) {
+    *breaks = c.breaks.length;
+    *continues = c.continues.length;
+    *in_loop = c.in_loop;
+    c.in_loop = true;
+}
+
+void end_loop(Compiler& c, uint breaks, uint continues, bool in_loop, uint continue_target, uint break_target) {
+    for (uint i = continues; i < c.continues.length; i++) patch_jump(c, c.continues[i], continue_target);
+    for (uint i = breaks; i < c.breaks.length; i++) patch_jump(c, c.breaks[i], break_target);
+
+    c.continues.resize(continues);
+    c.breaks.resize(breaks);
+    c.in_loop = in_loop;
+}
+
+//The condition is checked at the bottom, so every iteration only takes the jump back to the body:
+//  init; jump cond; body: body; step; cond: if (condition) jump body
+void compile_loop(Compiler& c, AST* init, AST* condition, AST* step, AST* body) {
+    uint locals = c.locals.length;
+    uint scope_begin = c.scope_begin;
+    uint saved[3];
+    memcpy(saved, c.next_reg, sizeof(saved));
+    c.scope_begin = locals;
+
+    if (init) compile_stmt(c, init);
+
+    bool truthy = true;
+    bool is_const = !condition || is_const_condition(condition, &truthy);
+
+    if (!is_const || truthy) {
+        uint enter = is_const ? NO_JUMP : emit_jump(c);
+        uint top = here(c);
+
+        uint breaks, continues;
+        bool in_loop;
+        begin_loop(c, &breaks, &continues, &in_loop);
+
+        compile_scope(c, body);
+
+        uint continue_target = here(c);
+        if (step) compile_scope(c, step);
+
+        uint check = here(c);
+        patch_jump(c, enter, check);
+
+        uint back = is_const ? emit_jump(c) : compile_condition_jump(c, condition, true);
+        patch_jump(c, back, top);
+
+        end_loop(c, breaks, continues, in_loop, continue_target, here(c));
+    }
+    else {
+        bool in_loop = c.in_loop;
+        c.in_loop = true;
+        check_scope(c, body);
+        if (step) check_scope(c, step);
+        c.in_loop = in_loop;
+    }
+
+    c.scope_begin = scope_begin;
+    c.locals.resize(locals);
+    memcpy(c.next_reg, saved, sizeof(saved));
+}
+
+void compile_if(Compiler& c, AST* node) {
+    AST* condition = get_node(c, node->if_stmt.condition);
+    AST* otherwise = get_node(c, node->if_stmt.otherwise);
+
+    bool truthy;
+    if (is_const_condition(condition, &truthy)) {
+        AST* then = get_node(c, node->if_stmt.then);
+        if (truthy) compile_scope(c, then);
+        else check_scope(c, then);
+
+        if (otherwise && truthy) check_scope(c, otherwise);
+        else if (otherwise) compile_scope(c, otherwise);
+        return;
+    }
+
+    //if (x) break; jumps out of the loop directly instead of over a jump that does
+    AST* then = get_node(c, node->if_stmt.then);
+    if (then->type == AST::Block && then->block.count == 1) then = get_node(c, get_statements(c.module, then)[0]);
+
+    bool is_loop_exit = then->type == AST::Break || then->type == AST::Continue;
+    if (is_loop_exit && c.in_loop && !otherwise) {
+        uint jump = compile_condition_jump(c, condition, true);
+        if (jump != NO_JUMP) (then->type == AST::Break ? c.breaks : c.continues).append(jump);
+        return;
+    }
+
+    uint skip_then = compile_condition_jump(c, condition, false);
+    compile_scope(c, get_node(c, node->if_stmt.then));
+
+    if (otherwise) {
+        uint skip_else = emit_jump(c);
+        patch_jump(c, skip_then, here(c));
+        compile_scope(c, otherwise);
+        patch_jump(c, skip_else, here(c));
+    }
+    else {
+        patch_jump(c, skip_then, here(c));
+    }
+}
+
+void compile_return(Compiler& c, Operand value) {
+    if (value.type == ValueType::Void) {
+        emit(c, Opcode::Return);
+        return;
+    }
+
+    value = to_reg(c, value);
+    emit(c, value.type == ValueType::Int ? Opcode::ReturnInt : Opcode::ReturnFloat, value.reg);
+}
+
+void compile_stmt(Compiler& c, AST* node) {
+    if (c.failed) return;
+    c.loc = node->loc.offset;
+
+    uint saved[3];
+    memcpy(saved, c.next_reg, sizeof(saved));
+
+    switch (node->type) {
+    case AST::Block: {
+        uint locals = c.locals.length;
+        uint scope_begin = c.scope_begin;
+        c.scope_begin = locals;
+
+        for (ast_handle stmt : get_statements(c.module, node)) compile_stmt(c, get_node(c, stmt));
+
+        c.scope_begin = scope_begin;
+        c.locals.resize(locals);
+        break;
+    }
+    case AST::Declaration:
+        compile_declaration(c, node);
+        return; //keeps the register of the local
+    case AST::Assign: compile_assign(c, node); break;
+    case AST::If: compile_if(c, node); break;
+    case AST::While: {
+        While& stmt = node->while_stmt;
+        compile_loop(c, nullptr, get_node(c, stmt.condition), nullptr, get_node(c, stmt.body));
+        break;
+    }
+    case AST::For: {
+        For& stmt = node->for_stmt;
+        compile_loop(c, get_node(c, stmt.init), get_node(c, stmt.condition), get_node(c, stmt.step), get_node(c, stmt.body));
+        break;
+    }
+    case AST::Return:
+        compile_return(c, node->ret.value ? compile_expr(c, get_node(c, node->ret.value)) : Operand{ ValueType::Void });
+        break;
+    case AST::Break:
+    case AST::Continue:
+        if (!c.in_loop) return fail(c, node->type == AST::Break ? "break outside of a loop" : "continue outside of a loop");
+        (node->type == AST::Break ? c.breaks : c.continues).append(emit_jump(c));
+        break;
+    default:
+        compile_expr(c, node);
+        break;
+    }
+
+    memcpy(c.next_reg, saved, sizeof(saved));
+}
+
+//Declarations at the top of the cell stay in scope for the whole cell. The last statement,
+//when it is an expression, is the result of the cell
+bool compile_ast(Bytecode& bytecode, AstModule& module, Diagnostic* error) {
+    bytecode = {};
+
+    Compiler c{ bytecode, module, error };
+
+    slice<ast_handle> stmts = get_statements(module, get_root(module));
+    for (uint i = 0; i + 1 < stmts.length; i++) compile_stmt(c, get_node(c, stmts[i]));
+
+    AST* stmt = stmts.length > 0 ? get_node(c, stmts[stmts.length - 1]) : nullptr;
+
+    bool is_expression = stmt && (stmt->type == AST::Operator || stmt->type == AST::Identifier || stmt->type == AST::IntLiteral
+        || stmt->type == AST::FloatLiteral || stmt->type == AST::FuncCall);
+
+    if (is_expression) {
+        c.loc = stmt->loc.offset;
+        compile_return(c, compile_expr(c, stmt));
+    }
+    else {
+        if (stmt) compile_stmt(c, stmt);
+        emit(c, Opcode::Return);
+    }
+
+    bytecode.int_registers = c.max_reg[(uint)ValueType::Int];
+    bytecode.float_registers = c.max_reg[(uint)ValueType::Float];
+    return !c.failed;
+}
+
+#define NOTEC_OPCODE_NAME(name) #name,
+
+const char* opcode_names[] = { NOTEC_OPCODES(NOTEC_OPCODE_NAME) };
+
+void dump_bytecode(const Bytecode& bytecode) {
+    for (uint i = 0; i < bytecode.code.length; i++) {
+        Instruction ins = bytecode.code[i];
+        printf("%4u %-16s %3u %3u %3u  (bx %d)\n", i, opcode_names[(uint)ins.op], ins.a, ins.b, ins.c, ins.sbx());
+    }
+}
@@ -32,5 +32,533 @@ void execute(string_view str) {
 }
 
 #else
-void execute(string_view str) {}
+
+#include "interpreter.h"
+#include "lexer.h"
+#include "parser.h"
+#include <stdio.h>
+#include <string.h>
+
+struct Variable {
+    symbol_handle symbol;
+    Value value;
+};
+
+enum class Flow { Next, Break, Continue, Return, Error };
+
+struct AstInterpreter {
+    AstModule* module;
+    vector<Variable> variables;
+    Diagnostic* error;
+    Value result;
+};
+
+Value int_value(i64 value) {
+    Value result = { ValueType::Int };
+    result.int_value = value;
+    return result;
+}
+
+Value float_value(double value) {
+    Value result = { ValueType::Float };
+    result.float_value = value;
+    return result;
+}
+
+bool runtime_error(AstInterpreter& interp, AST* node, const char* format, const char* arg = "") {
+    interp.error->loc = node->loc;
+    snprintf(interp.error->message, sizeof(interp.error->message), format, arg);
+    return false;
+}
+
+Flow error_flow(AstInterpreter& interp, AST* node, const char* format, const char* arg = "") {
+    runtime_error(interp, node, format, arg);
+    return Flow::Error;
+}
+
+Variable* find_variable(AstInterpreter& interp, symbol_handle symbol) {
+    for (int i = interp.variables.length - 1; i >= 0; i--) {
+        if (interp.variables[i].symbol == symbol) return &interp.variables[i];
+    }
+    return nullptr;
+}
+
+AST* get_node(AstInterpreter& interp, ast_handle handle) {
+    return get_node(*interp.module, handle);
+}
+
+const char* symbol_name(AstInterpreter& interp, ast_handle id) {
+    return symbol_name(*interp.module, get_node(interp, id)->id.symbol);
+}
+
+Value convert(Value value, ValueType type) {
+    if (value.type == type) return value;
+    return type == ValueType::Float ? float_value((double)value.int_value) : int_value((i64)value.float_value);
+}
+
+bool eval(AstInterpreter& interp, AST* node, Value* result);
+
+bool eval_binary(AstInterpreter& interp, AST* node, Operator::Type op, Value l, Value r, Value* result) {
+    if (l.type == ValueType::Void || r.type == ValueType::Void) return runtime_error(interp, node, "Expression has no value");
+
+    if (l.type == ValueType::Float || r.type == ValueType::Float) {
+        if (op == Operator::Mod) return runtime_error(interp, node, "Operator %% needs int operands");
+
+        double a = convert(l, ValueType::Float).float_value;
+        double b = convert(r, ValueType::Float).float_value;
+        switch (op) {
+        case Operator::Add: *result = float_value(a + b); break;
+        case Operator::Sub: *result = float_value(a - b); break;
+        case Operator::Mul: *result = float_value(a * b); break;
+        case Operator::Div: *result = float_value(a / b); break;
+        case Operator::Lt: *result = int_value(a < b); break;
+        case Operator::Gt: *result = int_value(a > b); break;
+        case Operator::Lte: *result = int_value(a <= b); break;
+        case Operator::Gte: *result = int_value(a >= b); break;
+        case Operator::Eq: *result = int_value(a == b); break;
+        default: *result = int_value(a != b); break;
+        }
+        return true;
+    }
+
+    i64 a = l.int_value;
+    i64 b = r.int_value;
+    if ((op == Operator::Div || op == Operator::Mod) && b == 0) return runtime_error(interp, node, "Integer division by zero");
+
+    switch (op) {
+    case Operator::Add: *result = int_value(add_int(a, b)); break;
+    case Operator::Sub: *result = int_value(sub_int(a, b)); break;
+    case Operator::Mul: *result = int_value(mul_int(a, b)); break;
+    case Operator::Div: *result = int_value(div_int(a, b)); break;
+    case Operator::Mod: *result = int_value(mod_int(a, b)); break;
+    case Operator::Lt: *result = int_value(a < b); break;
+    case Operator::Gt: *result = int_value(a > b); break;
+    case Operator::Lte: *result = int_value(a <= b); break;
+    case Operator::Gte: *result = int_value(a >= b); break;
+    case Operator::Eq: *result = int_value(a == b); break;
+    default: *result = int_value(a != b); break;
+    }
+    return true;
+}
+
+bool eval_call(AstInterpreter& interp, AST* node, Value* result) {
+    const char* name = symbol_name(interp, node->call.function);
+    if (node->call.arg_count != 1) return runtime_error(interp, node, "%s takes one argument", name);
+
+    Value arg;
+    if (!eval(interp, get_node(interp, get_args(*interp.module, node)[0]), &arg)) return false;
+    if (arg.type == ValueType::Void) return runtime_error(interp, node, "Expression has no value");
+
+    if (strcmp(name, "print") == 0) {
+        if (arg.type == ValueType::Int) printf("%lld\n", (long long)arg.int_value);
+        else printf("%g\n", arg.float_value);
+        *result = { ValueType::Void };
+        return true;
+    }
+
+    for (Builtin& builtin : get_builtins()) {
+        if (strcmp(builtin.name, name) == 0) {
+            *result = float_value(builtin.func(convert(arg, ValueType::Float).float_value));
+            return true;
+        }
+    }
+
+    return runtime_error(interp, node, "Unknown function %s", name);
+}
+
+bool eval(AstInterpreter& interp, AST* node, Value* result) {
+    switch (node->type) {
+    case AST::IntLiteral: *result = int_value((i64)node->int_lit.value); return true;
+    case AST::FloatLiteral: *result = float_value(node->float_lit.value); return true;
+    case AST::Identifier: {
+        Variable* var = find_variable(interp, node->id.symbol);
+        if (!var) return runtime_error(interp, node, "Undefined variable %s", symbol_name(*interp.module, node->id.symbol));
+        *result = var->value;
+        return true;
+    }
+    case AST::FuncCall: return eval_call(interp, node, result);
+    case AST::Operator: {
+        Value l, r;
+        if (!eval(interp, get_node(interp, node->op.left), &l)) return false;
+
+        if (node->op.type == Operator::Neg) {
+            if (l.type == ValueType::Void) return runtime_error(interp, node, "Expression has no value");
+            *result = l.type == ValueType::Int ? int_value(neg_int(l.int_value)) : float_value(-l.float_value);
+            return true;
+        }
+
+        if (!eval(interp, get_node(interp, node->op.right), &r)) return false;
+        return eval_binary(interp, node, node->op.type, l, r, result);
+    }
+    default:
+        return runtime_error(interp, node, "Expecting expression");
+    }
+}
+
+bool is_true(Value value) {
+    return value.type == ValueType::Int ? value.int_value != 0 : value.float_value != 0.0;
+}
+
+Flow exec(AstInterpreter& interp, AST* node);
+
+Flow exec_scope(AstInterpreter& interp, AST* node) {
+    uint variables = interp.variables.length;
+    Flow flow = exec(interp, node);
+    interp.variables.resize(variables);
+    return flow;
+}
+
+Flow exec_store(AstInterpreter& interp, AST* node, Variable* var, Value value) {
+    if (value.type == ValueType::Void) return error_flow(interp, node, "Expression has no value");
+    var->value = convert(value, var->value.type);
+    return Flow::Next;
+}
+
+Flow exec_loop(AstInterpreter& interp, AST* init, AST* condition, AST* step, AST* body) {
+    uint variables = interp.variables.length;
+    Flow flow = init ? exec(interp, init) : Flow::Next;
+
+    while (flow == Flow::Next) {
+        Value cond;
+        if (condition && !eval(interp, condition, &cond)) flow = Flow::Error;
+        else if (condition && cond.type == ValueType::Void) flow = error_flow(interp, condition, "Expression has no value");
+        else if (condition && !is_true(cond)) break;
+        else {
+            flow = exec_scope(interp, body);
+            if (flow == Flow::Break) {
+                flow = Flow::Next;
+                break;
+            }
+            if (flow == Flow::Continue) flow = Flow::Next;
+            if (flow == Flow::Next && step) flow = exec_scope(interp, step);
+        }
+    }
+
+    interp.variables.resize(variables);
+    return flow;
+}
+
+Flow exec(AstInterpreter& interp, AST* node) {
+    switch (node->type) {
+    case AST::Block: {
+        uint variables = interp.variables.length;
+        Flow flow = Flow::Next;
+        slice<ast_handle> stmts = get_statements(*interp.module, node);
+        for (uint i = 0; i < stmts.length && flow == Flow::Next; i++) flow = exec(interp, get_node(interp, stmts[i]));
+        interp.variables.resize(variables);
+        return flow;
+    }
+    case AST::Declaration: {
+        Variable var = { get_node(interp, node->decl.id)->id.symbol, convert(int_value(0), node->decl.type) };
+        if (node->decl.value) {
+            Value value;
+            if (!eval(interp, get_node(interp, node->decl.value), &value)) return Flow::Error;
+            if (exec_store(interp, node, &var, value) == Flow::Error) return Flow::Error;
+        }
+        interp.variables.append(var);
+        return Flow::Next;
+    }
+    case AST::Assign: {
+        Variable* var = find_variable(interp, get_node(interp, node->assign.target)->id.symbol);
+        if (!var) return error_flow(interp, node, "Undefined variable %s", symbol_name(interp, node->assign.target));
+
+        Value value;
+        if (!eval(interp, get_node(interp, node->assign.value), &value)) return Flow::Error;
+        if (node->assign.compound && !eval_binary(interp, node, node->assign.op, var->value, value, &value)) return Flow::Error;
+
+        return exec_store(interp, node, var, value);
+    }
+    case AST::If: {
+        Value cond;
+        if (!eval(interp, get_node(interp, node->if_stmt.condition), &cond)) return Flow::Error;
+        if (cond.type == ValueType::Void) return error_flow(interp, node, "Expression has no value");
+
+        if (is_true(cond)) return exec_scope(interp, get_node(interp, node->if_stmt.then));
+        if (node->if_stmt.otherwise) return exec_scope(interp, get_node(interp, node->if_stmt.otherwise));
+        return Flow::Next;
+    }
+    case AST::While: {
+        While& stmt = node->while_stmt;
+        return exec_loop(interp, nullptr, get_node(interp, stmt.condition), nullptr, get_node(interp, stmt.body));
+    }
+    case AST::For: {
+        For& stmt = node->for_stmt;
+        return exec_loop(interp, get_node(interp, stmt.init), get_node(interp, stmt.condition), get_node(interp, stmt.step), get_node(interp, stmt.body));
+    }
+    case AST::Return:
+        interp.result = { ValueType::Void };
+        if (node->ret.value && !eval(interp, get_node(interp, node->ret.value), &interp.result)) return Flow::Error;
+        return Flow::Return;
+    case AST::Break: return Flow::Break;
+    case AST::Continue: return Flow::Continue;
+    default: {
+        Value value;
+        return eval(interp, node, &value) ? Flow::Next : Flow::Error;
+    }
+    }
+}
+
+struct CheckedLocal {
+    symbol_handle symbol;
+    ValueType type;
+};
+
+//Gives every expression its type before the cell runs, with the same rules and messages as the compiler
+struct TypeChecker {
+    AstModule* module;
+    Diagnostic* error;
+    vector<CheckedLocal> locals;
+    uint scope_begin;
+    bool in_loop;
+};
+
+bool type_error(TypeChecker& c, AST* node, const char* format, const char* arg = "") {
+    c.error->loc = node->loc;
+    snprintf(c.error->message, sizeof(c.error->message), format, arg);
+    return false;
+}
+
+AST* get_node(TypeChecker& c, ast_handle handle) {
+    return get_node(*c.module, handle);
+}
+
+bool check_has_value(TypeChecker& c, AST* node, ValueType type) {
+    return type != ValueType::Void || type_error(c, node, "Expression has no value");
+}
+
+bool check_binary(TypeChecker& c, AST* node, Operator::Type op, ValueType l, ValueType r, ValueType* type) {
+    if (!check_has_value(c, node, l) || !check_has_value(c, node, r)) return false;
+
+    ValueType operands = l == ValueType::Float || r == ValueType::Float ? ValueType::Float : ValueType::Int;
+    if (op == Operator::Mod && operands == ValueType::Float) return type_error(c, node, "Operator %% needs int operands");
+
+    bool is_comparison = op >= Operator::Lt && op <= Operator::Neq;
+    *type = is_comparison ? ValueType::Int : operands;
+    return true;
+}
+
+bool check_expr(TypeChecker& c, AST* node, ValueType* type) {
+    switch (node->type) {
+    case AST::IntLiteral: *type = ValueType::Int; return true;
+    case AST::FloatLiteral: *type = ValueType::Float; return true;
+    case AST::Identifier:
+        for (int i = c.locals.length - 1; i >= 0; i--) {
+            if (c.locals[i].symbol != node->id.symbol) continue;
+            *type = c.locals[i].type;
+            return true;
+        }
+        return type_error(c, node, "Undefined variable %s", symbol_name(*c.module, node->id.symbol));
+    case AST::FuncCall: {
+        const char* name = symbol_name(*c.module, get_node(c, node->call.function)->id.symbol);
+        bool is_print = strcmp(name, "print") == 0;
+
+        bool is_builtin = false;
+        for (Builtin& builtin : get_builtins()) is_builtin |= strcmp(builtin.name, name) == 0;
+
+        if (!is_print && !is_builtin) return type_error(c, node, "Unknown function %s", name);
+        if (node->call.arg_count != 1) return type_error(c, node, "%s takes one argument", name);
+
+        ValueType arg;
+        if (!check_expr(c, get_node(c, get_args(*c.module, node)[0]), &arg) || !check_has_value(c, node, arg)) return false;
+
+        *type = is_print ? ValueType::Void : ValueType::Float;
+        return true;
+    }
+    case AST::Operator: {
+        ValueType l, r;
+        if (!check_expr(c, get_node(c, node->op.left), &l)) return false;
+
+        if (node->op.type == Operator::Neg) {
+            *type = l;
+            return check_has_value(c, node, l);
+        }
+
+        if (!check_expr(c, get_node(c, node->op.right), &r)) return false;
+        return check_binary(c, node, node->op.type, l, r, type);
+    }
+    default:
+        return type_error(c, node, "Expecting expression");
+    }
+}
+
+bool check_value(TypeChecker& c, AST* node, AST* expr) {
+    ValueType type;
+    return check_expr(c, expr, &type) && check_has_value(c, node, type);
+}
+
+bool check_stmt(TypeChecker& c, AST* node);
+
+bool check_scope(TypeChecker& c, AST* node) {
+    uint locals = c.locals.length;
+    uint scope_begin = c.scope_begin;
+    c.scope_begin = locals;
+
+    bool ok = check_stmt(c, node);
+
+    c.scope_begin = scope_begin;
+    c.locals.resize(locals);
+    return ok;
+}
+
+bool check_loop(TypeChecker& c, AST* init, AST* condition, AST* step, AST* body) {
+    uint locals = c.locals.length;
+    uint scope_begin = c.scope_begin;
+    bool in_loop = c.in_loop;
+    c.scope_begin = locals;
+
+    bool ok = !init || check_stmt(c, init);
+    if (ok) {
+        c.in_loop = true;
+        ok = check_scope(c, body) && (!step || check_scope(c, step)) && (!condition || check_value(c, condition, condition));
+    }
+
+    c.in_loop = in_loop;
+    c.scope_begin = scope_begin;
+    c.locals.resize(locals);
+    return ok;
+}
+
+bool check_stmt(TypeChecker& c, AST* node) {
+    switch (node->type) {
+    case AST::Block: {
+        uint locals = c.locals.length;
+        uint scope_begin = c.scope_begin;
+        c.scope_begin = locals;
+
+        bool ok = true;
+        slice<ast_handle> stmts = get_statements(*c.module, node);
+        for (uint i = 0; i < stmts.length && ok; i++) ok = check_stmt(c, get_node(c, stmts[i]));
+
+        c.scope_begin = scope_begin;
+        c.locals.resize(locals);
+        return ok;
+    }
+    case AST::Declaration: {
+        symbol_handle symbol = get_node(c, node->decl.id)->id.symbol;
+        for (uint i = c.scope_begin; i < c.locals.length; i++) {
+            if (c.locals[i].symbol == symbol) return type_error(c, node, "%s is already declared", symbol_name(*c.module, symbol));
+        }
+
+        if (node->decl.value && !check_value(c, node, get_node(c, node->decl.value))) return false;
+        c.locals.append({ symbol, node->decl.type });
+        return true;
+    }
+    case AST::Assign: {
+        symbol_handle symbol = get_node(c, node->assign.target)->id.symbol;
+
+        CheckedLocal* local = nullptr;
+        for (int i = c.locals.length - 1; i >= 0 && !local; i--) {
+            if (c.locals[i].symbol == symbol) local = &c.locals[i];
+        }
+        if (!local) return type_error(c, node, "Undefined variable %s", symbol_name(*c.module, symbol));
+
+        ValueType value;
+        if (!check_expr(c, get_node(c, node->assign.value), &value)) return false;
+        if (node->assign.compound && !check_binary(c, node, node->assign.op, local->type, value, &value)) return false;
+        return check_has_value(c, node, value);
+    }
+    case AST::If: {
+        AST* otherwise = get_node(c, node->if_stmt.otherwise);
+        return check_value(c, node, get_node(c, node->if_stmt.condition)) && check_scope(c, get_node(c, node->if_stmt.then))
+            && (!otherwise || check_scope(c, otherwise));
+    }
+    case AST::While: {
+        While& stmt = node->while_stmt;
+        return check_loop(c, nullptr, get_node(c, stmt.condition), nullptr, get_node(c, stmt.body));
+    }
+    case AST::For: {
+        For& stmt = node->for_stmt;
+        return check_loop(c, get_node(c, stmt.init), get_node(c, stmt.condition), get_node(c, stmt.step), get_node(c, stmt.body));
+    }
+    case AST::Return: {
+        ValueType type;
+        return !node->ret.value || check_expr(c, get_node(c, node->ret.value), &type);
+    }
+    case AST::Break:
+    case AST::Continue:
+        if (!c.in_loop) return type_error(c, node, node->type == AST::Break ? "break outside of a loop" : "continue outside of a loop");
+        return true;
+    default: {
+        ValueType type;
+        return check_expr(c, node, &type);
+    }
+    }
+}
+
+//Notec is statically typed, every statement of the cell is checked before any of it runs,
+//including those in branches and loops that are never taken
+bool check_types(AstModule& module, Diagnostic* error) {
+    TypeChecker c = {};
+    c.module = &module;
+    c.error = error;
+
+    slice<ast_handle> stmts = get_statements(module, get_root(module));
+    for (ast_handle stmt : stmts) {
+        if (!check_stmt(c, get_node(c, stmt))) return false;
+    }
+    return true;
+}
+
+bool eval_ast(AstModule& module, Value* result, Diagnostic* error) {
+    if (!check_types(module, error)) return false;
+
+    AstInterpreter interp = {};
+    interp.module = &module;
+    interp.error = error;
+    interp.result = { ValueType::Void };
+
+    slice<ast_handle> stmts = get_statements(module, get_root(module));
+    Flow flow = Flow::Next;
+    for (uint i = 0; i + 1 < stmts.length && flow == Flow::Next; i++) flow = exec(interp, get_node(interp, stmts[i]));
+
+    AST* stmt = stmts.length > 0 ? get_node(interp, stmts[stmts.length - 1]) : nullptr;
+
+    bool is_expression = stmt && (stmt->type == AST::Operator || stmt->type == AST::Identifier || stmt->type == AST::IntLiteral
+        || stmt->type == AST::FloatLiteral || stmt->type == AST::FuncCall);
+
+    if (flow == Flow::Next && is_expression) {
+        if (!eval(interp, stmt, &interp.result)) flow = Flow::Error;
+    }
+    else if (flow == Flow::Next && stmt) {
+        flow = exec(interp, stmt);
+    }
+
+    *result = interp.result;
+    return flow != Flow::Error;
+}
+
+void print_diagnostic(string_view src, const Diagnostic& error) {
+    uint line = 1;
+    uint column = 1;
+    for (uint i = 0; i < error.loc.offset && i < src.length; i++) {
+        if (src[i] == '\n') {
+            line++;
+            column = 1;
+        }
+        else column++;
+    }
+
+    printf("%u:%u: %s\n", line, column, error.message);
+}
+
+void execute(string_view src) {
+    static Lexer* lexer = make_lexer();
+    static AstPool* pool = make_ast_pool();
+
+    slice<Token> tokens = lex_src(*lexer, src);
+    AstModule* module = make_ast_module(pool);
+
+    Diagnostic error = {};
+    Bytecode bytecode;
+    Value result;
+
+    bool ok = parse_tokens(*module, tokens, &error) && compile_ast(bytecode, *module, &error) && run_bytecode(bytecode, &result, &error);
+
+    if (!ok) print_diagnostic(src, error);
+    else if (result.type == ValueType::Int) printf("= %lld\n", (long long)result.int_value);
+    else if (result.type == ValueType::Float) printf("= %g\n", result.float_value);
+
+    destroy_ast_module(module);
+}
+
 #endif
\ No newline at end of file
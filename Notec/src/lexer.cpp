@@ -3,6 +3,7 @@
 #include "core/memory/linear_allocator.h"
 #include "core/container/string_view.h"
 #include "core/container/vector.h"
+#include "core/lexing.h"
 #include <assert.h>
 #include <stdio.h>
 
@@ -12,6 +13,7 @@ struct Lexer {
     uint i;
     uint line;
     uint column;
+    LexState state;
 };
 
 Lexer* make_lexer() {
@@ -38,14 +40,6 @@ bool is_alpha(char c) {
     return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
 }
 
-bool is_alpha_lower(char c) {
-    return c >= 'a' && c <= 'z';
-}
-
-bool is_alpha_numeric(char c) {
-    return is_digit(c) || is_alpha(c);
-}
-
 char last(Lexer& lexer) {
     return lexer.src[lexer.i-1];
 }
@@ -120,108 +114,72 @@ Token lex_number(Lexer& lex) {
     return token;
 }
 
-const uint MAX_KEYWORDS_PER_LETTER = 10;
-const uint LONGEST_KEYWORD = 5;
-
-struct KeywordList {
-    uint count;
-    string_view keywords[MAX_KEYWORDS_PER_LETTER];
-    Token::Type type[MAX_KEYWORDS_PER_LETTER];
-};
-
-KeywordList keywords[26];
-KeywordList defines[26];
-
-void add_keyword(KeywordList list[26], Token::Type type, const char* str) {
-    uint bucket = str[0]-'a';
-    uint idx = list[bucket].count++;
-    list[bucket].keywords[idx] = str;
-    list[bucket].type[idx] = type;
-}
-
-bool lookup_match(KeywordList list[26], Lexer& lex, string_view str, Token& token) {
-    if (str.length == 0) return false;
-    char c = str[0];
-    if (is_alpha_lower(c)) {
-        KeywordList& bucket = list[c-'a'];
-        
-        for (uint i = 0; i < bucket.count; i++) {
-            if (bucket.keywords[i] == str) {
-                token = make_token(lex, bucket.type[i], str.length);
-                return true;
-            }
-        }
-    }
-    return false;
-}
-
-void add_keyword(Token::Type type, const char* str) {
-    add_keyword(keywords, type, str);
-}
-
-void add_define(Token::Type type, const char* str) {
-    assert(str[0] == '#');
-    add_keyword(defines, type, str+1);
-}
-
-void init_lexer_tables() {
-    add_keyword(Token::Struct, "struct");
-    add_keyword(Token::Class, "class");
-    add_keyword(Token::Template, "template");
-    add_keyword(Token::Typename, "typename");
-    add_keyword(Token::Using, "using");
-    add_keyword(Token::Namespace, "namespace");
+constexpr KeywordDesc<Token::Type> keyword_descs[] = {
+    { "struct", Token::Struct },
+    { "class", Token::Class },
+    { "template", Token::Template },
+    { "typename", Token::Typename },
+    { "using", Token::Using },
+    { "namespace", Token::Namespace },
     
-    add_keyword(Token::Void, "void");
-    add_keyword(Token::CharType, "char");
-    add_keyword(Token::ShortType, "short");
-    add_keyword(Token::IntType, "int");
-    add_keyword(Token::LongType, "long");
-
-    add_keyword(Token::Operator, "operator");
+    { "void", Token::Void },
+    { "char", Token::CharType },
+    { "short", Token::ShortType },
+    { "int", Token::IntType },
+    { "long", Token::LongType },
     
-    add_keyword(Token::FloatType, "float");
-    add_keyword(Token::DoubleType, "double");
+    { "operator", Token::Operator },
     
-    add_keyword(Token::Unsigned, "unsigned");
-    add_keyword(Token::Const, "const");
+    { "float", Token::FloatType },
+    { "double", Token::DoubleType },
     
-    add_keyword(Token::If, "if");
-    add_keyword(Token::Elif, "elif");
-    add_keyword(Token::Else, "else");
-    add_keyword(Token::While, "while");
-    add_keyword(Token::For, "for");
-    add_keyword(Token::True, "true");
-    add_keyword(Token::False, "false");
+    { "unsigned", Token::Unsigned },
+    { "const", Token::Const },
     
-    add_keyword(Token::Break, "break");
-    add_keyword(Token::Continue, "continue");
-    add_keyword(Token::Return, "return");
+    { "if", Token::If },
+    { "elif", Token::Elif },
+    { "else", Token::Else },
+    { "while", Token::While },
+    { "for", Token::For },
+    { "true", Token::True },
+    { "false", Token::False },
     
-    add_define(Token::Pre_If, "#if");
-    add_define(Token::Pre_IfDef, "#ifdef");
-    add_define(Token::Pre_ElseDef, "#else");
-    add_define(Token::Pre_Elif, "#elif");
-    add_define(Token::Pre_End, "#end");
-    add_define(Token::Pre_Include, "#include");
+    { "break", Token::Break },
+    { "continue", Token::Continue },
+    { "return", Token::Return },
+};
+
+//Without the #
+constexpr KeywordDesc<Token::Type> define_descs[] = {
+    { "if", Token::Pre_If },
+    { "ifdef", Token::Pre_IfDef },
+    { "else", Token::Pre_ElseDef },
+    { "elif", Token::Pre_Elif },
+    { "end", Token::Pre_End },
+    { "include", Token::Pre_Include },
+};
+
+constexpr auto keywords = make_keyword_table(keyword_descs);
+constexpr auto defines = make_keyword_table(define_descs);
+
+//Moves past the letters, digits and underscores after the current character
+void skip_identifier(Lexer& lex) {
+    const char* begin = lex.src.data + lex.i;
+    uint length = skip_identifier(begin, lex.src.data + lex.src.length) - begin;
+    lex.i += length;
+    lex.column += length;
 }
 
 Token lex_identifier(Lexer& lex) {
     uint start = lex.i-1;
-    char c = last(lex);
-    //assert(is_alpha(c));
-    
-    while (char c = peek(lex)) {
-        if (!is_alpha_numeric(c)) break;
-        adv(lex);
-    }
+    skip_identifier(lex);
     
-    Token token;
     string_view str = {lex.src.data + start, lex.i-start};
     
-    if (lookup_match(keywords, lex, str, token)) return token;
+    Token::Type type;
+    if (keywords.lookup(str, &type)) return make_token(lex, type, str.length);
      
-    token = make_token(lex, Token::Identifier, str.length);
+    Token token = make_token(lex, Token::Identifier, str.length);
     token.value_str = str;
     
     return token;
@@ -229,27 +187,27 @@ Token lex_identifier(Lexer& lex) {
 
 Token lex_define(Lexer& lex) {
     uint start = lex.i;
+    skip_identifier(lex);
     
-    while (char c = peek(lex)) {
-        if (!is_alpha(c)) break;
-        adv(lex);
-    }
-    
-    Token token;
     string_view str = {lex.src.data + start, lex.i-start};
     
-    if (lookup_match(keywords, lex, str, token)) return token;
+    Token::Type type;
+    if (defines.lookup(str, &type)) return make_token(lex, type, str.length+1);
     
     return make_token(lex, Token::Pre_If, str.length+1);
 }
 
-Token lex_string(Lexer& lex) {
-    uint start = lex.i-1;
+//Starts after the opening quote, or at the start of a line that continues a string
+Token lex_string(Lexer& lex, uint start) {
+    lex.state = LexState::String;
     
     bool escape = false;
     while (char c = next(lex)) {
         if (c == '\\') escape = true;
-        else if (c == '"' && !escape) break;
+        else if (c == '"' && !escape) {
+            lex.state = LexState::Code;
+            break;
+        }
         else escape = false;
     }
     
@@ -270,23 +228,35 @@ Token op_or_assign(Lexer& lex, Token::Type op) {
     }
 }
 
+Token eq_or_assign(Lexer& lex) {
+    if (peek(lex) == '=') {
+        adv(lex);
+        return make_token(lex, Token::Op_Eq, 2);
+    }
+    return make_token(lex, Token::Assign, 1);
+}
+
 Token lex_token(Lexer& lex) {
     char c = next(lex);
     
     if (c == '\0') return make_token(lex, Token::End_Of_File, 0);
     if (is_digit(c)) return lex_number(lex);
-    if (is_alpha(c)) return lex_identifier(lex);
+    if (is_alpha(c) || c == '_') return lex_identifier(lex);
     
     switch (c) {
         case '#': return lex_define(lex);
-        case '"': return lex_string(lex);
+        case '"': return lex_string(lex, lex.i-1);
         case '(': return make_token(lex, Token::Open_Paren, 1);
         case ')': return make_token(lex, Token::Close_Paren, 1);
         case '{': return make_token(lex, Token::Open_Bracket, 1);
         case '}': return make_token(lex, Token::Close_Bracket, 1);
         case '[': return make_token(lex, Token::Open_Square, 1);
         case ']': return make_token(lex, Token::Close_Square, 1);
-        case '=': return op_or_assign(lex, Token::Assign);
+        case '=': return eq_or_assign(lex);
+        case '!':
+            if (peek(lex) != '=') return {};
+            adv(lex);
+            return make_token(lex, Token::Op_Neq, 2);
         case '+': return op_or_assign(lex, Token::Op_Add);
         case '-': return op_or_assign(lex, Token::Op_Sub);
         case '*': return op_or_assign(lex, Token::Op_Mul);
@@ -303,13 +273,16 @@ Token lex_token(Lexer& lex) {
     }
 }
 
-slice<Token> lex_src(Lexer& lex, string_view src) {
+void begin_lexing(Lexer& lex, string_view src, LexState state) {
     lex.tokens.clear();
     lex.src = src;
     lex.i = 0;
     lex.column = 0;
     lex.line = 0;
-    
+    lex.state = state;
+}
+
+void lex_tokens(Lexer& lex) {
     char c;
     while ((c = peek(lex))) {
         if (c == '\n') {
@@ -317,14 +290,37 @@ slice<Token> lex_src(Lexer& lex, string_view src) {
             lex.line++;
             lex.column = 0;
         }
-        else if (c == ' ') adv(lex);
+        else if (c == ' ' || c == '\t' || c == '\r') {
+            const char* begin = lex.src.data + lex.i;
+            uint length = skip_blanks(begin, lex.src.data + lex.src.length) - begin;
+            lex.i += length;
+            lex.column += length;
+        }
         else {
             Token token = lex_token(lex);
             lex.tokens.append(token);
         }
     }
+}
+
+slice<Token> lex_src(Lexer& lex, string_view src) {
+    begin_lexing(lex, src, LexState::Code);
+    lex_tokens(lex);
     
     lex.tokens.append(make_token(lex, Token::End_Of_File, 1));
     
     return lex.tokens;
 }
+
+slice<Token> lex_line(Lexer& lex, string_view line, LexState* state) {
+    begin_lexing(lex, line, *state);
+    
+    if (lex.state == LexState::String && lex.i < line.length) {
+        lex.tokens.append(lex_string(lex, 0));
+    }
+    
+    lex_tokens(lex);
+    *state = lex.state;
+    
+    return lex.tokens;
+}
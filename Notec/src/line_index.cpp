@@ -0,0 +1,85 @@
+#include "line_index.h"
+#include "rope.h"
+#include <string.h>
+
+//An empty text still has one line
+void ensure_first_line(LineIndex& index) {
+    if (index.lines.length > 0) return;
+
+    index.lines.resize(1);
+    index.lines[0].dirty = true;
+    index.first_dirty = 0;
+}
+
+//Lines are moved with memmove, like vector moves its elements when it grows
+void insert_lines(LineIndex& index, uint at, uint count) {
+    vector<Line>& lines = index.lines;
+    uint length = lines.length;
+
+    lines.resize(length + count);
+    memmove(lines.data + at + count, lines.data + at, sizeof(Line) * (length - at));
+    for (uint i = at; i < at + count; i++) new (lines.data + i) Line();
+}
+
+void remove_lines(LineIndex& index, uint at, uint count) {
+    vector<Line>& lines = index.lines;
+
+    for (uint i = at; i < at + count; i++) lines[i].~Line();
+    memmove(lines.data + at, lines.data + at + count, sizeof(Line) * (lines.length - at - count));
+    lines.resize(lines.length - count);
+}
+
+void mark_dirty(LineIndex& index, uint line) {
+    index.lines[line].dirty = true;
+    index.first_dirty = min(index.first_dirty, line);
+}
+
+void update_lines(LineIndex& index, uint line, uint removed, uint added) {
+    ensure_first_line(index);
+
+    if (removed > 0) remove_lines(index, line + 1, removed);
+    if (added > 0) insert_lines(index, line + 1, added);
+
+    for (uint i = line; i <= line + added; i++) mark_dirty(index, i);
+}
+
+void reset_lines(LineIndex& index, uint line_count) {
+    ensure_first_line(index);
+
+    if (line_count < index.lines.length) remove_lines(index, line_count, index.lines.length - line_count);
+    else insert_lines(index, index.lines.length, line_count - index.lines.length);
+
+    //only the first state is known, the others are corrected as the lines are lexed in order
+    index.lines[0].state = LexState::Code;
+    for (uint i = 0; i < line_count; i++) index.lines[i].dirty = true;
+    index.first_dirty = 0;
+}
+
+void update_line_tokens(LineIndex& index, Lexer& lexer, Rope& text, uint end_line) {
+    ensure_first_line(index);
+
+    vector<Line>& lines = index.lines;
+    end_line = min(end_line, lines.length);
+
+    uint i = index.first_dirty;
+    for (; i < end_line; i++) {
+        Line& line = lines[i];
+        if (!line.dirty) continue;
+
+        LexState state = line.state;
+        string_view src = copy_temporary_text(text, line_start(text, i), line_end(text, i));
+
+        line.tokens.clear();
+        for (Token& token : lex_line(lexer, src, &state)) line.tokens.append({ token.type, token.loc + 1 });
+        line.dirty = false;
+
+        //the next line is only lexed again when it starts in another state, otherwise its tokens are still valid
+        if (i + 1 < lines.length && lines[i + 1].state != state) {
+            lines[i + 1].state = state;
+            lines[i + 1].dirty = true;
+        }
+    }
+
+    while (i < lines.length && !lines[i].dirty) i++;
+    index.first_dirty = i;
+}
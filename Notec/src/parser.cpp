@@ -1,3 +1,389 @@
 #include "parser.h"
+#include "ast.h"
+#include <stdio.h>
+#include <string.h>
 
+struct Parser {
+    AstModule& module;
+    slice<Token> tokens;
+    uint i;
+    Diagnostic* error;
+    bool failed;
+};
 
+const Token& peek(Parser& parser) {
+    return parser.tokens[parser.i];
+}
+
+const Token& next(Parser& parser) {
+    const Token& token = parser.tokens[parser.i];
+    if (token.type != Token::End_Of_File) parser.i++;
+    return token;
+}
+
+bool match(Parser& parser, Token::Type type) {
+    if (peek(parser).type != type) return false;
+    next(parser);
+    return true;
+}
+
+//Only the first error is kept, everything after it is likely to be caused by it
+ast_handle fail(Parser& parser, const char* message) {
+    if (!parser.failed) {
+        parser.failed = true;
+        parser.error->loc = { peek(parser).loc };
+        snprintf(parser.error->message, sizeof(parser.error->message), "%s", message);
+    }
+    return 0;
+}
+
+bool expect(Parser& parser, Token::Type type, const char* message) {
+    if (match(parser, type)) return true;
+    fail(parser, message);
+    return false;
+}
+
+ast_handle make_node(Parser& parser, AST::Type type, uint loc) {
+    return make_ast_node(parser.module, type, { loc });
+}
+
+//Chunks never move, so the node stays valid while its children are allocated
+AST* get_node(Parser& parser, ast_handle handle) {
+    return get_node(parser.module, handle);
+}
+
+ast_handle parse_expression(Parser& parser);
+ast_handle parse_statement(Parser& parser);
+
+ast_handle parse_identifier(Parser& parser) {
+    const Token& token = next(parser);
+    if (token.type != Token::Identifier || token.value_str.length == 0) return fail(parser, "Expecting identifier");
+
+    ast_handle handle = make_node(parser, AST::Identifier, token.loc);
+    get_node(parser, handle)->id.symbol = intern_symbol(parser.module, token.value_str);
+    return handle;
+}
+
+ast_handle parse_call(Parser& parser, ast_handle function) {
+    ast_handle handle = make_node(parser, AST::FuncCall, get_node(parser, function)->loc.offset);
+    AST* node = get_node(parser, handle);
+    node->call.function = function;
+
+    uint begin = parser.module.pending.length;
+    while (!parser.failed && !match(parser, Token::Close_Paren)) {
+        if (node->call.arg_count > 0 && !expect(parser, Token::Comma, "Expecting , between arguments")) break;
+
+        ast_handle arg = parse_expression(parser);
+        if (!arg) break;
+
+        parser.module.pending.append(arg);
+        node->call.arg_count++;
+    }
+
+    node->call.first_arg = commit_children(parser.module, begin);
+    return parser.failed ? 0 : handle;
+}
+
+ast_handle parse_primary(Parser& parser) {
+    const Token& token = peek(parser);
+
+    switch (token.type) {
+    case Token::Uint: {
+        next(parser);
+        ast_handle handle = make_node(parser, AST::IntLiteral, token.loc);
+        get_node(parser, handle)->int_lit.value = token.value_uint;
+        return handle;
+    }
+    case Token::Float: {
+        next(parser);
+        ast_handle handle = make_node(parser, AST::FloatLiteral, token.loc);
+        get_node(parser, handle)->float_lit.value = token.value_float;
+        return handle;
+    }
+    case Token::True:
+    case Token::False: {
+        next(parser);
+        ast_handle handle = make_node(parser, AST::IntLiteral, token.loc);
+        get_node(parser, handle)->int_lit.value = token.type == Token::True;
+        return handle;
+    }
+    case Token::Open_Paren: {
+        next(parser);
+        ast_handle handle = parse_expression(parser);
+        if (!expect(parser, Token::Close_Paren, "Expecting )")) return 0;
+        return handle;
+    }
+    case Token::Identifier: {
+        ast_handle handle = parse_identifier(parser);
+        if (handle && match(parser, Token::Open_Paren)) return parse_call(parser, handle);
+        return handle;
+    }
+    default:
+        return fail(parser, "Expecting expression");
+    }
+}
+
+ast_handle parse_unary(Parser& parser) {
+    if (peek(parser).type == Token::Op_Sub) {
+        uint loc = next(parser).loc;
+        ast_handle operand = parse_unary(parser);
+        if (!operand) return 0;
+
+        return make_op_node(parser.module, Operator::Neg, operand, 0, { loc });
+    }
+    if (match(parser, Token::Op_Add)) return parse_unary(parser);
+
+    return parse_primary(parser);
+}
+
+//Binding power of the binary operators, 0 for every other token
+uint precedence(Token::Type type, Operator::Type* op) {
+    switch (type) {
+    case Token::Op_Mul: *op = Operator::Mul; return 4;
+    case Token::Op_Div: *op = Operator::Div; return 4;
+    case Token::Op_Mod: *op = Operator::Mod; return 4;
+    case Token::Op_Add: *op = Operator::Add; return 3;
+    case Token::Op_Sub: *op = Operator::Sub; return 3;
+    case Token::Op_Lt: *op = Operator::Lt; return 2;
+    case Token::Op_Gt: *op = Operator::Gt; return 2;
+    case Token::Op_Lte: *op = Operator::Lte; return 2;
+    case Token::Op_Gte: *op = Operator::Gte; return 2;
+    case Token::Op_Eq: *op = Operator::Eq; return 1;
+    case Token::Op_Neq: *op = Operator::Neq; return 1;
+    default: return 0;
+    }
+}
+
+ast_handle parse_binary(Parser& parser, uint min_precedence) {
+    ast_handle left = parse_unary(parser);
+
+    while (left) {
+        Operator::Type op;
+        uint prec = precedence(peek(parser).type, &op);
+        if (prec == 0 || prec < min_precedence) break;
+
+        uint loc = next(parser).loc;
+        ast_handle right = parse_binary(parser, prec + 1);
+        if (!right) return 0;
+
+        left = make_op_node(parser.module, op, left, right, { loc });
+    }
+
+    return left;
+}
+
+ast_handle parse_expression(Parser& parser) {
+    return parse_binary(parser, 1);
+}
+
+bool is_type_keyword(Token::Type type) {
+    switch (type) {
+    case Token::BoolType: case Token::CharType: case Token::ShortType: case Token::IntType: case Token::LongType:
+    case Token::FloatType: case Token::DoubleType:
+    case Token::Unsigned: case Token::Const:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//int x = 1; long long, unsigned and const are all accepted but read as int
+ast_handle parse_declaration(Parser& parser) {
+    uint loc = peek(parser).loc;
+    ValueType type = ValueType::Int;
+
+    while (is_type_keyword(peek(parser).type)) {
+        Token::Type keyword = next(parser).type;
+        if (keyword == Token::FloatType || keyword == Token::DoubleType) type = ValueType::Float;
+    }
+
+    ast_handle handle = make_node(parser, AST::Declaration, loc);
+    AST* node = get_node(parser, handle);
+    node->decl.type = type;
+    node->decl.id = parse_identifier(parser);
+    if (!node->decl.id) return 0;
+
+    if (match(parser, Token::Assign)) {
+        node->decl.value = parse_expression(parser);
+        if (!node->decl.value) return 0;
+    }
+
+    return handle;
+}
+
+bool compound_assign(Token::Type type, Operator::Type* op) {
+    switch (type) {
+    case Token::Assign_Add: *op = Operator::Add; return true;
+    case Token::Assign_Sub: *op = Operator::Sub; return true;
+    case Token::Assign_Mul: *op = Operator::Mul; return true;
+    case Token::Assign_Div: *op = Operator::Div; return true;
+    case Token::Assign_Mod: *op = Operator::Mod; return true;
+    default: return false;
+    }
+}
+
+//An expression, or an assignment when the expression is followed by = or one of the compound assignments
+ast_handle parse_simple_statement(Parser& parser) {
+    if (is_type_keyword(peek(parser).type)) return parse_declaration(parser);
+
+    ast_handle expr = parse_expression(parser);
+    if (!expr) return 0;
+
+    Operator::Type op = Operator::Add;
+    bool compound = compound_assign(peek(parser).type, &op);
+    if (!compound && peek(parser).type != Token::Assign) return expr;
+
+    uint loc = next(parser).loc;
+    if (get_node(parser, expr)->type != AST::Identifier) return fail(parser, "Can only assign to variables");
+
+    ast_handle handle = make_node(parser, AST::Assign, loc);
+    AST* node = get_node(parser, handle);
+    node->assign.compound = compound;
+    node->assign.op = op;
+    node->assign.target = expr;
+    node->assign.value = parse_expression(parser);
+    if (!node->assign.value) return 0;
+
+    return handle;
+}
+
+ast_handle parse_block(Parser& parser, uint loc, Token::Type end) {
+    ast_handle handle = make_node(parser, AST::Block, loc);
+
+    uint begin = parser.module.pending.length;
+    while (!parser.failed && !match(parser, end)) {
+        if (peek(parser).type == Token::End_Of_File) return fail(parser, "Expecting }");
+
+        ast_handle stmt = parse_statement(parser);
+        if (!stmt) break;
+
+        parser.module.pending.append(stmt);
+    }
+    if (parser.failed) return 0;
+
+    AST* node = get_node(parser, handle);
+    node->block.count = parser.module.pending.length - begin;
+    node->block.first = commit_children(parser.module, begin);
+    return handle;
+}
+
+ast_handle parse_condition(Parser& parser) {
+    if (!expect(parser, Token::Open_Paren, "Expecting (")) return 0;
+    ast_handle condition = parse_expression(parser);
+    if (!condition || !expect(parser, Token::Close_Paren, "Expecting )")) return 0;
+    return condition;
+}
+
+ast_handle parse_if(Parser& parser, uint loc) {
+    ast_handle handle = make_node(parser, AST::If, loc);
+    AST* node = get_node(parser, handle);
+
+    node->if_stmt.condition = parse_condition(parser);
+    if (!node->if_stmt.condition) return 0;
+
+    node->if_stmt.then = parse_statement(parser);
+    if (!node->if_stmt.then) return 0;
+
+    const Token& token = peek(parser);
+    if (token.type == Token::Elif || (token.type == Token::Else && parser.tokens[parser.i + 1].type == Token::If)) {
+        if (token.type == Token::Else) next(parser);
+        node->if_stmt.otherwise = parse_if(parser, next(parser).loc);
+    }
+    else if (match(parser, Token::Else)) {
+        node->if_stmt.otherwise = parse_statement(parser);
+    }
+
+    return parser.failed ? 0 : handle;
+}
+
+ast_handle parse_for(Parser& parser, uint loc) {
+    ast_handle handle = make_node(parser, AST::For, loc);
+    For& stmt = get_node(parser, handle)->for_stmt;
+
+    if (!expect(parser, Token::Open_Paren, "Expecting (")) return 0;
+    if (!match(parser, Token::Semicolon)) {
+        stmt.init = parse_simple_statement(parser);
+        if (!stmt.init || !expect(parser, Token::Semicolon, "Expecting ;")) return 0;
+    }
+    if (!match(parser, Token::Semicolon)) {
+        stmt.condition = parse_expression(parser);
+        if (!stmt.condition || !expect(parser, Token::Semicolon, "Expecting ;")) return 0;
+    }
+    if (!match(parser, Token::Close_Paren)) {
+        stmt.step = parse_simple_statement(parser);
+        if (!stmt.step || !expect(parser, Token::Close_Paren, "Expecting )")) return 0;
+    }
+
+    stmt.body = parse_statement(parser);
+    if (!stmt.body) return 0;
+
+    return handle;
+}
+
+ast_handle parse_statement(Parser& parser) {
+    const Token& token = peek(parser);
+
+    switch (token.type) {
+    case Token::Open_Bracket:
+        next(parser);
+        return parse_block(parser, token.loc, Token::Close_Bracket);
+    case Token::If:
+        next(parser);
+        return parse_if(parser, token.loc);
+    case Token::While: {
+        next(parser);
+        ast_handle handle = make_node(parser, AST::While, token.loc);
+        AST* node = get_node(parser, handle);
+        node->while_stmt.condition = parse_condition(parser);
+        if (!node->while_stmt.condition) return 0;
+        node->while_stmt.body = parse_statement(parser);
+        if (!node->while_stmt.body) return 0;
+        return handle;
+    }
+    case Token::For:
+        next(parser);
+        return parse_for(parser, token.loc);
+    case Token::Return: {
+        next(parser);
+        ast_handle handle = make_node(parser, AST::Return, token.loc);
+        if (!match(parser, Token::Semicolon)) {
+            AST* node = get_node(parser, handle);
+            node->ret.value = parse_expression(parser);
+            if (!node->ret.value || !expect(parser, Token::Semicolon, "Expecting ;")) return 0;
+        }
+        return handle;
+    }
+    case Token::Break:
+    case Token::Continue: {
+        next(parser);
+        ast_handle handle = make_node(parser, token.type == Token::Break ? AST::Break : AST::Continue, token.loc);
+        if (!expect(parser, Token::Semicolon, "Expecting ;")) return 0;
+        return handle;
+    }
+    case Token::Semicolon:
+        next(parser);
+        return make_node(parser, AST::Block, token.loc);
+    default: {
+        ast_handle handle = parse_simple_statement(parser);
+        if (!handle) return 0;
+
+        //the last expression of a cell may leave out the ;, its value is the result of the cell
+        AST::Type type = get_node(parser, handle)->type;
+        bool is_expression = type != AST::Declaration && type != AST::Assign;
+        if (is_expression && peek(parser).type == Token::End_Of_File) return handle;
+
+        if (!expect(parser, Token::Semicolon, "Expecting ;")) return 0;
+        return handle;
+    }
+    }
+}
+
+bool parse_tokens(AstModule& module, slice<Token> tokens, Diagnostic* error) {
+    reset_ast_module(module);
+
+    Parser parser{ module, tokens, 0, error, false };
+
+    ast_handle root = parse_block(parser, 0, Token::End_Of_File);
+    set_root(module, root);
+    return root != 0;
+}
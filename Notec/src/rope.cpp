@@ -0,0 +1,369 @@
+#include "rope.h"
+#include "core/memory/linear_allocator.h"
+#include <atomic>
+#include <stdlib.h>
+#include <string.h>
+
+//Leaves have no children and keep their text right after the node
+struct RopeNode {
+    std::atomic<uint> refs;
+    uint length;
+    uint newlines;
+    uint height; //leaves are 1
+    RopeNode* left;
+    RopeNode* right;
+    char* text;
+};
+
+//Snapshots can be released on another thread, so only the reference count is atomic
+RopeNode* retain(RopeNode* node) {
+    if (node) node->refs.fetch_add(1, std::memory_order_relaxed);
+    return node;
+}
+
+void release(RopeNode* node) {
+    while (node && node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        RopeNode* right = node->right;
+        release(node->left);
+        free(node);
+        node = right;
+    }
+}
+
+bool is_leaf(RopeNode* node) {
+    return node->height == 1;
+}
+
+uint height(RopeNode* node) {
+    return node ? node->height : 0;
+}
+
+uint count_newlines(const char* text, uint length) {
+    uint newlines = 0;
+    for (uint i = 0; i < length; i++) newlines += text[i] == '\n';
+    return newlines;
+}
+
+RopeNode* alloc_leaf(uint length) {
+    RopeNode* leaf = new (malloc(sizeof(RopeNode) + length)) RopeNode();
+    leaf->refs = 1;
+    leaf->length = length;
+    leaf->height = 1;
+    leaf->text = (char*)(leaf + 1);
+    return leaf;
+}
+
+RopeNode* make_leaf(const char* text, uint length) {
+    RopeNode* leaf = alloc_leaf(length);
+    memcpy(leaf->text, text, length);
+    leaf->newlines = count_newlines(text, length);
+    return leaf;
+}
+
+//Takes over the references to left and right
+RopeNode* make_node(RopeNode* left, RopeNode* right) {
+    if (!left) return right;
+    if (!right) return left;
+
+    RopeNode* node = new (malloc(sizeof(RopeNode))) RopeNode();
+    node->refs = 1;
+    node->length = left->length + right->length;
+    node->newlines = left->newlines + right->newlines;
+    node->height = 1 + (left->height > right->height ? left->height : right->height);
+    node->left = left;
+    node->right = right;
+    return node;
+}
+
+RopeNode* rotate_left(RopeNode* node) {
+    RopeNode* a = retain(node->left);
+    RopeNode* b = retain(node->right->left);
+    RopeNode* c = retain(node->right->right);
+    release(node);
+    return make_node(make_node(a, b), c);
+}
+
+RopeNode* rotate_right(RopeNode* node) {
+    RopeNode* a = retain(node->left->left);
+    RopeNode* b = retain(node->left->right);
+    RopeNode* c = retain(node->right);
+    release(node);
+    return make_node(a, make_node(b, c));
+}
+
+RopeNode* join(RopeNode* left, RopeNode* right);
+
+//AVL join, descends the taller tree until the heights are close and rebalances on the way up
+RopeNode* join_right(RopeNode* left, RopeNode* right) {
+    RopeNode* a = retain(left->left);
+    RopeNode* b = retain(left->right);
+    release(left);
+
+    RopeNode* joined = join(b, right);
+    if (joined->height <= a->height + 1) return make_node(a, joined);
+
+    if (height(joined->left) > height(joined->right)) joined = rotate_right(joined);
+    return rotate_left(make_node(a, joined));
+}
+
+RopeNode* join_left(RopeNode* left, RopeNode* right) {
+    RopeNode* a = retain(right->left);
+    RopeNode* b = retain(right->right);
+    release(right);
+
+    RopeNode* joined = join(left, a);
+    if (joined->height <= b->height + 1) return make_node(joined, b);
+
+    if (height(joined->right) > height(joined->left)) joined = rotate_left(joined);
+    return rotate_right(make_node(joined, b));
+}
+
+//Takes over both references, small neighbouring leaves are merged so typing does not fragment the text
+RopeNode* join(RopeNode* left, RopeNode* right) {
+    if (!left) return right;
+    if (!right) return left;
+
+    if (left->height > right->height + 1) return join_right(left, right);
+    if (right->height > left->height + 1) return join_left(left, right);
+
+    if (is_leaf(left) && is_leaf(right) && left->length + right->length <= ROPE_CHUNK) {
+        RopeNode* leaf = alloc_leaf(left->length + right->length);
+        memcpy(leaf->text, left->text, left->length);
+        memcpy(leaf->text + left->length, right->text, right->length);
+        leaf->newlines = left->newlines + right->newlines;
+        release(left);
+        release(right);
+        return leaf;
+    }
+
+    return make_node(left, right);
+}
+
+//Both halves are new references, node is left untouched
+void split(RopeNode* node, uint offset, RopeNode** left, RopeNode** right) {
+    if (!node || offset == 0) {
+        *left = nullptr;
+        *right = retain(node);
+    }
+    else if (offset >= node->length) {
+        *left = retain(node);
+        *right = nullptr;
+    }
+    else if (is_leaf(node)) {
+        *left = make_leaf(node->text, offset);
+        *right = make_leaf(node->text + offset, node->length - offset);
+    }
+    else if (offset <= node->left->length) {
+        RopeNode* middle;
+        split(node->left, offset, left, &middle);
+        *right = join(middle, retain(node->right));
+    }
+    else {
+        RopeNode* middle;
+        split(node->right, offset - node->left->length, &middle, right);
+        *left = join(retain(node->left), middle);
+    }
+}
+
+//Leaves are cut after a newline when there is one in the second half, so most lines do not cross two chunks
+RopeNode* build_rope(const char* text, uint length) {
+    if (length == 0) return nullptr;
+
+    uint max_leaves = length / (ROPE_CHUNK / 2) + 1;
+    RopeNode** nodes = TEMPORARY_ARRAY(RopeNode*, max_leaves);
+    uint count = 0;
+
+    for (uint i = 0; i < length;) {
+        uint end = i + ROPE_CHUNK;
+        if (end >= length) end = length;
+        else {
+            for (uint j = end; j > i + ROPE_CHUNK / 2; j--) {
+                if (text[j - 1] == '\n') {
+                    end = j;
+                    break;
+                }
+            }
+        }
+
+        nodes[count++] = make_leaf(text + i, end - i);
+        i = end;
+    }
+
+    while (count > 1) {
+        uint pairs = 0;
+        for (uint i = 0; i < count; i += 2) {
+            nodes[pairs++] = i + 1 < count ? join(nodes[i], nodes[i + 1]) : nodes[i];
+        }
+        count = pairs;
+    }
+
+    return nodes[0];
+}
+
+//Replaces the text when the edit stays within a single leaf, which copies only the path to it.
+//Returns null when it would cross leaves, leave an empty one or overflow it
+RopeNode* edit_leaf(RopeNode* node, uint offset, uint remove, string_view text) {
+    if (!node) return nullptr;
+
+    if (is_leaf(node)) {
+        uint length = node->length - remove + text.length;
+        if (length == 0 || length > ROPE_CHUNK) return nullptr;
+
+        uint tail = offset + remove;
+        RopeNode* leaf = alloc_leaf(length);
+        memcpy(leaf->text, node->text, offset);
+        memcpy(leaf->text + offset, text.data, text.length);
+        memcpy(leaf->text + offset + text.length, node->text + tail, node->length - tail);
+        leaf->newlines = count_newlines(leaf->text, length);
+        return leaf;
+    }
+
+    uint left_length = node->left->length;
+
+    if (offset + remove <= left_length) {
+        RopeNode* left = edit_leaf(node->left, offset, remove, text);
+        return left ? make_node(left, retain(node->right)) : nullptr;
+    }
+    if (offset >= left_length) {
+        RopeNode* right = edit_leaf(node->right, offset - left_length, remove, text);
+        return right ? make_node(retain(node->left), right) : nullptr;
+    }
+    return nullptr;
+}
+
+RopeNode* find_leaf(RopeNode* node, uint* offset) {
+    while (node && !is_leaf(node)) {
+        if (*offset < node->left->length) node = node->left;
+        else {
+            *offset -= node->left->length;
+            node = node->right;
+        }
+    }
+    return node;
+}
+
+Rope make_rope(string_view text) {
+    return { build_rope(text.data, text.length) };
+}
+
+Rope snapshot(Rope& rope) {
+    return { retain(rope.root) };
+}
+
+void destroy_rope(Rope& rope) {
+    release(rope.root);
+    rope.root = nullptr;
+}
+
+uint text_length(Rope& rope) {
+    return rope.root ? rope.root->length : 0;
+}
+
+char char_at(Rope& rope, uint offset) {
+    if (offset >= text_length(rope)) return '\0';
+
+    RopeNode* leaf = find_leaf(rope.root, &offset);
+    return leaf->text[offset];
+}
+
+uint line_count(Rope& rope) {
+    return rope.root ? rope.root->newlines + 1 : 1;
+}
+
+uint line_of_offset(Rope& rope, uint offset) {
+    RopeNode* node = rope.root;
+    uint line = 0;
+
+    while (node && !is_leaf(node)) {
+        if (offset < node->left->length) node = node->left;
+        else {
+            line += node->left->newlines;
+            offset -= node->left->length;
+            node = node->right;
+        }
+    }
+
+    if (node) line += count_newlines(node->text, offset < node->length ? offset : node->length);
+    return line;
+}
+
+uint line_start(Rope& rope, uint line) {
+    if (line == 0) return 0;
+    if (line >= line_count(rope)) return text_length(rope);
+
+    //find the newline that ends the previous line
+    RopeNode* node = rope.root;
+    uint offset = 0;
+
+    while (!is_leaf(node)) {
+        if (line <= node->left->newlines) node = node->left;
+        else {
+            line -= node->left->newlines;
+            offset += node->left->length;
+            node = node->right;
+        }
+    }
+
+    uint i = 0;
+    for (; i < node->length; i++) {
+        if (node->text[i] == '\n' && --line == 0) break;
+    }
+    return offset + i + 1;
+}
+
+uint line_end(Rope& rope, uint line) {
+    return line + 1 < line_count(rope) ? line_start(rope, line + 1) : text_length(rope);
+}
+
+void insert_text(Rope& rope, uint offset, string_view text) {
+    if (text.length == 0) return;
+
+    RopeNode* root = edit_leaf(rope.root, offset, 0, text);
+    if (!root) {
+        RopeNode *left, *right;
+        split(rope.root, offset, &left, &right);
+        root = join(join(left, build_rope(text.data, text.length)), right);
+    }
+
+    release(rope.root);
+    rope.root = root;
+}
+
+void remove_text(Rope& rope, uint offset, uint length) {
+    if (length == 0) return;
+
+    RopeNode* root = edit_leaf(rope.root, offset, length, {});
+    if (!root) {
+        RopeNode *left, *rest, *removed, *right;
+        split(rope.root, offset, &left, &rest);
+        split(rest, length, &removed, &right);
+        release(rest);
+        release(removed);
+        root = join(left, right);
+    }
+
+    release(rope.root);
+    rope.root = root;
+}
+
+string_view rope_chunk(Rope& rope, uint offset) {
+    if (offset >= text_length(rope)) return {};
+
+    RopeNode* leaf = find_leaf(rope.root, &offset);
+    return { leaf->text + offset, leaf->length - offset };
+}
+
+string_view copy_temporary_text(Rope& rope, uint begin, uint end) {
+    string_view chunk = rope_chunk(rope, begin);
+    if (end - begin <= chunk.length) return { chunk.data, end - begin };
+
+    char* text = TEMPORARY_ARRAY(char, end - begin + 1);
+    for (uint i = begin; i < end; i += chunk.length) {
+        chunk = rope_chunk(rope, i);
+        if (chunk.length > end - i) chunk.length = end - i;
+        memcpy(text + i - begin, chunk.data, chunk.length);
+    }
+    text[end - begin] = '\0';
+
+    return { text, end - begin };
+}
@@ -0,0 +1,141 @@
+#include "bytecode.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+//Each handler jumps straight to the handler of the next instruction through a table of label addresses,
+//which gives every handler its own indirect branch for the predictor. Other compilers use a switch.
+//Handlers read their operands through ins, so the dispatch is short enough for GCC to copy into each of them
+#if defined(__GNUC__) || defined(__clang__)
+#define NOTEC_COMPUTED_GOTO
+#endif
+
+Builtin builtins[] = {
+    { "sqrt", sqrt },
+    { "sin", sin },
+    { "cos", cos },
+    { "tan", tan },
+    { "exp", exp },
+    { "log", log },
+    { "floor", floor },
+    { "ceil", ceil },
+    { "abs", fabs },
+};
+
+slice<Builtin> get_builtins() {
+    return { builtins, sizeof(builtins) / sizeof(Builtin) };
+}
+
+bool run_bytecode(const Bytecode& bytecode, Value* result, Diagnostic* error) {
+    i64 ints[MAX_REGISTERS];
+    double floats[MAX_REGISTERS];
+    memset(ints, 0, sizeof(i64) * bytecode.int_registers);
+    memset(floats, 0, sizeof(double) * bytecode.float_registers);
+
+    const Instruction* code = bytecode.code.data;
+    const Instruction* pc = code;
+    const i64* int_constants = bytecode.int_constants.data;
+    const double* float_constants = bytecode.float_constants.data;
+    const Instruction* ins;
+
+    *result = { ValueType::Void };
+
+#ifdef NOTEC_COMPUTED_GOTO
+    #define NOTEC_OPCODE_LABEL(name) &&op_##name,
+    static const void* dispatch[] = { NOTEC_OPCODES(NOTEC_OPCODE_LABEL) };
+    static_assert(sizeof(dispatch) / sizeof(void*) == (uint)Opcode::Count, "Dispatch table is missing opcodes");
+
+    #define CASE(name) op_##name:
+    #define NEXT() ins = pc++; goto *dispatch[(uint)ins->op]
+    NEXT();
+#else
+    #define CASE(name) case Opcode::name:
+    #define NEXT() continue
+    for (;;) {
+    ins = pc++;
+    switch (ins->op) {
+#endif
+
+    CASE(LoadInt) ints[ins->a] = int_constants[ins->bx()]; NEXT();
+    CASE(LoadIntImm) ints[ins->a] = ins->sbx(); NEXT();
+    CASE(LoadFloat) floats[ins->a] = float_constants[ins->bx()]; NEXT();
+
+    CASE(MovInt) ints[ins->a] = ints[ins->b]; NEXT();
+    CASE(MovFloat) floats[ins->a] = floats[ins->b]; NEXT();
+    CASE(IntToFloat) floats[ins->a] = (double)ints[ins->b]; NEXT();
+    CASE(FloatToInt) ints[ins->a] = (i64)floats[ins->b]; NEXT();
+
+    CASE(AddInt) ints[ins->a] = add_int(ints[ins->b], ints[ins->c]); NEXT();
+    CASE(AddIntImm) ints[ins->a] = add_int(ints[ins->b], (signed char)ins->c); NEXT();
+    CASE(SubInt) ints[ins->a] = sub_int(ints[ins->b], ints[ins->c]); NEXT();
+    CASE(MulInt) ints[ins->a] = mul_int(ints[ins->b], ints[ins->c]); NEXT();
+    CASE(DivInt) {
+        if (ints[ins->c] == 0) goto division_by_zero;
+        ints[ins->a] = div_int(ints[ins->b], ints[ins->c]);
+        NEXT();
+    }
+    CASE(ModInt) {
+        if (ints[ins->c] == 0) goto division_by_zero;
+        ints[ins->a] = mod_int(ints[ins->b], ints[ins->c]);
+        NEXT();
+    }
+    CASE(NegInt) ints[ins->a] = neg_int(ints[ins->b]); NEXT();
+
+    CASE(AddFloat) floats[ins->a] = floats[ins->b] + floats[ins->c]; NEXT();
+    CASE(SubFloat) floats[ins->a] = floats[ins->b] - floats[ins->c]; NEXT();
+    CASE(MulFloat) floats[ins->a] = floats[ins->b] * floats[ins->c]; NEXT();
+    CASE(DivFloat) floats[ins->a] = floats[ins->b] / floats[ins->c]; NEXT();
+    CASE(NegFloat) floats[ins->a] = -floats[ins->b]; NEXT();
+
+    CASE(LtInt) ints[ins->a] = ints[ins->b] < ints[ins->c]; NEXT();
+    CASE(LteInt) ints[ins->a] = ints[ins->b] <= ints[ins->c]; NEXT();
+    CASE(EqInt) ints[ins->a] = ints[ins->b] == ints[ins->c]; NEXT();
+    CASE(NeqInt) ints[ins->a] = ints[ins->b] != ints[ins->c]; NEXT();
+    CASE(LtFloat) ints[ins->a] = floats[ins->b] < floats[ins->c]; NEXT();
+    CASE(LteFloat) ints[ins->a] = floats[ins->b] <= floats[ins->c]; NEXT();
+    CASE(EqFloat) ints[ins->a] = floats[ins->b] == floats[ins->c]; NEXT();
+    CASE(NeqFloat) ints[ins->a] = floats[ins->b] != floats[ins->c]; NEXT();
+
+    CASE(Jump) pc += ins->sbx(); NEXT();
+    CASE(JumpIfZero) if (ints[ins->a] == 0) pc += ins->sbx(); NEXT();
+    CASE(JumpIfNotZero) if (ints[ins->a] != 0) pc += ins->sbx(); NEXT();
+
+    CASE(TestLtInt) if ((ints[ins->a] < ints[ins->b]) != ins->c) pc++; NEXT();
+    CASE(TestLteInt) if ((ints[ins->a] <= ints[ins->b]) != ins->c) pc++; NEXT();
+    CASE(TestEqInt) if ((ints[ins->a] == ints[ins->b]) != ins->c) pc++; NEXT();
+    CASE(TestNeqInt) if ((ints[ins->a] != ints[ins->b]) != ins->c) pc++; NEXT();
+    CASE(TestLtFloat) if ((floats[ins->a] < floats[ins->b]) != ins->c) pc++; NEXT();
+    CASE(TestLteFloat) if ((floats[ins->a] <= floats[ins->b]) != ins->c) pc++; NEXT();
+    CASE(TestEqFloat) if ((floats[ins->a] == floats[ins->b]) != ins->c) pc++; NEXT();
+    CASE(TestNeqFloat) if ((floats[ins->a] != floats[ins->b]) != ins->c) pc++; NEXT();
+
+    CASE(CallFloat) floats[ins->a] = builtins[ins->c].func(floats[ins->b]); NEXT();
+    CASE(PrintInt) printf("%lld\n", (long long)ints[ins->a]); NEXT();
+    CASE(PrintFloat) printf("%g\n", floats[ins->a]); NEXT();
+
+    CASE(ReturnInt) {
+        result->type = ValueType::Int;
+        result->int_value = ints[ins->a];
+        return true;
+    }
+    CASE(ReturnFloat) {
+        result->type = ValueType::Float;
+        result->float_value = floats[ins->a];
+        return true;
+    }
+    CASE(Return) return true;
+
+#ifndef NOTEC_COMPUTED_GOTO
+    default: return true;
+    }
+    }
+#endif
+
+    #undef CASE
+    #undef NEXT
+
+division_by_zero:
+    error->loc = { bytecode.locs[pc - code - 1] };
+    snprintf(error->message, sizeof(error->message), "Integer division by zero");
+    return false;
+}
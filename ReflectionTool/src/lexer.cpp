@@ -12,9 +12,9 @@
 #include <string.h>
 #include "string.h"
 #include "core/container/tvector.h"
-#include "core/container/array.h"
 #include "helper.h"
 #include "core/memory/linear_allocator.h"
+#include "core/lexing.h"
 
 namespace pixc {
     namespace lexer {
@@ -38,6 +38,7 @@ namespace pixc {
         }
         
         bool is_int(string tok) {
+            if (!is_digit(tok[0])) return false;
             if (tok[0] == '0' && !(tok == "0")) return false;
             
             for (int i = 0; i < tok.length; i++) {
@@ -54,8 +55,10 @@ namespace pixc {
         bool is_identifier(string tok) {
             if (!is_character(tok[0])) return false;
             
-            for (int i = 1; i < tok.length; i++) {
-                if (!(is_character(tok[i])|| is_digit(tok[i]))) return false;
+            //is_character also accepts the symbols between Z and a, which the wide scan stops at
+            const char* end = tok.data + tok.length;
+            for (const char* c = skip_identifier(tok.data + 1, end); c < end; c++) {
+                if (!(is_character(*c) || is_digit(*c))) return false;
             }
             
             return true;
@@ -65,15 +68,26 @@ namespace pixc {
             add_token(lexer, lexer.tok.length, lexer.column - lexer.tok.length, group, type, lbp, has_value ? lexer.tok : string());
         }
         
-        struct KeywordDesc {
-            string name;
-            TokenGroup group;
-            TokenType type;
-            unsigned int lbp;
-            bool has_value;
+        constexpr KeywordDesc<TokenType> keyword_descs[] = {
+            { "#pragma", Pragma },
+            { "#define", Define },
+            { "namespace", Namespace },
+            { "struct", Struct },
+            { "enum", Enum },
+            { "union", Union },
+            { "int", IntType },
+            { "uint", UintType },
+            { "i64", I64Type },
+            { "u64", U64Type },
+            { "float", FloatType },
+            { "bool", BoolType },
+            { "char", CharType },
+            { "static", Static },
+            { "constexpr", Constexpr },
+            { "using", Using },
         };
         
-        array<20, KeywordDesc> keywords = {};
+        constexpr auto keywords = make_keyword_table(keyword_descs);
         
         error::Error* make_error(Lexer& lexer) {
             error::Error* err = lexer.err;
@@ -83,11 +97,8 @@ namespace pixc {
         }
         
         void match_token(Lexer& lexer) {
-            for (int i = 0; i < keywords.length; i++) {
-                if (lexer.tok == keywords[i].name) {
-                    return add_tok(lexer, keywords[i].group, keywords[i].type, keywords[i].lbp, keywords[i].has_value);
-                }
-            }
+            TokenType type;
+            if (keywords.lookup(lexer.tok, &type)) return add_tok(lexer, Keyword, type, 0);
             
             if (is_int(lexer.tok)) { add_tok(lexer, Literal, Int, 0, true); }
             else if (is_identifier(lexer.tok)) { add_tok(lexer, Symbol, Identifier, 0, true); }
@@ -141,18 +152,6 @@ namespace pixc {
             type_to_string[type] = s;
         }
         
-        void add_keyword(string name, TokenGroup group, TokenType type, unsigned int lbp = 0, bool has_value = false) {
-            KeywordDesc desc = {};
-            desc.name = name;
-            desc.group = group;
-            desc.type = type;
-            desc.lbp = lbp;
-            desc.has_value = has_value;
-            
-            keywords.append(desc);
-            type_to_string[type] = name;
-        }
-        
         void init() {
 			linear_allocator = LinearAllocator(kb(10));
 
@@ -175,25 +174,9 @@ namespace pixc {
             add_delimitter("::", Operator, DoubleColon, 5);
             add_delimitter('=', Operator, AssignOp, 5);
             
-            add_keyword("#pragma", Keyword, Pragma);
-            add_keyword("#define", Keyword, Define);
-            add_keyword("namespace", Keyword, Namespace);
-            add_keyword("struct", Keyword, Struct);
-            add_keyword("enum", Keyword, Enum);
-			add_keyword("union", Keyword, Union);
-            add_keyword("int", Keyword, IntType);
-            add_keyword("uint", Keyword, UintType);
-			add_keyword("i64", Keyword, I64Type);
-			add_keyword("u64", Keyword, U64Type);
-            add_keyword("float", Keyword, FloatType);
-            add_keyword("bool", Keyword, BoolType);
-            add_keyword("char", Keyword, CharType);
-			//add_keyword("sstring", Keyword, SStringType);
-			//add_keyword("string_view", Keyword, StringViewType);
-			//add_keyword("string_", Keyword, );
-            add_keyword("static", Keyword, Static);
-            add_keyword("constexpr", Keyword, Constexpr);
-			add_keyword("using", Keyword, Using);
+            for (const KeywordDesc<TokenType>& desc : keyword_descs) {
+                type_to_string[desc.type] = desc.name;
+            }
         }
         
         void match_delimitter(Lexer& lexer, Delimitter& d) {
@@ -221,30 +204,38 @@ namespace pixc {
             lexer.line = 1;
 
 			uint length = lexer.input.length;
+			const char* src = lexer.input.data;
+			const char* end = src + length;
             
             for (lexer.i = 0; lexer.i < length; lexer.i++, lexer.column++) {
                 char c = lexer.input[lexer.i];
 				bool can_look_ahead = lexer.i + 1 < length;
                 
-                Delimitter& d = delimitters[c];
+                Delimitter& d = delimitters[(u8)c];
                 
+                //runs of blanks, identifiers and comments are skipped with the wide scans in core/lexing.h
                 if (c == ' ' || c == '\r' || c == '\t') {
                     reset_tok(lexer);
+                    
+                    int blanks = skip_blanks(src + lexer.i + 1, end) - (src + lexer.i + 1);
+                    lexer.i += blanks;
+                    lexer.column += blanks;
+                    lexer.tok.data = src + lexer.i + 1;
                 }
                 else if (c == '/' && can_look_ahead && lexer.input[lexer.i + 1] == '/') {
-                    while (lexer.i < length && lexer.input[lexer.i] != '\n') {
-                        lexer.i++;
-                    }
+                    reset_tok(lexer);
+                    
+                    lexer.i = find_char(src + lexer.i, end, '\n') - src;
                     lexer.line++;
+                    lexer.tok.data = src + lexer.i + 1;
                 }
-                else if (c == '/' && lexer.input[lexer.i + 1] == '*') {
+                else if (c == '/' && can_look_ahead && lexer.input[lexer.i + 1] == '*') {
                     reset_tok(lexer);
                     
-                    while (lexer.i + 1 < lexer.input.length && !(lexer.input[lexer.i] == '*' && lexer.input[lexer.i+1] == '/')) {
-                        
-                        lexer.i++;
-                        if (lexer.input[lexer.i] == '\n') lexer.i++;
-                    }
+                    const char* close = find_comment_end(src + lexer.i + 2, end);
+                    lexer.line += count_char(src + lexer.i, close, '\n');
+                    lexer.i = close + 1 < end ? close + 1 - src : length;
+                    lexer.tok.data = src + lexer.i + 1;
                 }
                 else if (c == '\n') {
                     reset_tok(lexer);
@@ -254,7 +245,12 @@ namespace pixc {
                     match_delimitter(lexer, d);
                 }
                 else {
-                    lexer.tok.length++;
+                    int run = skip_identifier(src + lexer.i, end) - (src + lexer.i);
+                    if (run == 0) run = 1;
+                    
+                    lexer.tok.length += run;
+                    lexer.i += run - 1;
+                    lexer.column += run - 1;
                 }
                 
                 if (error::is_error(lexer.err)) return {};
@@ -18,9 +18,12 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <sys/stat.h>
+#include <thread>
+#include <atomic>
 #include "core/serializer.h"
+#include "core/time.h"
 
-#ifdef __APPLE__
+#ifndef NE_PLATFORM_WINDOWS
 #define _stat stat
 #endif
 
@@ -479,6 +482,8 @@ namespace pixc::reflection::compiler {
             unexpected(ref, token);
             return nullptr;
         }
+        
+        return enum_type;
     }
 
     void parse_alias(Reflector& ref, uint flags) {
@@ -573,6 +578,8 @@ namespace pixc::reflection::compiler {
                         if (--bracket_count == 0) break;
                     }
                 };
+                //a brace initializer is still followed by the semicolon, a function body is not
+                if (ref.tokens[ref.i].type == lexer::Close_Bracket && ref.tokens[ref.i + 1].type == lexer::SemiColon) ref.i++;
                 continue;
             }
             else if (token.type == lexer::Struct) {
@@ -885,12 +892,155 @@ namespace pixc::reflection::compiler {
         }
     }
 
+    //Value types outside of the reflected headers that are known to be written as their bytes
+    const char* BYTE_COPYABLE_REFS[] = { "sstring", "vec2", "vec3", "vec4", "quat", "mat3", "mat4" };
+
+    //Types whose serialized form is exactly their bytes in memory, so consecutive fields and whole arrays
+    //of them are written with a single copy. Unlike is_trivially_copyable, unknown struct refs are not assumed to be.
+    //Enums are written as an int whatever their size. array<N, T> is copied whole with its length, the same way
+    //the trivially copyable structs that contain one are written
+    bool is_pod(Reflector& reflector, Type* type) {
+        switch (type->type) {
+        case Type::Int:
+        case Type::Uint:
+        case Type::I64:
+        case Type::U64:
+        case Type::Bool:
+        case Type::Float:
+        case Type::Double:
+        case Type::Char:
+        case Type::SString:
+            return true;
+        case Type::Alias: return is_pod(reflector, ((AliasType*)type)->aliasing);
+        case Type::StructRef: {
+            StructRef* struct_ref = (StructRef*)type;
+
+            Type* found = find_type(reflector, struct_ref->name.full);
+            if (found) return found->type != Type::Enum && is_trivially_copyable(reflector, found);
+
+            for (const char* name : BYTE_COPYABLE_REFS) {
+                if (strcmp(struct_ref->name.full, name) == 0) return true;
+            }
+            return false;
+        }
+        case Type::Array: {
+            Array* array_type = (Array*)type;
+            bool fixed_size = array_type->arr_type == Array::CArray || array_type->arr_type == Array::StaticArray;
+            return fixed_size && is_pod(reflector, array_type->element);
+        }
+        default: return false;
+        }
+    }
+
+    //One past the last field of the run of pod fields starting at first
+    uint end_of_pod_run(Reflector& reflector, tvector<Field>& fields, uint first) {
+        uint end = first;
+        while (end < fields.length && is_pod(reflector, fields[end].type)) end++;
+        return end;
+    }
+
+    void dump_run_size(FILE* f, slice<Field> run) {
+        for (uint i = 0; i < run.length; i++) fprintf(f, i == 0 ? "sizeof(data.%s)" : " + sizeof(data.%s)", run[i].name);
+    }
+
+    //The fields are packed without the padding between them, as if each was written on its own.
+    //A run without padding or ignored fields in between is a single copy, the others are staged on the stack
+    //so there is still a single capacity check for the whole run
+    void copy_pod_run(FILE* f, bool write, const char* type_name, slice<Field> run) {
+        const char* copy_func = write ? "write_n_to_buffer" : "read_n_from_buffer";
+
+        if (run.length == 1) {
+            fprintf(f, "    %s(buffer, &data.%s, sizeof(data.%s));\n", copy_func, run[0].name, run[0].name);
+            return;
+        }
+
+        Field& first = run[0];
+        Field& last = run[run.length - 1];
+
+        //known at compile time, so only one of the branches is kept
+        fprintf(f, "    if (offsetof(%s, %s) + sizeof(data.%s) - offsetof(%s, %s) == ", type_name, last.name, last.name, type_name, first.name);
+        dump_run_size(f, run);
+        fprintf(f, ") {\n");
+        fprintf(f, "    %s(buffer, &data.%s, ", copy_func, first.name);
+        dump_run_size(f, run);
+        fprintf(f, ");\n");
+        fprintf(f, "    }\n");
+
+        fprintf(f, "    else {\n");
+        fprintf(f, "    char run[");
+        dump_run_size(f, run);
+        fprintf(f, "];\n");
+        fprintf(f, "    char* at = run;\n");
+
+        if (!write) fprintf(f, "    read_n_from_buffer(buffer, run, sizeof(run));\n");
+
+        for (Field& field : run) {
+            if (write) fprintf(f, "    memcpy(at, &data.%s, sizeof(data.%s)); ", field.name, field.name);
+            else fprintf(f, "    memcpy(&data.%s, at, sizeof(data.%s)); ", field.name, field.name);
+            fprintf(f, "at += sizeof(data.%s);\n", field.name);
+        }
+
+        if (write) fprintf(f, "    write_n_to_buffer(buffer, run, sizeof(run));\n");
+        fprintf(f, "    }\n");
+    }
+
+    //FNV-1a, so field ids and layout hashes are the same in every run of the tool
+    u64 hash_layout(u64 hash, const char* str) {
+        for (; *str; str++) {
+            hash ^= (u8)*str;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    u64 hash_layout(u64 hash, uint value) {
+        for (uint i = 0; i < 4; i++) {
+            hash ^= (value >> (i * 8)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    //Hashes the names, kinds and order of the fields
+    u64 layout_hash(Reflector& reflector, Type* type, u64 hash) {
+        hash = hash_layout(hash, (uint)type->type);
+
+        switch (type->type) {
+        case Type::Enum: return hash_layout(hash, ((EnumType*)type)->name.full);
+        case Type::Alias: return layout_hash(reflector, ((AliasType*)type)->aliasing, hash);
+        case Type::Array: {
+            Array* array_type = (Array*)type;
+            hash = hash_layout(hash, (uint)array_type->arr_type);
+            hash = hash_layout(hash, array_type->num);
+            return layout_hash(reflector, array_type->element, hash);
+        }
+        case Type::Union:
+        case Type::Struct: {
+            StructType* struct_type = (StructType*)type;
+            for (Field& field : struct_type->fields) {
+                hash = hash_layout(hash, field.name);
+                hash = layout_hash(reflector, field.type, hash);
+            }
+            return hash;
+        }
+        case Type::StructRef: {
+            StructRef* struct_ref = (StructRef*)type;
+            hash = hash_layout(hash, struct_ref->name.full);
+
+            //types by value cannot contain themselves, the ones behind a vector are only known by name
+            Type* found = find_type(reflector, struct_ref->name.full);
+            if (found && is_trivially_copyable(reflector, found)) hash = layout_hash(reflector, found, hash);
+            return hash;
+        }
+        default: return hash;
+        }
+    }
+
     void write_trivial_to_buffer(FILE* f, const char* type, const char* name) {
         fprintf(f, "    write_n_to_buffer(buffer, &%s, sizeof(%s));\n", name, type);
     }
 
-    //todo optimization, if the struct is trivially copyable simply write_n_to_buffer
-    void serialize_type(FILE* f, Type* type, const char* name) {
+    void serialize_type(FILE* f, Reflector& reflector, Type* type, const char* name) {
         //fprintf(f, "    write_to_buffer(buffer, %s);\n", name);
 
         switch (type->type) {
@@ -929,8 +1079,14 @@ namespace pixc::reflection::compiler {
                 snprintf(length_str, 100, "%s.length", name);
             }
 
+            if (is_pod(reflector, array_type->element)) {
+                if (array_type->arr_type == Array::CArray) fprintf(f, "    write_n_to_buffer(buffer, %s, sizeof(%s));\n", name, name);
+                else fprintf(f, "    write_n_to_buffer(buffer, %s.data, sizeof(%s.data[0]) * %s.length);\n", name, name, name);
+                break;
+            }
+
             fprintf(f, "	for (uint i = 0; i < %s; i++) {\n     ", length_str);
-            serialize_type(f, array_type->element, write_to);
+            serialize_type(f, reflector, array_type->element, write_to);
             fprintf(f, "    }\n");
         }
         }
@@ -940,8 +1096,7 @@ namespace pixc::reflection::compiler {
         fprintf(f, "    read_n_from_buffer(buffer, &%s, sizeof(%s));\n", name, type);
     }
 
-    //todo optimization, if the struct is trivially copyable simply write_n_to_buffer
-    void deserialize_type(FILE* f, Type* type, const char* name) {
+    void deserialize_type(FILE* f, Reflector& reflector, Type* type, const char* name) {
         //fprintf(f, "    write_to_buffer(buffer, %s);\n", name);
 
         switch (type->type) {
@@ -983,8 +1138,14 @@ namespace pixc::reflection::compiler {
                 snprintf(length_str, 100, "%s.length", name);
             }
 
+            if (is_pod(reflector, array_type->element)) {
+                if (array_type->arr_type == Array::CArray) fprintf(f, "    read_n_from_buffer(buffer, %s, sizeof(%s));\n", name, name);
+                else fprintf(f, "    read_n_from_buffer(buffer, %s.data, sizeof(%s.data[0]) * %s.length);\n", name, name, name);
+                break;
+            }
+
             fprintf(f, "	for (uint i = 0; i < %s; i++) {\n     ", length_str);
-            deserialize_type(f,  array_type->element, write_to);
+            deserialize_type(f, reflector, array_type->element, write_to);
             fprintf(f, "    }\n");
         }
         }
@@ -993,15 +1154,20 @@ namespace pixc::reflection::compiler {
 
     void dump_enum_reflector(FILE* f, FILE* h, EnumType* type, const char* linking) {
         Name& name = type->name;
-        
-        fprintf(f, "refl::Enum init_%s() {\n", type->name.full);
-        fprintf(f, "	refl::Enum type(\"%s\", sizeof(%s));\n", type->name.iden, type->name.type);
 
-        for (Constant& constant : type->values) {
-            fprintf(f, "	type.values.append({ \"%s\", %s::%s });\n", constant.name, type->name.type, constant.name);
-        }
+        fprintf(f, "namespace {\n");
+        if (type->values.length > 0) {
+            fprintf(f, "refl::Enum::Value %s_values[] = {\n", name.full);
+            for (Constant& constant : type->values) {
+                fprintf(f, "	{ { \"%s\", %i }, (int)%s::%s },\n", constant.name, (int)strlen(constant.name), name.type, constant.name);
+            }
+            fprintf(f, "};\n\n");
 
-        fprintf(f, "	return type;\n");
+            fprintf(f, "refl::Enum %s_type(\"%s\", sizeof(%s), %s_values);\n", name.full, name.iden, name.type, name.full);
+        }
+        else {
+            fprintf(f, "refl::Enum %s_type(\"%s\", sizeof(%s));\n", name.full, name.iden, name.type);
+        }
         fprintf(f, "}\n\n");
 
         if (type->is_class) {
@@ -1015,8 +1181,7 @@ namespace pixc::reflection::compiler {
         }
 
         fprintf(f, "refl::Enum* get_%s_type() {\n", type->name.full);
-        fprintf(f, "	static refl::Enum type = init_%s();\n", type->name.full);
-        fprintf(f, "	return &type;\n");
+        fprintf(f, "	return &%s_type;\n", type->name.full);
         fprintf(f, "}\n");
 
         fprintf(h, "%s refl::Enum* get_%s_type();\n", linking, type->name.full);
@@ -1026,44 +1191,83 @@ namespace pixc::reflection::compiler {
         return NULL;
     }
 
-    void dump_type_ref(FILE* f, Type* type) {
+    //Types with a table in this file are referred to by address, which keeps the tables constant,
+    //the others are only reachable through their get function
+    bool has_static_table(Type* type) {
+        if (!type) return false;
+        if (type->type == Type::Enum) return true;
+        return type->type == Type::Struct && !(((StructType*)type)->flags & ENTITY_FLAG_TAG);
+    }
+
+    void dump_table_decls(FILE* f, Namespace* space) {
+        for (Namespace* child : space->namespaces) dump_table_decls(f, child);
+
+        for (EnumType* type : space->enums) fprintf(f, "extern refl::Enum %s_type;\n", type->name.full);
+        for (StructType* type : space->structs) {
+            if (has_static_table(type)) fprintf(f, "extern refl::Struct %s_type;\n", type->name.full);
+        }
+    }
+
+    //Same names make_vector_type and the others gave arrays, with the element spelled as in the source
+    //when its refl::Type is not known here
+    void dump_type_name(FILE* f, Reflector& reflector, Type* type) {
         switch (type->type) {
-        case Type::Bool: fprintf(f, "get_bool_type()"); break;
-        case Type::Uint: fprintf(f, "get_uint_type()"); break;
-        case Type::Int: fprintf(f, "get_int_type()"); break;
-        case Type::U64: fprintf(f, "get_u64_type()"); break;
-        case Type::I64: fprintf(f, "get_i64_type()"); break;
-        case Type::Float: fprintf(f, "get_float_type()"); break;
+        case Type::Bool: fprintf(f, "bool"); break;
+        case Type::Uint: fprintf(f, "uint"); break;
+        case Type::Int: fprintf(f, "int"); break;
+        case Type::U64: fprintf(f, "u64"); break;
+        case Type::I64: fprintf(f, "i64"); break;
+        case Type::Float: fprintf(f, "float"); break;
         case Type::Array: {
             Array* array = (Array*)type;
 
             switch (array->arr_type) {
-            case Array::Vector:  fprintf(f, "make_vector_type("); break;
-            case Array::TVector: fprintf(f, "make_tvector_type("); break;
-            case Array::StaticArray:
-                fprintf(f, "make_array_type(%i, sizeof(array<%i, ", array->num, array->num);
-                dump_type(f, array->element);
-                fprintf(f, ">), ");
-                break;
+            case Array::Vector: fprintf(f, "vector<"); break;
+            case Array::TVector: fprintf(f, "tvector<"); break;
+            case Array::StaticArray: fprintf(f, "array<%i, ", array->num); break;
+            }
 
+            dump_type_name(f, reflector, array->element);
 
-            case Array::CArray: fprintf(f, "make_carray_type(%i, ", array->num); break;
-            }
+            if (array->arr_type == Array::CArray) fprintf(f, "[%i]", array->num);
+            else fprintf(f, ">");
+            break;
+        }
 
-            dump_type_ref(f, array->element);
-            fprintf(f, ")");
+        case Type::StructRef: {
+            StructRef* ref = (StructRef*)type;
+            Type* found = find_type(reflector, ref->name.full);
+
+            if (found && found->type == Type::Enum) fprintf(f, "%s", ((EnumType*)found)->name.iden);
+            else if (found) fprintf(f, "%s", ref->name.full);
+            else fprintf(f, "%s", ref->name.type);
             break;
         }
 
+        case Type::Enum: fprintf(f, "%s", ((EnumType*)type)->name.iden); break;
+        }
+    }
+
+    void dump_type_ref(FILE* f, Reflector& reflector, Type* type, const char* var) {
+        switch (type->type) {
+        case Type::Bool: fprintf(f, "get_bool_type()"); break;
+        case Type::Uint: fprintf(f, "get_uint_type()"); break;
+        case Type::Int: fprintf(f, "get_int_type()"); break;
+        case Type::U64: fprintf(f, "get_u64_type()"); break;
+        case Type::I64: fprintf(f, "get_i64_type()"); break;
+        case Type::Float: fprintf(f, "get_float_type()"); break;
+        case Type::Array: fprintf(f, "&%s", var); break;
+
         case Type::StructRef: {
             StructRef* ref = (StructRef*)type;
-            fprintf(f, "get_%s_type()", ref->name.full);
+            if (has_static_table(find_type(reflector, ref->name.full))) fprintf(f, "&%s_type", ref->name.full);
+            else fprintf(f, "get_%s_type()", ref->name.full);
             break;
         }
 
         case Type::Enum: {
             EnumType* ref = (EnumType*)type;
-            fprintf(f, "get_%s_type()", ref->name.full);
+            fprintf(f, "&%s_type", ref->name.full);
             break;
         }
 
@@ -1071,7 +1275,41 @@ namespace pixc::reflection::compiler {
         }
     }
 
-    void serialize_tagged_union(FILE* f, const char* type_name, UnionType* type, EnumType* tag, const char* variable, void(*serialize_type)(FILE*, Type*, const char*)) {
+    //Arrays have no get function, every array in a table gets its own refl::Array named after the field,
+    //an array of arrays adds _element for each level
+    void dump_array_types(FILE* f, Reflector& reflector, Type* type, const char* var) {
+        if (type->type != Type::Array) return;
+        Array* array = (Array*)type;
+
+        char element_var[200];
+        snprintf(element_var, 200, "%s_element", var);
+        dump_array_types(f, reflector, array->element, element_var);
+
+        fprintf(f, "refl::Array %s(", var);
+
+        switch (array->arr_type) {
+        case Array::Vector: fprintf(f, "refl::Array::Vector, sizeof(vector<char>)"); break;
+        case Array::TVector: fprintf(f, "refl::Array::TVector, sizeof(tvector<char>)"); break;
+        case Array::StaticArray:
+            fprintf(f, "refl::Array::StaticArray, sizeof(array<%i, ", array->num);
+            dump_type(f, array->element);
+            fprintf(f, ">)");
+            break;
+        case Array::CArray:
+            fprintf(f, "refl::Array::CArray, sizeof(void*) + sizeof(");
+            dump_type(f, array->element);
+            fprintf(f, ") * %i", array->num);
+            break;
+        }
+
+        fprintf(f, ", \"");
+        dump_type_name(f, reflector, array);
+        fprintf(f, "\", ");
+        dump_type_ref(f, reflector, array->element, element_var);
+        fprintf(f, ", %i);\n", array->num);
+    }
+
+    void serialize_tagged_union(FILE* f, Reflector& reflector, const char* type_name, UnionType* type, EnumType* tag, const char* variable, void(*serialize_type)(FILE*, Reflector&, Type*, const char*)) {
         fprintf(f, "    switch (%stype) {\n", variable);
 
         for (int i = 0; i < min(type->fields.length, tag->values.length); i++) {
@@ -1082,7 +1320,7 @@ namespace pixc::reflection::compiler {
 
             char write_to[100];
             snprintf(write_to, 100, "%s%s", variable, field.name);
-            serialize_type(f, field.type, write_to);
+            serialize_type(f, reflector, field.type, write_to);
 
             fprintf(f, "    break;\n\n");
         }
@@ -1181,11 +1419,11 @@ namespace pixc::reflection::compiler {
         Name& name = type->name;
         const char* linking = reflector.linking;
         
-        fprintf(f, "refl::Struct init_%s() {\n", name.full);
-        fprintf(f, "	refl::Struct type(\"%s\", sizeof(%s));\n", name.full, name.type);
-
         EnumType* tag_type = nullptr;
         bool is_tagged_union = false;
+        uint reflected_fields = 0;
+
+        fprintf(f, "namespace {\n");
 
         //Support tags
         for (Field& field : type->fields) {
@@ -1193,24 +1431,53 @@ namespace pixc::reflection::compiler {
                 UnionType* union_type = (UnionType*)type;
 
                 //todo generate correct reflection data
-                fprintf(f, "    static refl::Union inline_union = { refl::Type::Union, 0, \"%s\" };\n", union_type->name.full); //no clue what the size
-                //todo reflect fields
-                fprintf(f, "    type.fields.append({ \"\", offsetof(%s, %s), &inline_union });\n", name.type, union_type->fields[0].name);
+                fprintf(f, "refl::Union %s_inline_union = { refl::Type::Union, 0, \"%s\" };\n", name.full, union_type->name.full); //no clue what the size
                 is_tagged_union = true;
             }
             else if (strcmp(field.name, "type") == 0 && field.type->type == Type::Enum) {
                 tag_type = (EnumType*)field.type;
+                continue;
             }
             else {
-                fprintf(f, "	type.fields.append({");
-                fprintf(f, "\"%s\", offsetof(%s, %s), ", field.name, name.type, field.name);
-                dump_type_ref(f, field.type);
+                char var[200];
+                snprintf(var, 200, "%s_%s_array", name.full, field.name);
+                dump_array_types(f, reflector, field.type, var);
+            }
+
+            reflected_fields++;
+        }
+
+        if (reflected_fields > 0) {
+            fprintf(f, "refl::Field %s_fields[] = {\n", name.full);
+
+            for (Field& field : type->fields) {
+                if (field.name == "" && field.type->type == Type::Union) {
+                    UnionType* union_type = (UnionType*)type;
+                    //todo reflect fields
+                    fprintf(f, "	{ \"\", offsetof(%s, %s), &%s_inline_union },\n", name.type, union_type->fields[0].name, name.full);
+                }
+                else if (strcmp(field.name, "type") == 0 && field.type->type == Type::Enum) {
+                    continue;
+                }
+                else {
+                    char var[200];
+                    snprintf(var, 200, "%s_%s_array", name.full, field.name);
 
-                fprintf(f, "});\n");
+                    fprintf(f, "	{ \"%s\", offsetof(%s, %s), ", field.name, name.type, field.name);
+                    dump_type_ref(f, reflector, field.type, var);
+
+                    //same hash as refl::field_id, so schemas of types reflected by hand match
+                    fprintf(f, ", 0, 0x%llxull },\n", (unsigned long long)hash_layout(14695981039346656037ull, field.name));
+                }
             }
+
+            fprintf(f, "};\n\n");
+            fprintf(f, "refl::Struct %s_type(\"%s\", sizeof(%s), %s_fields);\n", name.full, name.full, name.type, name.full);
+        }
+        else {
+            fprintf(f, "refl::Struct %s_type(\"%s\", sizeof(%s));\n", name.full, name.full, name.type);
         }
 
-        fprintf(f, "	return type;\n");
         fprintf(f, "}\n\n");
 
         bool trivial = is_trivially_copyable(reflector, type);
@@ -1222,16 +1489,25 @@ namespace pixc::reflection::compiler {
             fprintf(f, "    write_n_to_buffer(buffer, &data, sizeof(%s));\n", name.type);
         }
         else {
-            for (Field& field : type->fields) {
+            for (uint i = 0; i < type->fields.length;) {
+                Field& field = type->fields[i];
                 char write_to[100];
                 snprintf(write_to, 100, "data.%s", field.name);
 
+                uint run_end = is_tagged_union ? i : end_of_pod_run(reflector, type->fields, i);
+                if (run_end > i) {
+                    copy_pod_run(f, true, name.type, { type->fields.data + i, run_end - i });
+                    i = run_end;
+                    continue;
+                }
+
                 if (field.type->type == Type::Union && field.name == "") {
-                    serialize_tagged_union(f, name.type, (UnionType*)field.type, tag_type, write_to, serialize_type);
+                    serialize_tagged_union(f, reflector, name.type, (UnionType*)field.type, tag_type, write_to, serialize_type);
                 }
                 else {
-                    serialize_type(f, field.type, write_to);
+                    serialize_type(f, reflector, field.type, write_to);
                 }
+                i++;
             }
         }
         fprintf(f, "}\n\n");
@@ -1243,44 +1519,65 @@ namespace pixc::reflection::compiler {
             read_trivial_from_buffer(f, name.type, "data");
         }
         else {
-            for (Field& field : type->fields) {
+            for (uint i = 0; i < type->fields.length;) {
+                Field& field = type->fields[i];
                 char write_to[100];
                 snprintf(write_to, 100, "data.%s", field.name);
 
+                uint run_end = is_tagged_union ? i : end_of_pod_run(reflector, type->fields, i);
+                if (run_end > i) {
+                    copy_pod_run(f, false, name.type, { type->fields.data + i, run_end - i });
+                    i = run_end;
+                    continue;
+                }
+
                 if (field.type->type == Type::Union && field.name == "") {
-                    serialize_tagged_union(f, name.type, (UnionType*)field.type, tag_type, write_to, deserialize_type);
+                    serialize_tagged_union(f, reflector, name.type, (UnionType*)field.type, tag_type, write_to, deserialize_type);
                 }
                 else if (is_tagged_union && strcmp(field.name, "type") == 0) {
                     fprintf(f, "    ");
                     dump_type(f, tag_type);
                     fprintf(f, " type;\n");
-                    deserialize_type(f, field.type, "type");
+                    deserialize_type(f, reflector, field.type, "type");
                     fprintf(f, "    new (&data) %s(type);\n", name.type);
 
                 }
                 else {
-                    deserialize_type(f, field.type, write_to);
+                    deserialize_type(f, reflector, field.type, write_to);
                 }
+                i++;
             }
         }
         fprintf(f, "}\n\n");
 
         fprintf(h, "%s refl::Struct* get_%s_type();\n", linking, name.full);
+        //Data written with the same hash can be used in place when the type is trivially copyable
+        fprintf(h, "constexpr u64 %s_layout_hash = 0x%llxull;\n", name.full, (unsigned long long)layout_hash(reflector, type, 14695981039346656037ull));
 
         fprintf(f, "refl::Struct* get_%s_type() {\n", name.full);
-        fprintf(f, "	static refl::Struct type = init_%s();\n", name.full);
-        fprintf(f, "	return &type;\n");
+        fprintf(f, "	return &%s_type;\n", name.full);
         fprintf(f, "}\n\n");
 
         
     }
 
-    void dump_alias_reflector(FILE* f, FILE* h, AliasType& alias, const char* linking) {
+    void dump_alias_reflector(FILE* f, FILE* h, AliasType& alias, Reflector& reflector) {
         Name& name = alias.name;
+        const char* linking = reflector.linking;
+        char var[200];
+        snprintf(var, 200, "%s_array", name.full);
+
+        if (alias.aliasing->type == Type::Array) {
+            fprintf(f, "namespace {\n");
+            dump_array_types(f, reflector, alias.aliasing, var);
+            fprintf(f, "}\n\n");
+        }
+
+        //the size of the aliased type is only known once it is initialized, so aliases are still made on first use
         fprintf(h, "%s refl::Alias* get_%s_type();\n", linking, name.full);
         fprintf(f, "refl::Alias* get_%s_type() {\n", name.full);
         fprintf(f, "    static refl::Alias type(\"%s\", ", name.full);
-        dump_type_ref(f, alias.aliasing);
+        dump_type_ref(f, reflector, alias.aliasing, var);
         fprintf(f, ");\n");
         fprintf(f, "    return &type;\n");
         fprintf(f, "}\n\n");
@@ -1291,7 +1588,7 @@ namespace pixc::reflection::compiler {
         fprintf(h, "& data);\n");
 
         fprintf(f, "void write_%s_to_buffer(SerializerBuffer& buffer, %s& data) {\n", name.full, name.type);
-        serialize_type(f, alias.aliasing, "data");
+        serialize_type(f, reflector, alias.aliasing, "data");
         fprintf(f, "}\n");
 
         fprintf(h, "%s void read_%s_from_buffer(DeserializerBuffer& buffer, ", linking, name.full);
@@ -1299,7 +1596,7 @@ namespace pixc::reflection::compiler {
         fprintf(h, "& data);\n");
 
         fprintf(f, "void read_%s_from_buffer(DeserializerBuffer& buffer, %s& data) {\n", name.full, name.type);
-        deserialize_type(f, alias.aliasing, "data");
+        deserialize_type(f, reflector, alias.aliasing, "data");
         fprintf(f, "}\n");
     }
 
@@ -1321,7 +1618,7 @@ namespace pixc::reflection::compiler {
             dump_reflector(f, h, reflector, space->namespaces[i], buffer, indent);
         }
 
-        for (AliasType* type : space->alias) dump_alias_reflector(f, h, *type, linking);
+        for (AliasType* type : space->alias) dump_alias_reflector(f, h, *type, reflector);
         for (EnumType* type : space->enums) dump_enum_reflector(f, h, type, linking);
         for (StructType* type : space->structs) dump_struct_reflector(f, h, type, buffer, reflector, indent);
     }
@@ -1354,13 +1651,60 @@ namespace pixc::reflection::compiler {
         }
     }
 
+    //Outputs are written to a temporary file first and only replace the old file when the text differs,
+    //an unchanged generated header then does not make everything that includes it recompile
+    FILE* open_output(const char* path, char* tmp_path) {
+        snprintf(tmp_path, MAX_FILEPATH, "%s.tmp", path);
+        return fopen(tmp_path, "w");
+    }
+
+    bool same_contents(const char* a, const char* b) {
+        FILE* file_a = fopen(a, "rb");
+        FILE* file_b = fopen(b, "rb");
+
+        bool same = file_a && file_b;
+
+        char buffer_a[4096];
+        char buffer_b[4096];
+
+        while (same) {
+            size_t length_a = fread(buffer_a, sizeof(char), sizeof(buffer_a), file_a);
+            size_t length_b = fread(buffer_b, sizeof(char), sizeof(buffer_b), file_b);
+
+            same = length_a == length_b && memcmp(buffer_a, buffer_b, length_a) == 0;
+            if (length_a < sizeof(buffer_a)) break;
+        }
+
+        if (file_a) fclose(file_a);
+        if (file_b) fclose(file_b);
+
+        return same;
+    }
+
+    void replace_if_changed(const char* path, const char* tmp_path) {
+        if (same_contents(path, tmp_path)) {
+            remove(tmp_path);
+            printf("Unchanged %s\n", path);
+            return;
+        }
+
+        remove(path); //rename does not replace existing files on windows
+        if (rename(tmp_path, path) != 0) {
+            fprintf(stderr, "Could not replace %s!\n", path);
+            exit(1);
+        }
+
+        printf("Updated %s\n", path);
+    }
+
     void dump_register_components(Reflector& ref, FILE* f) {
         Namespace* space = ref.namespaces.last();
 
         char header_path[MAX_FILEPATH];
+        char header_tmp_path[MAX_FILEPATH];
         snprintf(header_path, MAX_FILEPATH, "%s/%s", ref.include, ref.component);
 
-        FILE* h = fopen(header_path, "w");
+        FILE* h = open_output(header_path, header_tmp_path);
         if (!h) {
             fprintf(stderr, "Could not open %s file for writing!", header_path);
             exit(1);
@@ -1383,6 +1727,9 @@ namespace pixc::reflection::compiler {
             }
         }
 
+        fclose(h);
+        replace_if_changed(header_path, header_tmp_path);
+
         fprintf(f, "#include \"%s\"\n", header_path);
         fprintf(f, "#include \"ecs/ecs.h\"\n");
         fprintf(f, "#include \"engine/application.h\"\n\n");
@@ -1780,14 +2127,17 @@ namespace pixc::reflection::compiler {
         char cpp_output_file[MAX_FILEPATH];
         char h_output_file[MAX_FILEPATH];
         char type_output_path[MAX_FILEPATH];
+        char cpp_tmp_file[MAX_FILEPATH];
+        char h_tmp_file[MAX_FILEPATH];
+        char type_tmp_path[MAX_FILEPATH];
 
         snprintf(h_output_file, MAX_FILEPATH, "%s/%s.h", ref.include, ref.h_output);
         snprintf(cpp_output_file, MAX_FILEPATH, "%s/%s.cpp", ref.base, ref.output);
         snprintf(type_output_path, MAX_FILEPATH, "%s/%s", ref.base, "type_info.refl");
 
-        FILE* file = fopen(cpp_output_file, "w");
+        FILE* file = open_output(cpp_output_file, cpp_tmp_file);
 
-        FILE* header_file = fopen(h_output_file, "w");
+        FILE* header_file = open_output(h_output_file, h_tmp_file);
 
         FILE* type_info_file = fopen(type_output_path, "r");
 
@@ -1851,6 +2201,11 @@ namespace pixc::reflection::compiler {
 
         assign_components_ids(ref);
 
+        //tables can point at each other in any order
+        fprintf(file, "namespace {\n");
+        dump_table_decls(file, space);
+        fprintf(file, "}\n\n");
+
         dump_reflector(file, header_file, ref, space, "", 0);
 
         dump_register_components(ref, file);
@@ -1859,7 +2214,9 @@ namespace pixc::reflection::compiler {
         //fprintf(header_file, "\t}\n}\n");
         fclose(file);
         fclose(header_file);
-        
+
+        replace_if_changed(cpp_output_file, cpp_tmp_file);
+        replace_if_changed(h_output_file, h_tmp_file);
 
         //todo move into a function
         {
@@ -1868,8 +2225,12 @@ namespace pixc::reflection::compiler {
             buffer.data = TEMPORARY_ARRAY(char, buffer.capacity);
 
             write_type_info_to_buffer(buffer, space);
+            if (buffer.overflow) {
+                printf("Type info does not fit in %u bytes", buffer.capacity);
+                return;
+            }
 
-            FILE* type_info_file = fopen(type_output_path, "w");
+            FILE* type_info_file = open_output(type_output_path, type_tmp_path);
             if (!type_info_file) {
                 printf("Could not open type_info file");
                 return;
@@ -1877,6 +2238,8 @@ namespace pixc::reflection::compiler {
 
             fwrite(buffer.data, sizeof(char), buffer.index, type_info_file);
             fclose(type_info_file);
+
+            replace_if_changed(type_output_path, type_tmp_path);
         }
 
     }
@@ -1934,7 +2297,7 @@ void listdir(const char* base, const char *path, int indent, tvector<const char*
 }
 #endif
 
-#ifdef NE_PLATFORM_MACOSX
+#ifndef NE_PLATFORM_WINDOWS
 #include <dirent.h>
 
 void listdir(const char* base, const char *path, int indent, tvector<const char*>& header_paths) {
@@ -2017,6 +2380,213 @@ bool io_readf(string_view full_filepath, string_buffer* buffer, int null_termina
 
 #include "core/context.h"
 
+//Remembers the content hash of every header of the last run, when neither the headers, the arguments
+//nor the tool changed nothing is regenerated
+const char* HEADER_CACHE_FILENAME = "header_cache.refl";
+const uint HEADER_CACHE_VERSION = 1;
+const uint MAX_PARSE_WORKERS = 8;
+
+struct HeaderFile {
+	const char* filename;
+	string_buffer contents;
+	u64 hash;
+	Namespace* root;
+	error::Error err;
+};
+
+u64 hash_contents(u64 hash, string_view contents) {
+	for (uint i = 0; i < contents.length; i++) {
+		hash ^= (u8)contents.data[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+//Includes the modification time of the executable, so rebuilding the tool regenerates the output
+u64 hash_tool(int argc, const char** c_args) {
+	u64 hash = 14695981039346656037ull;
+
+	struct _stat exe_info;
+	if (_stat(c_args[0], &exe_info) == -1) exe_info = {};
+
+	u64 exe_time = exe_info.st_mtime;
+	hash = hash_contents(hash, { (const char*)&exe_time, sizeof(u64) });
+	hash = hash_contents(hash, { (const char*)&HEADER_CACHE_VERSION, sizeof(uint) });
+
+	for (int i = 1; i < argc; i++) {
+		hash = hash_contents(hash, c_args[i]);
+		hash = hash_contents(hash, { "\0", 1 });
+	}
+
+	return hash;
+}
+
+bool output_exists(const char* path) {
+	struct _stat info;
+	return _stat(path, &info) == 0;
+}
+
+bool outputs_exist(Reflector& ref) {
+	char path[MAX_FILEPATH];
+
+	snprintf(path, MAX_FILEPATH, "%s/%s.cpp", ref.base, ref.output);
+	if (!output_exists(path)) return false;
+
+	snprintf(path, MAX_FILEPATH, "%s/%s.h", ref.include, ref.h_output);
+	if (!output_exists(path)) return false;
+
+	snprintf(path, MAX_FILEPATH, "%s/%s", ref.include, ref.component);
+	return output_exists(path);
+}
+
+//Prints every header that changed since the last run, returns false when the cache is missing or was made for other arguments
+bool compare_header_cache(const char* cache_path, u64 tool_hash, slice<HeaderFile> headers) {
+	DeserializerBuffer buffer = {};
+	DeserializerSource source = {};
+	if (!open_file_source(buffer, source, cache_path)) return false;
+
+	u64 cached_tool_hash = 0;
+	uint count = 0;
+	read_u64_from_buffer(buffer, cached_tool_hash);
+	read_uint_from_buffer(buffer, count);
+
+	bool valid = !buffer.overflow && cached_tool_hash == tool_hash && count == headers.length;
+	bool unchanged = valid;
+
+	for (uint i = 0; valid && i < count; i++) {
+		const char* filename = read_cstring_from_buffer(buffer);
+		u64 hash = 0;
+		read_u64_from_buffer(buffer, hash);
+
+		if (buffer.overflow || strcmp(filename, headers[i].filename) != 0) {
+			valid = false;
+			unchanged = false;
+		}
+		else if (hash != headers[i].hash) {
+			printf("%s changed\n", filename);
+			unchanged = false;
+		}
+	}
+
+	close_file_source(buffer);
+	return unchanged;
+}
+
+void write_header_cache(const char* cache_path, u64 tool_hash, slice<HeaderFile> headers) {
+	SerializerBuffer buffer = {};
+	SerializerSink sink = {};
+	if (!open_file_sink(buffer, sink, cache_path, false)) {
+		fprintf(stderr, "Could not open %s for writing!\n", cache_path);
+		return;
+	}
+
+	write_u64_to_buffer(buffer, tool_hash);
+	write_uint_to_buffer(buffer, headers.length);
+
+	for (HeaderFile& header : headers) {
+		write_cstring_to_buffer(buffer, header.filename);
+		write_u64_to_buffer(buffer, header.hash);
+	}
+
+	if (!close_file_sink(buffer)) fprintf(stderr, "Could not write %s!\n", cache_path);
+}
+
+//The component ids header is generated into a directory that is also searched for input headers
+bool is_generated_header(Reflector& ref, string_view filename) {
+	char h_output[MAX_FILEPATH];
+	snprintf(h_output, MAX_FILEPATH, "%s.h", ref.h_output);
+
+	return filename == ref.component || filename == h_output;
+}
+
+void hash_generated_headers(Reflector& ref, slice<HeaderFile> headers) {
+	for (HeaderFile& header : headers) {
+		if (!is_generated_header(ref, header.filename)) continue;
+
+		char full_path[MAX_FILEPATH];
+		snprintf(full_path, MAX_FILEPATH, "%s/%s", ref.include, header.filename);
+
+		if (io_readf(full_path, &header.contents)) header.hash = hash_contents(14695981039346656037ull, header.contents);
+	}
+}
+
+//Headers do not refer to each other while parsing, every worker lexes and parses whole headers into their own root namespace.
+//The tokens and the tvectors of a header are allocated from the worker's allocator, which outlives the thread
+void parse_headers(slice<HeaderFile> headers, std::atomic<uint>& next, LinearAllocator* allocator) {
+	Context context;
+	context.temporary_allocator = allocator;
+	context.allocator = &default_allocator;
+
+	ScopedContext scoped_context(context);
+
+	for (uint i = next++; i < headers.length; i = next++) {
+		HeaderFile& header = headers[i];
+
+		Reflector reflector = {};
+		reflector.err = &header.err;
+		reflector.allocator = allocator;
+
+		header.root = make_Namespace(reflector, "");
+		reflector.namespaces.append(header.root);
+
+		header.err.filename = header.filename;
+		header.err.src = header.contents;
+
+		lexer::Lexer lexer = {};
+		reflector.tokens = lexer::lex(lexer, header.contents, &header.err);
+		parse(reflector);
+	}
+}
+
+const uint LEXER_BENCHMARK_RUNS = 50;
+
+//Only lexes the headers, best of a few runs. Run with -d "" to lex every header of the include directory
+void benchmark_lexer(slice<HeaderFile> headers) {
+	u64 bytes = 0;
+	for (HeaderFile& header : headers) bytes += header.contents.length;
+
+	double best = 1e9;
+	uint tokens = 0;
+
+	for (uint run = 0; run < LEXER_BENCHMARK_RUNS; run++) {
+		tokens = 0;
+		double start = Time::now();
+
+		for (HeaderFile& header : headers) {
+			LinearRegion region(get_temporary_allocator());
+			lexer::Lexer lexer = {};
+			error::Error err = {};
+			tokens += lexer::lex(lexer, header.contents, &err).length;
+		}
+
+		double time = Time::now() - start;
+		if (time < best) best = time;
+	}
+
+	printf("Lexed %u headers, %llu bytes, %u tokens in %.3f ms, %.1f MB/s\n", headers.length, (unsigned long long)bytes, tokens, best * 1000, bytes / best / (1024 * 1024));
+}
+
+//A namespace opened in several headers is merged into one, so each is emitted once
+void merge_namespace(Namespace* space, Namespace* header_space) {
+	for (Namespace* sub : header_space->namespaces) {
+		Namespace* existing = nullptr;
+		for (Namespace* other : space->namespaces) {
+			if (other->name == sub->name) {
+				existing = other;
+				break;
+			}
+		}
+
+		if (existing) merge_namespace(existing, sub);
+		else space->namespaces.append(sub);
+	}
+
+	for (StructType* type : header_space->structs) space->structs.append(type);
+	for (EnumType* type : header_space->enums) space->enums.append(type);
+	for (AliasType* type : header_space->alias) space->alias.append(type);
+	for (UnionType* type : header_space->unions) space->unions.append(type);
+}
+
 int main(int argc, const char** c_args) {
 	LinearAllocator& permanent_allocator = get_thread_local_permanent_allocator(); 
 	LinearAllocator& temporary_allocator = get_thread_local_temporary_allocator();
@@ -2050,6 +2620,7 @@ int main(int argc, const char** c_args) {
 	printf("==== INPUT FILES ====\n");
 
 	bool modified = false;
+	bool benchmark = false;
 
 	//Profile input_profile("INPUT PROFILE");
 
@@ -2067,6 +2638,10 @@ int main(int argc, const char** c_args) {
 			modified = true;
 		}
 
+		else if (arg == "-bench") {
+			benchmark = true;
+		}
+
 		else if (arg == "-h") {
 			const char* filename = c_args[++i];
 			reflector.h_output = filename;
@@ -2115,38 +2690,42 @@ int main(int argc, const char** c_args) {
 		listdir(reflector.include, dir, 0, reflector.header_files);
 	}
 
-	if (!modified) {
-		char generated_cpp_filename[200];
-		snprintf(generated_cpp_filename, 200, "%s.cpp", reflector.output);
+	slice<HeaderFile> headers = { TEMPORARY_ARRAY(HeaderFile, reflector.header_files.length), reflector.header_files.length };
+
+	for (uint i = 0; i < headers.length; i++) {
+		HeaderFile& header = headers[i];
+		header.filename = reflector.header_files[i];
+		header.contents.allocator = &get_temporary_allocator();
 
-        struct _stat output_info;
-        if (_stat(generated_cpp_filename, &output_info) == -1) output_info = {};
+		char full_path[MAX_FILEPATH];
+		snprintf(full_path, MAX_FILEPATH, "%s/%s", reflector.include, header.filename);
 
-		//todo replace with macro generated by the build system
-		const char* OUTPUT_FILE = "C:\\Users\\User\\source\\repos\\NextEngine\\x64\\Release\\ReflectionTool.exe";
+		if (!io_readf(full_path, &header.contents)) {
+			fprintf(stderr, "Could not open file! %s", full_path);
+			exit(1);
+		}
 
-		struct _stat exe_info;
-        if (_stat(OUTPUT_FILE, &exe_info) == -1) exe_info = {};
+		header.hash = hash_contents(14695981039346656037ull, header.contents);
+	}
 
-		if (exe_info.st_mtime > output_info.st_mtime) modified = true;
+	if (benchmark) {
+		benchmark_lexer(headers);
+		return 0;
+	}
 
-		for (string_view filename : reflector.header_files) {
-			char full_path[200];
-			snprintf(full_path, 200, "%s/%s", reflector.include, filename.c_str());
-			
-			struct _stat info;
-			_stat(full_path, &info);
+	char cache_path[MAX_FILEPATH];
+	snprintf(cache_path, MAX_FILEPATH, "%s/%s", reflector.base, HEADER_CACHE_FILENAME);
 
-			if (info.st_mtime > output_info.st_mtime) {
-				modified = true;
-				break;
-			}
-		}
+	u64 tool_hash = hash_tool(argc, c_args);
 
-		if (!modified) {
-			printf("\n=== NO FILE MODIFIED ===\n");
-			return 0;
-		}
+	printf("\n");
+
+	if (!compare_header_cache(cache_path, tool_hash, headers)) modified = true;
+	if (!outputs_exist(reflector)) modified = true;
+
+	if (!modified) {
+		printf("\n=== NO FILE MODIFIED ===\n");
+		return 0;
 	}
 
 	//printf("=== SEARCHING DIRECTORIES TOOK %f", input_profile.end());
@@ -2155,37 +2734,36 @@ int main(int argc, const char** c_args) {
 
 	//Profile parsing_profile("PARSING");
 
-	for (string_view filename : reflector.header_files) {
-		char full_path[MAX_FILEPATH];
-		snprintf(full_path, MAX_FILEPATH, "%s/%s", reflector.include, filename.c_str());
-		
-		string_buffer contents;
-		contents.allocator = &get_temporary_allocator();
-		if (!io_readf(full_path, &contents)) {
-			fprintf(stderr, "Could not open file! %s", full_path);
-			exit(1);
-		}
-
-
-		err.filename = filename;
-		err.src = contents;
+	uint worker_count = std::thread::hardware_concurrency();
+	if (worker_count > MAX_PARSE_WORKERS) worker_count = MAX_PARSE_WORKERS;
+	if (worker_count > headers.length) worker_count = headers.length;
+	if (worker_count == 0) worker_count = 1;
 
-		lexer::Lexer lexer = {};
-		slice<lexer::Token> tokens = lexer::lex(lexer, contents, &err);
+	LinearAllocator worker_allocators[MAX_PARSE_WORKERS];
+	std::thread workers[MAX_PARSE_WORKERS];
+	std::atomic<uint> next_header(0);
 
-		//lexer::dump_tokens(lexer);
+	for (uint i = 0; i < worker_count; i++) {
+		worker_allocators[i] = LinearAllocator(mb(10));
+		workers[i] = std::thread(parse_headers, headers, std::ref(next_header), &worker_allocators[i]);
+	}
 
-		reflector.i = 0;
-		reflector.tokens = tokens;
-		parse(reflector);
+	for (uint i = 0; i < worker_count; i++) {
+		workers[i].join();
 	}
 
 	//printf("=== PARSING TOOK %f", parsing_profile.end());
 
-    
-	if (error::is_error(&err)) {
-		error::log_error(&err);
-		exit(1);
+	for (HeaderFile& header : headers) {
+		if (error::is_error(&header.err)) {
+			error::log_error(&header.err);
+			exit(1);
+		}
+	}
+
+	//merged in the order of the headers, so the output is the same as when they are parsed one after another
+	for (HeaderFile& header : headers) {
+		merge_namespace(root, header.root);
 	}
     
     printf("\n==== GENERATING REFLECTION FILE ====\n");
@@ -2193,6 +2771,9 @@ int main(int argc, const char** c_args) {
 	//Profile dump_profiler("DUMP");
     dump_reflector(reflector);
 
+	hash_generated_headers(reflector, headers);
+	write_header_cache(cache_path, tool_hash, headers);
+
 	//printf("=== DUMP TOOK %f", dump_profiler.end());
     //dump_reflector_header(reflector);
 }
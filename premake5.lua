@@ -226,6 +226,33 @@ project "NextEngine"
         links "%{VULKAN_SDK}/lib/shaderc_combined.lib"
 
 
+project "AssetPacker"
+	location "AssetPacker"
+	kind "ConsoleApp"
+
+	includedirs {
+		"NextEngine/include",
+		"NextCore/include",
+	}
+
+	sysincludedirs "vendor/glm"
+
+	links 
+	{
+		"NextCore",
+		"NextEngine",
+	}
+
+	if os.istarget("windows") then
+		postbuildcommands {
+			"{COPY} ../bin/" .. outputdir .. "/NextCore/NextCore.dll ../bin/" .. outputdir .. "/%{prj.name}",
+			"{COPY} ../bin/" .. outputdir .. "/NextEngine/NextEngine.dll ../bin/" .. outputdir .. "/%{prj.name}",
+		}
+	end
+
+	default_config()
+	set_rpath()
+
 project "NextEngineEditor"
 	location "NextEngineEditor"
 